@@ -53,4 +53,98 @@ kernel void bilateral_filter(__global float* src, __global float* dest,
 
     dest[y * width + x] = summation/W_p;
 
-}
\ No newline at end of file
+}
+
+#define TILE_WIDTH (16U)
+#define TILE_HEIGHT (16U)
+
+/**
+ *  Bilateral filter on 2d image which produces the same
+ *  result as bilateral_filter (up to rounding)
+ *
+ *  Each work group (of TILE_WIDTH x TILE_HEIGHT work items)
+ *  loads the tile of the source image it filters, together
+ *  with an apron of window pixels on each side, into local
+ *  memory.  The spatial weights are looked up in a table
+ *  rather than computed and the range weight is computed
+ *  with native_exp.
+ *
+ *  The global size must be rounded up to a multiple of the
+ *  tile size.
+ *
+ *  src - source image
+ *  dest - dest image
+ *  spatial - spatial weights, the weight for offset (dx, dy)
+ *  is at ((dy + window) * 2 * window) + dx + window
+ *  sigma_r_inv_sq - inverse square of std dev of gaussian for range kernel
+ *  width - width of src and dest
+ *  height - height of src and dest
+ *  window - the window extends this many pixels before and
+ *  this many pixels less one after each pixel in each dimension
+ *  tile - local memory of (TILE_WIDTH + 2 * window) x
+ *  (TILE_HEIGHT + 2 * window) floats
+ */
+kernel void bilateral_filter_tiled(const __global float * src, __global float * dest,
+    const __constant float * spatial, const float sigma_r_inv_sq,
+    const unsigned int width, const unsigned int height, const unsigned int window,
+    __local float * tile) {
+
+    unsigned int lx = (unsigned int)get_local_id(0);
+    unsigned int ly = (unsigned int)get_local_id(1);
+    int origin_x = (int)(get_group_id(0) * TILE_WIDTH) - (int)window;
+    int origin_y = (int)(get_group_id(1) * TILE_HEIGHT) - (int)window;
+    unsigned int tile_width = TILE_WIDTH + (2U * window);
+    unsigned int tile_height = TILE_HEIGHT + (2U * window);
+
+    // Pixels outside the image are never used (the window
+    // is clipped below) but clamping keeps reads in bounds
+    for (unsigned int j = ly; j < tile_height; j += TILE_HEIGHT) {
+        int sy = clamp(origin_y + (int)j, 0, (int)height - 1);
+        for (unsigned int i = lx; i < tile_width; i += TILE_WIDTH) {
+            int sx = clamp(origin_x + (int)i, 0, (int)width - 1);
+            tile[(j * tile_width) + i] = src[(sy * width) + sx];
+        }
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    unsigned int x = (unsigned int)get_global_id(0);
+    unsigned int y = (unsigned int)get_global_id(1);
+    if ((x >= width) || (y >= height)) return;
+
+    unsigned int start_x = 0;
+    if (x > window) start_x = x - window;
+    unsigned int start_y = 0;
+    if (y > window) start_y = y - window;
+    unsigned int end_x = x + window;
+    if (end_x > width) end_x = width;
+    unsigned int end_y = y + window;
+    if (end_y > height) end_y = height;
+
+    float summation = 0;
+    float W_p = 0;
+
+    float R_k_u = tile[(((unsigned int)((int)y - origin_y)) * tile_width) + (unsigned int)((int)x - origin_x)];
+    unsigned int spatial_width = 2U * window;
+
+    for (unsigned int j = start_y; j < end_y; j++) {
+
+        unsigned int tile_row = ((unsigned int)((int)j - origin_y)) * tile_width;
+        unsigned int spatial_row = (j + window - y) * spatial_width;
+
+        for (unsigned int i = start_x; i < end_x; i++) {
+
+            float R_k_q = tile[tile_row + (unsigned int)((int)i - origin_x)];
+
+            float range2 = (R_k_u - R_k_q) * (R_k_u - R_k_q);
+            float weight = spatial[spatial_row + (i + window - x)] * native_exp(-range2 * sigma_r_inv_sq);
+
+            summation += weight * R_k_q;
+            W_p += weight;
+        }
+
+    }
+
+    dest[(y * width) + x] = summation / W_p;
+
+}
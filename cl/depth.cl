@@ -0,0 +1,18 @@
+/**
+ *  Converts a depth frame from the native 16 bit
+ *  representation of a depth sensor (millimeters) to
+ *  meters
+ *
+ *  src - raw depth frame
+ *  dest - depth frame in meters
+ *  invalid - the raw value which represents an invalid
+ *  depth value (which becomes NaN)
+ */
+kernel void depth_to_meters(const __global ushort * src, __global float * dest, const ushort invalid) {
+
+    size_t idx = get_global_id(0);
+    ushort depth = src[idx];
+
+    dest[idx] = (depth == invalid) ? NAN : (depth / 1000.0f);
+
+}
@@ -0,0 +1,424 @@
+#include "tsdf.h"
+
+
+/**
+ *	A sparse TSDF stored as 8x8x8 voxel bricks which are
+ *	allocated only near observed surfaces and located via
+ *	a hash table keyed by brick coordinate
+ *
+ *	The hash table consists of two arrays of the same size:
+ *
+ *	keys - the packed coordinate of the brick in each slot
+ *	(or EMPTY_KEY)
+ *	ptrs - the index in the brick pool of the brick in each
+ *	slot (or -1 if the pool was exhausted)
+ *
+ *	Collisions are resolved by linear probing.  Brick
+ *	coordinates are packed into 10 bits per axis and so
+ *	must lie in [-512, 512)
+ *
+ *	Voxel i (along any axis) has its center at
+ *	(i + 0.5) * voxel_size in world space as in the dense
+ *	TSDF
+ */
+
+#define BRICK_SIZE (8)
+#define BRICK_VOXELS (512U)
+#define EMPTY_KEY (0xFFFFFFFFU)
+#define MAX_PROBES (32U)
+
+
+int brick_in_range(int3 b) {
+
+	return (b.x >= -512) && (b.x < 512) && (b.y >= -512) && (b.y < 512) && (b.z >= -512) && (b.z < 512);
+
+}
+
+
+uint brick_key(int3 b) {
+
+	return (((uint)b.x & 1023U) << 20) | (((uint)b.y & 1023U) << 10) | ((uint)b.z & 1023U);
+
+}
+
+
+int unpack_component(uint bits) {
+
+	int retr = (int)(bits & 1023U);
+	return (retr >= 512) ? (retr - 1024) : retr;
+
+}
+
+
+int3 key_brick(uint key) {
+
+	return (int3)(unpack_component(key >> 20), unpack_component(key >> 10), unpack_component(key));
+
+}
+
+
+uint brick_hash(int3 b, uint buckets) {
+
+	return (((uint)b.x * 73856093U) ^ ((uint)b.y * 19349669U) ^ ((uint)b.z * 83492791U)) % buckets;
+
+}
+
+
+int3 brick_of(int3 vox) {
+
+	// Rounds toward negative infinity
+	return convert_int3(floor(convert_float3(vox) / (float)BRICK_SIZE));
+
+}
+
+
+/**
+ *	Finds the index in the brick pool of a brick, or -1
+ *	if it is not allocated
+ */
+int find_brick(int3 b, __global const uint * keys, __global const int * ptrs, uint buckets) {
+
+	if (!brick_in_range(b)) return -1;
+
+	uint key = brick_key(b);
+	uint slot = brick_hash(b, buckets);
+	for (uint i = 0; i < MAX_PROBES; ++i) {
+
+		uint k = keys[slot];
+		if (k == key) return ptrs[slot];
+		if (k == EMPTY_KEY) return -1;
+		slot = (slot + 1U) % buckets;
+
+	}
+
+	return -1;
+
+}
+
+
+/**
+ *	Allocates a brick if it has not already been allocated
+ *
+ *	Newly allocated bricks are empty since the entire pool
+ *	is cleared when the TSDF is reset
+ */
+void insert_brick(int3 b, __global uint * keys, __global int * ptrs, __global uint * brick_keys,
+ __global uint * count, uint max_bricks, uint buckets) {
+
+	if (!brick_in_range(b)) return;
+
+	uint key = brick_key(b);
+	uint slot = brick_hash(b, buckets);
+	for (uint i = 0; i < MAX_PROBES; ++i) {
+
+		uint old = atomic_cmpxchg(&keys[slot], EMPTY_KEY, key);
+		if (old == EMPTY_KEY) {
+
+			uint p = atomic_inc(count);
+			if (p < max_bricks) {
+
+				ptrs[slot] = (int)p;
+				brick_keys[p] = key;
+
+			}
+			return;
+
+		}
+		if (old == key) return;
+		slot = (slot + 1U) % buckets;
+
+	}
+
+}
+
+
+/**
+ *	Params:
+ *
+ *	src - depth image
+ *	T_g_k - camera to world transform (4x4)
+ *	K_inv - inverse camera matrix (3x3)
+ *	mu - truncation distance
+ *	voxel_size - edge length of a voxel in m
+ *	keys, ptrs - hash table
+ *	brick_keys - the key of each brick in the pool
+ *	count - number of bricks allocated
+ *	max_bricks - size of the brick pool
+ *	buckets - size of the hash table
+ *
+ *	Launched over the width and height of the depth image,
+ *	each work item allocates the bricks through which the
+ *	ray through its pixel passes within the truncation
+ *	region about the measurement
+ */
+kernel void allocate_bricks(__global const float * src, __global const float * T_g_k, __global const float * K_inv,
+ const float mu, const float voxel_size, __global uint * keys, __global int * ptrs, __global uint * brick_keys,
+ __global uint * count, const unsigned int max_bricks, const unsigned int buckets) {
+
+	size_t u = get_global_id(0);
+	size_t v = get_global_id(1);
+	size_t frame_width = get_global_size(0);
+
+	float d = src[v * frame_width + u];
+	if (isnan(d) || !(d > 0.0f)) return;
+
+	float3 ray;
+	ray.x = K_inv[0]*u + K_inv[1]*v + K_inv[2];
+	ray.y = K_inv[3]*u + K_inv[4]*v + K_inv[5];
+	ray.z = K_inv[6]*u + K_inv[7]*v + K_inv[8];
+
+	float brick_m = voxel_size * BRICK_SIZE;
+	float z_near = fmax(d - mu, 0.0f);
+	float z_far = d + mu;
+	// Sample at least twice per brick
+	float step = brick_m * 0.5f;
+	uint samples = (uint)ceil(((z_far - z_near) * length(ray)) / step) + 1U;
+
+	int3 prev = (int3)(INT_MAX, INT_MAX, INT_MAX);
+	for (uint i = 0; i <= samples; ++i) {
+
+		float z = mix(z_near, z_far, (float)i / (float)samples);
+		float3 c = ray * z;
+		float3 w;
+		w.x = T_g_k[0]*c.x + T_g_k[1]*c.y + T_g_k[2]*c.z + T_g_k[3];
+		w.y = T_g_k[4]*c.x + T_g_k[5]*c.y + T_g_k[6]*c.z + T_g_k[7];
+		w.z = T_g_k[8]*c.x + T_g_k[9]*c.y + T_g_k[10]*c.z + T_g_k[11];
+
+		float3 f = floor(w / brick_m);
+		int3 b = (int3)((int)f.x, (int)f.y, (int)f.z);
+		if (all(b == prev)) continue;
+		prev = b;
+		insert_brick(b, keys, ptrs, brick_keys, count, max_bricks, buckets);
+
+	}
+
+}
+
+
+/**
+ *	Params:
+ *
+ *	src - depth image
+ *	tsdf - TSDF value of each voxel of each brick in the pool
+ *	weight - weight of each voxel of each brick in the pool
+ *	brick_keys - the key of each brick in the pool
+ *	proj_view - world to camera transform (4x4)
+ *	K - camera matrix (3x3)
+ *	K_inv - inverse camera matrix (3x3)
+ *	mu - truncation distance
+ *	frame_width, frame_height - size of the depth image
+ *	voxel_size - edge length of a voxel in m
+ *
+ *	Launched with one work item per voxel of each allocated
+ *	brick, the update is that performed for the dense TSDF
+ *	(see tsdf.h)
+ */
+kernel void integrate_bricks(__global const float * src, __global half * tsdf, __global uchar * weight,
+ __global const uint * brick_keys, __global const float * proj_view, __global const float * K,
+ __global const float * K_inv, const float mu, const unsigned int frame_width, const unsigned int frame_height,
+ const float voxel_size) {
+
+	uint idx = get_global_id(0);
+	uint l = idx % BRICK_VOXELS;
+	int3 b = key_brick(brick_keys[idx / BRICK_VOXELS]);
+	int3 vox = (b * BRICK_SIZE) + (int3)(l % 8U, (l / 8U) % 8U, l / 64U);
+
+	float3 p = ((float3)(vox.x, vox.y, vox.z) + 0.5f) * voxel_size;
+	float3 cam;
+	cam.x = proj_view[0]*p.x + proj_view[1]*p.y + proj_view[2]*p.z + proj_view[3];
+	cam.y = proj_view[4]*p.x + proj_view[5]*p.y + proj_view[6]*p.z + proj_view[7];
+	cam.z = proj_view[8]*p.x + proj_view[9]*p.y + proj_view[10]*p.z + proj_view[11];
+
+	integrate(cam, idx, src, tsdf, K, K_inv, mu, frame_width, frame_height, weight, INFINITY);
+
+}
+
+
+/**
+ *	Retrieves the TSDF value of a voxel in the brick at
+ *	index p of the pool
+ */
+float brick_voxel_value(int p, int3 vox, __global const half * tsdf) {
+
+	// Two's complement makes this the voxel's position
+	// within its brick even for negative coordinates
+	int3 l = vox & (BRICK_SIZE - 1);
+	return vload_half(((uint)p * BRICK_VOXELS) + l.x + (l.y * 8) + (l.z * 64), tsdf);
+
+}
+
+
+/**
+ *	Retrieves the TSDF value of a voxel, voxels in bricks
+ *	which are not allocated have never been observed near
+ *	a surface and have the value of an empty voxel
+ */
+float voxel_value(int3 vox, __global const uint * keys, __global const int * ptrs,
+ __global const half * tsdf, uint buckets) {
+
+	int p = find_brick(brick_of(vox), keys, ptrs, buckets);
+	if (p < 0) return 1.0f;
+
+	return brick_voxel_value(p, vox, tsdf);
+
+}
+
+
+int3 world_voxel(float3 pos, float voxel_size) {
+
+	float3 f = floor(pos / voxel_size);
+	return (int3)((int)f.x, (int)f.y, (int)f.z);
+
+}
+
+
+float trilinear(float3 p, __global const uint * keys, __global const int * ptrs,
+ __global const half * tsdf, uint buckets, float voxel_size) {
+
+	// Position relative to the centers of the voxels
+	float3 g = (p / voxel_size) - 0.5f;
+	float3 f = floor(g);
+	int3 vox = (int3)((int)f.x, (int)f.y, (int)f.z);
+	float3 rs = g - f;
+
+	float c000 = voxel_value(vox, keys, ptrs, tsdf, buckets);
+	float c001 = voxel_value(vox + (int3)(0, 0, 1), keys, ptrs, tsdf, buckets);
+	float c010 = voxel_value(vox + (int3)(0, 1, 0), keys, ptrs, tsdf, buckets);
+	float c011 = voxel_value(vox + (int3)(0, 1, 1), keys, ptrs, tsdf, buckets);
+	float c100 = voxel_value(vox + (int3)(1, 0, 0), keys, ptrs, tsdf, buckets);
+	float c101 = voxel_value(vox + (int3)(1, 0, 1), keys, ptrs, tsdf, buckets);
+	float c110 = voxel_value(vox + (int3)(1, 1, 0), keys, ptrs, tsdf, buckets);
+	float c111 = voxel_value(vox + (int3)(1, 1, 1), keys, ptrs, tsdf, buckets);
+
+	return
+		c000 * (1 - rs.x) * (1 - rs.y) * (1 - rs.z) +
+		c001 * (1 - rs.x) * (1 - rs.y) * rs.z +
+		c010 * (1 - rs.x) * rs.y * (1 - rs.z) +
+		c011 * (1 - rs.x) * rs.y * rs.z +
+		c100 * rs.x * (1 - rs.y) * (1 - rs.z) +
+		c101 * rs.x * (1 - rs.y) * rs.z +
+		c110 * rs.x * rs.y * (1 - rs.z) +
+		c111 * rs.x * rs.y * rs.z;
+
+}
+
+
+/**
+ *	Determines the distance along a ray from a point to
+ *	where the ray leaves the brick containing that point
+ */
+float brick_exit(float3 pos, float3 dir, float brick_m) {
+
+	float3 lo = floor(pos / brick_m) * brick_m;
+	float3 hi = lo + brick_m;
+	float3 t = (float3)(INFINITY, INFINITY, INFINITY);
+	if (dir.x != 0.0f) t.x = ((dir.x > 0.0f ? hi.x : lo.x) - pos.x) / dir.x;
+	if (dir.y != 0.0f) t.y = ((dir.y > 0.0f ? hi.y : lo.y) - pos.y) / dir.y;
+	if (dir.z != 0.0f) t.z = ((dir.z > 0.0f ? hi.z : lo.z) - pos.z) / dir.z;
+
+	return fmin(t.x, fmin(t.y, t.z));
+
+}
+
+
+/**
+ *	Params:
+ *
+ *	keys, ptrs - hash table
+ *	tsdf - TSDF value of each voxel of each brick in the pool
+ *	map - map output (as for raycast.cl)
+ *	T_g_k - camera to world transform (4x4)
+ *	Kinv - inverse camera matrix (3x3)
+ *	voxel_size - edge length of a voxel in m
+ *	buckets - size of the hash table
+ *
+ *	As raycast in raycast.cl except that the ray skips
+ *	over bricks which are not allocated
+ */
+kernel void hashed_raycast(__global const uint * keys, __global const int * ptrs, __global const half * tsdf,
+ __global float * map, __global const float * T_g_k, __global const float * Kinv, const float voxel_size,
+ const unsigned int buckets) {
+
+	size_t u = get_global_id(0);
+	size_t frame_width = get_global_size(0);
+	size_t v = get_global_id(1);
+	size_t idx = ((v * frame_width) + u) * 2U;
+
+	float3 camera_pos = (float3)(T_g_k[3], T_g_k[7], T_g_k[11]);
+
+	float3 uv_sensor;
+	uv_sensor.x = Kinv[0]*u + Kinv[1]*v + Kinv[2];
+	uv_sensor.y = Kinv[3]*u + Kinv[4]*v + Kinv[5];
+	uv_sensor.z = Kinv[6]*u + Kinv[7]*v + Kinv[8];
+
+	float3 uv_world;
+	uv_world.x = T_g_k[0]*uv_sensor.x + T_g_k[1]*uv_sensor.y + T_g_k[2]*uv_sensor.z + T_g_k[3];
+	uv_world.y = T_g_k[4]*uv_sensor.x + T_g_k[5]*uv_sensor.y + T_g_k[6]*uv_sensor.z + T_g_k[7];
+	uv_world.z = T_g_k[8]*uv_sensor.x + T_g_k[9]*uv_sensor.y + T_g_k[10]*uv_sensor.z + T_g_k[11];
+
+	float3 ray_dir = fast_normalize(uv_world - camera_pos);
+	float3 initial_ray = camera_pos + KINECT_MIN_DIST * ray_dir;
+	float brick_m = voxel_size * BRICK_SIZE;
+
+	float tsdf_val = NAN;
+	float prev_dist = 0.0f;
+	for (float dist = 0.0f; dist < KINECT_MAX_DIST;) {
+
+		float3 where = initial_ray + (ray_dir * dist);
+		int3 vox = world_voxel(where, voxel_size);
+
+		int brick = find_brick(brick_of(vox), keys, ptrs, buckets);
+		if (brick < 0) {
+
+			// Nothing has been observed near a surface in this
+			// brick, continue from just past where the ray
+			// leaves it and forget the previous sample so that
+			// no sign change is detected across the gap
+			dist += fmax(brick_exit(where, ray_dir, brick_m), 0.0f) + STEP_SIZE;
+			tsdf_val = NAN;
+			continue;
+
+		}
+
+		float tsdf_val_prev = tsdf_val;
+		tsdf_val = brick_voxel_value(brick, vox, tsdf);
+		float last_dist = prev_dist;
+		prev_dist = dist;
+		dist += STEP_SIZE;
+
+		if (isnan(tsdf_val_prev)) continue;
+
+		int p = signbit(tsdf_val_prev);
+		int c = signbit(tsdf_val);
+		if (p == c) continue;
+
+		// Detect backface: From negative to positive
+		if (p) break;
+
+		float ftdt = trilinear(where, keys, ptrs, tsdf, buckets, voxel_size);
+		float3 last = initial_ray + (ray_dir * last_dist);
+		float ft = trilinear(last, keys, ptrs, tsdf, buckets, voxel_size);
+		float t_star = prev_dist - ((prev_dist - last_dist) * ft) / (ftdt - ft);
+
+		float3 vert = initial_ray + (ray_dir * t_star);
+		vstore3(vert, idx, map);
+
+		float3 n;
+		float3 dx = (float3)(voxel_size, 0.0f, 0.0f);
+		float3 dy = (float3)(0.0f, voxel_size, 0.0f);
+		float3 dz = (float3)(0.0f, 0.0f, voxel_size);
+		n.x = trilinear(vert + dx, keys, ptrs, tsdf, buckets, voxel_size) - trilinear(vert - dx, keys, ptrs, tsdf, buckets, voxel_size);
+		n.y = trilinear(vert + dy, keys, ptrs, tsdf, buckets, voxel_size) - trilinear(vert - dy, keys, ptrs, tsdf, buckets, voxel_size);
+		n.z = trilinear(vert + dz, keys, ptrs, tsdf, buckets, voxel_size) - trilinear(vert - dz, keys, ptrs, tsdf, buckets, voxel_size);
+
+		float3 nullv = (float3)(0, 0, 0);
+		vstore3(all(n == nullv) ? NAN : fast_normalize(n), idx + 1U, map);
+
+		return;
+
+	}
+
+	vstore3(NAN, idx, map);
+	vstore3(NAN, idx + 1U, map);
+
+}
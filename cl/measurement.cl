@@ -0,0 +1,174 @@
+#define SMALL_DEPTH (0.1f)
+
+#define TILE_WIDTH (16U)
+#define TILE_HEIGHT (16U)
+
+//  The filtered tile extends one pixel past the right and
+//  bottom of the output tile so that each normal may be
+//  computed from neighbours in the same work group
+#define FILTERED_WIDTH (TILE_WIDTH + 1U)
+#define FILTERED_HEIGHT (TILE_HEIGHT + 1U)
+
+float3 vertex(float depth, float x, float y, const __global float * K_inv) {
+
+    if (isnan(depth) || (depth <= SMALL_DEPTH)) return NAN;
+
+    // assume z = 1 -> homoegeneous coords
+    float v1 = K_inv[0]*x + K_inv[1]*y + K_inv[2];
+    float v2 = K_inv[3]*x + K_inv[4]*y + K_inv[5];
+    float v3 = K_inv[6]*x + K_inv[7]*y + K_inv[8];
+
+    return depth * (float3)(v1, v2, v3);
+
+}
+
+/**
+ *  Performs the measurement phase for a single level in one
+ *  pass: bilateral filtering (as bilateral_filter_tiled),
+ *  back projection (as vertex_map) and normal computation
+ *  (as normal_map)
+ *
+ *  Each work group (of TILE_WIDTH x TILE_HEIGHT work items)
+ *  stages the raw depth of its tile and apron in local memory,
+ *  filters a tile one pixel larger than its output in each
+ *  dimension into local memory, and then writes its vertices
+ *  and normals.  The filtered depth is only written to global
+ *  memory if it is requested (i.e. if it is needed to generate
+ *  further levels of a pyramid).
+ *
+ *  The global size must be rounded up to a multiple of the
+ *  tile size.
+ *
+ *  src - source image
+ *  map - vertex and normal map
+ *  filtered - filtered depth (only written if write_filtered
+ *  is non-zero)
+ *  spatial - spatial weights as for bilateral_filter_tiled
+ *  sigma_r_inv_sq - inverse square of std dev of gaussian for range kernel
+ *  width - width of src, map and filtered
+ *  height - height of src, map and filtered
+ *  window - as for bilateral_filter_tiled
+ *  K_inv - K^-1 (row major)
+ *  tile - local memory of (TILE_WIDTH + 2 * window) x
+ *  (TILE_HEIGHT + 2 * window) floats
+ *  filtered_tile - local memory of FILTERED_WIDTH x
+ *  FILTERED_HEIGHT floats
+ *  write_filtered - whether filtered should be written
+ */
+kernel void measurement(const __global float * src, __global float * map, __global float * filtered,
+    const __constant float * spatial, const float sigma_r_inv_sq,
+    const unsigned int width, const unsigned int height, const unsigned int window,
+    const __global float * K_inv, __local float * tile, __local float * filtered_tile,
+    const unsigned int write_filtered) {
+
+    unsigned int lx = (unsigned int)get_local_id(0);
+    unsigned int ly = (unsigned int)get_local_id(1);
+    unsigned int group_x = (unsigned int)get_group_id(0) * TILE_WIDTH;
+    unsigned int group_y = (unsigned int)get_group_id(1) * TILE_HEIGHT;
+    int origin_x = (int)group_x - (int)window;
+    int origin_y = (int)group_y - (int)window;
+    unsigned int tile_width = TILE_WIDTH + (2U * window);
+    unsigned int tile_height = TILE_HEIGHT + (2U * window);
+
+    // Pixels outside the image are never used (the window
+    // is clipped below) but clamping keeps reads in bounds
+    for (unsigned int j = ly; j < tile_height; j += TILE_HEIGHT) {
+        int sy = clamp(origin_y + (int)j, 0, (int)height - 1);
+        for (unsigned int i = lx; i < tile_width; i += TILE_WIDTH) {
+            int sx = clamp(origin_x + (int)i, 0, (int)width - 1);
+            tile[(j * tile_width) + i] = src[(sy * width) + sx];
+        }
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    unsigned int spatial_width = 2U * window;
+    for (unsigned int fy = ly; fy < FILTERED_HEIGHT; fy += TILE_HEIGHT) {
+        for (unsigned int fx = lx; fx < FILTERED_WIDTH; fx += TILE_WIDTH) {
+
+            unsigned int x = group_x + fx;
+            unsigned int y = group_y + fy;
+            if ((x >= width) || (y >= height)) {
+                filtered_tile[(fy * FILTERED_WIDTH) + fx] = NAN;
+                continue;
+            }
+
+            unsigned int start_x = 0;
+            if (x > window) start_x = x - window;
+            unsigned int start_y = 0;
+            if (y > window) start_y = y - window;
+            unsigned int end_x = x + window;
+            if (end_x > width) end_x = width;
+            unsigned int end_y = y + window;
+            if (end_y > height) end_y = height;
+
+            float summation = 0;
+            float W_p = 0;
+
+            float R_k_u = tile[((fy + window) * tile_width) + fx + window];
+
+            for (unsigned int j = start_y; j < end_y; j++) {
+
+                unsigned int tile_row = ((unsigned int)((int)j - origin_y)) * tile_width;
+                unsigned int spatial_row = (j + window - y) * spatial_width;
+
+                for (unsigned int i = start_x; i < end_x; i++) {
+
+                    float R_k_q = tile[tile_row + (unsigned int)((int)i - origin_x)];
+
+                    float range2 = (R_k_u - R_k_q) * (R_k_u - R_k_q);
+                    float weight = spatial[spatial_row + (i + window - x)] * native_exp(-range2 * sigma_r_inv_sq);
+
+                    summation += weight * R_k_q;
+                    W_p += weight;
+                }
+
+            }
+
+            filtered_tile[(fy * FILTERED_WIDTH) + fx] = summation / W_p;
+
+        }
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    unsigned int x = group_x + lx;
+    unsigned int y = group_y + ly;
+    if ((x >= width) || (y >= height)) return;
+    unsigned int idx = (y * width) + x;
+
+    float depth = filtered_tile[(ly * FILTERED_WIDTH) + lx];
+    if (write_filtered) filtered[idx] = depth;
+
+    float3 v = vertex(depth, (float)x, (float)y, K_inv);
+
+    float3 n;
+    if ((x >= width - 1U) || (y >= height - 1U)) {
+
+        n = NAN;
+
+    } else {
+
+        float3 V_k_u1_v = vertex(filtered_tile[(ly * FILTERED_WIDTH) + lx + 1U], (float)(x + 1U), (float)y, K_inv);
+        float3 V_k_u_v1 = vertex(filtered_tile[((ly + 1U) * FILTERED_WIDTH) + lx], (float)x, (float)(y + 1U), K_inv);
+
+        float3 u = V_k_u1_v - v;
+        float3 w = V_k_u_v1 - v;
+
+        float3 x_vec;
+
+        // compute V_k_u cross V_k_v
+        x_vec.x = u.y*w.z - u.z*w.y;
+        x_vec.y = u.z*w.x - u.x*w.z;
+        x_vec.z = u.x*w.y - u.y*w.x;
+
+        float l2_norm_x = sqrt(dot(x_vec,x_vec));
+
+        n = x_vec/l2_norm_x;
+
+    }
+
+    vstore3(v, idx * 2U, map);
+    vstore3(n, (idx * 2U) + 1U, map);
+
+}
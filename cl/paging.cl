@@ -0,0 +1,262 @@
+#include "tsdf.h"
+
+
+/**
+ *	A dense TSDF which is split into chunks of
+ *	chunk_size x chunk_size x chunk_size voxels of which
+ *	only some are resident in device memory
+ *
+ *	table - the slot in which each chunk is resident (or -1)
+ *	slot_chunks - the chunk resident in each slot (or -1)
+ *
+ *	Chunk (cx, cy, cz) has index cx + chunks_x*(cy + chunks_y*cz)
+ *	and voxel (lx, ly, lz) within a chunk resident in slot s
+ *	is at index s*chunk_size^3 + lx + chunk_size*(ly + chunk_size*lz)
+ *
+ *	Voxel i (along any axis) has its center at
+ *	(i + 0.5) * extent / size in world space as in the dense
+ *	TSDF
+ */
+
+
+/**
+ *	Params:
+ *
+ *	src - depth image
+ *	tsdf - TSDF value of each voxel of each slot
+ *	weight - weight of each voxel of each slot
+ *	slot_chunks - the chunk resident in each slot
+ *	proj_view - world to camera transform (4x4)
+ *	K - camera matrix (3x3)
+ *	K_inv - inverse camera matrix (3x3)
+ *	mu - truncation distance
+ *	frame_width, frame_height - size of the depth image
+ *	tsdf_width, tsdf_height, tsdf_depth - size of the TSDF in voxels
+ *	tsdf_extent_w, tsdf_extent_h, tsdf_extent_d - size of the TSDF in m
+ *	chunk_size - the number of voxels along each edge of a chunk
+ *	chunks_x, chunks_y - the number of chunks along the x and y axes
+ *	max_depth - voxels whose depth in camera space exceeds this are not updated
+ *
+ *	Launched with one work item per voxel of each slot, the
+ *	update is that performed for the dense TSDF (see tsdf.h)
+ */
+kernel void paged_integrate(__global const float * src, __global half * tsdf, __global uchar * weight,
+ __global const int * slot_chunks, __global const float * proj_view, __global const float * K,
+ __global const float * K_inv, const float mu, const unsigned int frame_width, const unsigned int frame_height,
+ const unsigned int tsdf_width, const unsigned int tsdf_height, const unsigned int tsdf_depth,
+ const float tsdf_extent_w, const float tsdf_extent_h, const float tsdf_extent_d,
+ const unsigned int chunk_size, const unsigned int chunks_x, const unsigned int chunks_y,
+ const float max_depth) {
+
+	uint idx = get_global_id(0);
+	uint chunk_voxels = chunk_size * chunk_size * chunk_size;
+	int chunk = slot_chunks[idx / chunk_voxels];
+	if (chunk < 0) return;
+
+	uint l = idx % chunk_voxels;
+	uint c = (uint)chunk;
+	uint x = ((c % chunks_x) * chunk_size) + (l % chunk_size);
+	uint y = (((c / chunks_x) % chunks_y) * chunk_size) + ((l / chunk_size) % chunk_size);
+	uint z = ((c / (chunks_x * chunks_y)) * chunk_size) + (l / (chunk_size * chunk_size));
+	// Chunks on the far faces of the volume may be partial
+	if (x >= tsdf_width || y >= tsdf_height || z >= tsdf_depth) return;
+
+	float3 p;
+	p.x = ((float)x + 0.5f) * tsdf_extent_w/tsdf_width;
+	p.y = ((float)y + 0.5f) * tsdf_extent_h/tsdf_height;
+	p.z = ((float)z + 0.5f) * tsdf_extent_d/tsdf_depth;
+
+	float3 cam;
+	cam.x = proj_view[0]*p.x + proj_view[1]*p.y + proj_view[2]*p.z + proj_view[3];
+	cam.y = proj_view[4]*p.x + proj_view[5]*p.y + proj_view[6]*p.z + proj_view[7];
+	cam.z = proj_view[8]*p.x + proj_view[9]*p.y + proj_view[10]*p.z + proj_view[11];
+
+	integrate(cam, idx, src, tsdf, K, K_inv, mu, frame_width, frame_height, weight, max_depth);
+
+}
+
+
+/**
+ *	Retrieves the TSDF value of a voxel which must be within
+ *	the volume, voxels in chunks which are not resident have
+ *	no known value
+ */
+float paged_value(int3 vox, __global const half * tsdf, __global const int * table,
+ uint chunk_size, uint chunks_x, uint chunks_y) {
+
+	uint3 v = convert_uint3(vox);
+	uint3 c = v / chunk_size;
+	int slot = table[c.x + chunks_x * (c.y + chunks_y * c.z)];
+	if (slot < 0) return NAN;
+
+	uint3 l = v % chunk_size;
+
+	return vload_half(((uint)slot * chunk_size * chunk_size * chunk_size) + l.x + chunk_size * (l.y + chunk_size * l.z), tsdf);
+
+}
+
+
+int3 paged_voxel(float3 pos, float3 voxel_size) {
+
+	float3 f = floor(pos / voxel_size);
+	return (int3)((int)f.x, (int)f.y, (int)f.z);
+
+}
+
+
+int paged_in_volume(int3 vox, int3 size, int border) {
+
+	return !(
+		(vox.x < border) || (vox.x >= (size.x - border)) ||
+		(vox.y < border) || (vox.y >= (size.y - border)) ||
+		(vox.z < border) || (vox.z >= (size.z - border))
+	);
+
+}
+
+
+float paged_trilinear(float3 p, __global const half * tsdf, __global const int * table,
+ float3 voxel_size, int3 size, uint chunk_size, uint chunks_x, uint chunks_y) {
+
+	int3 vox = paged_voxel(p, voxel_size);
+	if (!paged_in_volume(vox, size, 1)) return NAN;
+
+	// As raycast.cl
+	float3 vox_world = ((float3)(vox.x, vox.y, vox.z) + 0.5f) * voxel_size;
+	if (p.x < vox_world.x) --vox.x;
+	if (p.y < vox_world.y) --vox.y;
+	if (p.z < vox_world.z) --vox.z;
+	float3 rs = (p - vox_world) / voxel_size;
+
+	float c000 = paged_value(vox, tsdf, table, chunk_size, chunks_x, chunks_y);
+	float c001 = paged_value(vox + (int3)(0, 0, 1), tsdf, table, chunk_size, chunks_x, chunks_y);
+	float c010 = paged_value(vox + (int3)(0, 1, 0), tsdf, table, chunk_size, chunks_x, chunks_y);
+	float c011 = paged_value(vox + (int3)(0, 1, 1), tsdf, table, chunk_size, chunks_x, chunks_y);
+	float c100 = paged_value(vox + (int3)(1, 0, 0), tsdf, table, chunk_size, chunks_x, chunks_y);
+	float c101 = paged_value(vox + (int3)(1, 0, 1), tsdf, table, chunk_size, chunks_x, chunks_y);
+	float c110 = paged_value(vox + (int3)(1, 1, 0), tsdf, table, chunk_size, chunks_x, chunks_y);
+	float c111 = paged_value(vox + (int3)(1, 1, 1), tsdf, table, chunk_size, chunks_x, chunks_y);
+
+	return
+		c000 * (1 - rs.x) * (1 - rs.y) * (1 - rs.z) +
+		c001 * (1 - rs.x) * (1 - rs.y) * rs.z +
+		c010 * (1 - rs.x) * rs.y * (1 - rs.z) +
+		c011 * (1 - rs.x) * rs.y * rs.z +
+		c100 * rs.x * (1 - rs.y) * (1 - rs.z) +
+		c101 * rs.x * (1 - rs.y) * rs.z +
+		c110 * rs.x * rs.y * (1 - rs.z) +
+		c111 * rs.x * rs.y * rs.z;
+
+}
+
+
+/**
+ *	Params:
+ *
+ *	tsdf - TSDF value of each voxel of each slot
+ *	table - the slot in which each chunk is resident
+ *	map - map output (as for raycast.cl)
+ *	T_g_k - camera to world transform (4x4)
+ *	Kinv - inverse camera matrix (3x3)
+ *	tsdf_width, tsdf_height, tsdf_depth - size of the TSDF in voxels
+ *	tsdf_extent - size of the TSDF in m along each axis
+ *	chunk_size - the number of voxels along each edge of a chunk
+ *	chunks_x, chunks_y - the number of chunks along the x and y axes
+ *
+ *	As raycast in raycast.cl except that samples in chunks
+ *	which are not resident are skipped
+ */
+kernel void paged_raycast(__global const half * tsdf, __global const int * table, __global float * map,
+ __global const float * T_g_k, __global const float * Kinv,
+ const unsigned int tsdf_width, const unsigned int tsdf_height, const unsigned int tsdf_depth,
+ const float tsdf_extent, const unsigned int chunk_size, const unsigned int chunks_x, const unsigned int chunks_y) {
+
+	size_t u = get_global_id(0);
+	size_t frame_width = get_global_size(0);
+	size_t v = get_global_id(1);
+	size_t idx = ((v * frame_width) + u) * 2U;
+
+	int3 size = (int3)(tsdf_width, tsdf_height, tsdf_depth);
+	float3 voxel_size = (float3)(tsdf_extent / tsdf_width, tsdf_extent / tsdf_height, tsdf_extent / tsdf_depth);
+	float3 camera_pos = (float3)(T_g_k[3], T_g_k[7], T_g_k[11]);
+
+	float3 uv_sensor;
+	uv_sensor.x = Kinv[0]*u + Kinv[1]*v + Kinv[2];
+	uv_sensor.y = Kinv[3]*u + Kinv[4]*v + Kinv[5];
+	uv_sensor.z = Kinv[6]*u + Kinv[7]*v + Kinv[8];
+
+	float3 uv_world;
+	uv_world.x = T_g_k[0]*uv_sensor.x + T_g_k[1]*uv_sensor.y + T_g_k[2]*uv_sensor.z + T_g_k[3];
+	uv_world.y = T_g_k[4]*uv_sensor.x + T_g_k[5]*uv_sensor.y + T_g_k[6]*uv_sensor.z + T_g_k[7];
+	uv_world.z = T_g_k[8]*uv_sensor.x + T_g_k[9]*uv_sensor.y + T_g_k[10]*uv_sensor.z + T_g_k[11];
+
+	float3 ray_dir = fast_normalize(uv_world - camera_pos);
+	float3 initial_ray = camera_pos + KINECT_MIN_DIST * ray_dir;
+
+	int3 vox = paged_voxel(initial_ray, voxel_size);
+	if (!paged_in_volume(vox, size, 0)) {
+
+		vstore3(NAN, idx, map);
+		vstore3(NAN, idx + 1U, map);
+
+		return;
+
+	}
+	float tsdf_val = paged_value(vox, tsdf, table, chunk_size, chunks_x, chunks_y);
+	for (float dist = STEP_SIZE; dist < KINECT_MAX_DIST; dist += STEP_SIZE) {
+
+		float3 where = initial_ray + (ray_dir * dist);
+
+		float tsdf_val_prev = tsdf_val;
+		vox = paged_voxel(where, voxel_size);
+		if (!paged_in_volume(vox, size, 0)) break;
+		tsdf_val = paged_value(vox, tsdf, table, chunk_size, chunks_x, chunks_y);
+
+		if (isnan(tsdf_val)) continue;
+		if (isnan(tsdf_val_prev)) continue;
+
+		int p = signbit(tsdf_val_prev);
+		int c = signbit(tsdf_val);
+		if (p == c) continue;
+
+		// Detect backface: From negative to positive
+		if (p) break;
+
+		float ftdt = paged_trilinear(where, tsdf, table, voxel_size, size, chunk_size, chunks_x, chunks_y);
+		if (isnan(ftdt)) break;
+
+		float3 last = where - (ray_dir * STEP_SIZE);
+		float ft = paged_trilinear(last, tsdf, table, voxel_size, size, chunk_size, chunks_x, chunks_y);
+		if (isnan(ft)) break;
+
+		float t_star = dist - (STEP_SIZE * ft) / (ftdt - ft);
+
+		float3 vert = initial_ray + (ray_dir * t_star);
+		vstore3(vert, idx, map);
+
+		if (!paged_in_volume(paged_voxel(last, voxel_size), size, 2)) {
+
+			vstore3(NAN, idx + 1U, map);
+			return;
+
+		}
+
+		float3 n;
+		float3 dx = (float3)(voxel_size.x, 0.0f, 0.0f);
+		float3 dy = (float3)(0.0f, voxel_size.y, 0.0f);
+		float3 dz = (float3)(0.0f, 0.0f, voxel_size.z);
+		n.x = paged_trilinear(vert + dx, tsdf, table, voxel_size, size, chunk_size, chunks_x, chunks_y) - paged_trilinear(vert - dx, tsdf, table, voxel_size, size, chunk_size, chunks_x, chunks_y);
+		n.y = paged_trilinear(vert + dy, tsdf, table, voxel_size, size, chunk_size, chunks_x, chunks_y) - paged_trilinear(vert - dy, tsdf, table, voxel_size, size, chunk_size, chunks_x, chunks_y);
+		n.z = paged_trilinear(vert + dz, tsdf, table, voxel_size, size, chunk_size, chunks_x, chunks_y) - paged_trilinear(vert - dz, tsdf, table, voxel_size, size, chunk_size, chunks_x, chunks_y);
+
+		float3 nullv = (float3)(0, 0, 0);
+		vstore3(all(n == nullv) ? NAN : fast_normalize(n), idx + 1U, map);
+
+		return;
+
+	}
+
+	vstore3(NAN, idx, map);
+	vstore3(NAN, idx + 1U, map);
+
+}
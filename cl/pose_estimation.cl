@@ -1,4 +1,15 @@
-#define SIZEOF_MATS (27U)
+//	21 floats of A (upper triangle), 6 floats of b, and
+//	the number of correspondences
+#define SIZEOF_MATS (28U)
+#define MIN_CORRESPONDENCES (6.0f)
+#define STATUS_CONVERGED (0U)
+#define STATUS_ITERATIONS (1U)
+#define STATUS_FAILED (2U)
+
+
+#ifdef cl_khr_subgroups
+#pragma OPENCL EXTENSION cl_khr_subgroups : enable
+#endif
 
 
 float3 matrixmul3(const __constant float * m, float3 v) {
@@ -33,7 +44,7 @@ int is_finite(float3 v) {
 }
 
 
-void zero_ab (__local float * ms) {
+void zero_ab (float * ms) {
 
 	#pragma unroll
 	for (size_t i=0;i<SIZEOF_MATS;++i) ms[i]=0;
@@ -41,7 +52,15 @@ void zero_ab (__local float * ms) {
 }
 
 
-void icp (float3 p, float3 q, float3 n, __local float * ms) {
+void add_ab (float * acc, const float * ms) {
+
+	#pragma unroll
+	for (size_t i=0;i<SIZEOF_MATS;++i) acc[i]+=ms[i];
+
+}
+
+
+void icp (float3 p, float3 q, float3 n, float * ms) {
 
 	float3 c=cross(p,n);
 	float pqn=dot(p-q,n);
@@ -82,10 +101,13 @@ void icp (float3 p, float3 q, float3 n, __local float * ms) {
 	ms[25]=n.y*pqn;
 	ms[26]=n.z*pqn;
 
+	//	Counts correspondences
+	ms[27]=1;
+
 }
 
 
-void correspondences_impl(
+int correspondences_impl(
 	const __global float * map,
 	const __global float * prev_map,
 	const __constant float * t_frame_frame,
@@ -97,7 +119,7 @@ void correspondences_impl(
 	size_t y,
 	size_t width,
 	size_t height,
-	__local float * ms
+	float * ms
 ) {
 
 	size_t idx=(y*width)+x;
@@ -107,8 +129,7 @@ void correspondences_impl(
 	float3 curr_n=vload3(idx+1U,map);
 	if (!is_finite(curr_v) || !is_finite(curr_n)) {
 
-		zero_ab(ms);
-		return;
+		return 0;
 
 	}
 
@@ -123,8 +144,7 @@ void correspondences_impl(
 
 	if ((u.x<0) || (u.y<0) || (((size_t)u.x)>=width) || (((size_t)u.y)>=height)) {
 
-		zero_ab(ms);
-		return;
+		return 0;
 
 	}
 
@@ -137,8 +157,7 @@ void correspondences_impl(
 
 	if (!(is_finite(curr_pv) && is_finite(curr_pn))) {
 
-		zero_ab(ms);
-		return;
+		return 0;
 
 	}
 
@@ -148,8 +167,7 @@ void correspondences_impl(
 	float3 t_z_curr_v=(float3)(t_z_curr_v_homo.x,t_z_curr_v_homo.y,t_z_curr_v_homo.z);
 	if (fast_length(t_z_curr_v_homo_curr_pv_homo) > epsilon_d) {
 
-		zero_ab(ms);
-		return;
+		return 0;
 
 	}
 
@@ -169,13 +187,14 @@ void correspondences_impl(
 	float3 crzcncpn=cross(r_z_curr_n,curr_pn);
 	if (fast_length(crzcncpn) > epsilon_theta) {
 
-		zero_ab(ms);
-		return;
+		return 0;
 
 	}
 
 	icp(t_z_curr_v,curr_pv,curr_pn,ms);
 
+	return 1;
+
 }
 
 
@@ -186,18 +205,27 @@ void parallel_sum_impl(
 	__local float * lmats
 ) {
 
-	for (size_t stride=size/2U;stride>0;stride/=2U) {
+	//	Each step folds the upper half (rounded down) onto
+	//	the lower half so that size need not be a power of
+	//	two
+	for (size_t n=size;n>1U;) {
+
+		size_t half=(n+1U)/2U;
 
 		//	Wait for everything else to finish
 		barrier(CLK_LOCAL_MEM_FENCE);
 
 		//	Perform add if needed
-		if (l>=stride) continue;
+		if ((l<half) && ((l+half)<n)) {
 
-		local float * a=lmats+(l*SIZEOF_MATS);
-		const local float * b=lmats+((l+stride)*SIZEOF_MATS);
-		#pragma unroll
-		for (size_t i=0;i<SIZEOF_MATS;++i) a[i]+=b[i];
+			local float * a=lmats+(l*SIZEOF_MATS);
+			const local float * b=lmats+((l+half)*SIZEOF_MATS);
+			#pragma unroll
+			for (size_t i=0;i<SIZEOF_MATS;++i) a[i]+=b[i];
+
+		}
+
+		n=half;
 
 	}
 
@@ -209,6 +237,11 @@ void parallel_sum_impl(
 }
 
 
+//	Each work item accumulates the contributions of
+//	the pixels idx, idx+global size, idx+2*global size,
+//	... in registers, the work group then reduces those
+//	sums and writes out a single set of sums for the
+//	group (i.e. to mats+(group*SIZEOF_MATS))
 kernel void correspondences(
 	const __global float * map,	//	0
 	const __global float * prev_map,	//	1
@@ -220,62 +253,78 @@ kernel void correspondences(
 	unsigned int width,	//	7
 	unsigned int height,	//	8
 	__global float * mats,	//	9
-	__local float * lmats	//	10
+	__local float * lmats,	//	10
+	const __global unsigned int * status,	//	11
+	const __global unsigned int * samples,	//	12
+	unsigned int sampled,	//	13
+	const __global unsigned int * sample_count	//	14
 ) {
 
-	size_t idx=get_global_id(0);
-	size_t x=idx%width;
-	size_t y=idx/width;
-	size_t l=get_local_id(0);
-
-	correspondences_impl(
-		map,
-		prev_map,
-		t_frame_frame,
-		t_z,
-		epsilon_d,
-		epsilon_theta,
-		k,
-		x,
-		y,
-		width,
-		height,
-		lmats+(SIZEOF_MATS*l)
-	);
-
-	parallel_sum_impl(
-		l,
-		get_local_size(0),
-		mats+(get_group_id(0)*SIZEOF_MATS),
-		lmats
-	);
+	//	The solution has converged (see solve), this
+	//	is uniform across the work group so returning
+	//	before any barrier is safe
+	if (status[STATUS_CONVERGED]) return;
+
+	//	When sampled only those pixels whose indices appear
+	//	in samples are considered
+	size_t size=sampled ? *sample_count : (((size_t)width)*height);
+	size_t stride=get_global_size(0);
+
+	float acc [SIZEOF_MATS];
+	zero_ab(acc);
+	float ms [SIZEOF_MATS];
+	for (size_t i=get_global_id(0);i<size;i+=stride) {
+
+		size_t idx=sampled ? samples[i] : i;
+		size_t x=idx%width;
+		size_t y=idx/width;
+
+		if (correspondences_impl(
+			map,
+			prev_map,
+			t_frame_frame,
+			t_z,
+			epsilon_d,
+			epsilon_theta,
+			k,
+			x,
+			y,
+			width,
+			height,
+			ms
+		)) add_ab(acc,ms);
 
-}
+	}
 
+#ifdef cl_khr_subgroups
+	//	Reduce within each sub group without going through
+	//	local memory, then reduce across sub groups
+	#pragma unroll
+	for (size_t i=0;i<SIZEOF_MATS;++i) acc[i]=sub_group_reduce_add(acc[i]);
+	size_t l=get_sub_group_id();
+	size_t n=get_num_sub_groups();
+	if (get_sub_group_local_id()==0) {
 
-//	ASSUMPTION:
-//
-//	Local group size IS NOT ODD!!!!
-kernel void parallel_sum(
-	const __global float * src,	//	0
-	__global float * dest,	//	1
-	__local float * lmats	//	2
-) {
+		local float * sv=lmats+(l*SIZEOF_MATS);
+		#pragma unroll
+		for (size_t i=0;i<SIZEOF_MATS;++i) sv[i]=acc[i];
 
-	//	Get identifiers
-	size_t g=get_global_id(0);
+	}
+	//	Work items other than the first in each sub group
+	//	take no part in the reduction below
+	if (get_sub_group_local_id()!=0) l=n;
+#else
 	size_t l=get_local_id(0);
-
-	//	Load into local memory
-	const global float * ld=src+(g*SIZEOF_MATS);
+	size_t n=get_local_size(0);
 	local float * sv=lmats+(l*SIZEOF_MATS);
 	#pragma unroll
-	for (size_t i=0;i<SIZEOF_MATS;++i,++sv,++ld) *sv=*ld;
+	for (size_t i=0;i<SIZEOF_MATS;++i) sv[i]=acc[i];
+#endif
 
 	parallel_sum_impl(
 		l,
-		get_local_size(0),
-		dest+(get_group_id(0)*SIZEOF_MATS),
+		n,
+		mats+(get_group_id(0)*SIZEOF_MATS),
 		lmats
 	);
 
@@ -295,3 +344,140 @@ kernel void serial_sum(
 	mats[i]=sum;
 
 }
+
+
+
+//	Solves the linear system whose coefficients were
+//	summed by correspondences and serial_sum, applies the
+//	resulting incremental transformation to T_z, and
+//	computes T_frame_frame for the next iteration so that
+//	the host need not intervene between iterations
+//
+//	Launched with a single work item
+kernel void solve(
+	const __global float * mats,	//	0
+	__global float * t_z,	//	1
+	__global float * t_frame_frame,	//	2
+	const __constant float * t_gk_prev_inverse,	//	3
+	__global unsigned int * status,	//	4
+	float epsilon_rotation,	//	5
+	float epsilon_translation,	//	6
+	unsigned int force_px_px	//	7
+) {
+
+	if (status[STATUS_CONVERGED]) return;
+
+	//	Tracking has been lost
+	if (mats[27]<MIN_CORRESPONDENCES) {
+
+		status[STATUS_FAILED]=1U;
+		status[STATUS_CONVERGED]=1U;
+		return;
+
+	}
+
+	//	Unpack the upper triangle of A and b
+	float a [36];
+	size_t m=0;
+	for (size_t i=0;i<6U;++i) for (size_t j=i;j<6U;++j,++m) {
+
+		a[(i*6U)+j]=mats[m];
+		a[(j*6U)+i]=mats[m];
+
+	}
+	float x [6];
+	for (size_t i=0;i<6U;++i) x[i]=mats[21U+i];
+
+	//	LDL^T decomposition, A is symmetric positive
+	//	semidefinite so no pivoting is performed and
+	//	a non-positive pivot means A is singular
+	float l [36];
+	float d [6];
+	for (size_t j=0;j<6U;++j) {
+
+		float sum=a[(j*6U)+j];
+		for (size_t k=0;k<j;++k) sum-=l[(j*6U)+k]*l[(j*6U)+k]*d[k];
+		if (!(isfinite(sum) && (sum>0))) {
+
+			status[STATUS_CONVERGED]=1U;
+			return;
+
+		}
+		d[j]=sum;
+
+		for (size_t i=j+1U;i<6U;++i) {
+
+			sum=a[(i*6U)+j];
+			for (size_t k=0;k<j;++k) sum-=l[(i*6U)+k]*l[(j*6U)+k]*d[k];
+			l[(i*6U)+j]=sum/d[j];
+
+		}
+
+	}
+
+	//	Forward substitution, diagonal, then back
+	//	substitution
+	for (size_t i=0;i<6U;++i) for (size_t k=0;k<i;++k) x[i]-=l[(i*6U)+k]*x[k];
+	for (size_t i=0;i<6U;++i) x[i]/=d[i];
+	for (size_t n=0;n<6U;++n) {
+
+		size_t i=5U-n;
+		for (size_t k=i+1U;k<6U;++k) x[i]-=l[(k*6U)+i]*x[k];
+
+	}
+
+	float alpha=x[0];
+	float beta=x[1];
+	float gamma=x[2];
+	float tx=x[3];
+	float ty=x[4];
+	float tz=x[5];
+
+	float t_inc [16]={
+		1.0f, -gamma, beta, tx,
+		gamma, 1.0f, -alpha, ty,
+		-beta, alpha, 1.0f, tz,
+		0.0f, 0.0f, 0.0f, 1.0f
+	};
+
+	//	T_z=T_inc*T_z
+	float4 cols [4];
+	for (size_t j=0;j<4U;++j) cols[j]=(float4)(t_z[j],t_z[4U+j],t_z[8U+j],t_z[12U+j]);
+	for (size_t i=0;i<4U;++i) {
+
+		float4 row=vload4(i,t_inc);
+		float4 r=(float4)(dot(row,cols[0]),dot(row,cols[1]),dot(row,cols[2]),dot(row,cols[3]));
+		vstore4(r,i,t_z);
+
+	}
+
+	//	T_frame_frame=T_{g,k-1}^-1*T_z
+	for (size_t j=0;j<4U;++j) cols[j]=(float4)(t_z[j],t_z[4U+j],t_z[8U+j],t_z[12U+j]);
+	for (size_t i=0;i<4U;++i) {
+
+		float4 r;
+		if (force_px_px) {
+
+			r=(float4)(0,0,0,0);
+			if (i==0) r.x=1;
+			if (i==1) r.y=1;
+			if (i==2) r.z=1;
+			if (i==3) r.w=1;
+
+		} else {
+
+			float4 row=vload4(i,t_gk_prev_inverse);
+			r=(float4)(dot(row,cols[0]),dot(row,cols[1]),dot(row,cols[2]),dot(row,cols[3]));
+
+		}
+		vstore4(r,i,t_frame_frame);
+
+	}
+
+	++status[STATUS_ITERATIONS];
+
+	float3 rotation=(float3)(alpha,beta,gamma);
+	float3 translation=(float3)(tx,ty,tz);
+	if ((length(rotation)<epsilon_rotation) && (length(translation)<epsilon_translation)) status[STATUS_CONVERGED]=1U;
+
+}
@@ -0,0 +1,96 @@
+/**
+ *  Depth aware half sampling of a depth image
+ *
+ *  Each destination pixel is the average of those depths
+ *  in the corresponding 2x2 block of the source image
+ *  which lie within a threshold of the depth at the top
+ *  left of the block so that depth discontinuities are
+ *  not smoothed across
+ *
+ *  src - source image
+ *  dest - dest image (half the width and height of src)
+ *  src_width - width of src
+ *  threshold - maximum difference from the depth at the
+ *  top left of the block (3 sigma_r)
+ */
+kernel void half_sample(
+    const __global float * src, //  0
+    __global float * dest,  //  1
+    const unsigned int src_width,   //  2
+    const float threshold   //  3
+) {
+
+    size_t x = get_global_id(0);
+    size_t y = get_global_id(1);
+    size_t width = get_global_size(0);
+
+    size_t src_idx = (y * 2U * src_width) + (x * 2U);
+    float center = src[src_idx];
+
+    float sum = 0;
+    float count = 0;
+    for (size_t j = 0; j < 2U; ++j) {
+        for (size_t i = 0; i < 2U; ++i) {
+
+            float d = src[src_idx + (j * src_width) + i];
+            // NaN fails this comparison and is therefore skipped
+            if (fabs(d - center) <= threshold) {
+
+                sum += d;
+                count += 1;
+
+            }
+
+        }
+    }
+
+    dest[(y * width) + x] = (count == 0) ? NAN : (sum / count);
+
+}
+
+
+/**
+ *  Half samples a vertex and normal map
+ *
+ *  Each destination vertex and normal is the average of
+ *  those in the corresponding 2x2 block of the source map
+ *  with the normal renormalized, if any vertex or normal
+ *  in the block is invalid the result is invalid
+ *
+ *  src - source map
+ *  dest - dest map (half the width and height of src)
+ *  src_width - width of src
+ */
+kernel void half_sample_map(
+    const __global float * src, //  0
+    __global float * dest,  //  1
+    const unsigned int src_width    //  2
+) {
+
+    size_t x = get_global_id(0);
+    size_t y = get_global_id(1);
+    size_t width = get_global_size(0);
+
+    size_t src_idx = (y * 2U * src_width) + (x * 2U);
+
+    float3 v = 0;
+    float3 n = 0;
+    for (size_t j = 0; j < 2U; ++j) {
+        for (size_t i = 0; i < 2U; ++i) {
+
+            size_t idx = (src_idx + (j * src_width) + i) * 2U;
+            v += vload3(idx, src);
+            n += vload3(idx + 1U, src);
+
+        }
+    }
+
+    // NaN propagates through the sums and normalization
+    v /= 4.0f;
+    n = normalize(n);
+
+    size_t dest_idx = ((y * width) + x) * 2U;
+    vstore3(v, dest_idx, dest);
+    vstore3(n, dest_idx + 1U, dest);
+
+}
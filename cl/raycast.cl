@@ -1,19 +1,39 @@
-#define KINECT_MAX_DIST (8.0f)
-#define KINECT_MIN_DIST (0.4f)
-#define STEP_SIZE (0.0005f) // mu *0.8
-
-
-float getTsdfValue (const int3 vox, const __global half * tsdf, const size_t size) {
-
-    size_t offset = vox.x + vox.y * size + vox.z * size * size;
+#include "tsdf.h"
+
+
+//  Must agree with tsdf.cl
+#define BRICK_SIZE (8U)
+
+
+//  vox is relative to the origin and must be within the
+//  volume, wrap is the index along each axis at which the
+//  voxel at the origin is stored (see tsdf.cl)
+float getTsdfValue (const int3 vox, const __global voxel * tsdf, const int3 wrap, const size_t size) {
+
+    int3 s = vox + wrap;
+    int isize = size;
+    if (s.x >= isize) s.x -= isize;
+    if (s.y >= isize) s.y -= isize;
+    if (s.z >= isize) s.z -= isize;
+    size_t offset = s.x + s.y * size + s.z * size * size;
+#if VOXEL_FORMAT == 1
+    float val = (float)((short)(tsdf[offset] & 0xFFFFU)) / 32767.0f;
+#elif VOXEL_FORMAT == 2
+    float val = vload_half(2U * offset, (const __global half *)tsdf);
+#elif VOXEL_FORMAT == 3
+    float val = (float)tsdf[offset].x / 127.0f;
+#else
     float val = vload_half(offset, tsdf);
+#endif
 
     return val;
 
 }
 
 
-int3 getVoxel (const float3 pos, const float extent, const size_t size) {
+//  Obtains the voxel containing a position relative to the
+//  origin of the volume
+int3 getVoxel (const float3 pos, const int3 origin, const float extent, const size_t size) {
 
     float flt_size = size;
     float one_over_voxel_size = flt_size / extent;
@@ -21,7 +41,7 @@ int3 getVoxel (const float3 pos, const float extent, const size_t size) {
         floor(pos.x * one_over_voxel_size),
         floor(pos.y * one_over_voxel_size),
         floor(pos.z * one_over_voxel_size)
-    );
+    ) - origin;
 
 }
 
@@ -47,14 +67,14 @@ int isVoxelValid (const int3 vox, const size_t size) {
 }
 
 
-float triLerp (const float3 p, const __global float * tsdf, const float extent, const size_t size) {
+float triLerp (const float3 p, const __global voxel * tsdf, const int3 origin, const int3 wrap, const float extent, const size_t size) {
 
-    int3 vox = getVoxel(p, extent, size);
+    int3 vox = getVoxel(p, origin, extent, size);
     if (!isVoxelValidAndOffBorder(vox,size,1)) return NAN;
 
     float flt_size = size;
     float voxel_size = extent / flt_size;
-    float3 vox_flt = (float3)(vox.x, vox.y, vox.z);
+    float3 vox_flt = (float3)(vox.x + origin.x, vox.y + origin.y, vox.z + origin.z);
     float3 vox_world = (vox_flt + 0.5f) * voxel_size;
 
     if (p.x < vox_world.x) --vox.x;
@@ -76,14 +96,14 @@ float triLerp (const float3 p, const __global float * tsdf, const float extent,
     int3 v111 = (int3)(vox.x + 1, vox.y + 1, vox.z + 1);
 
     return
-        getTsdfValue(v000, tsdf, size) * (1 - rs.x) * (1 - rs.y) * (1 - rs.z) +
-        getTsdfValue(v001, tsdf, size) * (1 - rs.x) * (1 - rs.y) * rs.z +
-        getTsdfValue(v010, tsdf, size) * (1 - rs.x) * rs.y * (1 - rs.z) +
-        getTsdfValue(v011, tsdf, size) * (1 - rs.x) * rs.y * rs.z +
-        getTsdfValue(v100, tsdf, size) * rs.x * (1 - rs.y) * (1 - rs.z) +
-        getTsdfValue(v101, tsdf, size) * rs.x * (1 - rs.y) * rs.z +
-        getTsdfValue(v110, tsdf, size) * rs.x * rs.y * (1 - rs.z) +
-        getTsdfValue(v111, tsdf, size) * rs.x * rs.y * rs.z;
+        getTsdfValue(v000, tsdf, wrap, size) * (1 - rs.x) * (1 - rs.y) * (1 - rs.z) +
+        getTsdfValue(v001, tsdf, wrap, size) * (1 - rs.x) * (1 - rs.y) * rs.z +
+        getTsdfValue(v010, tsdf, wrap, size) * (1 - rs.x) * rs.y * (1 - rs.z) +
+        getTsdfValue(v011, tsdf, wrap, size) * (1 - rs.x) * rs.y * rs.z +
+        getTsdfValue(v100, tsdf, wrap, size) * rs.x * (1 - rs.y) * (1 - rs.z) +
+        getTsdfValue(v101, tsdf, wrap, size) * rs.x * (1 - rs.y) * rs.z +
+        getTsdfValue(v110, tsdf, wrap, size) * rs.x * rs.y * (1 - rs.z) +
+        getTsdfValue(v111, tsdf, wrap, size) * rs.x * rs.y * rs.z;
 
 }
 
@@ -98,16 +118,51 @@ float triLerp (const float3 p, const __global float * tsdf, const float extent,
  *  mu - The TSDF truncation distance
  *  extent - The extent, in meters, of the TSDF (assume square volume here)
  *  tsdf_size - The number of elements in a dimension of the TSDF (assume square volume here)
+ *  origin_x, origin_y, origin_z - The voxel coordinate of the first voxel of the TSDF
+ *  wrap_x, wrap_y, wrap_z - The index along each axis at which the first voxel is stored
+ *  max_step - The largest step (in meters) taken through free space
+ *  ranges - The minimum and maximum TSDF value of each brick (see tsdf.cl)
+ *  observed - Whether any voxel of each brick has been observed
+ *  skip_bricks - Nonzero if ranges and observed may be used to skip bricks
  *  frame_width - The width of the depth frame
+ *
+ *  Rays step by 0.8 * mu * the sampled TSDF value (clamped
+ *  to [STEP_SIZE, max_step]) so that steps are large far from
+ *  surfaces, a sign change found by a step larger than
+ *  STEP_SIZE is searched for again in STEP_SIZE steps so that
+ *  the surface is located exactly as by a fixed step march.
+ *  A max_step of STEP_SIZE gives a fixed step march.
+ *
+ *  Each ray is first clipped to the bounds of the volume
+ *  (by the slab method) and marched only where it lies
+ *  within the volume, so rays from a camera outside the
+ *  volume find surfaces within it.
+ *
+ *  A brick which has not been observed or which contains no
+ *  negative TSDF value cannot contain a surface, so when
+ *  skip_bricks is nonzero rays step straight out of such
+ *  bricks.  A sign change between the last sample in such a
+ *  brick and the first sample beyond it is searched for
+ *  again like any other found by a large step.
  */
  kernel void raycast(
-    const __global half * tsdf,    //  0
+    const __global voxel * tsdf,    //  0
     __global float * map,   //  1
     const __global float * T_g_k,   //  2
     const __global float * Kinv,    //  3
     const float mu, //  4
     const float extent, //  5
-    const unsigned int tsdf_size    //  6
+    const unsigned int tsdf_size,   //  6
+    const int origin_x, //  7
+    const int origin_y, //  8
+    const int origin_z, //  9
+    const int wrap_x,   //  10
+    const int wrap_y,   //  11
+    const int wrap_z,   //  12
+    const float max_step,   //  13
+    const __global float * ranges,  //  14
+    const __global uchar * observed,    //  15
+    const unsigned int skip_bricks  //  16
  ) {
 
 	size_t u = get_global_id(0);
@@ -116,6 +171,9 @@ float triLerp (const float3 p, const __global float * tsdf, const float extent,
     size_t idx = (v * frame_width) + u;
     idx *= 2U;
 
+    int3 origin = (int3)(origin_x, origin_y, origin_z);
+    int3 wrap = (int3)(wrap_x, wrap_y, wrap_z);
+
     //  This is where the camera is in world space
     float3 camera_pos = (float3)(T_g_k[3], T_g_k[7], T_g_k[11]);
 
@@ -141,16 +199,35 @@ float triLerp (const float3 p, const __global float * tsdf, const float extent,
     //  handle that?
     float3 ray_dir = fast_normalize(uv_world - camera_pos);
 
+    float flt_size = tsdf_size;
+    float cell_size = extent / flt_size;
+
+    //  Intersect the ray with each pair of planes bounding
+    //  the volume, division by a zero component of the
+    //  direction gives infinities which fmin and fmax handle
+    float3 lo = convert_float3(origin) * cell_size;
+    float3 hi = convert_float3(origin + (int3)((int)tsdf_size)) * cell_size;
+    float3 inv_dir = 1.0f / ray_dir;
+    float3 t0 = (lo - camera_pos) * inv_dir;
+    float3 t1 = (hi - camera_pos) * inv_dir;
+    float3 t_min = fmin(t0, t1);
+    float3 t_max = fmax(t0, t1);
+    //  The bounds are pulled in slightly so rounding does not
+    //  place the first or last sample outside the volume
+    float epsilon = cell_size * 0.01f;
+    float t_enter = fmax(KINECT_MIN_DIST, fmax(fmax(t_min.x, t_min.y), t_min.z) + epsilon);
+    float t_exit = fmin(KINECT_MAX_DIST, fmin(fmin(t_max.x, t_max.y), t_max.z) - epsilon);
+
     //  This gives us the position from which we will begin
-    //  our search (i.e. this position is on the near plane)
-    float3 initial_ray = camera_pos + KINECT_MIN_DIST * ray_dir;
+    //  our search (i.e. where the ray enters the volume or
+    //  the near plane, whichever is further)
+    float3 initial_ray = camera_pos + t_enter * ray_dir;
 
-    //  We trace the ray by starting on the near plane (see
-    //  above) and stepping in STEP_SIZE increments until
-    //  we find a surface intersection or until we exit the
-    //  TSDF volume
-    int3 vox = getVoxel(initial_ray, extent, tsdf_size);
-    if (!isVoxelValid(vox, tsdf_size)) {
+    //  We trace the ray by starting at the above position
+    //  and stepping until we find a surface intersection or
+    //  until we exit the TSDF volume
+    int3 vox = getVoxel(initial_ray, origin, extent, tsdf_size);
+    if (!(t_enter < t_exit) || !isVoxelValid(vox, tsdf_size)) {
 
         vstore3(NAN, idx, map);
         vstore3(NAN, idx + 1U, map);
@@ -158,20 +235,56 @@ float triLerp (const float3 p, const __global float * tsdf, const float extent,
         return;
 
     }
-    float tsdf_val = getTsdfValue(vox, tsdf, tsdf_size);
-    float flt_size = tsdf_size;
-    float cell_size = extent / flt_size;
+    float tsdf_val = getTsdfValue(vox, tsdf, wrap, tsdf_size);
+    float span = t_exit - t_enter;
+    //  Steps up to this distance are STEP_SIZE (see below)
+    float fine_until = 0.0f;
+    float step = STEP_SIZE;
     //  We have to start STEP_SIZE away because we need
     //  two samples to detect a sign change
-    for (float dist = STEP_SIZE; dist < KINECT_MAX_DIST; dist += STEP_SIZE) {
+    for (float dist = STEP_SIZE; dist < span; dist += step) {
 
         float3 where = initial_ray + (ray_dir * dist);
 
         //  Get current TSDF value
         float tsdf_val_prev = tsdf_val;
-        vox = getVoxel(where, extent, tsdf_size);
+        vox = getVoxel(where, origin, extent, tsdf_size);
         if (!isVoxelValid(vox, tsdf_size)) break;
-        tsdf_val = getTsdfValue(vox, tsdf, tsdf_size);
+        tsdf_val = getTsdfValue(vox, tsdf, wrap, tsdf_size);
+
+        //  The TSDF value bounds the distance to the surface so
+        //  we may skip through free space
+        float taken = step;
+        step = (isnan(tsdf_val) || (dist < fine_until)) ? STEP_SIZE : clamp(0.8f * mu * tsdf_val, STEP_SIZE, max_step);
+
+        //  Bricks are found by where their voxels are stored
+        //  (as in getTsdfValue), those voxels are contiguous
+        //  relative to the origin except where the volume
+        //  wraps around, which is outside the volume
+        if (skip_bricks && !(dist < fine_until)) {
+
+            int isize = tsdf_size;
+            int3 s = vox + wrap;
+            if (s.x >= isize) s.x -= isize;
+            if (s.y >= isize) s.y -= isize;
+            if (s.z >= isize) s.z -= isize;
+            int3 b = s / (int)BRICK_SIZE;
+            int bricks = (tsdf_size + BRICK_SIZE - 1U) / BRICK_SIZE;
+            int b_idx = b.x + bricks * (b.y + bricks * b.z);
+            float2 range = vload2(b_idx, ranges);
+            if (!observed[b_idx] || (range.x > 0.0f)) {
+
+                int3 first = vox - (s - (b * (int)BRICK_SIZE));
+                int3 last = first + min((int3)((int)BRICK_SIZE), (int3)(isize) - (b * (int)BRICK_SIZE));
+                float3 b0 = (convert_float3(origin + first) * cell_size - camera_pos) * inv_dir;
+                float3 b1 = (convert_float3(origin + last) * cell_size - camera_pos) * inv_dir;
+                float3 b_max = fmax(b0, b1);
+                float out = fmin(fmin(b_max.x, b_max.y), b_max.z) + epsilon - t_enter;
+                step = fmax(step, out - dist);
+
+            }
+
+        }
 
         if (isnan(tsdf_val)) continue;
         if (isnan(tsdf_val_prev)) continue;
@@ -183,13 +296,25 @@ float triLerp (const float3 p, const __global float * tsdf, const float extent,
         //  Detect backface: From negative to positive
         if (p) break;
 
+        //  The sign change was found by a large step, go
+        //  back and find it again in STEP_SIZE steps
+        if (taken > STEP_SIZE) {
+
+            fine_until = dist;
+            dist -= taken;
+            tsdf_val = tsdf_val_prev;
+            step = STEP_SIZE;
+            continue;
+
+        }
+
         //  Good sign change
 
-        float ftdt = triLerp(where, tsdf, extent, tsdf_size);
+        float ftdt = triLerp(where, tsdf, origin, wrap, extent, tsdf_size);
         if (isnan(ftdt)) break;
 
         float3 last = where - (ray_dir * STEP_SIZE);
-        float ft = triLerp(last, tsdf, extent, tsdf_size);
+        float ft = triLerp(last, tsdf, origin, wrap, extent, tsdf_size);
         if (isnan(ft)) break;
 
         float t_star = dist - (STEP_SIZE * ft) / (ftdt - ft);
@@ -199,7 +324,7 @@ float triLerp (const float3 p, const __global float * tsdf, const float extent,
         vstore3(v, idx, map);
 
         //  Check to see if we can even compute a normal
-        if (!isVoxelValidAndOffBorder(getVoxel(last, extent, tsdf_size), tsdf_size, 2)) {
+        if (!isVoxelValidAndOffBorder(getVoxel(last, origin, extent, tsdf_size), tsdf_size, 2)) {
 
             vstore3(NAN, idx + 1U, map);
             return;
@@ -210,24 +335,24 @@ float triLerp (const float3 p, const __global float * tsdf, const float extent,
         //  along all three axes
         float3 t = v;
         t.x += cell_size;
-        float fx1 = triLerp(t, tsdf, extent, tsdf_size);
+        float fx1 = triLerp(t, tsdf, origin, wrap, extent, tsdf_size);
         t = v;
         t.x -= cell_size;
-        float fx2 = triLerp(t, tsdf, extent, tsdf_size);
+        float fx2 = triLerp(t, tsdf, origin, wrap, extent, tsdf_size);
 
         t = v;
         t.y += cell_size;
-        float fy1 = triLerp(t, tsdf, extent, tsdf_size);
+        float fy1 = triLerp(t, tsdf, origin, wrap, extent, tsdf_size);
         t = v;
         t.y -= cell_size;
-        float fy2 = triLerp(t, tsdf, extent, tsdf_size);
+        float fy2 = triLerp(t, tsdf, origin, wrap, extent, tsdf_size);
 
         t = v;
         t.z += cell_size;
-        float fz1 = triLerp(t, tsdf, extent, tsdf_size);
+        float fz1 = triLerp(t, tsdf, origin, wrap, extent, tsdf_size);
         t = v;
         t.z -= cell_size;
-        float fz2 = triLerp(t, tsdf, extent, tsdf_size);
+        float fz2 = triLerp(t, tsdf, origin, wrap, extent, tsdf_size);
 
         //  We only store the normal if it's not the null vector
         //  otherwise we store NaN
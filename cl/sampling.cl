@@ -0,0 +1,92 @@
+#define NORMAL_SPACE_BUCKETS (64U)
+
+
+int is_valid(float3 v, float3 n) {
+
+	return isfinite(v.x) && isfinite(v.y) && isfinite(v.z) &&
+		isfinite(n.x) && isfinite(n.y) && isfinite(n.z);
+
+}
+
+
+//	Must match kinfu::normal_space_bucket
+size_t quantize(float c) {
+
+	int retr=(int)((c+1.0f)*2.0f);
+	return (size_t)clamp(retr,0,3);
+
+}
+
+
+size_t normal_space_bucket(float3 n) {
+
+	return quantize(n.x)+(4U*quantize(n.y))+(16U*quantize(n.z));
+
+}
+
+
+//	Thomas Wang's integer hash
+unsigned int hash(unsigned int x) {
+
+	x=(x^61U)^(x>>16U);
+	x*=9U;
+	x^=x>>4U;
+	x*=0x27d4eb2dU;
+	x^=x>>15U;
+
+	return x;
+
+}
+
+
+//	Counts the valid pixels whose normals fall into
+//	each bucket
+//
+//	histogram must be zeroed beforehand
+kernel void normal_space_histogram(
+	const __global float * map,	//	0
+	__global unsigned int * histogram	//	1
+) {
+
+	size_t i=get_global_id(0);
+	float3 v=vload3(i*2U,map);
+	float3 n=vload3((i*2U)+1U,map);
+	if (!is_valid(v,n)) return;
+
+	atomic_inc(histogram+normal_space_bucket(n));
+
+}
+
+
+//	Selects each valid pixel with a probability such
+//	that the expected number of pixels selected from
+//	each non-empty bucket is the same (save for those
+//	buckets which contain too few pixels), appending
+//	the indices of the selected pixels to samples
+//
+//	count must be zeroed beforehand
+kernel void normal_space_select(
+	const __global float * map,	//	0
+	const __global unsigned int * histogram,	//	1
+	__global unsigned int * samples,	//	2
+	__global unsigned int * count,	//	3
+	unsigned int target,	//	4
+	unsigned int seed	//	5
+) {
+
+	size_t i=get_global_id(0);
+	float3 v=vload3(i*2U,map);
+	float3 n=vload3((i*2U)+1U,map);
+	if (!is_valid(v,n)) return;
+
+	unsigned int nonempty=0;
+	for (size_t b=0;b<NORMAL_SPACE_BUCKETS;++b) if (histogram[b]!=0) ++nonempty;
+
+	float per_bucket=((float)target)/nonempty;
+	float p=per_bucket/histogram[normal_space_bucket(n)];
+	float r=(hash(((unsigned int)i)^seed)&0xFFFFFFU)/16777216.0f;
+	if (r>=p) return;
+
+	samples[atomic_inc(count)]=(unsigned int)i;
+
+}
@@ -1,8 +1,29 @@
+#include "tsdf.h"
+
+
 #define l2_norm(t) \
 	( sqrt(t.x*t.x + t.y*t.y + t.z*t.z) )
 
 
-#define MAX_WEIGHT ((uchar)254U)
+/**
+ *	The volume is addressed modulo its size so that it may
+ *	be moved by changing its origin (the voxel coordinate of
+ *	its first voxel) without moving any voxels
+ *
+ *	Determines the index along one axis at which the voxel
+ *	i voxels past the origin along that axis is stored
+ */
+unsigned int wrap(int origin, unsigned int i, unsigned int size) {
+
+	int o = origin % (int)size;
+	if (o < 0) o += size;
+	unsigned int retr = (unsigned int)o + i;
+
+	return (retr >= size) ? (retr - size) : retr;
+
+}
+
+
 /**
  *	Params:
  *
@@ -17,43 +38,48 @@
  *	frame_width - width of depth image (for indexing)
  *	frame_height - height of depth image (for indexing)
  *	tsdf_extent_w,h,d - tsdf_extent in m in w,h,d directions
+ *	weight - the weight of each voxel (unused unless weights are stored separately)
+ *	max_depth - voxels whose depth in camera space exceeds this are not updated
+ *	origin_x, origin_y, origin_z - the voxel coordinate of the first voxel of the volume
+ *
+ *	The launch may be restricted to a sub-volume via a global offset
+ *	(relative to the origin)
+ *
+ *	The TSDF must have been cleared (i.e. each voxel has a
+ *	value of 1 and a weight of 0) before the first frame is
+ *	integrated
  *
  */
-kernel void tsdf_kernel(__global float * src, __global half * dest, 
+kernel void tsdf_kernel(__global float * src, __global voxel * dest, 
  const unsigned int tsdf_width, const unsigned int tsdf_height, const unsigned int tsdf_depth,
  __global const float* proj_view, __global const float* K, __global const float* K_inv, 
  __global const float* t_gk, const float mu, const unsigned int frame_width, const unsigned int frame_height, 
- const float tsdf_extent_w, const float tsdf_extent_h, const float tsdf_extent_d, const unsigned int n,
- __global unsigned char * weight) {
+ const float tsdf_extent_w, const float tsdf_extent_h, const float tsdf_extent_d,
+ __global unsigned char * weight, const float max_depth,
+ const int origin_x, const int origin_y, const int origin_z) {
 
 
- 	// get the x, y, z of the current voxel from memory
+ 	// get the x, y, z of the current voxel relative to the origin
 	unsigned int x = get_global_id(0);
 	unsigned int y = get_global_id(1);
 	unsigned int z = get_global_id(2);
 
-	// Determine the linear index using the x,y,z components
-	// From http://stackoverflow.com/questions/10903149/how-do-i-compute-the-linear-index-of-a-3d-coordinate-and-vice-versa
-	unsigned int idx = x + (tsdf_width)*y + ((tsdf_width) * (tsdf_height))*z;
-
-
-	if (n==0) {
-		vstore_half(1.0f, idx, dest);
-		weight[idx] = 0;
-	}
-
 	// OOB
-	if (x > tsdf_width || y > tsdf_height || z > tsdf_depth ) {
+	if (x >= tsdf_width || y >= tsdf_height || z >= tsdf_depth ) {
 
 		 return;
 	} 	
 
+	// Determine the linear index using the x,y,z components
+	// From http://stackoverflow.com/questions/10903149/how-do-i-compute-the-linear-index-of-a-3d-coordinate-and-vice-versa
+	unsigned int idx = wrap(origin_x, x, tsdf_width) + (tsdf_width)*wrap(origin_y, y, tsdf_height) + ((tsdf_width) * (tsdf_height))*wrap(origin_z, z, tsdf_depth);
+
 	// x,y,z give the voxel id, but we need to compute the position in 3D space.
 
 	// Compute the world coordinates of the center of this voxel
-	float p_x = ((float)x + 0.5) * tsdf_extent_w/tsdf_width;
-	float p_y = ((float)y + 0.5) * tsdf_extent_h/tsdf_height;
-	float p_z = ((float)z + 0.5) * tsdf_extent_d/tsdf_depth;
+	float p_x = ((float)(origin_x + (int)x) + 0.5) * tsdf_extent_w/tsdf_width;
+	float p_y = ((float)(origin_y + (int)y) + 0.5) * tsdf_extent_h/tsdf_height;
+	float p_z = ((float)(origin_z + (int)z) + 0.5) * tsdf_extent_d/tsdf_depth;
 	float4 p = (float4)(p_x, p_y, p_z, 1);
 
 	// Multiplying by T_g_k.inverse() here. This takes us to camera space.
@@ -62,63 +88,150 @@ kernel void tsdf_kernel(__global float * src, __global half * dest,
 	cam.y = proj_view[4]*p.x + proj_view[5]*p.y + proj_view[6]*p.z + proj_view[7]*p.w;
 	cam.z = proj_view[8]*p.x + proj_view[9]*p.y + proj_view[10]*p.z + proj_view[11]*p.w;
 
-	float3 plane;
-	plane.x = cam.x * K[0] + cam.y * K[1] + cam.z * K[2];
-	plane.y = cam.x * K[3] + cam.y * K[4] + cam.z * K[5];
-	plane.z = cam.x * K[6] + cam.y * K[7] + cam.z * K[8];
+	integrate(cam, idx, src, dest, K, K_inv, mu, frame_width, frame_height, weight, max_depth);
+}
 
-	float2 uv;
-	uv.x = plane.x / plane.z;
-	uv.y = plane.y / plane.z;
 
-	// take nearest neighbour in image
-	int2 x_tild;
-	x_tild.x = round(uv.x);
-	x_tild.y = round(uv.y);
+/**
+ *	As tsdf_kernel except that each work item updates a
+ *	column of voxels (i.e. all voxels with a certain x and
+ *	y) in [z_begin, z_end)
+ *
+ *	Moving one voxel along z moves the voxel by a constant
+ *	step in camera space, so the world to camera transform
+ *	is performed once per column and each subsequent voxel
+ *	is obtained with a single multiply-add
+ *
+ *	The launch is two dimensional and may be restricted to
+ *	a sub-volume in x and y via a global offset
+ */
+kernel void tsdf_sweep_kernel(__global float * src, __global voxel * dest,
+ const unsigned int tsdf_width, const unsigned int tsdf_height, const unsigned int tsdf_depth,
+ __global const float* proj_view, __global const float* K, __global const float* K_inv,
+ __global const float* t_gk, const float mu, const unsigned int frame_width, const unsigned int frame_height,
+ const float tsdf_extent_w, const float tsdf_extent_h, const float tsdf_extent_d,
+ __global unsigned char * weight, const float max_depth,
+ const int origin_x, const int origin_y, const int origin_z,
+ const unsigned int z_begin, const unsigned int z_end) {
 
-	// check if the current voxel projects into the depth frame
-	if (x_tild.x < 0 || x_tild.x >= frame_width || x_tild.y < 0 || x_tild.y >= frame_height || plane.z < 0.0f) {
+	unsigned int x = get_global_id(0);
+	unsigned int y = get_global_id(1);
 
-		return;
+	if (x >= tsdf_width || y >= tsdf_height) return;
 
-	}
+	// World coordinates of the center of the first voxel
+	// of this column
+	float p_x = ((float)(origin_x + (int)x) + 0.5f) * tsdf_extent_w/tsdf_width;
+	float p_y = ((float)(origin_y + (int)y) + 0.5f) * tsdf_extent_h/tsdf_height;
+	float p_z = ((float)(origin_z + (int)z_begin) + 0.5f) * tsdf_extent_d/tsdf_depth;
+
+	float3 base;
+	base.x = proj_view[0]*p_x + proj_view[1]*p_y + proj_view[2]*p_z + proj_view[3];
+	base.y = proj_view[4]*p_x + proj_view[5]*p_y + proj_view[6]*p_z + proj_view[7];
+	base.z = proj_view[8]*p_x + proj_view[9]*p_y + proj_view[10]*p_z + proj_view[11];
+
+	// The step in camera space for one voxel along z
+	float voxel_d = tsdf_extent_d/tsdf_depth;
+	float3 step = (float3)(proj_view[2], proj_view[6], proj_view[10]) * voxel_d;
 
-	float v = src[x_tild.y * frame_width + x_tild.x];
-	float3 pix = (float3)(x_tild.x, x_tild.y, 1.0f);
-	float3 pix_k_inv;
-	pix_k_inv.x = dot ((float3)(K_inv[0], K_inv[1], K_inv[2]), pix);
-	pix_k_inv.y = dot ((float3)(K_inv[3], K_inv[4], K_inv[5]), pix);
-	pix_k_inv.z = dot ((float3)(K_inv[6], K_inv[7], K_inv[8]), pix);
-	pix_k_inv *= v;
+	unsigned int slice = tsdf_width * tsdf_height;
+	unsigned int column = wrap(origin_x, x, tsdf_width) + tsdf_width*wrap(origin_y, y, tsdf_height);
+	unsigned int zs = wrap(origin_z, z_begin, tsdf_depth);
+	for (unsigned int z = z_begin; z < z_end; ++z) {
 
-	float to_measurement = sqrt(dot(pix_k_inv, pix_k_inv));
-	float to_voxel = sqrt(dot(cam, cam));
+		float3 cam = mad((float3)((float)(z - z_begin)), step, base);
+		integrate(cam, column + slice*zs, src, dest, K, K_inv, mu, frame_width, frame_height, weight, max_depth);
+		if (++zs == tsdf_depth) zs = 0;
 
-	float sdf = to_measurement - to_voxel;
+	}
+
+}
 
-	if (sdf >= -mu) {
 
-		float tsdf = fmin(1.0f, sdf/mu);
+/**
+ *	Params:
+ *
+ *	dest - allocated TSDF volume
+ *	weight - the weight of each voxel (unused unless weights are stored separately)
+ *	out - receives the voxels of the box, densely packed
+ *	tsdf_width, tsdf_height, tsdf_depth - size params of TSDF
+ *	box_x, box_y, box_z - the voxel coordinate of the first voxel of the box
+ *
+ *	Launched over the size of a box of voxels within the
+ *	volume, copies each voxel to out and then clears it
+ *	(i.e. gives it a value of 1 and a weight of 0) so that
+ *	the storage may be reused for voxels which enter the
+ *	volume when it moves
+ */
+kernel void evict_kernel(__global voxel * dest, __global unsigned char * weight, __global voxel * out,
+ const unsigned int tsdf_width, const unsigned int tsdf_height, const unsigned int tsdf_depth,
+ const int box_x, const int box_y, const int box_z) {
 
-		if (isnan(tsdf)) return;
+	unsigned int x = get_global_id(0);
+	unsigned int y = get_global_id(1);
+	unsigned int z = get_global_id(2);
 
-		float prev_tsdf = vload_half(idx, dest);
+	unsigned int idx = wrap(box_x, x, tsdf_width) + tsdf_width*(wrap(box_y, y, tsdf_height) + tsdf_height*wrap(box_z, z, tsdf_depth));
+	unsigned int o = x + get_global_size(0)*(y + get_global_size(1)*z);
+#if (VOXEL_FORMAT == 1) || (VOXEL_FORMAT == 2) || (VOXEL_FORMAT == 3)
+	out[o] = dest[idx];
+#else
+	vstore_half(vload_half(idx, dest), o, out);
+#endif
+	store_voxel(dest, weight, idx, 1.0f, 0U);
 
-		if (isnan(prev_tsdf)) prev_tsdf = 0;
+}
 
-		uchar prev_weight = weight[idx];
 
-		// if we haven't had a valid measurement, 
-		// then the prev_tsdf is NAN and prev_weight = 0
-		uchar new_weight = min(MAX_WEIGHT, prev_weight);
-		++new_weight;
+//  Must agree with tsdf_brick_size in
+//  include/kinfu/opencl_voxel_pipeline_value.hpp
+#define BRICK_SIZE (8U)
 
-		weight[idx] = new_weight;
 
-		float new_tsdf = (prev_tsdf * prev_weight + tsdf * new_weight) / (prev_weight + new_weight);
-		vstore_half(new_tsdf, idx, dest);
+/**
+ *	Params:
+ *
+ *	dest - TSDF volume
+ *	weight - the weight of each voxel (unused unless weights are stored separately)
+ *	ranges - the minimum and maximum TSDF value of each brick
+ *	observed - whether any voxel of each brick has a nonzero weight
+ *	tsdf_width, tsdf_height, tsdf_depth - size params of TSDF
+ *
+ *	Launched over bricks of BRICK_SIZE x BRICK_SIZE x BRICK_SIZE
+ *	voxels (which may be restricted via a global offset),
+ *	summarizes each brick.  Bricks are indexed by where their
+ *	voxels are stored (rather than by voxel coordinate) so
+ *	moving the volume does not move them, bricks on the far
+ *	faces of the volume may be partial
+ */
+kernel void summarize_kernel(__global voxel * dest, __global unsigned char * weight,
+ __global float * ranges, __global uchar * observed,
+ const unsigned int tsdf_width, const unsigned int tsdf_height, const unsigned int tsdf_depth) {
+
+	unsigned int bx = get_global_id(0);
+	unsigned int by = get_global_id(1);
+	unsigned int bz = get_global_id(2);
+	unsigned int bricks_x = (tsdf_width + BRICK_SIZE - 1U) / BRICK_SIZE;
+	unsigned int bricks_y = (tsdf_height + BRICK_SIZE - 1U) / BRICK_SIZE;
+
+	float lo = INFINITY;
+	float hi = -INFINITY;
+	uint seen = 0U;
+	unsigned int x_end = min(tsdf_width, (bx + 1U) * BRICK_SIZE);
+	unsigned int y_end = min(tsdf_height, (by + 1U) * BRICK_SIZE);
+	unsigned int z_end = min(tsdf_depth, (bz + 1U) * BRICK_SIZE);
+	for (unsigned int z = bz * BRICK_SIZE; z < z_end; ++z) for (unsigned int y = by * BRICK_SIZE; y < y_end; ++y) for (unsigned int x = bx * BRICK_SIZE; x < x_end; ++x) {
+
+		uint w;
+		float t = load_voxel(dest, weight, x + tsdf_width*(y + tsdf_height*z), &w);
+		lo = fmin(lo, t);
+		hi = fmax(hi, t);
+		seen |= w;
 
- 
 	}
-}
 
+	unsigned int b = bx + bricks_x*(by + bricks_y*bz);
+	vstore2((float2)(lo, hi), b, ranges);
+	observed[b] = (seen != 0U) ? 1 : 0;
+
+}
@@ -0,0 +1,162 @@
+/**
+ *	Definitions shared by the programs which integrate depth
+ *	frames into and raycast a TSDF so that voxels are laid
+ *	out and updated identically by each
+ */
+#ifndef KINFU_TSDF_H
+#define KINFU_TSDF_H
+
+
+#define KINECT_MAX_DIST (8.0f)
+#define KINECT_MIN_DIST (0.4f)
+#define STEP_SIZE (0.0005f) // mu *0.8
+
+
+/**
+ *	The layout of each voxel is selected when the program
+ *	is built (see kinfu::voxel_format):
+ *
+ *	0 - half TSDF value, weights stored separately
+ *	1 - 32 bits: 16 bit fixed point TSDF value, 8 bit weight, padding
+ *	2 - 32 bits: half TSDF value, 16 bit weight
+ *	3 - 16 bits: 8 bit fixed point TSDF value, 8 bit weight
+ *
+ *	The TSDF read by raycast.cl is decoded accordingly
+ */
+#ifndef VOXEL_FORMAT
+#define VOXEL_FORMAT 0
+#endif
+
+#if VOXEL_FORMAT == 1
+typedef uint voxel;
+#define MAX_WEIGHT (254U)
+#elif VOXEL_FORMAT == 2
+typedef ushort2 voxel;
+#define MAX_WEIGHT (65534U)
+#elif VOXEL_FORMAT == 3
+typedef char2 voxel;
+#define MAX_WEIGHT (254U)
+#else
+typedef half voxel;
+#define MAX_WEIGHT (254U)
+#endif
+
+
+/**
+ *	Reads the TSDF value and weight of a voxel
+ *
+ *	weight is only accessed if the weights are stored
+ *	separately
+ */
+float load_voxel(__global voxel * dest, __global uchar * weight, unsigned int idx, uint * w) {
+
+#if VOXEL_FORMAT == 1
+	uint v = dest[idx];
+	*w = (v >> 16) & 0xFFU;
+	return (float)((short)(v & 0xFFFFU)) / 32767.0f;
+#elif VOXEL_FORMAT == 2
+	*w = dest[idx].y;
+	return vload_half(2U * idx, (__global half *)dest);
+#elif VOXEL_FORMAT == 3
+	char2 v = dest[idx];
+	*w = (uchar)v.y;
+	return (float)v.x / 127.0f;
+#else
+	*w = weight[idx];
+	return vload_half(idx, dest);
+#endif
+
+}
+
+
+/**
+ *	Writes the TSDF value and weight of a voxel
+ */
+void store_voxel(__global voxel * dest, __global uchar * weight, unsigned int idx, float tsdf, uint w) {
+
+#if VOXEL_FORMAT == 1
+	dest[idx] = (uint)((ushort)convert_short_sat_rte(tsdf * 32767.0f)) | (w << 16);
+#elif VOXEL_FORMAT == 2
+	vstore_half(tsdf, 2U * idx, (__global half *)dest);
+	((__global ushort *)dest)[2U * idx + 1U] = (ushort)w;
+#elif VOXEL_FORMAT == 3
+	dest[idx] = (char2)(convert_char_sat_rte(tsdf * 127.0f), as_char((uchar)w));
+#else
+	vstore_half(tsdf, idx, dest);
+	weight[idx] = (uchar)w;
+#endif
+
+}
+
+
+/**
+ *	Updates a single voxel given its position in camera
+ *	space
+ *
+ *	See tsdf_kernel in tsdf.cl for parameters, voxels
+ *	deeper than max_depth in camera space are not updated
+ */
+void integrate(float3 cam, unsigned int idx, __global const float * src, __global voxel * dest,
+ __global const float* K, __global const float* K_inv, const float mu,
+ const unsigned int frame_width, const unsigned int frame_height,
+ __global unsigned char * weight, const float max_depth) {
+
+	float3 plane;
+	plane.x = cam.x * K[0] + cam.y * K[1] + cam.z * K[2];
+	plane.y = cam.x * K[3] + cam.y * K[4] + cam.z * K[5];
+	plane.z = cam.x * K[6] + cam.y * K[7] + cam.z * K[8];
+
+	float2 uv;
+	uv.x = plane.x / plane.z;
+	uv.y = plane.y / plane.z;
+
+	// take nearest neighbour in image
+	int2 x_tild;
+	x_tild.x = round(uv.x);
+	x_tild.y = round(uv.y);
+
+	// check if the current voxel projects into the depth frame
+	if (x_tild.x < 0 || x_tild.x >= frame_width || x_tild.y < 0 || x_tild.y >= frame_height || plane.z < 0.0f || cam.z > max_depth) {
+
+		return;
+
+	}
+
+	float v = src[x_tild.y * frame_width + x_tild.x];
+	float3 pix = (float3)(x_tild.x, x_tild.y, 1.0f);
+	float3 pix_k_inv;
+	pix_k_inv.x = dot ((float3)(K_inv[0], K_inv[1], K_inv[2]), pix);
+	pix_k_inv.y = dot ((float3)(K_inv[3], K_inv[4], K_inv[5]), pix);
+	pix_k_inv.z = dot ((float3)(K_inv[6], K_inv[7], K_inv[8]), pix);
+	pix_k_inv *= v;
+
+	float to_measurement = sqrt(dot(pix_k_inv, pix_k_inv));
+	float to_voxel = sqrt(dot(cam, cam));
+
+	float sdf = to_measurement - to_voxel;
+
+	if (sdf >= -mu) {
+
+		float tsdf = fmin(1.0f, sdf/mu);
+
+		if (isnan(tsdf)) return;
+
+		uint prev_weight;
+		float prev_tsdf = load_voxel(dest, weight, idx, &prev_weight);
+
+		if (isnan(prev_tsdf)) prev_tsdf = 0;
+
+		// if we haven't had a valid measurement, 
+		// then the prev_tsdf is NAN and prev_weight = 0
+		uint new_weight = min(MAX_WEIGHT, prev_weight);
+		++new_weight;
+
+		float new_tsdf = (prev_tsdf * prev_weight + tsdf * new_weight) / (prev_weight + new_weight);
+		store_voxel(dest, weight, idx, new_tsdf, new_weight);
+
+ 
+	}
+}
+
+
+#endif
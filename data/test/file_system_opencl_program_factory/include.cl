@@ -0,0 +1,8 @@
+// Only compiles if included.h (in the same directory) is found
+#include "included.h"
+
+kernel void include (__global int * out) {
+
+	out[get_global_id(0)] = INCLUDED;
+
+}
@@ -0,0 +1,2 @@
+// Included by include.cl
+#define INCLUDED 1
@@ -0,0 +1,10 @@
+// Only compiles if REQUIRED is defined when the program is built
+#ifndef REQUIRED
+#error REQUIRED is not defined
+#endif
+
+kernel void options (__global int * out) {
+
+	out[get_global_id(0)] = REQUIRED;
+
+}
@@ -7,6 +7,7 @@
 
 
 #include <Eigen/Dense>
+#include <cstddef>
 #include <utility>
 
 
@@ -47,6 +48,53 @@ namespace kinfu {
 	 *		the camera when \em depth was recorded at \em pixel.
 	 */
 	Eigen::Vector3f to_camera (Eigen::Vector2i pixel, float depth, Eigen::Matrix3f k) noexcept;
+	
+	
+	/**
+	 *	Given a camera calibration matrix obtains the camera
+	 *	calibration matrix for a certain level of an image
+	 *	pyramid wherein each level has half the width and
+	 *	height of the level before it.
+	 *
+	 *	\param [in] k
+	 *		A camera calibration matrix for level zero.
+	 *	\param [in] level
+	 *		The level.
+	 *
+	 *	\return
+	 *		The camera calibration matrix for \em level.
+	 */
+	Eigen::Matrix3f pyramid_k (Eigen::Matrix3f k, std::size_t level) noexcept;
+	
+	
+	/**
+	 *	Obtains the axis aligned bounding box in world space
+	 *	of that portion of the view frustum of a camera which
+	 *	lies no further than a certain depth from the camera.
+	 *
+	 *	Points which lie within the bounding box are those
+	 *	which project into a pixel of the image (after rounding
+	 *	to the nearest pixel) at a depth between zero and
+	 *	\em depth.
+	 *
+	 *	\param [in] t_g_k
+	 *		The pose of the camera (i.e. the transformation from
+	 *		camera space to world space).
+	 *	\param [in] k
+	 *		A camera calibration matrix.
+	 *	\param [in] width
+	 *		The width of the image in pixels.
+	 *	\param [in] height
+	 *		The height of the image in pixels.
+	 *	\param [in] depth
+	 *		The maximum depth.
+	 *
+	 *	\return
+	 *		A pair whose first element is the minimum corner of
+	 *		the bounding box and whose second element is the
+	 *		maximum corner.
+	 */
+	std::pair<Eigen::Vector3f,Eigen::Vector3f> frustum_bounds (const Eigen::Matrix4f & t_g_k, const Eigen::Matrix3f & k, std::size_t width, std::size_t height, float depth) noexcept;
 
 
 }
@@ -0,0 +1,132 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include <kinfu/pixel.hpp>
+#include <Eigen/Dense>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace kinfu {
+
+
+	/**
+	 *	Strategies by which a pose estimation pipeline block may
+	 *	select the pixels for which it seeks correspondences.
+	 */
+	enum class correspondence_sampling {
+
+		/**
+		 *	Every pixel is considered.
+		 */
+		all,
+		/**
+		 *	Pixels are selected at regular intervals.
+		 */
+		stride,
+		/**
+		 *	The frame is divided into as many strata as there
+		 *	are samples and one pixel is selected at random
+		 *	from each stratum, which avoids both the regularity
+		 *	of \ref correspondence_sampling::stride and the
+		 *	clumping of uniform random sampling.
+		 */
+		random,
+		/**
+		 *	Pixels are bucketed according to the direction of
+		 *	their normals and samples are distributed as evenly
+		 *	as possible between buckets so that surfaces which
+		 *	occupy a small part of the frame but constrain the
+		 *	pose (e.g. in directions along which large surfaces
+		 *	would slide) are well represented.
+		 */
+		normal_space
+
+	};
+
+
+	/**
+	 *	The number of buckets used by
+	 *	\ref correspondence_sampling::normal_space.
+	 */
+	constexpr std::size_t normal_space_buckets=64U;
+
+
+	/**
+	 *	Determines which bucket a normal falls into for the
+	 *	purposes of \ref correspondence_sampling::normal_space.
+	 *
+	 *	Each component of the normal is quantized into four
+	 *	bins.
+	 *
+	 *	\param [in] n
+	 *		A unit normal.
+	 *
+	 *	\return
+	 *		A bucket less than \ref normal_space_buckets.
+	 */
+	std::size_t normal_space_bucket (const Eigen::Vector3f & n) noexcept;
+
+
+	/**
+	 *	Selects pixels at regular intervals.
+	 *
+	 *	\param [in] size
+	 *		The number of pixels.
+	 *	\param [in] count
+	 *		The number of pixels to select.  If this is not
+	 *		less than \em size all pixels are selected.
+	 *
+	 *	\return
+	 *		The indices of the selected pixels in ascending
+	 *		order.
+	 */
+	std::vector<std::uint32_t> stride_samples (std::size_t size, std::size_t count);
+	/**
+	 *	Selects one pixel at random from each of \em count
+	 *	equally sized strata.
+	 *
+	 *	\param [in] size
+	 *		The number of pixels.
+	 *	\param [in] count
+	 *		The number of pixels to select.  If this is not
+	 *		less than \em size all pixels are selected.
+	 *	\param [in] seed
+	 *		The seed for the pseudo-random number generator,
+	 *		the same seed always yields the same selection.
+	 *
+	 *	\return
+	 *		The indices of the selected pixels in ascending
+	 *		order.
+	 */
+	std::vector<std::uint32_t> random_samples (std::size_t size, std::size_t count, std::uint32_t seed);
+	/**
+	 *	Selects pixels with valid vertices and normals such
+	 *	that the selected pixels are distributed as evenly as
+	 *	possible between the buckets given by
+	 *	\ref normal_space_bucket.
+	 *
+	 *	\param [in] map
+	 *		A vertex and normal map.
+	 *	\param [in] count
+	 *		The number of pixels to select.  If this is not
+	 *		less than the number of valid pixels all valid
+	 *		pixels are selected.
+	 *	\param [in] seed
+	 *		The seed for the pseudo-random number generator,
+	 *		the same seed always yields the same selection.
+	 *
+	 *	\return
+	 *		The indices of the selected pixels in ascending
+	 *		order.
+	 */
+	std::vector<std::uint32_t> normal_space_samples (const std::vector<pixel> & map, std::size_t count, std::uint32_t seed);
+
+
+}
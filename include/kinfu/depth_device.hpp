@@ -56,7 +56,10 @@ namespace kinfu {
 			/**
 			 *	Retrieves a frame from the depth sensor.
 			 *
-			 *	All measurements are in meters.
+			 *	All measurements are in meters.  Implementations
+			 *	which obtain depth in millimeters may return a
+			 *	\ref raw_depth_pipeline_value so that conversion
+			 *	may be deferred to the consumer.
 			 *
 			 *	\param [in] v
 			 *		A \ref pipeline_value object representing a
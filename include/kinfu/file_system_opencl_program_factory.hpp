@@ -19,6 +19,9 @@ namespace kinfu {
 	/**
 	 *	An \ref opencl_program_factory which loads and
 	 *	compiles OpenCL files from the file system.
+	 *
+	 *	The directory which is searched for OpenCL files is
+	 *	also searched for files they include.
 	 */
 	class file_system_opencl_program_factory : public opencl_program_factory {
 		
@@ -52,6 +55,7 @@ namespace kinfu {
 			
 			
 			virtual boost::compute::program operator () (const std::string &) override;
+			virtual boost::compute::program operator () (const std::string &, const std::string &) override;
 		
 		
 	};
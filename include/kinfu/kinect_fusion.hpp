@@ -9,11 +9,13 @@
 #include <kinfu/depth_device.hpp>
 #include <kinfu/measurement_pipeline_block.hpp>
 #include <kinfu/pose_estimation_pipeline_block.hpp>
+#include <kinfu/profiler.hpp>
 #include <kinfu/surface_prediction_pipeline_block.hpp>
 #include <kinfu/timer.hpp>
 #include <kinfu/update_reconstruction_pipeline_block.hpp>
 #include <Eigen/Dense>
 #include <cstddef>
+#include <exception>
 
 
 namespace kinfu {
@@ -58,6 +60,12 @@ namespace kinfu {
 			kinfu::pose_estimation_pipeline_block::value_type t_g_k_;
 			kinfu::update_reconstruction_pipeline_block::value_type tsdf_;
 			kinfu::surface_prediction_pipeline_block::value_type prev_map_;
+			bool pipelined_;
+			bool prefetched_;
+			kinfu::depth_device::value_type next_frame_;
+			kinfu::measurement_pipeline_block::value_type next_map_;
+			std::exception_ptr prefetch_ex_;
+			kinfu::profiler * profiler_;
 			
 			
 			void check_pipeline () const;
@@ -66,6 +74,7 @@ namespace kinfu {
 			void get_tgk ();
 			void get_tsdf ();
 			void get_prediction ();
+			void prefetch () noexcept;
 		
 		
 		public:
@@ -136,6 +145,60 @@ namespace kinfu {
 			 *		undefined.
 			 */
 			void surface_prediction_pipeline_block (kinfu::surface_prediction_pipeline_block & sppb) noexcept;
+			/**
+			 *	Enables or disables pipelined execution.
+			 *
+			 *	When pipelined execution is enabled each invocation,
+			 *	after enqueuing pose estimation, integration, and
+			 *	surface prediction for the current frame, retrieves
+			 *	the next frame from the depth device and enqueues its
+			 *	measurement.  If the measurement pipeline block was
+			 *	created with a different command queue than the
+			 *	remaining blocks this allows measurement of frame
+			 *	\f$k+1\f$ to overlap with integration and surface
+			 *	prediction of frame \f$k\f$.
+			 *
+			 *	The results of each invocation are identical to those
+			 *	obtained with pipelined execution disabled.  However
+			 *	\ref depth_device_elapsed and
+			 *	\ref measurement_pipeline_block_elapsed
+			 *	report the time spent obtaining and measuring the frame
+			 *	which shall be consumed by the next invocation, and
+			 *	exceptions thrown while doing so are deferred until that
+			 *	invocation.
+			 *
+			 *	Pipelined execution is disabled by default.
+			 *
+			 *	\param [in] p
+			 *		\em true to enable pipelined execution, \em false
+			 *		otherwise.
+			 */
+			void pipelined (bool p) noexcept;
+			/**
+			 *	Determines whether pipelined execution is enabled.
+			 *
+			 *	\return
+			 *		\em true if pipelined execution is enabled,
+			 *		\em false otherwise.
+			 */
+			bool pipelined () const noexcept;
+			/**
+			 *	Sets the profiler.
+			 *
+			 *	The profiler is cleared at the beginning of each
+			 *	invocation so that after each invocation it holds
+			 *	the timings of only those operations issued during
+			 *	that invocation.  The profiler must also be provided
+			 *	to the depth device and pipeline blocks whose
+			 *	operations are to be recorded.
+			 *
+			 *	\param [in] p
+			 *		A reference to the profiler this kinect_fusion
+			 *		shall use.  This reference must remain valid as
+			 *		long as this object is in use or the behaviour is
+			 *		undefined.
+			 */
+			void profiler (kinfu::profiler & p) noexcept;
 			
 			
 			/**
@@ -190,6 +253,20 @@ namespace kinfu {
 			 *		The amount of time.
 			 */
 			timer::duration surface_prediction_pipeline_block_elapsed () const;
+			/**
+			 *	Retrieves the timings which were recorded on the
+			 *	device for each operation issued during the last
+			 *	invocation.
+			 *
+			 *	If no profiler has been set the returned collection
+			 *	is empty.  Otherwise this may block until all such
+			 *	operations complete.
+			 *
+			 *	\return
+			 *		A reference to a collection of records.  This
+			 *		reference is invalidated by the next invocation.
+			 */
+			const kinfu::profiler::records_type & profile () const;
 
 
 			/**
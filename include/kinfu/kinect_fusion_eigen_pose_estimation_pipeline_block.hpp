@@ -5,9 +5,13 @@
 
 #pragma once
 
+#include <kinfu/correspondence_sampling.hpp>
+#include <kinfu/optional.hpp>
 #include <kinfu/pose_estimation_pipeline_block.hpp>
 #include <Eigen/Dense>
 #include <cstddef>
+#include <tuple>
+#include <vector>
 
 
 namespace kinfu {
@@ -34,6 +38,20 @@ namespace kinfu {
 			std::size_t numit_;
 			Eigen::Matrix4f t_gk_initial_;
 			bool force_px_px_;
+			bool motion_model_;
+			optional<Eigen::Matrix4f> t_gk_minus_two_;
+			correspondence_sampling sampling_;
+			std::size_t samples_;
+
+			using correspondences_type=std::vector<std::tuple<Eigen::Vector3f, Eigen::Vector3f, Eigen::Vector3f>>;
+
+			correspondences_type correspondences(
+				measurement_pipeline_block::value_type::element_type &,
+				measurement_pipeline_block::value_type::element_type &,
+				Eigen::Matrix3f,
+				Eigen::Matrix4f,
+				Eigen::Matrix4f
+			);
 
 			Eigen::Matrix4f incremental(
 				measurement_pipeline_block::value_type::element_type &,
@@ -80,6 +98,64 @@ namespace kinfu {
 				bool force_px_px=false
 			);
 
+			/**
+			 *	Enables or disables the constant velocity motion
+			 *	model.
+			 *
+			 *	When enabled the initial estimate is extrapolated
+			 *	from the poses of the two previous frames (see
+			 *	\ref constant_velocity) rather than being the pose
+			 *	of the previous frame.  The extrapolated estimate is
+			 *	only used if it yields at least as many correspondences
+			 *	as the pose of the previous frame.
+			 *
+			 *	The motion model is disabled by default.
+			 *
+			 *	\param [in] m
+			 *		\em true to enable the motion model, \em false
+			 *		otherwise.
+			 */
+			void motion_model (bool m) noexcept;
+			/**
+			 *	Determines whether the constant velocity motion model
+			 *	is enabled.
+			 *
+			 *	\return
+			 *		\em true if the motion model is enabled, \em false
+			 *		otherwise.
+			 */
+			bool motion_model () const noexcept;
+
+			/**
+			 *	Sets the strategy by which pixels are selected for
+			 *	correspondence search.
+			 *
+			 *	By default every pixel is considered.
+			 *
+			 *	\param [in] s
+			 *		The strategy.
+			 *	\param [in] samples
+			 *		The number of pixels to select.  Ignored if \em s
+			 *		is \ref correspondence_sampling::all.
+			 */
+			void sampling (correspondence_sampling s, std::size_t samples);
+			/**
+			 *	Retrieves the strategy by which pixels are selected
+			 *	for correspondence search.
+			 *
+			 *	\return
+			 *		The strategy.
+			 */
+			correspondence_sampling sampling () const noexcept;
+			/**
+			 *	Retrieves the number of pixels selected for
+			 *	correspondence search.
+			 *
+			 *	\return
+			 *		The number of pixels.
+			 */
+			std::size_t samples () const noexcept;
+
 			virtual value_type operator () (
 				measurement_pipeline_block::value_type::element_type &,
 				measurement_pipeline_block::value_type::element_type *,
@@ -7,13 +7,14 @@
 
 
 #include <boost/compute/command_queue.hpp>
+#include <kinfu/opencl_profiler.hpp>
 #include <kinfu/surface_prediction_pipeline_block.hpp>
 
 
 namespace kinfu {
 
 
-	class kinect_fusion_opencl_frame_to_frame_surface_prediction_pipeline_block : public surface_prediction_pipeline_block {
+	class kinect_fusion_opencl_frame_to_frame_surface_prediction_pipeline_block : public surface_prediction_pipeline_block, public opencl_profiled {
 
 
 		private:
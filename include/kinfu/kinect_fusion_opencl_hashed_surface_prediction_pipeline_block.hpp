@@ -0,0 +1,99 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include <boost/compute/buffer.hpp>
+#include <boost/compute/command_queue.hpp>
+#include <boost/compute/kernel.hpp>
+#include <boost/compute/utility/wait_list.hpp>
+#include <kinfu/measurement_pipeline_block.hpp>
+#include <kinfu/opencl_profiler.hpp>
+#include <kinfu/opencl_program_factory.hpp>
+#include <kinfu/optional.hpp>
+#include <kinfu/pose_estimation_pipeline_block.hpp>
+#include <kinfu/surface_prediction_pipeline_block.hpp>
+#include <kinfu/update_reconstruction_pipeline_block.hpp>
+#include <Eigen/Dense>
+#include <cstddef>
+
+
+namespace kinfu {
+	
+	
+	/**
+	 *	A \ref surface_prediction_pipeline_block which raycasts
+	 *	the sparse TSDF produced by a
+	 *	\ref kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block,
+	 *	skipping over bricks which have not been allocated.
+	 *
+	 *	\sa kinect_fusion
+	 */
+	class kinect_fusion_opencl_hashed_surface_prediction_pipeline_block : public surface_prediction_pipeline_block, public opencl_profiled {
+		
+		
+		private:
+			boost::compute::command_queue q_;
+			boost::compute::kernel raycast_kernel_;
+			boost::compute::buffer t_g_k_buf_;
+			boost::compute::buffer ik_buf_;
+			optional<Eigen::Matrix4f> t_g_k_;
+			optional<Eigen::Matrix3f> k_;
+			//	Host copies of the contents of the above buffers,
+			//	these must remain unchanged until the asynchronous
+			//	writes in writes_ complete
+			Eigen::Matrix4f t_g_k_t_;
+			Eigen::Matrix3f ik_;
+			boost::compute::wait_list writes_;
+			std::size_t frame_width_;
+			std::size_t frame_height_;
+		
+		public:
+			
+			kinect_fusion_opencl_hashed_surface_prediction_pipeline_block () = delete;
+			
+			/**
+			 *	Creates a new kinect_fusion_opencl_hashed_surface_prediction_pipeline_block.
+			 *
+			 *	\param [in] q
+			 *		A boost::compute::command_queue which the newly created
+			 *		object shall use to dispatch OpenCL tasks.  TSDFs must
+			 *		reside in the same context.
+			 *	\param [in] opf
+			 *		An \ref opencl_program_factory which the newly created
+			 *		object shall use to obtain OpenCL programs.
+			 *	\param [in] frame_width
+			 *		The width of the depth frame.
+			 *	\param [in] frame_height
+			 *		The height of the depth frame.
+			 */
+			kinect_fusion_opencl_hashed_surface_prediction_pipeline_block (
+				boost::compute::command_queue q,
+				opencl_program_factory & opf,
+				std::size_t frame_width=640,
+				std::size_t frame_height=480
+			);
+			
+			~kinect_fusion_opencl_hashed_surface_prediction_pipeline_block () noexcept;
+			
+			/**
+			 *	\em tsdf must be an \ref opencl_voxel_hash_pipeline_value.
+			 */
+			virtual value_type operator () (
+				update_reconstruction_pipeline_block::value_type::element_type & tsdf,
+				std::size_t,
+				std::size_t,
+				std::size_t,
+				pose_estimation_pipeline_block::value_type::element_type &,
+				Eigen::Matrix3f,
+				measurement_pipeline_block::value_type::element_type &,
+				value_type
+			) override;
+			 
+	};
+	
+	
+}
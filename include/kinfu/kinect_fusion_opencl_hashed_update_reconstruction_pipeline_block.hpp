@@ -0,0 +1,135 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include <boost/compute/buffer.hpp>
+#include <boost/compute/command_queue.hpp>
+#include <boost/compute/kernel.hpp>
+#include <boost/compute/utility/wait_list.hpp>
+#include <kinfu/depth_device.hpp>
+#include <kinfu/opencl_profiler.hpp>
+#include <kinfu/opencl_program_factory.hpp>
+#include <kinfu/opencl_vector_pipeline_value.hpp>
+#include <kinfu/optional.hpp>
+#include <kinfu/pose_estimation_pipeline_block.hpp>
+#include <kinfu/update_reconstruction_pipeline_block.hpp>
+#include <Eigen/Dense>
+#include <cstddef>
+
+
+namespace kinfu {
+	
+	
+	/**
+	 *	An \ref update_reconstruction_pipeline_block which stores
+	 *	the TSDF sparsely as bricks of voxels which are allocated
+	 *	only near observed surfaces and located via a hash table
+	 *	(see \ref opencl_voxel_hash_pipeline_value) rather than as
+	 *	a dense grid.  Memory therefore grows with the area of the
+	 *	observed surfaces rather than with the volume of the scene.
+	 *
+	 *	The TSDF this object produces must be consumed by a
+	 *	\ref kinect_fusion_opencl_hashed_surface_prediction_pipeline_block.
+	 *
+	 *	\sa kinect_fusion
+	 */
+	class kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block : public update_reconstruction_pipeline_block, public opencl_profiled {
+		
+		
+		private:
+			opencl_vector_pipeline_value_extractor<float> ve_;
+			boost::compute::kernel allocate_kernel_;
+			boost::compute::kernel integrate_kernel_;
+			boost::compute::buffer t_g_k_buf_;
+			boost::compute::buffer proj_view_buf_;
+			boost::compute::buffer k_buf_;
+			boost::compute::buffer ik_buf_;
+			optional<Eigen::Matrix4f> t_g_k_;
+			optional<Eigen::Matrix3f> k_;
+			//	Host copies of the contents of the above buffers,
+			//	these must remain unchanged until the asynchronous
+			//	writes in writes_ complete
+			Eigen::Matrix4f t_g_k_t_;
+			Eigen::Matrix4f proj_view_;
+			Eigen::Matrix3f k_t_;
+			Eigen::Matrix3f ik_;
+			boost::compute::wait_list writes_;
+			float mu_;
+			float voxel_size_;
+			std::size_t width_;
+			std::size_t height_;
+			std::size_t depth_;
+			std::size_t bricks_;
+			std::size_t buckets_;
+			bool reset_;
+		
+		public:
+			
+			kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block () = delete;
+			
+			/**
+			 *	Creates a new kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block.
+			 *
+			 *	\param [in] q
+			 *		A boost::compute::command_queue which the newly created
+			 *		object shall use to dispatch OpenCL tasks.
+			 *	\param [in] opf
+			 *		An \ref opencl_program_factory which the newly created
+			 *		object shall use to obtain OpenCL programs.
+			 *	\param [in] mu
+			 *		\f$\mu\f$: the truncation distance of the truncated signed distance function (TSDF).
+			 *	\param [in] voxel_size
+			 *		The edge length of each voxel in meters.
+			 *	\param [in] width
+			 *		The width (in voxels) of the dense TSDF, beginning at the
+			 *		origin, which is presented when the TSDF is retrieved on
+			 *		the CPU.  The extent of the TSDF itself is not limited by
+			 *		this (bricks may be allocated within 512 bricks of the
+			 *		origin along each axis).
+			 *	\param [in] height
+			 *		The height (in voxels) of the dense TSDF presented on the
+			 *		CPU.
+			 *	\param [in] depth
+			 *		The depth (in voxels) of the dense TSDF presented on the
+			 *		CPU.
+			 *	\param [in] bricks
+			 *		The maximum number of bricks which may be allocated.  Once
+			 *		this is exhausted surfaces in bricks which have not been
+			 *		allocated are no longer integrated.
+			 *	\param [in] buckets
+			 *		The number of slots in the hash table.  This should be
+			 *		comfortably larger than \em bricks.
+			 */
+			kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block (
+				boost::compute::command_queue q,
+				opencl_program_factory & opf,
+				float mu,
+				float voxel_size=0.005f,
+				std::size_t width=256,
+				std::size_t height=256,
+				std::size_t depth=256,
+				std::size_t bricks=65536,
+				std::size_t buckets=262144
+			);
+			
+			~kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block () noexcept;
+			
+			virtual value_type operator () (depth_device::value_type::element_type & frame, std::size_t width, std::size_t height, Eigen::Matrix3f k, pose_estimation_pipeline_block::value_type::element_type & T_g_k, value_type v=value_type{}) override;
+			
+			
+			/**
+			 *	Causes the TSDF to be emptied (i.e. all bricks are
+			 *	deallocated) before the next frame is integrated.
+			 *	The storage of the TSDF is reused rather than
+			 *	reallocated.
+			 */
+			void reset () noexcept;
+			 
+	};
+	
+	
+}
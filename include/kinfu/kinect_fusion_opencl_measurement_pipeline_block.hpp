@@ -12,11 +12,13 @@
 #include <boost/compute/kernel.hpp>
 #include <kinfu/depth_device.hpp>
 #include <kinfu/measurement_pipeline_block.hpp>
+#include <kinfu/opencl_profiler.hpp>
 #include <kinfu/opencl_program_factory.hpp>
 #include <kinfu/opencl_vector_pipeline_value.hpp>
 #include <kinfu/optional.hpp>
 #include <Eigen/Dense>
 #include <cstddef>
+#include <vector>
 
 
 namespace kinfu {
@@ -28,7 +30,7 @@ namespace kinfu {
 	 *
 	 *	\sa kinect_fusion
 	 */
-	class kinect_fusion_opencl_measurement_pipeline_block : public measurement_pipeline_block {
+	class kinect_fusion_opencl_measurement_pipeline_block : public measurement_pipeline_block, public opencl_profiled {
 		
 		
 		private:
@@ -36,11 +38,20 @@ namespace kinfu {
 		
 			opencl_vector_pipeline_value_extractor<float> ve_;
 			boost::compute::kernel bilateral_kernel_;
+			boost::compute::kernel bilateral_tiled_kernel_;
+			boost::compute::buffer spatial_;
+			bool tileable_;
+			bool tiled_;
+			boost::compute::kernel measurement_kernel_;
+			bool fusable_;
+			bool fused_;
 			boost::compute::kernel v_kernel_;
 			boost::compute::kernel n_kernel_;
-			boost::compute::vector<float> v_;
-			boost::compute::buffer kbuf_;
+			boost::compute::kernel half_sample_kernel_;
+			std::vector<boost::compute::vector<float>> v_;
+			std::vector<boost::compute::buffer> kbuf_;
 			optional<Eigen::Matrix3f> k_;
+			float threshold_;
 		
 		
 		public:
@@ -67,13 +78,22 @@ namespace kinfu {
 			 *	\param [in] sigma_r
 			 *		The \f$\sigma_r\f$ value which shall be used by the
 			 *		bilateral filter.
+			 *	\param [in] levels
+			 *		The number of levels of the pyramid which shall be
+			 *		generated.  Each level after the first is obtained
+			 *		by half sampling the filtered depth of the level
+			 *		before it, averaging only those depths within
+			 *		\f$3\sigma_r\f$ of each other, and has its own vertex
+			 *		and normal map.  Defaults to 1 in which case only
+			 *		full resolution vertex and normal maps are generated.
 			 */
 			kinect_fusion_opencl_measurement_pipeline_block (
 				boost::compute::command_queue q,
 				opencl_program_factory & opf,
 				std::size_t window_size,
 				float sigma_s,
-				float sigma_r
+				float sigma_r,
+				std::size_t levels=1
 			);
 			
 			
@@ -99,10 +119,65 @@ namespace kinfu {
 			 *		object to return.
 			 *
 			 *	\return
-			 *		A tuple of \ref pipeline_value objects representing a
-			 *		vertex map and corresponding normal map.
+			 *		An \ref opencl_vector_pyramid_pipeline_value whose
+			 *		levels are the vertex and normal maps for each level
+			 *		of the pyramid.
 			 */
 			virtual value_type operator () (depth_device::value_type::element_type & frame, std::size_t width, std::size_t height, Eigen::Matrix3f k, value_type v=value_type{});
+			
+			
+			/**
+			 *	Determines whether the bilateral filter shall be
+			 *	applied to each tile of the depth frame in local
+			 *	memory with spatial weights taken from a table.
+			 *
+			 *	If the device does not have sufficient local memory
+			 *	or cannot launch a work group per tile this setting
+			 *	has no effect.  Defaults to \em true.
+			 *
+			 *	\param [in] tiled
+			 *		\em true if the tiled kernel should be used,
+			 *		\em false otherwise.
+			 */
+			void tiled (bool tiled) noexcept;
+			/**
+			 *	Determines whether the bilateral filter shall be
+			 *	applied to each tile of the depth frame in local
+			 *	memory.
+			 *
+			 *	\return
+			 *		\em true if the tiled kernel shall be used (when
+			 *		supported by the device), \em false otherwise.
+			 */
+			bool tiled () const noexcept;
+			
+			
+			/**
+			 *	Determines whether the first level of the pyramid
+			 *	shall be measured by a single kernel which filters,
+			 *	back projects, and computes normals for each tile
+			 *	of the depth frame in local memory.
+			 *
+			 *	When enabled the filtered depth of the first level
+			 *	is only written to device memory if further levels
+			 *	must be generated from it.  If the device does not
+			 *	have sufficient local memory this setting has no
+			 *	effect.  Defaults to \em false.
+			 *
+			 *	\param [in] fused
+			 *		\em true if the fused kernel should be used,
+			 *		\em false otherwise.
+			 */
+			void fused (bool fused) noexcept;
+			/**
+			 *	Determines whether the first level of the pyramid
+			 *	shall be measured by a single kernel.
+			 *
+			 *	\return
+			 *		\em true if the fused kernel shall be used (when
+			 *		supported by the device), \em false otherwise.
+			 */
+			bool fused () const noexcept;
 		
 		
 	};
@@ -0,0 +1,170 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include <boost/compute/buffer.hpp>
+#include <boost/compute/command_queue.hpp>
+#include <boost/compute/kernel.hpp>
+#include <boost/compute/utility/wait_list.hpp>
+#include <kinfu/depth_device.hpp>
+#include <kinfu/filesystem.hpp>
+#include <kinfu/opencl_profiler.hpp>
+#include <kinfu/opencl_program_factory.hpp>
+#include <kinfu/opencl_vector_pipeline_value.hpp>
+#include <kinfu/optional.hpp>
+#include <kinfu/pose_estimation_pipeline_block.hpp>
+#include <kinfu/update_reconstruction_pipeline_block.hpp>
+#include <Eigen/Dense>
+#include <cstddef>
+#include <vector>
+
+
+namespace kinfu {
+
+
+	/**
+	 *	An \ref update_reconstruction_pipeline_block which stores
+	 *	the TSDF as chunks in a file on the host of which only
+	 *	those which intersect the view frustum of the camera
+	 *	are resident on the GPU (see
+	 *	\ref opencl_paged_voxel_pipeline_value).  The size of the
+	 *	TSDF is therefore limited by the size of the file rather
+	 *	than the memory of the GPU.
+	 *
+	 *	Voxels are updated exactly as by a
+	 *	\ref kinect_fusion_opencl_update_reconstruction_pipeline_block
+	 *	with the same maximum depth, except that when more chunks
+	 *	intersect the view frustum than may be resident those
+	 *	furthest from the camera are not updated.
+	 *
+	 *	The TSDF this object produces must be consumed by a
+	 *	\ref kinect_fusion_opencl_paged_surface_prediction_pipeline_block.
+	 *
+	 *	\sa kinect_fusion
+	 */
+	class kinect_fusion_opencl_paged_update_reconstruction_pipeline_block : public update_reconstruction_pipeline_block, public opencl_profiled {
+
+
+		private:
+			opencl_vector_pipeline_value_extractor<float> ve_;
+			boost::compute::kernel integrate_kernel_;
+			boost::compute::buffer proj_view_buf_;
+			boost::compute::buffer k_buf_;
+			boost::compute::buffer ik_buf_;
+			optional<Eigen::Matrix4f> t_g_k_;
+			optional<Eigen::Matrix3f> k_;
+			//	Host copies of the contents of the above buffers,
+			//	these must remain unchanged until the asynchronous
+			//	writes in writes_ complete
+			Eigen::Matrix4f proj_view_;
+			Eigen::Matrix3f k_t_;
+			Eigen::Matrix3f ik_;
+			boost::compute::wait_list writes_;
+			float mu_;
+			filesystem::path path_;
+			std::size_t width_;
+			std::size_t height_;
+			std::size_t depth_;
+			Eigen::Vector3f extent_;
+			std::size_t chunk_size_;
+			std::size_t slots_;
+			float max_depth_;
+			bool reset_;
+
+			std::vector<std::size_t> select (
+				const Eigen::Matrix4f & t_g_k,
+				const Eigen::Matrix3f & k,
+				std::size_t frame_width,
+				std::size_t frame_height
+			) const;
+
+		public:
+
+			kinect_fusion_opencl_paged_update_reconstruction_pipeline_block () = delete;
+
+			/**
+			 *	Creates a new kinect_fusion_opencl_paged_update_reconstruction_pipeline_block.
+			 *
+			 *	\param [in] q
+			 *		A boost::compute::command_queue which the newly created
+			 *		object shall use to dispatch OpenCL tasks.
+			 *	\param [in] opf
+			 *		An \ref opencl_program_factory which the newly created
+			 *		object shall use to obtain OpenCL programs.
+			 *	\param [in] mu
+			 *		\f$\mu\f$: the truncation distance of the truncated signed distance function (TSDF).
+			 *	\param [in] path
+			 *		The path of the file in which the TSDF is stored.  The
+			 *		file is created (or overwritten) when the first frame
+			 *		is integrated.
+			 *	\param [in] tsdf_width
+			 *		The width of the TSDF in voxels.
+			 *	\param [in] tsdf_height
+			 *		The height of the TSDF in voxels.
+			 *	\param [in] tsdf_depth
+			 *		The depth of the TSDF in voxels.
+			 *	\param [in] tsdf_extent_w
+			 *		The width of the TSDF in meters.
+			 *	\param [in] tsdf_extent_h
+			 *		The height of the TSDF in meters.
+			 *	\param [in] tsdf_extent_d
+			 *		The depth of the TSDF in meters.
+			 *	\param [in] chunk_size
+			 *		The number of voxels along each edge of a chunk.
+			 *	\param [in] slots
+			 *		The number of chunks which may be resident on the GPU.
+			 */
+			kinect_fusion_opencl_paged_update_reconstruction_pipeline_block (
+				boost::compute::command_queue q,
+				opencl_program_factory & opf,
+				float mu,
+				filesystem::path path,
+				std::size_t tsdf_width=512,
+				std::size_t tsdf_height=512,
+				std::size_t tsdf_depth=512,
+				float tsdf_extent_w=3.0f,
+				float tsdf_extent_h=3.0f,
+				float tsdf_extent_d=3.0f,
+				std::size_t chunk_size=32,
+				std::size_t slots=1024
+			);
+
+			~kinect_fusion_opencl_paged_update_reconstruction_pipeline_block () noexcept;
+
+			virtual value_type operator () (depth_device::value_type::element_type & frame, std::size_t width, std::size_t height, Eigen::Matrix3f k, pose_estimation_pipeline_block::value_type::element_type & T_g_k, value_type v=value_type{}) override;
+
+
+			/**
+			 *	Sets the maximum depth (in camera space) of voxels
+			 *	which are updated.  This also bounds the view frustum
+			 *	which determines which chunks are resident.
+			 *	Defaults to 4 meters.
+			 *
+			 *	\param [in] depth
+			 *		The maximum depth in meters.
+			 */
+			void max_depth (float depth);
+			/**
+			 *	Retrieves the maximum depth of voxels which are
+			 *	updated.
+			 *
+			 *	\return
+			 *		The maximum depth in meters.
+			 */
+			float max_depth () const noexcept;
+
+
+			/**
+			 *	Causes the TSDF to be emptied before the next frame
+			 *	is integrated.
+			 */
+			void reset () noexcept;
+
+	};
+
+
+}
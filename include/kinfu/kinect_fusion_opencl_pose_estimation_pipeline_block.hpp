@@ -8,14 +8,20 @@
 
 #include <boost/compute/buffer.hpp>
 #include <boost/compute/command_queue.hpp>
+#include <boost/compute/container/vector.hpp>
 #include <boost/compute/kernel.hpp>
+#include <boost/compute/utility/wait_list.hpp>
+#include <kinfu/correspondence_sampling.hpp>
 #include <kinfu/measurement_pipeline_block.hpp>
+#include <kinfu/opencl_profiler.hpp>
 #include <kinfu/opencl_program_factory.hpp>
 #include <kinfu/opencl_vector_pipeline_value.hpp>
 #include <kinfu/optional.hpp>
 #include <kinfu/pose_estimation_pipeline_block.hpp>
 #include <Eigen/Dense>
 #include <cstddef>
+#include <cstdint>
+#include <vector>
 
 
 namespace kinfu {
@@ -30,7 +36,7 @@ namespace kinfu {
 	 *
 	 *	\sa kinect_fusion
 	 */
-	class kinect_fusion_opencl_pose_estimation_pipeline_block : public pose_estimation_pipeline_block {
+	class kinect_fusion_opencl_pose_estimation_pipeline_block : public pose_estimation_pipeline_block, public opencl_profiled {
 
 
 		private:
@@ -38,23 +44,50 @@ namespace kinfu {
 
 			boost::compute::command_queue q_;
 			boost::compute::kernel corr_;
-			boost::compute::kernel parallel_sum_;
 			boost::compute::kernel serial_sum_;
+			boost::compute::kernel half_sample_map_;
+			boost::compute::kernel solve_;
 			boost::compute::buffer t_z_;
 			boost::compute::buffer t_frame_frame_;
-			boost::compute::buffer k_;
+			boost::compute::buffer t_gk_prev_inverse_;
+			boost::compute::buffer status_;
+			std::vector<boost::compute::buffer> k_;
 			boost::compute::buffer mats_;
-			boost::compute::buffer mats_output_;
 			opencl_vector_pipeline_value_extractor<measurement_pipeline_block::value_type::element_type::type::value_type> e_;
 			opencl_vector_pipeline_value_extractor<measurement_pipeline_block::value_type::element_type::type::value_type> p_e_;
+			std::vector<boost::compute::vector<measurement_pipeline_block::value_type::element_type::type::value_type>> map_levels_;
+			std::vector<boost::compute::vector<measurement_pipeline_block::value_type::element_type::type::value_type>> prev_map_levels_;
 			float epsilon_d_;
 			float epsilon_theta_;
 			std::size_t frame_width_;
 			std::size_t frame_height_;
 			Eigen::Matrix4f t_gk_initial_;
-			std::size_t numit_;
+			std::vector<std::size_t> iterations_;
 			std::size_t group_size_;
+			std::size_t groups_;
 			bool force_px_px_;
+			float epsilon_rotation_;
+			float epsilon_translation_;
+			std::size_t iterations_performed_;
+			bool device_solve_;
+			bool motion_model_;
+			optional<Eigen::Matrix4f> t_gk_minus_two_;
+			boost::compute::kernel histogram_kernel_;
+			boost::compute::kernel select_kernel_;
+			boost::compute::buffer histogram_;
+			std::vector<boost::compute::vector<std::uint32_t>> sample_indices_;
+			std::vector<boost::compute::buffer> sample_counts_;
+			correspondence_sampling sampling_;
+			std::size_t samples_;
+			bool samples_dirty_;
+			std::uint32_t seed_;
+
+
+			std::size_t level_samples (std::size_t) const noexcept;
+			void prepare_samples (
+				const std::vector<boost::compute::vector<measurement_pipeline_block::value_type::element_type::type::value_type> *> &,
+				boost::compute::wait_list &
+			);
 
 
 		public:
@@ -113,6 +146,190 @@ namespace kinfu {
 				std::size_t group_size=16,
 				bool force_px_px=false
 			);
+			/**
+			 *  Creates a new kinect_fusion_opencl_pose_estimation_pipeline_block
+			 *	which iterates coarse to fine over a depth pyramid.
+			 *
+			 *	Each level of the pyramid has half the width and
+			 *	height of the level before it.  Where the vertex
+			 *	and normal map is a \ref opencl_vector_pyramid_pipeline_value
+			 *	with sufficiently many levels those levels are used,
+			 *	otherwise coarser levels are generated by half sampling.
+			 *
+			 *	\param [in] q
+			 *		A boost::compute::command_queue which the newly created
+			 *		object shall use to dispatch OpenCL tasks.
+			 *
+			 *  \param [in] pf
+			 *      An \ref opencl_program_factory which the newly created object will
+			 *		use to obtain OpenCL programs.
+			 *
+			 *  \param [in] epsilon_d
+			 *      The rejection distance in Equation 17, \f$\epsilon_d\f$
+			 *
+			 *  \param [in] epsilon_theta
+			 *      The normal rejection angle in Equation 17, \f$\epsilon_\theta\f$
+			 *
+			 *  \param [in] frame_width
+			 *      The width of the depth frame
+			 *
+			 *  \param [in] frame_height
+			 *      The height of the depth frame
+			 *
+			 *	\param [in] t_gk_initial
+			 *		The \f$T_{g,k}\f$ to return from the first invocation.
+			 *
+			 *  \param [in] iterations
+			 *      The number of iterations to use at each level of the
+			 *		pyramid ordered from the coarsest level to the finest.
+			 *		The number of levels is the size of this vector and the
+			 *		sum of its elements must be at least one.
+			 *
+			 *	\param [in] group_size
+			 *		The group size to use in the OpenCL correspondences kernel.
+			 *		Must not be greater than the number of pixels at any level
+			 *		at which iterations are performed.
+			 *
+			 *	\param [in] force_px_px
+			 *		When set to true, forces all correspondences to be pixel to pixel
+			 *		instead of generated through projection.
+			 */
+			kinect_fusion_opencl_pose_estimation_pipeline_block (
+				boost::compute::command_queue q,
+				opencl_program_factory & pf,
+				float epsilon_d,
+				float epsilon_theta,
+				std::size_t frame_width,
+				std::size_t frame_height,
+				Eigen::Matrix4f t_gk_initial,
+				std::vector<std::size_t> iterations,
+				std::size_t group_size=16,
+				bool force_px_px=false
+			);
+
+
+			/**
+			 *	Sets the thresholds below which the incremental
+			 *	transformation computed by an iteration is considered
+			 *	to have converged.
+			 *
+			 *	Once the norm of the rotational component (i.e.
+			 *	\f$\left(\alpha,\beta,\gamma\right)\f$) and the norm
+			 *	of the translational component of the incremental
+			 *	transformation both fall below their respective
+			 *	thresholds no further iterations are performed at
+			 *	that pyramid level.
+			 *
+			 *	Both thresholds are zero by default which means that
+			 *	all iterations are always performed.
+			 *
+			 *	\param [in] rotation
+			 *		The rotation threshold in radians.
+			 *	\param [in] translation
+			 *		The translation threshold in the same units as
+			 *		the vertex map.
+			 */
+			void termination_thresholds (float rotation, float translation) noexcept;
+			/**
+			 *	Enables or disables solving on the device.
+			 *
+			 *	When enabled the linear system of each iteration is
+			 *	solved, and the estimate updated, by an OpenCL kernel
+			 *	so that the host does not wait on the device between
+			 *	iterations.  The final estimate is read back once per
+			 *	invocation.  Should the system become singular no
+			 *	further iterations are performed and the estimate
+			 *	obtained thus far is returned.  Loss of tracking is
+			 *	only detected (and reported) once all iterations have
+			 *	been enqueued.
+			 *
+			 *	Solving on the device is disabled by default.
+			 *
+			 *	\param [in] d
+			 *		\em true to solve on the device, \em false to
+			 *		solve on the host.
+			 */
+			void device_solve (bool d) noexcept;
+			/**
+			 *	Determines whether solving on the device is enabled.
+			 *
+			 *	\return
+			 *		\em true if solving on the device is enabled,
+			 *		\em false otherwise.
+			 */
+			bool device_solve () const noexcept;
+			/**
+			 *	Enables or disables the constant velocity motion
+			 *	model.
+			 *
+			 *	When enabled the initial estimate is extrapolated
+			 *	from the poses of the two previous frames (see
+			 *	\ref constant_velocity) rather than being the pose
+			 *	of the previous frame.  The extrapolated estimate is
+			 *	only used if it yields at least as many correspondences
+			 *	as the pose of the previous frame at the coarsest level
+			 *	of the pyramid.
+			 *
+			 *	The motion model is disabled by default.
+			 *
+			 *	\param [in] m
+			 *		\em true to enable the motion model, \em false
+			 *		otherwise.
+			 */
+			void motion_model (bool m) noexcept;
+			/**
+			 *	Determines whether the constant velocity motion model
+			 *	is enabled.
+			 *
+			 *	\return
+			 *		\em true if the motion model is enabled, \em false
+			 *		otherwise.
+			 */
+			bool motion_model () const noexcept;
+			/**
+			 *	Sets the strategy by which pixels are selected for
+			 *	correspondence search.
+			 *
+			 *	By default every pixel is considered.
+			 *
+			 *	\param [in] s
+			 *		The strategy.
+			 *	\param [in] samples
+			 *		The number of pixels to select at the finest level
+			 *		of the pyramid.  A quarter as many are selected at
+			 *		each subsequent level.  Ignored if \em s is
+			 *		\ref correspondence_sampling::all.  When \em s is
+			 *		\ref correspondence_sampling::normal_space this is
+			 *		the expected rather than the exact number of pixels.
+			 */
+			void sampling (correspondence_sampling s, std::size_t samples);
+			/**
+			 *	Retrieves the strategy by which pixels are selected
+			 *	for correspondence search.
+			 *
+			 *	\return
+			 *		The strategy.
+			 */
+			correspondence_sampling sampling () const noexcept;
+			/**
+			 *	Retrieves the number of pixels selected for
+			 *	correspondence search at the finest level of the
+			 *	pyramid.
+			 *
+			 *	\return
+			 *		The number of pixels.
+			 */
+			std::size_t samples () const noexcept;
+			/**
+			 *	Retrieves the number of iterations performed during the
+			 *	last invocation, summed over all pyramid levels.
+			 *
+			 *	\return
+			 *		The number of iterations.  Zero if this object has
+			 *		not been invoked or if the last invocation did not
+			 *		iterate (e.g. because it was the first).
+			 */
+			std::size_t iterations_performed () const noexcept;
 
 
 			virtual value_type operator () (
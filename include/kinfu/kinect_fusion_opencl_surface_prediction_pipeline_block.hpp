@@ -10,17 +10,21 @@
 #include <boost/compute/command_queue.hpp>
 #include <boost/compute/container/vector.hpp>
 #include <boost/compute/kernel.hpp>
+#include <boost/compute/utility/wait_list.hpp>
 #include <kinfu/depth_device.hpp>
 #include <kinfu/half.hpp>
 #include <kinfu/measurement_pipeline_block.hpp>
+#include <kinfu/opencl_profiler.hpp>
 #include <kinfu/opencl_program_factory.hpp>
 #include <kinfu/opencl_vector_pipeline_value.hpp>
 #include <kinfu/optional.hpp>
 #include <kinfu/pose_estimation_pipeline_block.hpp>
 #include <kinfu/surface_prediction_pipeline_block.hpp>
 #include <kinfu/update_reconstruction_pipeline_block.hpp>
+#include <kinfu/voxel_format.hpp>
 #include <Eigen/Dense>
 #include <cstddef>
+#include <cstdint>
 
 
 
@@ -34,21 +38,37 @@ namespace kinfu {
 	 *
 	 *	\sa kinect_fusion
 	 */
-	class kinect_fusion_opencl_surface_prediction_pipeline_block : public surface_prediction_pipeline_block {
+	class kinect_fusion_opencl_surface_prediction_pipeline_block : public surface_prediction_pipeline_block, public opencl_profiled {
 		
 		
 		private:
 			opencl_vector_pipeline_value_extractor<half> ve_;
 			boost::compute::kernel raycast_kernel_;
+			boost::compute::kernel voxel_raycast_kernel_;
 			boost::compute::buffer t_g_k_buf_;
 			boost::compute::buffer ik_buf_;
+			//	Bound in place of brick summaries when there are
+			//	none (i.e. when the TSDF is converted to half
+			//	precision values) since the kernel must have all
+			//	its arguments set
+			boost::compute::vector<float> no_ranges_;
+			boost::compute::vector<std::uint8_t> no_observed_;
 			optional<Eigen::Matrix4f> t_g_k_;
 			optional<Eigen::Matrix3f> k_;
+			//	Host copies of the contents of the above buffers,
+			//	these must remain unchanged until the asynchronous
+			//	writes in writes_ complete
+			Eigen::Matrix4f t_g_k_t_;
+			Eigen::Matrix3f ik_;
+			boost::compute::wait_list writes_;
 			float mu_;
+			float max_step_;
+			bool brick_skipping_;
 			float tsdf_extent_;
 			std::size_t tsdf_size_;
 			std::size_t frame_width_;
 			std::size_t frame_height_;
+			voxel_format format_;
 		
 		public:
 			
@@ -76,6 +96,11 @@ namespace kinfu {
 			 *		The width of the depth frame.
 			 *	\param [in] frame_height 
 			 *		The height of the depth frame.
+			 *	\param [in] format
+			 *		The \ref voxel_format of the TSDFs which shall be
+			 *		raycast directly.  TSDFs in any other format (or
+			 *		which do not reside on the GPU) are converted to
+			 *		half precision values first.
 			 */
 			kinect_fusion_opencl_surface_prediction_pipeline_block (				
 				boost::compute::command_queue q,
@@ -84,9 +109,12 @@ namespace kinfu {
 				std::size_t tsdf_size=256,
 				float tsdf_extent=3.0f,
 				std::size_t frame_width=640,
-				std::size_t frame_height=480
+				std::size_t frame_height=480,
+				voxel_format format=voxel_format::half
 			);
 			
+			~kinect_fusion_opencl_surface_prediction_pipeline_block () noexcept;
+			
 			virtual value_type operator () (
 				update_reconstruction_pipeline_block::value_type::element_type &,
 				std::size_t,
@@ -97,6 +125,51 @@ namespace kinfu {
 				measurement_pipeline_block::value_type::element_type &,
 				value_type
 			) override;
+			
+			
+			/**
+			 *	Sets the largest step (in meters) rays may take
+			 *	through free space.  Rays step in proportion to the
+			 *	sampled TSDF value (i.e. in large steps far from
+			 *	surfaces and in steps of 0.5mm near them), a maximum
+			 *	of 0.5mm gives a fixed step march.
+			 *	Defaults to \f$0.8\mu\f$.
+			 *
+			 *	\param [in] step
+			 *		The maximum step.
+			 */
+			void max_step (float step);
+			/**
+			 *	Retrieves the largest step rays may take through
+			 *	free space.
+			 *
+			 *	\return
+			 *		The maximum step in meters.
+			 */
+			float max_step () const noexcept;
+			
+			
+			/**
+			 *	Sets whether rays step straight out of bricks of
+			 *	the TSDF which cannot contain a surface (see
+			 *	\ref opencl_voxel_pipeline_value::ranges).  Bricks
+			 *	are only skipped when the TSDF is raycast directly
+			 *	(rather than being converted).  Defaults to \em true.
+			 *
+			 *	\param [in] skip
+			 *		\em true if bricks should be skipped, \em false
+			 *		otherwise.
+			 */
+			void brick_skipping (bool skip) noexcept;
+			/**
+			 *	Determines whether rays step straight out of bricks
+			 *	which cannot contain a surface.
+			 *
+			 *	\return
+			 *		\em true if bricks are skipped, \em false
+			 *		otherwise.
+			 */
+			bool brick_skipping () const noexcept;
 			 
 	};
 	
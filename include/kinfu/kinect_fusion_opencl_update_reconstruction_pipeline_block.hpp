@@ -10,15 +10,21 @@
 #include <boost/compute/command_queue.hpp>
 #include <boost/compute/container/vector.hpp>
 #include <boost/compute/kernel.hpp>
+#include <boost/compute/utility/wait_list.hpp>
 #include <kinfu/depth_device.hpp>
+#include <kinfu/opencl_profiler.hpp>
 #include <kinfu/opencl_program_factory.hpp>
 #include <kinfu/opencl_vector_pipeline_value.hpp>
 #include <kinfu/optional.hpp>
+#include <kinfu/opencl_voxel_pipeline_value.hpp>
 #include <kinfu/pose_estimation_pipeline_block.hpp>
+#include <kinfu/tsdf_slice_sink.hpp>
 #include <kinfu/update_reconstruction_pipeline_block.hpp>
+#include <kinfu/voxel_format.hpp>
 #include <Eigen/Dense>
 #include <cstddef>
 #include <cstdint>
+#include <vector>
 
 
 
@@ -32,26 +38,97 @@ namespace kinfu {
 	 *
 	 *	\sa kinect_fusion
 	 */
-	class kinect_fusion_opencl_update_reconstruction_pipeline_block : public update_reconstruction_pipeline_block {
+	class kinect_fusion_opencl_update_reconstruction_pipeline_block : public update_reconstruction_pipeline_block, public opencl_profiled {
 		
 		
 		private:
+			//	A box of voxels which has been evicted and is
+			//	being downloaded so it may be passed to the sink
+			class pending_slice {
+				
+				
+				public:
+					
+					
+					tsdf_slice_sink::slice slice;
+					std::vector<unsigned char> raw;
+					boost::compute::event event;
+				
+				
+			};
+			
+			
 			opencl_vector_pipeline_value_extractor<float> ve_;
 			boost::compute::kernel tsdf_kernel_;
+			boost::compute::kernel tsdf_sweep_kernel_;
+			boost::compute::kernel evict_kernel_;
+			boost::compute::kernel summarize_kernel_;
 			boost::compute::buffer t_g_k_vec_buf_;
 			boost::compute::buffer ik_buf_;
 			boost::compute::buffer k_buf_;
 			boost::compute::buffer proj_view_buf_;
 			boost::compute::vector<std::uint8_t> weights_;
+			//	Each box evicted by a shift is staged in its own
+			//	buffer so the downloads need not wait on one another
+			std::vector<boost::compute::vector<std::uint8_t>> evicted_;
 			optional<Eigen::Matrix4f> t_g_k_;
 			optional<Eigen::Matrix3f> k_;
+			//	Host copies of the contents of the above buffers,
+			//	these must remain unchanged until the asynchronous
+			//	writes in writes_ complete
+			Eigen::Matrix4f proj_view_;
+			Eigen::Vector3f t_g_k_vec_;
+			Eigen::Matrix3f ik_;
+			Eigen::Matrix3f k_t_;
+			boost::compute::wait_list writes_;
 			float mu_;
 			
 			std::size_t tsdf_width_;
 			std::size_t tsdf_height_;
 			std::size_t tsdf_depth_;
+			Eigen::Vector3f tsdf_extent_;
+			
+			bool reset_;
+			bool culling_;
+			float max_depth_;
+			bool sweep_;
+			voxel_format format_;
+			Eigen::Vector3i origin_;
+			bool rolling_;
+			float shift_threshold_;
+			tsdf_slice_sink * sink_;
+			std::vector<pending_slice> pending_;
 			
-			std::size_t invk_;
+			
+			bool bounds (
+				const Eigen::Matrix4f & t_g_k,
+				const Eigen::Matrix3f & k,
+				std::size_t frame_width,
+				std::size_t frame_height,
+				std::size_t (& offset) [3],
+				std::size_t (& extent) [3]
+			) const;
+			void evict (
+				boost::compute::command_queue & q,
+				opencl_voxel_pipeline_value & tsdf,
+				const Eigen::Vector3i & begin,
+				const Eigen::Vector3i & end,
+				std::size_t slot,
+				boost::compute::wait_list & events
+			);
+			void deliver ();
+			void shift (
+				boost::compute::command_queue & q,
+				opencl_voxel_pipeline_value & tsdf,
+				const Eigen::Vector3i & origin,
+				boost::compute::wait_list & events
+			);
+			boost::compute::event summarize (
+				boost::compute::command_queue & q,
+				opencl_voxel_pipeline_value & tsdf,
+				const std::size_t (& offset) [3],
+				const std::size_t (& extent) [3]
+			);
 		
 		public:
 			
@@ -83,6 +160,11 @@ namespace kinfu {
 			 *		The extent of the TSDF (in meters) in the height direction.
 			 *	\param [in] tsdf_extent_d
 			 *		The extent of the TSDF (in meters) in the depth direction.
+			 *	\param [in] format
+			 *		The \ref voxel_format in which the TSDF shall be stored.
+			 *		The \ref surface_prediction_pipeline_block which consumes
+			 *		the TSDF should be created with the same format to avoid
+			 *		converting it.
 			 */
 			kinect_fusion_opencl_update_reconstruction_pipeline_block (				
 				boost::compute::command_queue q,
@@ -93,10 +175,185 @@ namespace kinfu {
 				std::size_t tsdf_depth=256,
 				float tsdf_extent_w=3.0f,
 				float tsdf_extent_h=3.0f,
-				float tsdf_extent_d=3.0f
+				float tsdf_extent_d=3.0f,
+				voxel_format format=voxel_format::half
 			);
 			
+			~kinect_fusion_opencl_update_reconstruction_pipeline_block () noexcept;
+			
 			virtual value_type operator () (depth_device::value_type::element_type & frame, std::size_t width, std::size_t height, Eigen::Matrix3f k, pose_estimation_pipeline_block::value_type::element_type & T_g_k, value_type v=value_type{});
+			
+			
+			/**
+			 *	Determines whether the TSDF kernel shall be launched
+			 *	only over the voxels within the axis aligned bounding
+			 *	box of the view frustum of the camera.  Culling does
+			 *	not change the result since voxels outside the view
+			 *	frustum are not updated.
+			 *	Defaults to \em true.
+			 *
+			 *	\param [in] culling
+			 *		\em true if the launch should be culled, \em false
+			 *		otherwise.
+			 */
+			void frustum_culling (bool culling) noexcept;
+			/**
+			 *	Determines whether the launch of the TSDF kernel
+			 *	shall be culled to the view frustum of the camera.
+			 *
+			 *	\return
+			 *		\em true if the launch shall be culled, \em false
+			 *		otherwise.
+			 */
+			bool frustum_culling () const noexcept;
+			
+			
+			/**
+			 *	Sets the maximum depth (in meters) of voxels which
+			 *	shall be updated.  Voxels further from the camera
+			 *	are not updated and the view frustum is truncated
+			 *	at this depth when culling.  Defaults to infinity.
+			 *
+			 *	\param [in] depth
+			 *		The maximum depth.
+			 */
+			void max_depth (float depth);
+			/**
+			 *	Determines the maximum depth (in meters) of voxels
+			 *	which shall be updated.
+			 *
+			 *	\return
+			 *		The maximum depth.
+			 */
+			float max_depth () const noexcept;
+			
+			
+			/**
+			 *	Determines whether the TSDF shall be updated by a
+			 *	kernel which is launched over the width and height
+			 *	of the TSDF and sweeps each column along the depth,
+			 *	stepping incrementally in camera space, rather than
+			 *	by a kernel with one work item per voxel.  Defaults
+			 *	to \em false.
+			 *
+			 *	\param [in] sweep
+			 *		\em true if the sweeping kernel should be used,
+			 *		\em false otherwise.
+			 */
+			void sweep (bool sweep) noexcept;
+			/**
+			 *	Determines whether the TSDF shall be updated by a
+			 *	kernel which sweeps each column along the depth.
+			 *
+			 *	\return
+			 *		\em true if the sweeping kernel shall be used,
+			 *		\em false otherwise.
+			 */
+			bool sweep () const noexcept;
+			
+			
+			/**
+			 *	Causes the TSDF to be cleared (i.e. each voxel is given
+			 *	a value of 1 and a weight of 0) before the next frame
+			 *	is integrated.  The storage of the TSDF is reused rather
+			 *	than reallocated.  This allows a scan to be restarted
+			 *	(for example after a \ref pose_estimation_pipeline_block::tracking_lost_error)
+			 *	without recreating this object.
+			 *
+			 *	A TSDF which is allocated by this object is always
+			 *	cleared before the first frame is integrated into it.
+			 */
+			void reset () noexcept;
+			
+			
+			/**
+			 *	Determines whether the volume shall move with the
+			 *	camera.  When the camera moves further than
+			 *	\ref shift_threshold from the center of the volume
+			 *	along any axis the volume is moved by a whole number
+			 *	of voxels so that the camera is at its center.
+			 *
+			 *	The volume is addressed modulo its size so voxels
+			 *	which remain within the volume are not moved.  Voxels
+			 *	which leave the volume are passed to the
+			 *	\ref tsdf_slice_sink (if any) and are then cleared in
+			 *	place so their storage may be reused by the voxels
+			 *	which enter the volume.
+			 *
+			 *	Defaults to \em false.
+			 *
+			 *	\param [in] rolling
+			 *		\em true if the volume should move, \em false
+			 *		otherwise.
+			 */
+			void rolling (bool rolling) noexcept;
+			/**
+			 *	Determines whether the volume shall move with the
+			 *	camera.
+			 *
+			 *	\return
+			 *		\em true if the volume shall move, \em false
+			 *		otherwise.
+			 */
+			bool rolling () const noexcept;
+			/**
+			 *	Sets the distance (in meters) along any axis which
+			 *	the camera must be from the center of the volume
+			 *	before the volume is moved.  Defaults to a quarter
+			 *	of the smallest extent of the volume.
+			 *
+			 *	\param [in] threshold
+			 *		The distance.
+			 */
+			void shift_threshold (float threshold) noexcept;
+			/**
+			 *	Retrieves the distance (in meters) along any axis
+			 *	which the camera must be from the center of the
+			 *	volume before the volume is moved.
+			 *
+			 *	\return
+			 *		The distance.
+			 */
+			float shift_threshold () const noexcept;
+			/**
+			 *	Sets the \ref tsdf_slice_sink to which voxels which
+			 *	leave the volume shall be passed.  The voxels are
+			 *	downloaded asynchronously and are passed to the sink
+			 *	at the start of the next invocation (or by
+			 *	\ref flush_slices) rather than by the invocation
+			 *	which evicts them.
+			 *
+			 *	\param [in] sink
+			 *		A reference to a \ref tsdf_slice_sink.  This
+			 *		reference must remain valid until this object is
+			 *		destroyed or this method is called again.
+			 */
+			void slice_sink (tsdf_slice_sink & sink) noexcept;
+			/**
+			 *	Waits for the voxels which have left the volume but
+			 *	have not yet been passed to the \ref tsdf_slice_sink
+			 *	to be downloaded and passes them to it.  This should
+			 *	be called after the last frame is integrated.
+			 */
+			void flush_slices ();
+			/**
+			 *	Retrieves the voxel coordinate of the first voxel
+			 *	of the volume, which is \f$(0,0,0)\f$ unless the
+			 *	volume has moved.
+			 *
+			 *	\return
+			 *		The origin.
+			 */
+			const Eigen::Vector3i & origin () const noexcept;
+			
+			
+			/**
+			 *	Retrieves the format in which the TSDF is stored.
+			 *
+			 *	\return
+			 *		A \ref voxel_format.
+			 */
+			voxel_format format () const noexcept;
 			 
 	};
 	
@@ -0,0 +1,65 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include <kinfu/tsdf_slice_sink.hpp>
+#include <vector>
+
+
+namespace kinfu {
+
+
+	/**
+	 *	A \ref tsdf_slice_sink which keeps every slice it
+	 *	receives in host memory.
+	 */
+	class memory_tsdf_slice_sink final : public tsdf_slice_sink {
+
+
+		public:
+
+
+			/**
+			 *	The type used to represent a collection of
+			 *	slices.
+			 */
+			using slices_type=std::vector<slice>;
+
+
+		private:
+
+
+			slices_type slices_;
+
+
+		public:
+
+
+			virtual void operator () (slice s) override;
+
+
+			/**
+			 *	Retrieves all slices received since the last call
+			 *	to \ref clear.
+			 *
+			 *	\return
+			 *		A reference to a collection of slices in the
+			 *		order they were received.
+			 */
+			const slices_type & slices () const noexcept;
+
+
+			/**
+			 *	Discards all slices received thus far.
+			 */
+			void clear () noexcept;
+
+
+	};
+
+
+}
@@ -0,0 +1,36 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include <Eigen/Dense>
+
+
+namespace kinfu {
+
+
+	/**
+	 *	Extrapolates a sensor pose from the two poses which
+	 *	precede it assuming the sensor moves with constant
+	 *	velocity.
+	 *
+	 *	The motion between the two previous frames (expressed
+	 *	in the frame of the sensor at \f$k-2\f$) is applied once
+	 *	more to the pose at \f$k-1\f$.  That is the result is
+	 *	\f$T_{g,k-1}T_{g,k-2}^{-1}T_{g,k-1}\f$.
+	 *
+	 *	\param [in] t_gk_minus_two
+	 *		\f$T_{g,k-2}\f$
+	 *	\param [in] t_gk_minus_one
+	 *		\f$T_{g,k-1}\f$
+	 *
+	 *	\return
+	 *		The predicted \f$T_{g,k}\f$.
+	 */
+	Eigen::Matrix4f constant_velocity (const Eigen::Matrix4f & t_gk_minus_two, const Eigen::Matrix4f & t_gk_minus_one) noexcept;
+
+
+}
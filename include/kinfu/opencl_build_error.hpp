@@ -154,11 +154,13 @@ namespace kinfu {
 			 *		to be built shall be drawn.
 			 *	\param [in] ctx
 			 *		The OpenCL context within which to build the program.
+			 *	\param [in] options
+			 *		The options to pass to the OpenCL compiler.
 			 *
 			 *	\return
 			 *		The program built from the source held in file \em path.
 			 */
-			static boost::compute::program build (const filesystem::path & path, const boost::compute::context & ctx);
+			static boost::compute::program build (const filesystem::path & path, const boost::compute::context & ctx, const std::string & options=std::string());
 			
 			
 			/**
@@ -6,8 +6,16 @@
 #pragma once
 
 
+#include <boost/compute/buffer.hpp>
 #include <boost/compute/command_queue.hpp>
+#include <boost/compute/event.hpp>
+#include <boost/compute/kernel.hpp>
 #include <kinfu/depth_device_decorator.hpp>
+#include <kinfu/opencl_profiler.hpp>
+#include <kinfu/opencl_program_factory.hpp>
+#include <kinfu/optional.hpp>
+#include <cstddef>
+#include <vector>
 
 
 namespace kinfu {
@@ -16,14 +24,42 @@ namespace kinfu {
 	/**
 	 *	Decorates a \ref depth_device and uploads all
 	 *	generated depth frames to the GPU.
+	 *
+	 *	Frames are copied into one of a ring of pinned
+	 *	staging buffers and uploaded therefrom without
+	 *	blocking so that obtaining each frame may overlap
+	 *	with uploading and processing those before it.
 	 */
-	class opencl_depth_device final : public depth_device_decorator {
+	class opencl_depth_device final : public depth_device_decorator, public opencl_profiled {
 		
 		
 		private:
 		
 		
 			boost::compute::command_queue q_;
+			optional<boost::compute::kernel> kernel_;
+			
+			
+			class staging_buffer {
+				
+				
+				public:
+				
+				
+					boost::compute::buffer buffer;
+					void * ptr=nullptr;
+					std::size_t size=0;
+					boost::compute::event event;
+				
+				
+			};
+			
+			
+			std::vector<staging_buffer> staging_;
+			std::size_t next_;
+			
+			
+			boost::compute::event upload (const void * src, std::size_t size, const boost::compute::buffer & dest);
 			
 			
 		public:
@@ -42,8 +78,35 @@ namespace kinfu {
 			 *		The boost::compute::command_queue which
 			 *		the newly created opencl_depth_device shall
 			 *		use to dispatch commands to the GPU.
+			 *	\param [in] staging
+			 *		The number of staging buffers.  Defaults to 3.
+			 */
+			opencl_depth_device (depth_device & dev, boost::compute::command_queue q, std::size_t staging=3);
+			/**
+			 *	Creates a new opencl_depth_device which uploads
+			 *	frames represented by a \ref raw_depth_pipeline_value
+			 *	in their native 16 bit representation and converts
+			 *	them to meters on the GPU.
+			 *
+			 *	\param [in] dev
+			 *		The \ref depth_device which the newly
+			 *		created object shall decorate.
+			 *	\param [in] q
+			 *		The boost::compute::command_queue which
+			 *		the newly created opencl_depth_device shall
+			 *		use to dispatch commands to the GPU.
+			 *	\param [in] opf
+			 *		An \ref opencl_program_factory which the newly
+			 *		created object shall use to obtain OpenCL programs.
+			 *	\param [in] staging
+			 *		The number of staging buffers.  Defaults to 3.
+			 */
+			opencl_depth_device (depth_device & dev, boost::compute::command_queue q, opencl_program_factory & opf, std::size_t staging=3);
+			/**
+			 *	Waits for all outstanding uploads to complete
+			 *	and releases the staging buffers.
 			 */
-			opencl_depth_device (depth_device & dev, boost::compute::command_queue q);
+			~opencl_depth_device () noexcept;
 			
 			
 			virtual value_type operator () (value_type v=value_type{}) override;
@@ -0,0 +1,280 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include <boost/compute/command_queue.hpp>
+#include <boost/compute/container/vector.hpp>
+#include <boost/compute/utility/wait_list.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <kinfu/filesystem.hpp>
+#include <kinfu/half.hpp>
+#include <kinfu/opencl_pipeline_value.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace kinfu {
+
+
+	/**
+	 *	Represents a dense TSDF which is split into cubic chunks
+	 *	of which only some are resident on the GPU at any one
+	 *	time.  The remainder are stored in a memory mapped file
+	 *	on the host (see cl/paging.cl for the layout of resident
+	 *	chunks).
+	 *
+	 *	Each chunk is resident in one of a fixed number of slots.
+	 *	Chunks are written back to the file only when their slot
+	 *	is required for another chunk or when \ref flush is
+	 *	invoked.  Chunks which have never been written back have
+	 *	a TSDF value of 1 and a weight of 0.
+	 *
+	 *	The value presented to consumers on the CPU is the
+	 *	entire TSDF assembled from the file.
+	 */
+	class opencl_paged_voxel_pipeline_value final : public opencl_pipeline_value<std::vector<half>> {
+
+
+		private:
+
+
+			using base=opencl_pipeline_value<std::vector<half>>;
+
+
+			std::size_t width_;
+			std::size_t height_;
+			std::size_t depth_;
+			std::size_t chunk_size_;
+			std::size_t chunks_x_;
+			std::size_t chunks_y_;
+			std::size_t chunks_z_;
+			boost::interprocess::file_mapping file_;
+			boost::interprocess::mapped_region region_;
+			std::vector<bool> stored_;
+			//	Host copies of the contents of table_gpu_ and
+			//	slot_chunks_gpu_, these must remain unchanged until
+			//	the asynchronous writes in writes_ complete
+			std::vector<std::int32_t> table_;
+			std::vector<std::int32_t> slot_chunks_;
+			boost::compute::vector<half> tsdf_;
+			boost::compute::vector<std::uint8_t> weights_;
+			boost::compute::vector<std::int32_t> table_gpu_;
+			boost::compute::vector<std::int32_t> slot_chunks_gpu_;
+			//	Transfers between the GPU and the file (or the above
+			//	host copies) which have not yet completed
+			boost::compute::wait_list writes_;
+			std::vector<half> cpu_;
+			bool dirty_;
+
+
+			unsigned char * chunk_data (std::size_t chunk) noexcept;
+			void page_out (boost::compute::command_queue & q, std::size_t slot);
+			void page_in (boost::compute::command_queue & q, std::size_t chunk, std::size_t slot);
+			void upload (boost::compute::command_queue & q);
+
+
+		public:
+
+
+			/**
+			 *	Creates a new opencl_paged_voxel_pipeline_value.  The
+			 *	TSDF must be cleared before it is used.
+			 *
+			 *	\param [in] q
+			 *		The boost::compute::command_queue which will
+			 *		be associated with this pipeline value.
+			 *	\param [in] path
+			 *		The path of the file in which chunks which are
+			 *		not resident are stored.  The file is created
+			 *		or overwritten.
+			 *	\param [in] width
+			 *		The width of the TSDF in voxels.
+			 *	\param [in] height
+			 *		The height of the TSDF in voxels.
+			 *	\param [in] depth
+			 *		The depth of the TSDF in voxels.
+			 *	\param [in] chunk_size
+			 *		The number of voxels along each edge of a chunk.
+			 *	\param [in] slots
+			 *		The number of chunks which may be resident on
+			 *		the GPU.
+			 */
+			opencl_paged_voxel_pipeline_value (
+				boost::compute::command_queue q,
+				const filesystem::path & path,
+				std::size_t width,
+				std::size_t height,
+				std::size_t depth,
+				std::size_t chunk_size,
+				std::size_t slots
+			);
+
+
+			opencl_paged_voxel_pipeline_value (const opencl_paged_voxel_pipeline_value &) = delete;
+			opencl_paged_voxel_pipeline_value & operator = (const opencl_paged_voxel_pipeline_value &) = delete;
+
+
+			/**
+			 *	Blocks until all transfers to and from the file
+			 *	have completed.
+			 */
+			~opencl_paged_voxel_pipeline_value () noexcept;
+
+
+			/**
+			 *	Enqueues commands which empty the TSDF and evicts
+			 *	all chunks without writing them back.
+			 */
+			void clear ();
+
+
+			/**
+			 *	Enqueues commands which make certain chunks resident.
+			 *
+			 *	Chunks which are already resident remain in their
+			 *	slots.  Other chunks are assigned slots, in order,
+			 *	from those which are empty or which hold a chunk not
+			 *	in \em chunks (the latter being written back to the
+			 *	file) until no such slots remain.
+			 *
+			 *	Blocks only until the transfers enqueued by the
+			 *	previous invocation have completed.
+			 *
+			 *	\param [in] chunks
+			 *		The index of each chunk, in order of priority.
+			 */
+			void require (const std::vector<std::size_t> & chunks);
+
+
+			/**
+			 *	Writes all resident chunks back to the file and
+			 *	blocks until they have been written.
+			 */
+			void flush ();
+
+
+			/**
+			 *	Retrieves the width of the TSDF.
+			 *
+			 *	\return
+			 *		The width in voxels.
+			 */
+			std::size_t width () const noexcept;
+			/**
+			 *	Retrieves the height of the TSDF.
+			 *
+			 *	\return
+			 *		The height in voxels.
+			 */
+			std::size_t height () const noexcept;
+			/**
+			 *	Retrieves the depth of the TSDF.
+			 *
+			 *	\return
+			 *		The depth in voxels.
+			 */
+			std::size_t depth () const noexcept;
+			/**
+			 *	Retrieves the number of voxels along each edge of
+			 *	a chunk.
+			 *
+			 *	\return
+			 *		The chunk size.
+			 */
+			std::size_t chunk_size () const noexcept;
+			/**
+			 *	Retrieves the number of chunks along the x axis.
+			 *
+			 *	\return
+			 *		The number of chunks.
+			 */
+			std::size_t chunks_x () const noexcept;
+			/**
+			 *	Retrieves the number of chunks along the y axis.
+			 *
+			 *	\return
+			 *		The number of chunks.
+			 */
+			std::size_t chunks_y () const noexcept;
+			/**
+			 *	Retrieves the number of chunks along the z axis.
+			 *
+			 *	\return
+			 *		The number of chunks.
+			 */
+			std::size_t chunks_z () const noexcept;
+			/**
+			 *	Retrieves the number of chunks which may be resident.
+			 *
+			 *	\return
+			 *		The number of slots.
+			 */
+			std::size_t slots () const noexcept;
+			/**
+			 *	Determines how many chunks are resident.
+			 *
+			 *	\return
+			 *		The number of occupied slots.
+			 */
+			std::size_t resident () const noexcept;
+
+
+			/**
+			 *	Returns a reference to the TSDF value of each voxel
+			 *	of each slot.
+			 *
+			 *	Invoking this or any other non-const method which
+			 *	returns GPU storage causes the CPU copy (if any) to
+			 *	be considered dirty.
+			 *
+			 *	\return
+			 *		A reference to GPU storage.
+			 */
+			boost::compute::vector<half> & tsdf () noexcept;
+			/**
+			 *	Returns a reference to the TSDF value of each voxel
+			 *	of each slot.
+			 *
+			 *	\return
+			 *		A reference to GPU storage.
+			 */
+			const boost::compute::vector<half> & tsdf () const noexcept;
+			/**
+			 *	Returns a reference to the weight of each voxel of
+			 *	each slot.
+			 *
+			 *	\return
+			 *		A reference to GPU storage.
+			 */
+			boost::compute::vector<std::uint8_t> & weights () noexcept;
+			/**
+			 *	Returns a reference to the slot in which each chunk
+			 *	is resident (or -1).
+			 *
+			 *	\return
+			 *		A reference to GPU storage.
+			 */
+			const boost::compute::vector<std::int32_t> & table () const noexcept;
+			/**
+			 *	Returns a reference to the chunk resident in each
+			 *	slot (or -1).
+			 *
+			 *	\return
+			 *		A reference to GPU storage.
+			 */
+			const boost::compute::vector<std::int32_t> & slot_chunks () const noexcept;
+
+
+			virtual const std::vector<half> & get () override;
+
+
+	};
+
+
+}
@@ -9,6 +9,8 @@
 #include <boost/compute/command_queue.hpp>
 #include <boost/compute/context.hpp>
 #include <boost/compute/device.hpp>
+#include <boost/compute/event.hpp>
+#include <boost/compute/utility/wait_list.hpp>
 #include <kinfu/pipeline_value.hpp>
 #include <utility>
 
@@ -32,6 +34,7 @@ namespace kinfu {
 		
 		
 			boost::compute::command_queue q_;
+			boost::compute::wait_list events_;
 			
 			
 		public:
@@ -106,6 +109,91 @@ namespace kinfu {
 			}
 			
 			
+			/**
+			 *	Retrieves the OpenCL events which must complete
+			 *	before the value represented by this object is
+			 *	available on the GPU.
+			 *
+			 *	Commands enqueued on a command queue other than the
+			 *	one associated with this object which consume the
+			 *	value represented by this object should wait on
+			 *	these events.
+			 *
+			 *	If no events have been associated with this object
+			 *	the returned wait list shall be empty in which case
+			 *	the value represented by this object is available
+			 *	only once all commands enqueued on the associated
+			 *	command queue have completed.
+			 *
+			 *	\return
+			 *		A wait list.
+			 */
+			const boost::compute::wait_list & events () const noexcept {
+				
+				return events_;
+				
+			}
+			
+			
+			/**
+			 *	Sets the OpenCL events which must complete before
+			 *	the value represented by this object is available
+			 *	on the GPU.
+			 *
+			 *	Producers should invoke this method each time they
+			 *	enqueue commands which update the value represented
+			 *	by this object.
+			 *
+			 *	\param [in] events
+			 *		A wait list.
+			 */
+			void events (boost::compute::wait_list events) noexcept {
+				
+				events_=std::move(events);
+				
+			}
+			
+			
+			/**
+			 *	Sets the OpenCL event which must complete before
+			 *	the value represented by this object is available
+			 *	on the GPU.
+			 *
+			 *	\param [in] event
+			 *		The event.
+			 */
+			void event (boost::compute::event event) {
+				
+				events_.clear();
+				events_.insert(std::move(event));
+				
+			}
+			
+			
+			/**
+			 *	Blocks until the value represented by this object
+			 *	is available on the GPU.
+			 *
+			 *	If no events have been associated with this object
+			 *	all commands enqueued on the associated command queue
+			 *	are waited on.
+			 */
+			void wait () const {
+				
+				if (events_.empty()) {
+					
+					//	Must be a mutable lvalue
+					auto q=q_;
+					q.finish();
+					return;
+					
+				}
+				
+				events_.wait();
+				
+			}
+			
+			
 			/**
 			 *	Checks the compatibility of this object with another
 			 *	OpenCL command queue, context, and device.
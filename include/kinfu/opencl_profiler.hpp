@@ -0,0 +1,119 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include <boost/compute/event.hpp>
+#include <kinfu/profiler.hpp>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace kinfu {
+
+
+	/**
+	 *	A \ref profiler which obtains timings from OpenCL
+	 *	events.
+	 *
+	 *	Events recorded by this object must have been enqueued
+	 *	on a command queue created with CL_QUEUE_PROFILING_ENABLE
+	 *	or retrieving the records shall fail.
+	 *
+	 *	Operations may be recorded from multiple threads
+	 *	simultaneously.
+	 */
+	class opencl_profiler final : public profiler {
+
+
+		private:
+
+
+			std::mutex m_;
+			std::vector<std::pair<std::string,boost::compute::event>> pending_;
+			records_type records_;
+
+
+		public:
+
+
+			/**
+			 *	Records an operation.
+			 *
+			 *	\param [in] name
+			 *		The name of the operation.
+			 *	\param [in] event
+			 *		The event associated with the operation.
+			 *
+			 *	\return
+			 *		\em event.
+			 */
+			boost::compute::event operator () (std::string name, boost::compute::event event);
+
+
+			virtual void clear () override;
+			virtual const records_type & records () override;
+
+
+	};
+
+
+	/**
+	 *	A base class for objects which issue OpenCL commands
+	 *	and may optionally report them to an \ref opencl_profiler.
+	 */
+	class opencl_profiled {
+
+
+		private:
+
+
+			opencl_profiler * p_;
+
+
+		protected:
+
+
+			/**
+			 *	Records an operation with the associated
+			 *	\ref opencl_profiler, if any.
+			 *
+			 *	\param [in] name
+			 *		The name of the operation.
+			 *	\param [in] event
+			 *		The event associated with the operation.
+			 *
+			 *	\return
+			 *		\em event.
+			 */
+			boost::compute::event profile (const char * name, boost::compute::event event);
+
+
+		public:
+
+
+			opencl_profiled () noexcept;
+
+
+			/**
+			 *	Sets the \ref opencl_profiler to which all OpenCL
+			 *	commands subsequently issued by this object shall
+			 *	be reported.
+			 *
+			 *	\param [in] p
+			 *		A reference to the \ref opencl_profiler.  This
+			 *		reference must remain valid as long as this object
+			 *		is in use or the behaviour is undefined.
+			 */
+			void profiler (opencl_profiler & p) noexcept;
+
+
+	};
+
+
+}
@@ -48,6 +48,22 @@ namespace kinfu {
 			 *		The program referred to by \em name.
 			 */
 			virtual boost::compute::program operator () (const std::string & name) = 0;
+			/**
+			 *	Retrieves a boost::compute::program given
+			 *	a program name and the options with which it
+			 *	shall be built.
+			 *
+			 *	\param [in] name
+			 *		The name of the program to retrieve.
+			 *	\param [in] options
+			 *		The options (e.g. preprocessor definitions)
+			 *		to pass to the OpenCL compiler.
+			 *
+			 *	\return
+			 *		The program referred to by \em name built
+			 *		with \em options.
+			 */
+			virtual boost::compute::program operator () (const std::string & name, const std::string & options) = 0;
 		
 		
 	};
@@ -7,12 +7,14 @@
 
 
 #include <boost/compute/algorithm/copy.hpp>
+#include <boost/compute/buffer.hpp>
 #include <boost/compute/command_queue.hpp>
 #include <boost/compute/container/vector.hpp>
+#include <boost/compute/utility/wait_list.hpp>
 #include <kinfu/opencl_pipeline_value.hpp>
 #include <kinfu/pipeline_value.hpp>
 #include <kinfu/optional.hpp>
-#include <iterator>
+#include <cstddef>
 #include <utility>
 #include <vector>
 
@@ -45,10 +47,13 @@ namespace kinfu {
 				
 				if (!dirty_) return;
 				
-				cpu_.clear();
+				//	Resizing rather than clearing and appending
+				//	means storage is only reallocated when the
+				//	size changes
+				cpu_.resize(gpu_.size());
 				//	Must be a mutable lvalue reference
 				auto q=base::command_queue();
-				boost::compute::copy(gpu_.begin(),gpu_.end(),std::back_inserter(cpu_),q);
+				boost::compute::copy(gpu_.begin(),gpu_.end(),cpu_.begin(),q);
 				
 				dirty_=false;
 				
@@ -58,6 +63,143 @@ namespace kinfu {
 		public:
 		
 		
+			/**
+			 *	A read only view of the GPU storage of an
+			 *	opencl_vector_pipeline_value which is mapped
+			 *	into host memory.
+			 *
+			 *	The storage remains mapped for the lifetime of
+			 *	this object.  On devices which share memory with
+			 *	the host (such as CPU devices) this is a true alias
+			 *	of the GPU storage and no copy is made.
+			 */
+			class view {
+				
+				
+				private:
+				
+				
+					boost::compute::command_queue q_;
+					boost::compute::buffer buffer_;
+					const T * ptr_;
+					std::size_t size_;
+					
+					
+					void unmap () noexcept {
+						
+						if (!ptr_) return;
+						//	Errors cannot be reported from a destructor
+						try {
+							
+							q_.enqueue_unmap_buffer(buffer_,const_cast<T *>(ptr_)).wait();
+							
+						} catch (...) {	}
+						ptr_=nullptr;
+						
+					}
+				
+				
+				public:
+				
+				
+					using value_type=T;
+					using const_iterator=const T *;
+					using iterator=const_iterator;
+					
+					
+					view () = delete;
+					view (const view &) = delete;
+					view & operator = (const view &) = delete;
+					
+					
+					view (boost::compute::command_queue q, const boost::compute::buffer & buffer, std::size_t size, const boost::compute::wait_list & events)
+						:	q_(std::move(q)),
+							buffer_(buffer),
+							ptr_(nullptr),
+							size_(size)
+					{
+						
+						if (size_==0) return;
+						ptr_=static_cast<const T *>(q_.enqueue_map_buffer(buffer_,CL_MAP_READ,0,size_*sizeof(T),events));
+						
+					}
+					
+					
+					view (view && other) noexcept : q_(std::move(other.q_)), buffer_(std::move(other.buffer_)), ptr_(other.ptr_), size_(other.size_) {
+						
+						other.ptr_=nullptr;
+						other.size_=0;
+						
+					}
+					
+					
+					view & operator = (view && other) noexcept {
+						
+						unmap();
+						q_=std::move(other.q_);
+						buffer_=std::move(other.buffer_);
+						ptr_=other.ptr_;
+						size_=other.size_;
+						other.ptr_=nullptr;
+						other.size_=0;
+						
+						return *this;
+						
+					}
+					
+					
+					~view () noexcept {
+						
+						unmap();
+						
+					}
+					
+					
+					const T * data () const noexcept {
+						
+						return ptr_;
+						
+					}
+					
+					
+					std::size_t size () const noexcept {
+						
+						return size_;
+						
+					}
+					
+					
+					bool empty () const noexcept {
+						
+						return size_==0;
+						
+					}
+					
+					
+					const_iterator begin () const noexcept {
+						
+						return ptr_;
+						
+					}
+					
+					
+					const_iterator end () const noexcept {
+						
+						return ptr_+size_;
+						
+					}
+					
+					
+					const T & operator [] (std::size_t i) const noexcept {
+						
+						return ptr_[i];
+						
+					}
+				
+				
+			};
+		
+		
 			/**
 			 *	Creates a new opencl_vector_pipeline_value.
 			 *
@@ -102,6 +244,23 @@ namespace kinfu {
 			}
 			
 			
+			/**
+			 *	Maps the GPU storage into host memory rather than
+			 *	downloading it.
+			 *
+			 *	Modifying the GPU storage while the returned view
+			 *	persists results in undefined behaviour.
+			 *
+			 *	\return
+			 *		A \ref view of the GPU storage.
+			 */
+			view map () const {
+				
+				return view(base::command_queue(),gpu_.get_buffer(),gpu_.size(),base::events());
+				
+			}
+			
+			
 			virtual const std::vector<T> & get () override {
 				
 				download();
@@ -177,15 +336,23 @@ namespace kinfu {
 			 *	associated with this object which contains a copy of
 			 *	the data in a particular \ref pipeline_value.
 			 *
+			 *	Rather than blocking until the value is available the
+			 *	events which must complete before the returned vector
+			 *	may be used are added to a wait list.  Commands which
+			 *	consume the returned vector must wait on these events.
+			 *
 			 *	\param [in] pv
 			 *		The \ref pipeline_value whose value shall be extracted.
+			 *	\param [in,out] events
+			 *		A wait list to which the events which must complete
+			 *		before the returned vector may be used shall be added.
 			 *
 			 *	\return
 			 *		A reference to a boost::compute::vector.  This reference
 			 *		shall remain valid as long as the lifetime of both this
 			 *		object and \em pv persist.
 			 */
-			boost::compute::vector<T> & operator () (pipeline_value<std::vector<T>> & pv) {
+			boost::compute::vector<T> & operator () (pipeline_value<std::vector<T>> & pv, boost::compute::wait_list & events) {
 				
 				auto ptr=dynamic_cast<opencl_vector_pipeline_value<T> *>(&pv);
 				if (!ptr) return from_vector(pv.get());
@@ -194,7 +361,11 @@ namespace kinfu {
 				switch (ptr->check(q_)) {
 					
 					case compatibility::same_context:
-						ptr->command_queue().finish();
+						//	Producers which do not record events
+						//	can only be synchronized with by
+						//	waiting on their entire queue
+						if (ptr->events().empty()) ptr->wait();
+						for (auto && e : ptr->events()) events.insert(e);
 					case compatibility::same_queue:
 						return ptr->vector();
 					default:
@@ -207,6 +378,32 @@ namespace kinfu {
 			}
 			
 			
+			/**
+			 *	Obtains a boost::compute::vector in the context and
+			 *	on the device associated with the boost::compute::command_queue
+			 *	associated with this object which contains a copy of
+			 *	the data in a particular \ref pipeline_value.
+			 *
+			 *	Blocks until the value is available.
+			 *
+			 *	\param [in] pv
+			 *		The \ref pipeline_value whose value shall be extracted.
+			 *
+			 *	\return
+			 *		A reference to a boost::compute::vector.  This reference
+			 *		shall remain valid as long as the lifetime of both this
+			 *		object and \em pv persist.
+			 */
+			boost::compute::vector<T> & operator () (pipeline_value<std::vector<T>> & pv) {
+				
+				boost::compute::wait_list events;
+				auto && retr=(*this)(pv,events);
+				events.wait();
+				return retr;
+				
+			}
+			
+			
 			/**
 			 *	Retrieves the boost::compute::command_queue
 			 *	associated with this object.
@@ -0,0 +1,112 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include <boost/compute/command_queue.hpp>
+#include <boost/compute/container/vector.hpp>
+#include <kinfu/opencl_vector_pipeline_value.hpp>
+#include <cstddef>
+#include <vector>
+
+
+namespace kinfu {
+
+
+	/**
+	 *	Represents a vector of values stored on the GPU
+	 *	together with successively coarser versions of
+	 *	those values.
+	 *
+	 *	Level zero is the finest level and is the vector
+	 *	wrapped by the \ref opencl_vector_pipeline_value
+	 *	base class, so that consumers which are unaware
+	 *	of the coarser levels see only the finest level.
+	 *	Each level after that has half the width and half
+	 *	the height (rounded down) of the level before it.
+	 *
+	 *	The events associated with this object (if any)
+	 *	cover all levels.
+	 *
+	 *	\tparam T
+	 *		The element type.
+	 */
+	template <typename T>
+	class opencl_vector_pyramid_pipeline_value : public opencl_vector_pipeline_value<T> {
+
+
+		private:
+
+
+			using base=opencl_vector_pipeline_value<T>;
+
+
+			std::vector<boost::compute::vector<T>> levels_;
+
+
+		public:
+
+
+			using base::base;
+
+
+			/**
+			 *	Retrieves the number of levels, including the
+			 *	finest level.
+			 *
+			 *	\return
+			 *		The number of levels.
+			 */
+			std::size_t levels () const noexcept {
+
+				return levels_.size()+1U;
+
+			}
+			/**
+			 *	Sets the number of levels, including the finest
+			 *	level.
+			 *
+			 *	Levels which are added are empty.
+			 *
+			 *	\param [in] n
+			 *		The number of levels.  Must be at least one.
+			 */
+			void levels (std::size_t n) {
+
+				auto ctx=base::context();
+				while (levels_.size()>(n-1U)) levels_.pop_back();
+				while (levels_.size()<(n-1U)) levels_.emplace_back(ctx);
+
+			}
+
+
+			/**
+			 *	Returns a reference to the boost::compute::vector
+			 *	which holds a certain level.
+			 *
+			 *	The same restrictions which apply to the reference
+			 *	returned by \ref opencl_vector_pipeline_value::vector
+			 *	apply to the returned reference.
+			 *
+			 *	\param [in] i
+			 *		The level.  If this is greater than or equal to
+			 *		\ref levels the behaviour is undefined.
+			 *
+			 *	\return
+			 *		A reference to the GPU storage for level \em i.
+			 */
+			boost::compute::vector<T> & level (std::size_t i) noexcept {
+
+				if (i==0) return base::vector();
+				return levels_[i-1U];
+
+			}
+
+
+	};
+
+
+}
@@ -0,0 +1,225 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include <boost/compute/command_queue.hpp>
+#include <boost/compute/container/vector.hpp>
+#include <kinfu/half.hpp>
+#include <kinfu/opencl_pipeline_value.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace kinfu {
+
+
+	/**
+	 *	The number of voxels along each edge of the bricks of
+	 *	an \ref opencl_voxel_hash_pipeline_value.
+	 */
+	constexpr std::size_t voxel_hash_brick_size=8U;
+
+
+	/**
+	 *	Represents a sparse TSDF stored on the GPU as bricks of
+	 *	\ref voxel_hash_brick_size voxels per side which are
+	 *	located via a hash table keyed by brick coordinate (see
+	 *	cl/hashing.cl for the layout).
+	 *
+	 *	The value presented to consumers on the CPU is a dense
+	 *	TSDF of a certain width, height, and depth whose first
+	 *	voxel is the voxel at the origin.  Voxels in bricks which
+	 *	are not allocated have a value of 1.  Bricks may be
+	 *	allocated anywhere within the range of the hash keys but
+	 *	only voxels within that region are presented, the
+	 *	remainder are only accessible on the GPU.
+	 */
+	class opencl_voxel_hash_pipeline_value final : public opencl_pipeline_value<std::vector<half>> {
+
+
+		private:
+
+
+			using base=opencl_pipeline_value<std::vector<half>>;
+
+
+			float voxel_size_;
+			std::size_t width_;
+			std::size_t height_;
+			std::size_t depth_;
+			boost::compute::vector<std::uint32_t> keys_;
+			boost::compute::vector<std::int32_t> ptrs_;
+			boost::compute::vector<std::uint32_t> brick_keys_;
+			boost::compute::vector<half> tsdf_;
+			boost::compute::vector<std::uint8_t> weights_;
+			boost::compute::vector<std::uint32_t> count_;
+			std::vector<half> cpu_;
+			bool dirty_;
+
+
+		public:
+
+
+			/**
+			 *	Creates a new opencl_voxel_hash_pipeline_value.  The
+			 *	TSDF must be cleared before it is used.
+			 *
+			 *	\param [in] q
+			 *		The boost::compute::command_queue which will
+			 *		be associated with this pipeline value.
+			 *	\param [in] buckets
+			 *		The number of slots in the hash table.
+			 *	\param [in] bricks
+			 *		The maximum number of bricks which may be allocated.
+			 *	\param [in] voxel_size
+			 *		The edge length of each voxel in meters.
+			 *	\param [in] width
+			 *		The width of the dense TSDF presented on the CPU.
+			 *	\param [in] height
+			 *		The height of the dense TSDF presented on the CPU.
+			 *	\param [in] depth
+			 *		The depth of the dense TSDF presented on the CPU.
+			 */
+			opencl_voxel_hash_pipeline_value (
+				boost::compute::command_queue q,
+				std::size_t buckets,
+				std::size_t bricks,
+				float voxel_size,
+				std::size_t width,
+				std::size_t height,
+				std::size_t depth
+			);
+
+
+			/**
+			 *	Enqueues commands which empty the hash table and
+			 *	the brick pool and associates them with this object.
+			 */
+			void clear ();
+
+
+			/**
+			 *	Determines how many bricks have been allocated.  Blocks
+			 *	until the value represented by this object is available.
+			 *
+			 *	\return
+			 *		The number of bricks allocated, which may exceed
+			 *		\ref bricks if the pool has been exhausted.
+			 */
+			std::size_t allocated () const;
+
+
+			/**
+			 *	Retrieves the number of slots in the hash table.
+			 *
+			 *	\return
+			 *		The number of slots.
+			 */
+			std::size_t buckets () const noexcept;
+			/**
+			 *	Retrieves the maximum number of bricks which may be
+			 *	allocated.
+			 *
+			 *	\return
+			 *		The size of the brick pool.
+			 */
+			std::size_t bricks () const noexcept;
+			/**
+			 *	Retrieves the edge length of each voxel.
+			 *
+			 *	\return
+			 *		The edge length in meters.
+			 */
+			float voxel_size () const noexcept;
+
+
+			/**
+			 *	Returns a reference to the key of the brick in each
+			 *	slot of the hash table.
+			 *
+			 *	Invoking this or any other non-const method which
+			 *	returns GPU storage causes the CPU copy (if any) to
+			 *	be considered dirty.
+			 *
+			 *	\return
+			 *		A reference to GPU storage.
+			 */
+			boost::compute::vector<std::uint32_t> & keys () noexcept;
+			/**
+			 *	Returns a reference to the key of the brick in each
+			 *	slot of the hash table.
+			 *
+			 *	\return
+			 *		A reference to GPU storage.
+			 */
+			const boost::compute::vector<std::uint32_t> & keys () const noexcept;
+			/**
+			 *	Returns a reference to the index in the brick pool of
+			 *	the brick in each slot of the hash table.
+			 *
+			 *	\return
+			 *		A reference to GPU storage.
+			 */
+			boost::compute::vector<std::int32_t> & pointers () noexcept;
+			/**
+			 *	Returns a reference to the index in the brick pool of
+			 *	the brick in each slot of the hash table.
+			 *
+			 *	\return
+			 *		A reference to GPU storage.
+			 */
+			const boost::compute::vector<std::int32_t> & pointers () const noexcept;
+			/**
+			 *	Returns a reference to the key of each brick in the
+			 *	brick pool.
+			 *
+			 *	\return
+			 *		A reference to GPU storage.
+			 */
+			boost::compute::vector<std::uint32_t> & brick_keys () noexcept;
+			/**
+			 *	Returns a reference to the TSDF value of each voxel of
+			 *	each brick in the brick pool.
+			 *
+			 *	\return
+			 *		A reference to GPU storage.
+			 */
+			boost::compute::vector<half> & tsdf () noexcept;
+			/**
+			 *	Returns a reference to the TSDF value of each voxel of
+			 *	each brick in the brick pool.
+			 *
+			 *	\return
+			 *		A reference to GPU storage.
+			 */
+			const boost::compute::vector<half> & tsdf () const noexcept;
+			/**
+			 *	Returns a reference to the weight of each voxel of each
+			 *	brick in the brick pool.
+			 *
+			 *	\return
+			 *		A reference to GPU storage.
+			 */
+			boost::compute::vector<std::uint8_t> & weights () noexcept;
+			/**
+			 *	Returns a reference to the number of bricks which have
+			 *	been allocated.
+			 *
+			 *	\return
+			 *		A reference to GPU storage holding one value.
+			 */
+			boost::compute::vector<std::uint32_t> & count () noexcept;
+
+
+			virtual const std::vector<half> & get () override;
+
+
+	};
+
+
+}
@@ -0,0 +1,303 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include <boost/compute/buffer.hpp>
+#include <boost/compute/command_queue.hpp>
+#include <boost/compute/container/vector.hpp>
+#include <boost/compute/utility/wait_list.hpp>
+#include <kinfu/half.hpp>
+#include <kinfu/opencl_pipeline_value.hpp>
+#include <kinfu/voxel_format.hpp>
+#include <Eigen/Dense>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace kinfu {
+
+
+	/**
+	 *	The number of voxels along each edge of the bricks
+	 *	summarized by an \ref opencl_voxel_pipeline_value.
+	 */
+	constexpr std::size_t tsdf_brick_size=8U;
+
+
+	/**
+	 *	Represents a TSDF stored on the GPU in a certain
+	 *	\ref voxel_format.
+	 *
+	 *	The value presented to consumers on the CPU is the
+	 *	TSDF values converted to half precision (the weights
+	 *	are not presented).  Consumers which only read the
+	 *	values once may \ref map the GPU storage rather than
+	 *	converting all of it to a host copy.
+	 *
+	 *	The volume is addressed modulo its size so that it may
+	 *	be moved by changing its \ref origin without moving
+	 *	any voxels.  The value presented on the CPU is ordered
+	 *	starting from the voxel at the origin.
+	 *
+	 *	The volume is also summarized as bricks of
+	 *	\ref tsdf_brick_size voxels per side, each having the
+	 *	minimum and maximum TSDF value of its voxels and whether
+	 *	any of its voxels has been observed.  Like voxels bricks
+	 *	are indexed by where they are stored.
+	 */
+	class opencl_voxel_pipeline_value final : public opencl_pipeline_value<std::vector<half>> {
+
+
+		private:
+
+
+			using base=opencl_pipeline_value<std::vector<half>>;
+
+
+			voxel_format format_;
+			std::size_t width_;
+			std::size_t height_;
+			std::size_t depth_;
+			Eigen::Vector3i origin_;
+			boost::compute::vector<std::uint8_t> gpu_;
+			boost::compute::vector<float> ranges_;
+			boost::compute::vector<std::uint8_t> observed_;
+			std::vector<half> cpu_;
+			bool dirty_;
+
+
+		public:
+
+
+			/**
+			 *	A read only view of the GPU storage of an
+			 *	opencl_voxel_pipeline_value which is mapped into
+			 *	host memory and presents it in the same order as
+			 *	\ref get.
+			 *
+			 *	The storage remains mapped for the lifetime of this
+			 *	object.  Voxels stored in \ref voxel_format::half are
+			 *	read directly from the mapped storage, voxels in other
+			 *	formats are converted as they are accessed.  On
+			 *	devices which share memory with the host no copy of
+			 *	the TSDF is made.
+			 */
+			class view {
+
+
+				private:
+
+
+					boost::compute::command_queue q_;
+					boost::compute::buffer buffer_;
+					const unsigned char * ptr_;
+					voxel_format format_;
+					std::size_t width_;
+					std::size_t height_;
+					std::size_t depth_;
+					std::size_t offset_[3];
+
+
+					void unmap () noexcept;
+
+
+				public:
+
+
+					using value_type=half;
+
+
+					view () = delete;
+					view (const view &) = delete;
+					view & operator = (const view &) = delete;
+
+
+					view (
+						boost::compute::command_queue q,
+						const boost::compute::buffer & buffer,
+						voxel_format format,
+						std::size_t width,
+						std::size_t height,
+						std::size_t depth,
+						const std::size_t (& offset) [3],
+						const boost::compute::wait_list & events
+					);
+					view (view && other) noexcept;
+					view & operator = (view && other) noexcept;
+					~view () noexcept;
+
+
+					std::size_t size () const noexcept;
+					bool empty () const noexcept;
+					half operator [] (std::size_t i) const noexcept;
+
+
+			};
+
+
+			/**
+			 *	Creates a new opencl_voxel_pipeline_value.
+			 *
+			 *	\param [in] q
+			 *		The boost::compute::command_queue which will
+			 *		be associated with this pipeline value.
+			 *	\param [in] format
+			 *		The \ref voxel_format in which voxels are
+			 *		stored.
+			 */
+			opencl_voxel_pipeline_value (boost::compute::command_queue q, voxel_format format);
+
+
+			/**
+			 *	Retrieves the format in which voxels are stored.
+			 *
+			 *	\return
+			 *		A \ref voxel_format.
+			 */
+			voxel_format format () const noexcept;
+
+
+			/**
+			 *	Retrieves the number of voxels.
+			 *
+			 *	\return
+			 *		The number of voxels.
+			 */
+			std::size_t size () const noexcept;
+
+
+			/**
+			 *	Changes the number of voxels.  The contents of the
+			 *	voxels are unspecified afterwards.
+			 *
+			 *	\param [in] size
+			 *		The number of voxels.
+			 */
+			void resize (std::size_t size);
+			/**
+			 *	Changes the dimensions of the volume.  The contents
+			 *	of the voxels and of the brick summaries are
+			 *	unspecified afterwards.
+			 *
+			 *	\param [in] width
+			 *		The number of voxels along the x axis.
+			 *	\param [in] height
+			 *		The number of voxels along the y axis.
+			 *	\param [in] depth
+			 *		The number of voxels along the z axis.
+			 */
+			void resize (std::size_t width, std::size_t height, std::size_t depth);
+
+
+			/**
+			 *	Sets the voxel coordinate of the first voxel of the
+			 *	volume.  The voxel with coordinate \f$(x,y,z)\f$ is
+			 *	stored at \f$(x\bmod w,y\bmod h,z\bmod d)\f$ whatever
+			 *	the origin.  Defaults to \f$(0,0,0)\f$.
+			 *
+			 *	\param [in] origin
+			 *		The origin.
+			 */
+			void origin (const Eigen::Vector3i & origin) noexcept;
+			/**
+			 *	Retrieves the voxel coordinate of the first voxel
+			 *	of the volume.
+			 *
+			 *	\return
+			 *		The origin.
+			 */
+			const Eigen::Vector3i & origin () const noexcept;
+
+
+			/**
+			 *	Returns a reference to the GPU storage of the voxels.
+			 *
+			 *	Invoking this method causes the CPU copy (if any) of the
+			 *	GPU data to be considered dirty (i.e. it will be converted
+			 *	the next time it is retrieved).
+			 *
+			 *	\return
+			 *		A reference to the wrapped GPU storage.
+			 */
+			boost::compute::vector<std::uint8_t> & vector () noexcept;
+			/**
+			 *	Returns a reference to the GPU storage of the voxels.
+			 *
+			 *	\return
+			 *		A reference to the wrapped GPU storage.
+			 */
+			const boost::compute::vector<std::uint8_t> & vector () const noexcept;
+
+
+			/**
+			 *	Retrieves the number of bricks along each axis.
+			 *
+			 *	\return
+			 *		The number of bricks along the x, y, and z axes.
+			 */
+			Eigen::Vector3i bricks () const noexcept;
+			/**
+			 *	Returns a reference to the minimum and maximum TSDF
+			 *	value of the voxels of each brick (two values per
+			 *	brick).
+			 *
+			 *	\return
+			 *		A reference to GPU storage.
+			 */
+			boost::compute::vector<float> & ranges () noexcept;
+			/**
+			 *	Returns a reference to the minimum and maximum TSDF
+			 *	value of the voxels of each brick.
+			 *
+			 *	\return
+			 *		A reference to GPU storage.
+			 */
+			const boost::compute::vector<float> & ranges () const noexcept;
+			/**
+			 *	Returns a reference to a value for each brick which
+			 *	is nonzero if any of its voxels has a nonzero weight.
+			 *
+			 *	\return
+			 *		A reference to GPU storage.
+			 */
+			boost::compute::vector<std::uint8_t> & observed () noexcept;
+			/**
+			 *	Returns a reference to a value for each brick which
+			 *	is nonzero if any of its voxels has a nonzero weight.
+			 *
+			 *	\return
+			 *		A reference to GPU storage.
+			 */
+			const boost::compute::vector<std::uint8_t> & observed () const noexcept;
+
+
+			/**
+			 *	Maps the GPU storage into host memory rather than
+			 *	downloading and converting it.
+			 *
+			 *	Modifying the GPU storage or the origin while the
+			 *	returned view persists results in undefined behaviour.
+			 *
+			 *	\return
+			 *		A \ref view of the GPU storage.
+			 */
+			view map () const;
+
+
+			/**
+			 *	The GPU storage is mapped rather than downloaded
+			 *	and the TSDF values are converted directly from
+			 *	the mapped storage into a host copy.
+			 */
+			virtual const std::vector<half> & get () override;
+
+
+	};
+
+
+}
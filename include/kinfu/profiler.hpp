@@ -0,0 +1,115 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+
+namespace kinfu {
+
+
+	/**
+	 *	An abstract base class which, when implemented in a
+	 *	derived class, collects timings for the individual
+	 *	operations which pipeline blocks perform on a device.
+	 *
+	 *	\sa kinect_fusion
+	 */
+	class profiler {
+
+
+		public:
+
+
+			/**
+			 *	The timings of a single operation.
+			 *
+			 *	All times are measured by the device's own clock
+			 *	and are therefore only comparable to other times
+			 *	from the same device.
+			 */
+			class record {
+
+
+				public:
+
+
+					/**
+					 *	The name of the operation.
+					 */
+					std::string name;
+					/**
+					 *	The time at which the operation was queued
+					 *	by the host.
+					 */
+					std::chrono::nanoseconds queued;
+					/**
+					 *	The time at which the operation was submitted
+					 *	to the device.
+					 */
+					std::chrono::nanoseconds submit;
+					/**
+					 *	The time at which the device began executing
+					 *	the operation.
+					 */
+					std::chrono::nanoseconds start;
+					/**
+					 *	The time at which the device finished executing
+					 *	the operation.
+					 */
+					std::chrono::nanoseconds end;
+
+
+			};
+
+
+			/**
+			 *	The type used to represent a collection of
+			 *	records.
+			 */
+			using records_type=std::vector<record>;
+
+
+			profiler () = default;
+			profiler (const profiler &) = delete;
+			profiler (profiler &&) = delete;
+			profiler & operator = (const profiler &) = delete;
+			profiler & operator = (profiler &&) = delete;
+
+
+			/**
+			 *	Allows derived classes to be cleaned up through
+			 *	pointer or reference to base.
+			 */
+			virtual ~profiler () noexcept;
+
+
+			/**
+			 *	Discards all operations recorded thus far.
+			 */
+			virtual void clear () = 0;
+			/**
+			 *	Retrieves the timings of all operations recorded
+			 *	since the last call to \ref clear.
+			 *
+			 *	This may block until all such operations complete.
+			 *
+			 *	\return
+			 *		A reference to a collection of records in the
+			 *		order the operations were recorded.  This reference
+			 *		is invalidated by the next call to any method of
+			 *		this object.
+			 */
+			virtual const records_type & records () = 0;
+
+
+	};
+
+
+}
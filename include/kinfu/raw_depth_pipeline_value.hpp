@@ -0,0 +1,144 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include <kinfu/depth_device.hpp>
+#include <kinfu/pipeline_value.hpp>
+#include <cstdint>
+#include <vector>
+
+
+namespace kinfu {
+	
+	
+	/**
+	 *	Represents a depth frame stored on the CPU in the
+	 *	native 16 bit representation of a depth sensor (i.e.
+	 *	as millimeters).
+	 *
+	 *	Conversion to meters is deferred until the value is
+	 *	retrieved via \ref get.  Consumers which are aware of
+	 *	this type (such as \ref opencl_depth_device) may instead
+	 *	retrieve the raw frame and perform the conversion
+	 *	elsewhere.
+	 *
+	 *	Each source of depth frames designates a single raw
+	 *	value as invalid (for example OpenNI uses 0 whereas the
+	 *	MSRC 7-Scenes dataset uses 65535) which is converted to
+	 *	qNaN.
+	 */
+	class raw_depth_pipeline_value final : public pipeline_value<depth_device::buffer_type> {
+		
+		
+		public:
+		
+		
+			/**
+			 *	A vector of unsigned 16 bit integers which contains
+			 *	a depth buffer in millimeters.
+			 */
+			using raw_buffer_type=std::vector<std::uint16_t>;
+		
+		
+		private:
+		
+		
+			raw_buffer_type raw_;
+			std::uint16_t invalid_;
+			depth_device::buffer_type converted_;
+			bool dirty_;
+		
+		
+		public:
+		
+		
+			raw_depth_pipeline_value () = delete;
+			
+			
+			/**
+			 *	Creates a new raw_depth_pipeline_value.
+			 *
+			 *	\param [in] invalid
+			 *		The raw value which represents an invalid
+			 *		depth value.
+			 */
+			explicit raw_depth_pipeline_value (std::uint16_t invalid) noexcept;
+			
+			
+			/**
+			 *	Converts a single raw depth value to meters.
+			 *
+			 *	\param [in] depth
+			 *		The depth in millimeters.
+			 *	\param [in] invalid
+			 *		The raw value which represents an invalid
+			 *		depth value.
+			 *
+			 *	\return
+			 *		The depth in meters or qNaN if \em depth is
+			 *		\em invalid.
+			 */
+			static float to_meters (std::uint16_t depth, std::uint16_t invalid) noexcept;
+			/**
+			 *	Converts a row major range of raw depth values to
+			 *	meters.
+			 *
+			 *	Uses AVX2 or SSE2 where available and otherwise
+			 *	falls back to converting each value in turn.  The
+			 *	result is identical in all cases.
+			 *
+			 *	\param [in] begin
+			 *		A pointer to the first raw depth value.
+			 *	\param [in] end
+			 *		A pointer to one past the last raw depth value.
+			 *	\param [out] out
+			 *		A pointer to storage for at least \em end minus
+			 *		\em begin depth values in meters.
+			 *	\param [in] invalid
+			 *		The raw value which represents an invalid
+			 *		depth value.
+			 */
+			static void to_meters (const std::uint16_t * begin, const std::uint16_t * end, float * out, std::uint16_t invalid) noexcept;
+			
+			
+			/**
+			 *	Determines which raw value represents an invalid
+			 *	depth value.
+			 *
+			 *	\return
+			 *		The raw value.
+			 */
+			std::uint16_t invalid () const noexcept;
+			
+			
+			/**
+			 *	Returns a reference to the raw frame.
+			 *
+			 *	Invoking this method causes the converted frame (if
+			 *	any) to be considered dirty (i.e. it will be converted
+			 *	once again the next time it is retrieved).
+			 *
+			 *	\return
+			 *		A reference to the raw frame.
+			 */
+			raw_buffer_type & raw () noexcept;
+			/**
+			 *	Returns a reference to the raw frame.
+			 *
+			 *	\return
+			 *		A reference to the raw frame.
+			 */
+			const raw_buffer_type & raw () const noexcept;
+			
+			
+			virtual const depth_device::buffer_type & get () override;
+		
+		
+	};
+	
+	
+}
@@ -0,0 +1,95 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include <kinfu/half.hpp>
+#include <Eigen/Dense>
+#include <cstddef>
+#include <vector>
+
+
+namespace kinfu {
+
+
+	/**
+	 *	An abstract base class which, when implemented in a
+	 *	derived class, receives the parts of a moving TSDF
+	 *	which leave the volume (for example by storing them
+	 *	in memory or writing them to disk).
+	 *
+	 *	\sa kinect_fusion_opencl_update_reconstruction_pipeline_block
+	 */
+	class tsdf_slice_sink {
+
+
+		public:
+
+
+			/**
+			 *	A box of voxels which has left the volume.
+			 */
+			class slice {
+
+
+				public:
+
+
+					/**
+					 *	The voxel coordinate of the first voxel of
+					 *	the box.
+					 */
+					Eigen::Vector3i origin;
+					/**
+					 *	The number of voxels along the x axis.
+					 */
+					std::size_t width;
+					/**
+					 *	The number of voxels along the y axis.
+					 */
+					std::size_t height;
+					/**
+					 *	The number of voxels along the z axis.
+					 */
+					std::size_t depth;
+					/**
+					 *	The TSDF value of each voxel, the voxel
+					 *	\f$(x,y,z)\f$ relative to \ref origin is
+					 *	at index \f$x+w(y+hz)\f$.
+					 */
+					std::vector<half> tsdf;
+
+
+			};
+
+
+			tsdf_slice_sink () = default;
+			tsdf_slice_sink (const tsdf_slice_sink &) = delete;
+			tsdf_slice_sink (tsdf_slice_sink &&) = delete;
+			tsdf_slice_sink & operator = (const tsdf_slice_sink &) = delete;
+			tsdf_slice_sink & operator = (tsdf_slice_sink &&) = delete;
+
+
+			/**
+			 *	Allows derived classes to be cleaned up through
+			 *	pointer or reference to base.
+			 */
+			virtual ~tsdf_slice_sink () noexcept;
+
+
+			/**
+			 *	Receives a slice.
+			 *
+			 *	\param [in] s
+			 *		The slice.
+			 */
+			virtual void operator () (slice s) = 0;
+
+
+	};
+
+
+}
@@ -0,0 +1,127 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include <kinfu/half.hpp>
+#include <cstddef>
+#include <string>
+
+
+namespace kinfu {
+
+
+	/**
+	 *	The layouts in which the voxels of a TSDF may be
+	 *	stored on the GPU.
+	 *
+	 *	The format is compiled into the OpenCL programs which
+	 *	integrate and raycast the TSDF (see \ref voxel_format_options)
+	 *	so that loads and stores are specialized without
+	 *	branching.
+	 */
+	enum class voxel_format {
+
+		/**
+		 *	Each voxel is a half precision TSDF value with
+		 *	the 8 bit weights stored in a separate buffer.
+		 */
+		half,
+		/**
+		 *	Each voxel is 32 bits consisting of the TSDF value
+		 *	as a 16 bit signed fixed point number (scaled by
+		 *	32767) followed by an 8 bit weight and 8 bits of
+		 *	padding.
+		 */
+		fixed16_weight8,
+		/**
+		 *	Each voxel is 32 bits consisting of a half precision
+		 *	TSDF value followed by a 16 bit weight.
+		 */
+		half_weight16,
+		/**
+		 *	Each voxel is 16 bits consisting of the TSDF value
+		 *	as an 8 bit signed fixed point number (scaled by
+		 *	127) followed by an 8 bit weight.
+		 */
+		fixed8_weight8
+
+	};
+
+
+	/**
+	 *	Determines the number of bytes each voxel occupies
+	 *	in a certain format.
+	 *
+	 *	\param [in] format
+	 *		The \ref voxel_format.
+	 *
+	 *	\return
+	 *		The size of a voxel in bytes, not including any
+	 *		separately stored weight.
+	 */
+	std::size_t voxel_size (voxel_format format) noexcept;
+
+
+	/**
+	 *	Determines whether a certain format stores weights
+	 *	separately from the TSDF values.
+	 *
+	 *	\param [in] format
+	 *		The \ref voxel_format.
+	 *
+	 *	\return
+	 *		\em true if weights are stored in a separate buffer,
+	 *		\em false if they are packed with the TSDF values.
+	 */
+	bool voxel_separate_weights (voxel_format format) noexcept;
+
+
+	/**
+	 *	Obtains the options with which OpenCL programs which
+	 *	access a TSDF stored in a certain format must be built.
+	 *
+	 *	\param [in] format
+	 *		The \ref voxel_format.
+	 *
+	 *	\return
+	 *		A string suitable for passing to an
+	 *		\ref opencl_program_factory.
+	 */
+	std::string voxel_format_options (voxel_format format);
+
+
+	/**
+	 *	Obtains the representation of an empty voxel (i.e. one
+	 *	with a TSDF value of 1 and a weight of 0) in a certain
+	 *	format, suitable for use as the pattern with which a
+	 *	TSDF is filled to clear it.
+	 *
+	 *	\param [in] format
+	 *		The \ref voxel_format.
+	 *	\param [out] out
+	 *		A pointer to \ref voxel_size bytes.
+	 */
+	void empty_voxel (voxel_format format, void * out) noexcept;
+
+
+	/**
+	 *	Converts voxels stored in a certain format to half
+	 *	precision TSDF values.
+	 *
+	 *	\param [in] format
+	 *		The \ref voxel_format of the voxels.
+	 *	\param [in] begin
+	 *		A pointer to the first voxel.
+	 *	\param [in] size
+	 *		The number of voxels.
+	 *	\param [out] out
+	 *		A pointer to storage for \em size values.
+	 */
+	void decode_voxels (voxel_format format, const void * begin, std::size_t size, half * out) noexcept;
+
+
+}
@@ -1,5 +1,6 @@
 #include <kinfu/camera.hpp>
 #include <cmath>
+#include <cstddef>
 #include <utility>
 
 
@@ -26,4 +27,47 @@ namespace kinfu {
 	}
 
 
+	Eigen::Matrix3f pyramid_k (Eigen::Matrix3f k, std::size_t level) noexcept {
+
+		for (;level!=0;--level) {
+
+			k(0,0)/=2.0f;
+			k(1,1)/=2.0f;
+			//	Pixel centers at the coarser level lie at the
+			//	center of 2x2 blocks at the finer level
+			k(0,2)=((k(0,2)+0.5f)/2.0f)-0.5f;
+			k(1,2)=((k(1,2)+0.5f)/2.0f)-0.5f;
+
+		}
+
+		return k;
+
+	}
+
+
+	std::pair<Eigen::Vector3f,Eigen::Vector3f> frustum_bounds (const Eigen::Matrix4f & t_g_k, const Eigen::Matrix3f & k, std::size_t width, std::size_t height, float depth) noexcept {
+
+		//	The frustum is the convex hull of the camera's
+		//	position and the corners of the image (extended
+		//	by half a pixel since pixels are rounded) at the
+		//	maximum depth
+		Eigen::Vector3f t(t_g_k.block<3,1>(0,3));
+		std::pair<Eigen::Vector3f,Eigen::Vector3f> retr(t,t);
+		Eigen::Matrix3f k_inv(k.inverse());
+		Eigen::Matrix3f r(t_g_k.block<3,3>(0,0));
+		float us []={-0.5f,float(width)-0.5f};
+		float vs []={-0.5f,float(height)-0.5f};
+		for (auto u : us) for (auto v : vs) {
+
+			Eigen::Vector3f corner((r*(k_inv*Eigen::Vector3f(u,v,1.0f)*depth))+t);
+			retr.first=retr.first.cwiseMin(corner);
+			retr.second=retr.second.cwiseMax(corner);
+
+		}
+
+		return retr;
+
+	}
+
+
 }
@@ -0,0 +1,116 @@
+#include <kinfu/correspondence_sampling.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+
+namespace kinfu {
+
+
+	static std::size_t quantize (float c) noexcept {
+
+		auto retr=int((c+1.0f)*2.0f);
+		return std::size_t(std::min(std::max(retr,0),3));
+
+	}
+
+
+	std::size_t normal_space_bucket (const Eigen::Vector3f & n) noexcept {
+
+		return quantize(n(0))+(4U*quantize(n(1)))+(16U*quantize(n(2)));
+
+	}
+
+
+	static std::vector<std::uint32_t> all_samples (std::size_t size) {
+
+		std::vector<std::uint32_t> retr(size);
+		std::iota(retr.begin(),retr.end(),std::uint32_t(0));
+
+		return retr;
+
+	}
+
+
+	std::vector<std::uint32_t> stride_samples (std::size_t size, std::size_t count) {
+
+		if (count>=size) return all_samples(size);
+
+		std::vector<std::uint32_t> retr;
+		retr.reserve(count);
+		for (std::size_t i=0;i<count;++i) retr.push_back(std::uint32_t((i*size)/count));
+
+		return retr;
+
+	}
+
+
+	std::vector<std::uint32_t> random_samples (std::size_t size, std::size_t count, std::uint32_t seed) {
+
+		if (count>=size) return all_samples(size);
+
+		std::mt19937 mt(seed);
+		std::vector<std::uint32_t> retr;
+		retr.reserve(count);
+		for (std::size_t i=0;i<count;++i) {
+
+			auto begin=(i*size)/count;
+			auto end=((i+1U)*size)/count;
+			std::uniform_int_distribution<std::size_t> dist(begin,end-1U);
+			retr.push_back(std::uint32_t(dist(mt)));
+
+		}
+
+		return retr;
+
+	}
+
+
+	static bool is_valid (const pixel & p) noexcept {
+
+		return std::isfinite(p.v(0)) && std::isfinite(p.v(1)) && std::isfinite(p.v(2)) &&
+			std::isfinite(p.n(0)) && std::isfinite(p.n(1)) && std::isfinite(p.n(2));
+
+	}
+
+
+	std::vector<std::uint32_t> normal_space_samples (const std::vector<pixel> & map, std::size_t count, std::uint32_t seed) {
+
+		std::array<std::vector<std::uint32_t>,normal_space_buckets> buckets;
+		for (std::size_t i=0;i<map.size();++i) if (is_valid(map[i])) buckets[normal_space_bucket(map[i].n)].push_back(std::uint32_t(i));
+
+		std::mt19937 mt(seed);
+		for (auto && bucket : buckets) std::shuffle(bucket.begin(),bucket.end(),mt);
+
+		//	Take one sample from each non-empty bucket in
+		//	turn until enough samples have been taken or
+		//	every bucket has been exhausted
+		std::vector<std::uint32_t> retr;
+		for (std::size_t taken=0;retr.size()<count;++taken) {
+
+			bool any=false;
+			for (auto && bucket : buckets) {
+
+				if (taken>=bucket.size()) continue;
+				any=true;
+				retr.push_back(bucket[taken]);
+				if (retr.size()==count) break;
+
+			}
+			if (!any) break;
+
+		}
+
+		std::sort(retr.begin(),retr.end());
+
+		return retr;
+
+	}
+
+
+}
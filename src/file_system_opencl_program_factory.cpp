@@ -4,6 +4,7 @@
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
+#include <string>
 #include <utility>
 
 
@@ -23,11 +24,29 @@ namespace kinfu {
 	
 	boost::compute::program file_system_opencl_program_factory::operator () (const std::string & name) {
 		
+		return (*this)(name,std::string());
+		
+	}
+	
+	
+	boost::compute::program file_system_opencl_program_factory::operator () (const std::string & name, const std::string & options) {
+		
 		auto p=root_;
 		p/=name;
 		p+=".cl";
 		
-		return opencl_file_build_error::build(p,ctx_);
+		//	Programs may include headers from the same directory
+		std::string o("-I \"");
+		o+=root_.string();
+		o+="\"";
+		if (!options.empty()) {
+			
+			o+=" ";
+			o+=options;
+			
+		}
+		
+		return opencl_file_build_error::build(p,ctx_,o);
 		
 	}
 	
@@ -1,5 +1,7 @@
 #include <kinfu/kinect_fusion.hpp>
+#include <kinfu/scope.hpp>
 #include <Eigen/Dense>
+#include <exception>
 #include <stdexcept>
 #include <utility>
 
@@ -74,6 +76,34 @@ namespace kinfu {
 		sppbt_=t.elapsed();
 
 	}
+
+
+	void kinect_fusion::prefetch () noexcept {
+
+		//	The current frame and vertex and normal map must
+		//	survive since they are exposed through the accessors
+		//	so the next frame is obtained into the spare values
+		using std::swap;
+		swap(frame_,next_frame_);
+		swap(map_,next_map_);
+		auto g=make_scope_exit([&] () noexcept {
+			swap(frame_,next_frame_);
+			swap(map_,next_map_);
+		});
+
+		try {
+
+			get_frame();
+			get_vertex_and_normal_map();
+			prefetched_=true;
+
+		} catch (...) {
+
+			prefetch_ex_=std::current_exception();
+
+		}
+
+	}
 	
 	
 	kinect_fusion::kinect_fusion () noexcept
@@ -85,7 +115,10 @@ namespace kinfu {
 			pepb_(nullptr),
 			urpb_(nullptr),
 			sppb_(nullptr),
-			tsdf_{{},0,0,0}
+			tsdf_{{},0,0,0},
+			pipelined_(false),
+			prefetched_(false),
+			profiler_(nullptr)
 	{	}
 	
 	
@@ -125,17 +158,62 @@ namespace kinfu {
 		sppb_=&sppb;
 
 	}
+
+
+	void kinect_fusion::pipelined (bool p) noexcept {
+
+		pipelined_=p;
+
+	}
+
+
+	bool kinect_fusion::pipelined () const noexcept {
+
+		return pipelined_;
+
+	}
+
+
+	void kinect_fusion::profiler (kinfu::profiler & p) noexcept {
+
+		profiler_=&p;
+
+	}
 	
 	
 	void kinect_fusion::operator () () {
 
 		check_pipeline();
+
+		if (profiler_) profiler_->clear();
+
+		if (prefetch_ex_) {
+
+			std::exception_ptr ex;
+			using std::swap;
+			swap(ex,prefetch_ex_);
+			std::rethrow_exception(ex);
+
+		}
 		
-		get_frame();
-		get_vertex_and_normal_map();
+		if (prefetched_) {
+
+			using std::swap;
+			swap(frame_,next_frame_);
+			swap(map_,next_map_);
+			prefetched_=false;
+
+		} else {
+
+			get_frame();
+			get_vertex_and_normal_map();
+
+		}
 		get_tgk();
 		get_tsdf();
 		get_prediction();
+
+		if (pipelined_) prefetch();
 		
 	}
 	
@@ -175,6 +253,16 @@ namespace kinfu {
 	}
 
 
+	const profiler::records_type & kinect_fusion::profile () const {
+
+		static const kinfu::profiler::records_type empty;
+		if (!profiler_) return empty;
+
+		return profiler_->records();
+
+	}
+
+
 	depth_device::value_type::element_type & kinect_fusion::frame () const noexcept {
 
 		return *frame_;
@@ -1,14 +1,17 @@
 #include <kinfu/kinect_fusion_eigen_pose_estimation_pipeline_block.hpp>
 #include <kinfu/cpu_pipeline_value.hpp>
+#include <kinfu/motion_model.hpp>
 #include <kinfu/pipeline_value.hpp>
 #include <Eigen/Dense>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <exception>
 #include <memory>
 #include <stdexcept>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 
 #include <iostream>
@@ -26,10 +29,48 @@ namespace kinfu {
 		Eigen::Matrix4f t_gk_initial,
 		std::size_t numit,
 		bool force_px_px
-	) : epsilon_d_(epsilon_d), epsilon_theta_(epsilon_theta), frame_width_(frame_width), frame_height_(frame_height), numit_(numit), t_gk_initial_(std::move(t_gk_initial)), force_px_px_(force_px_px) {}
+	) : epsilon_d_(epsilon_d), epsilon_theta_(epsilon_theta), frame_width_(frame_width), frame_height_(frame_height), numit_(numit), t_gk_initial_(std::move(t_gk_initial)), force_px_px_(force_px_px), motion_model_(false), sampling_(correspondence_sampling::all), samples_(0) {}
 
 
-	Eigen::Matrix4f kinect_fusion_eigen_pose_estimation_pipeline_block::incremental(
+	void kinect_fusion_eigen_pose_estimation_pipeline_block::sampling (correspondence_sampling s, std::size_t samples) {
+
+		if ((s != correspondence_sampling::all) && (samples == 0)) throw std::logic_error("Must sample at least one pixel");
+
+		sampling_ = s;
+		samples_ = samples;
+
+	}
+
+
+	correspondence_sampling kinect_fusion_eigen_pose_estimation_pipeline_block::sampling () const noexcept {
+
+		return sampling_;
+
+	}
+
+
+	std::size_t kinect_fusion_eigen_pose_estimation_pipeline_block::samples () const noexcept {
+
+		return samples_;
+
+	}
+
+
+	void kinect_fusion_eigen_pose_estimation_pipeline_block::motion_model (bool m) noexcept {
+
+		motion_model_=m;
+
+	}
+
+
+	bool kinect_fusion_eigen_pose_estimation_pipeline_block::motion_model () const noexcept {
+
+		return motion_model_;
+
+	}
+
+
+	kinect_fusion_eigen_pose_estimation_pipeline_block::correspondences_type kinect_fusion_eigen_pose_estimation_pipeline_block::correspondences(
 		measurement_pipeline_block::value_type::element_type & map,
 		measurement_pipeline_block::value_type::element_type & prev_map,
 		Eigen::Matrix3f k,
@@ -49,12 +90,32 @@ namespace kinfu {
 		long long int u_std = 0;
 		long long int v_std = 0;
 
-		std::vector<std::tuple<Eigen::Vector3f, Eigen::Vector3f, Eigen::Vector3f>> correspondences;
+		correspondences_type correspondences;
 
 		auto && u_map = map.get();
 		auto && u_prev_map = prev_map.get();
 
-		for (std::size_t i = 0; i < numpts; ++i) {
+		// Select the pixels to consider
+		std::vector<std::uint32_t> samples;
+		switch (sampling_) {
+			case correspondence_sampling::all:
+				break;
+			case correspondence_sampling::stride:
+				samples = stride_samples(numpts, samples_);
+				break;
+			case correspondence_sampling::random:
+				samples = random_samples(numpts, samples_, 0);
+				break;
+			case correspondence_sampling::normal_space:
+				samples = normal_space_samples(u_map, samples_, 0);
+				break;
+		}
+		bool sampled = sampling_ != correspondence_sampling::all;
+		std::size_t count = sampled ? samples.size() : numpts;
+
+		for (std::size_t j = 0; j < count; ++j) {
+
+			std::size_t i = sampled ? samples[j] : j;
 
 			// measured v and n maps from current frame. These are in current camera space.
 			auto v = u_map[i].v;
@@ -138,6 +199,20 @@ namespace kinfu {
 		std::cout << "\t Rej due to angle: " << rej_et << std::endl;
 		std::cout << "\t Rej due to oob: " << rej_oob << std::endl;
 
+		return correspondences;
+
+	}
+
+
+	Eigen::Matrix4f kinect_fusion_eigen_pose_estimation_pipeline_block::incremental(
+		measurement_pipeline_block::value_type::element_type & map,
+		measurement_pipeline_block::value_type::element_type & prev_map,
+		Eigen::Matrix3f k,
+		Eigen::Matrix4f t_frame_frame,
+		Eigen::Matrix4f t_z
+	) {
+
+		auto correspondences=this->correspondences(map,prev_map,k,std::move(t_frame_frame),std::move(t_z));
 
 		// 6 is the DOF, so we need 6 points to solve minimum
 		if (correspondences.size() < 6) {
@@ -223,6 +298,7 @@ namespace kinfu {
 	
 		if (!(t_gk_minus_one && prev_map)) {
 
+			t_gk_minus_two_=nullopt;
 			t_gk_minus_one=std::make_unique<pv_type>();
 			static_cast<pv_type &>(*t_gk_minus_one).emplace(t_gk_initial_);
 
@@ -235,6 +311,23 @@ namespace kinfu {
 		auto t_gk_minus_one_m=pv.get();
 		Eigen::Matrix4f t_z(t_gk_minus_one_m);
 		Eigen::Matrix4f t_gk_prev_inverse(t_gk_minus_one_m.inverse());
+
+		// Forget the velocity unless this invocation succeeds
+		auto t_gk_minus_two=std::move(t_gk_minus_two_);
+		t_gk_minus_two_=nullopt;
+
+		// Use the pose predicted by the motion model as the initial
+		// estimate if it yields at least as many correspondences
+		if (motion_model_ && t_gk_minus_two) {
+
+			Eigen::Matrix4f predicted(constant_velocity(*t_gk_minus_two, t_gk_minus_one_m));
+			auto inliers = [&] (const Eigen::Matrix4f & t) {
+				Eigen::Matrix4f t_frame_frame(force_px_px_ ? Eigen::Matrix4f::Identity() : Eigen::Matrix4f(t_gk_prev_inverse * t));
+				return correspondences(map, *prev_map, k, t_frame_frame, t).size();
+			};
+			if (inliers(predicted) >= inliers(t_z)) t_z = predicted;
+
+		}
 		
 
 		// Iterate
@@ -264,6 +357,7 @@ namespace kinfu {
 
 		}
 
+		t_gk_minus_two_ = t_gk_minus_one_m;
 		pv.emplace(t_z);
 		return t_gk_minus_one;
 	}
@@ -32,11 +32,12 @@ namespace kinfu {
 		auto && buffer=pv.vector();
 
 		opencl_vector_pipeline_value_extractor<kinfu::pixel> e(q_);
-		auto && map=e(prev);
+		boost::compute::wait_list events;
+		auto && map=e(prev,events);
 
 		buffer.resize(map.size(),q_);
 
-		boost::compute::copy(map.begin(),map.end(),buffer.begin(),q_);
+		pv.event(profile("copy map",q_.enqueue_copy_buffer(map.get_buffer(),buffer.get_buffer(),0,0,map.size()*sizeof(kinfu::pixel),events)));
 
 		return vn;
 
@@ -0,0 +1,133 @@
+#include <kinfu/kinect_fusion_opencl_hashed_surface_prediction_pipeline_block.hpp>
+#include <kinfu/opencl_vector_pipeline_value.hpp>
+#include <kinfu/opencl_voxel_hash_pipeline_value.hpp>
+#include <kinfu/pixel.hpp>
+#include <Eigen/Dense>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+
+namespace kinfu {
+	
+	
+	static boost::compute::kernel get_hashed_raycast_kernel (opencl_program_factory & opf) {
+		
+		auto p=opf("hashing");
+		return boost::compute::kernel(p,"hashed_raycast");
+		
+	}
+	
+	
+	kinect_fusion_opencl_hashed_surface_prediction_pipeline_block::kinect_fusion_opencl_hashed_surface_prediction_pipeline_block (
+		boost::compute::command_queue q,
+		opencl_program_factory & opf,
+		std::size_t frame_width,
+		std::size_t frame_height)
+		:	q_(std::move(q)),
+			raycast_kernel_(get_hashed_raycast_kernel(opf)),
+			t_g_k_buf_(q_.get_context(),sizeof(Eigen::Matrix4f),CL_MEM_READ_ONLY),
+			ik_buf_(q_.get_context(),sizeof(Eigen::Matrix3f),CL_MEM_READ_ONLY),
+			frame_width_(frame_width),
+			frame_height_(frame_height)
+	{
+		
+		//	Kernel arguments are:
+		//
+		//	0:	Hash table keys
+		//	1:	Hash table pointers
+		//	2:	TSDF values of the brick pool
+		//	3:	Map
+		//	4:	T_g_k
+		//	5:	K^-1
+		//	6:	Voxel size
+		//	7:	Number of hash table slots
+		raycast_kernel_.set_arg(4,t_g_k_buf_);
+		raycast_kernel_.set_arg(5,ik_buf_);
+		
+	}
+	
+	
+	kinect_fusion_opencl_hashed_surface_prediction_pipeline_block::~kinect_fusion_opencl_hashed_surface_prediction_pipeline_block () noexcept {
+		
+		//	Errors cannot be reported from a destructor
+		try {
+		
+			writes_.wait();
+		
+		} catch (...) {	}
+		
+	}
+	
+	
+	kinect_fusion_opencl_hashed_surface_prediction_pipeline_block::value_type kinect_fusion_opencl_hashed_surface_prediction_pipeline_block::operator () (
+		update_reconstruction_pipeline_block::value_type::element_type & tsdf,
+		std::size_t,
+		std::size_t,
+		std::size_t,
+		pose_estimation_pipeline_block::value_type::element_type & t_g_k_pv,
+		Eigen::Matrix3f k,
+		measurement_pipeline_block::value_type::element_type &,
+		value_type map
+	) {
+		
+		auto && voxels = dynamic_cast<const opencl_voxel_hash_pipeline_value &>(tsdf);
+		boost::compute::wait_list events;
+		using compatibility = opencl_voxel_hash_pipeline_value::compatibility;
+		switch (voxels.check(q_)) {
+			
+			case compatibility::same_context:
+				if (voxels.events().empty()) voxels.wait();
+				for (auto && e : voxels.events()) events.insert(e);
+			case compatibility::same_queue:
+				break;
+			default:
+				throw std::invalid_argument("Hashed TSDF must reside in the same OpenCL context");
+			
+		}
+		
+		writes_.wait();
+		writes_.clear();
+		
+		auto t_g_k = t_g_k_pv.get();
+		if (t_g_k_ != t_g_k) {
+			
+			t_g_k_ = t_g_k;
+			t_g_k_t_ = t_g_k.transpose();
+			writes_.insert(profile("write T_g_k",q_.enqueue_write_buffer_async(t_g_k_buf_,0,sizeof(t_g_k_t_),t_g_k_t_.data())));
+			
+		}
+		
+		if (k_ != k) {
+			
+			k_ = k;
+			ik_ = k.inverse();
+			ik_.transposeInPlace();
+			writes_.insert(profile("write K^-1",q_.enqueue_write_buffer_async(ik_buf_,0,sizeof(ik_),ik_.data())));
+			
+		}
+		
+		using type = opencl_vector_pipeline_value<pixel>;
+		if (!map) map = std::make_unique<type>(q_);
+		auto && pv = dynamic_cast<type &>(*map);
+		auto && m = pv.vector();
+		m.resize(frame_width_*frame_height_,q_);
+		
+		raycast_kernel_.set_arg(0,voxels.keys().get_buffer());
+		raycast_kernel_.set_arg(1,voxels.pointers().get_buffer());
+		raycast_kernel_.set_arg(2,voxels.tsdf().get_buffer());
+		raycast_kernel_.set_arg(3,m);
+		raycast_kernel_.set_arg(6,voxels.voxel_size());
+		raycast_kernel_.set_arg(7,std::uint32_t(voxels.buckets()));
+		
+		std::size_t extent [] = {frame_width_,frame_height_};
+		pv.event(profile("hashed_raycast",q_.enqueue_nd_range_kernel(raycast_kernel_,2,nullptr,extent,nullptr,events)));
+		
+		return map;
+		
+	}
+	
+	
+}
@@ -0,0 +1,207 @@
+#include <kinfu/boost_compute_detail_type_name_trait.hpp>
+#include <kinfu/kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block.hpp>
+#include <kinfu/opencl_vector_pipeline_value.hpp>
+#include <kinfu/opencl_voxel_hash_pipeline_value.hpp>
+#include <kinfu/pose_estimation_pipeline_block.hpp>
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+
+namespace kinfu {
+	
+	
+	static boost::compute::kernel get_allocate_kernel (opencl_program_factory & opf) {
+		
+		auto p=opf("hashing");
+		return boost::compute::kernel(p,"allocate_bricks");
+		
+	}
+	
+	
+	static boost::compute::kernel get_integrate_kernel (opencl_program_factory & opf) {
+		
+		auto p=opf("hashing");
+		return boost::compute::kernel(p,"integrate_bricks");
+		
+	}
+	
+	
+	kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block::kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block (
+		boost::compute::command_queue q,
+		opencl_program_factory & opf,
+		float mu,
+		float voxel_size,
+		std::size_t width,
+		std::size_t height,
+		std::size_t depth,
+		std::size_t bricks,
+		std::size_t buckets)
+		:	ve_(std::move(q)),
+			allocate_kernel_(get_allocate_kernel(opf)),
+			integrate_kernel_(get_integrate_kernel(opf)),
+			t_g_k_buf_(ve_.command_queue().get_context(),sizeof(Eigen::Matrix4f),CL_MEM_READ_ONLY),
+			proj_view_buf_(ve_.command_queue().get_context(),sizeof(Eigen::Matrix4f),CL_MEM_READ_ONLY),
+			k_buf_(ve_.command_queue().get_context(),sizeof(Eigen::Matrix3f),CL_MEM_READ_ONLY),
+			ik_buf_(ve_.command_queue().get_context(),sizeof(Eigen::Matrix3f),CL_MEM_READ_ONLY),
+			mu_(mu),
+			voxel_size_(voxel_size),
+			width_(width),
+			height_(height),
+			depth_(depth),
+			bricks_(bricks),
+			buckets_(buckets),
+			reset_(true)
+	{
+		
+		//	Kernel arguments for allocation are:
+		//
+		//	0:	Depth frame
+		//	1:	T_g_k
+		//	2:	K^-1
+		//	3:	mu
+		//	4:	Voxel size
+		//	5:	Hash table keys
+		//	6:	Hash table pointers
+		//	7:	Brick keys
+		//	8:	Allocated brick count
+		//	9:	Maximum number of bricks
+		//	10:	Number of hash table slots
+		allocate_kernel_.set_arg(1,t_g_k_buf_);
+		allocate_kernel_.set_arg(2,ik_buf_);
+		allocate_kernel_.set_arg(3,mu_);
+		allocate_kernel_.set_arg(4,voxel_size_);
+		allocate_kernel_.set_arg(9,std::uint32_t(bricks_));
+		allocate_kernel_.set_arg(10,std::uint32_t(buckets_));
+		
+		//	Kernel arguments for integration are:
+		//
+		//	0:	Depth frame
+		//	1:	TSDF values of the brick pool
+		//	2:	Weights of the brick pool
+		//	3:	Brick keys
+		//	4:	T_g_k^-1
+		//	5:	K
+		//	6:	K^-1
+		//	7:	mu
+		//	8:	Frame width
+		//	9:	Frame height
+		//	10:	Voxel size
+		integrate_kernel_.set_arg(4,proj_view_buf_);
+		integrate_kernel_.set_arg(5,k_buf_);
+		integrate_kernel_.set_arg(6,ik_buf_);
+		integrate_kernel_.set_arg(7,mu_);
+		integrate_kernel_.set_arg(10,voxel_size_);
+		
+	}
+	
+	
+	kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block::~kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block () noexcept {
+		
+		//	Errors cannot be reported from a destructor
+		try {
+		
+			writes_.wait();
+		
+		} catch (...) {	}
+		
+	}
+	
+	
+	kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block::value_type kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block::operator () (
+		depth_device::value_type::element_type & frame,
+		std::size_t frame_width,
+		std::size_t frame_height,
+		Eigen::Matrix3f k,
+		pose_estimation_pipeline_block::value_type::element_type & T_g_k,
+		value_type v
+	) {
+		
+		boost::compute::wait_list events;
+		auto && depth_frame = ve_(frame,events);
+		auto q = ve_.command_queue();
+		auto t_g_k = T_g_k.get();
+		
+		writes_.wait();
+		writes_.clear();
+		
+		if (t_g_k_ != t_g_k) {
+			
+			t_g_k_ = t_g_k;
+			t_g_k_t_ = t_g_k.transpose();
+			writes_.insert(profile("write T_g_k",q.enqueue_write_buffer_async(t_g_k_buf_,0,sizeof(t_g_k_t_),t_g_k_t_.data())));
+			proj_view_ = t_g_k.inverse();
+			proj_view_.transposeInPlace();
+			writes_.insert(profile("write T_g_k^-1",q.enqueue_write_buffer_async(proj_view_buf_,0,sizeof(proj_view_),proj_view_.data())));
+			
+		}
+		
+		if (k_ != k) {
+			
+			k_ = k;
+			ik_ = k.inverse();
+			ik_.transposeInPlace();
+			writes_.insert(profile("write K^-1",q.enqueue_write_buffer_async(ik_buf_,0,sizeof(ik_),ik_.data())));
+			k_t_ = k.transpose();
+			writes_.insert(profile("write K",q.enqueue_write_buffer_async(k_buf_,0,sizeof(k_t_),k_t_.data())));
+			
+		}
+		
+		using type = opencl_voxel_hash_pipeline_value;
+		if (!v.buffer) {
+			
+			v.buffer = std::make_unique<type>(q,buckets_,bricks_,voxel_size_,width_,height_,depth_);
+			reset_ = true;
+			
+		}
+		auto && pv = dynamic_cast<type &>(*v.buffer);
+		if (reset_) {
+			
+			pv.clear();
+			reset_ = false;
+			
+		}
+		
+		allocate_kernel_.set_arg(0,depth_frame);
+		allocate_kernel_.set_arg(5,pv.keys());
+		allocate_kernel_.set_arg(6,pv.pointers());
+		allocate_kernel_.set_arg(7,pv.brick_keys());
+		allocate_kernel_.set_arg(8,pv.count());
+		std::size_t extent [] = {frame_width,frame_height};
+		pv.event(profile("allocate_bricks",q.enqueue_nd_range_kernel(allocate_kernel_,2,nullptr,extent,nullptr,events)));
+		
+		//	Integration is launched over every allocated brick so
+		//	the number allocated must be known on the host
+		auto n = std::min(pv.allocated(),bricks_);
+		if (n != 0) {
+			
+			integrate_kernel_.set_arg(0,depth_frame);
+			integrate_kernel_.set_arg(1,pv.tsdf());
+			integrate_kernel_.set_arg(2,pv.weights());
+			integrate_kernel_.set_arg(3,pv.brick_keys());
+			integrate_kernel_.set_arg(8,std::uint32_t(frame_width));
+			integrate_kernel_.set_arg(9,std::uint32_t(frame_height));
+			pv.event(profile("integrate_bricks",q.enqueue_1d_range_kernel(integrate_kernel_,0,n*voxel_hash_brick_size*voxel_hash_brick_size*voxel_hash_brick_size,0)));
+			
+		}
+		
+		v.width = width_;
+		v.height = height_;
+		v.depth = depth_;
+		
+		return v;
+		
+	}
+	
+	
+	void kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block::reset () noexcept {
+		
+		reset_ = true;
+		
+	}
+	
+	
+}
@@ -1,13 +1,18 @@
 #include <boost/compute/buffer.hpp>
+#include <boost/compute/utility/wait_list.hpp>
 #include <kinfu/boost_compute_detail_type_name_trait.hpp>
+#include <kinfu/camera.hpp>
 #include <kinfu/kinect_fusion_opencl_measurement_pipeline_block.hpp>
-#include <kinfu/opencl_vector_pipeline_value.hpp>
+#include <kinfu/opencl_vector_pyramid_pipeline_value.hpp>
 #include <Eigen/Dense>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <stdexcept>
 #include <utility>
 #include <tuple>
+#include <vector>
 
 
 namespace kinfu {
@@ -21,6 +26,38 @@ namespace kinfu {
 	}
 	
 	
+	static boost::compute::kernel get_bilateral_tiled_kernel (opencl_program_factory & opf) {
+		
+		auto p=opf("bilateral");
+		return boost::compute::kernel(p,"bilateral_filter_tiled");
+		
+	}
+	
+	
+	static boost::compute::kernel get_measurement_kernel (opencl_program_factory & opf) {
+		
+		auto p=opf("measurement");
+		return boost::compute::kernel(p,"measurement");
+		
+	}
+	
+	
+	//	Must match TILE_WIDTH and TILE_HEIGHT in bilateral.cl
+	//	and measurement.cl
+	constexpr std::size_t bilateral_tile_width=16U;
+	constexpr std::size_t bilateral_tile_height=16U;
+	//	Must match FILTERED_WIDTH and FILTERED_HEIGHT in
+	//	measurement.cl
+	constexpr std::size_t filtered_tile_floats=(bilateral_tile_width+1U)*(bilateral_tile_height+1U);
+	
+	
+	static std::size_t round_up (std::size_t n, std::size_t multiple) noexcept {
+		
+		return ((n+multiple-1U)/multiple)*multiple;
+		
+	}
+	
+	
 	static boost::compute::kernel get_v_kernel (opencl_program_factory & opf) {
 		
 		auto p=opf("vertex_map");
@@ -37,22 +74,108 @@ namespace kinfu {
 	}
 	
 	
-	kinect_fusion_opencl_measurement_pipeline_block::kinect_fusion_opencl_measurement_pipeline_block (boost::compute::command_queue q, opencl_program_factory & opf, std::size_t window_size, float sigma_s, float sigma_r)
+	static boost::compute::kernel get_half_sample_kernel (opencl_program_factory & opf) {
+		
+		auto p=opf("pyramid");
+		return boost::compute::kernel(p,"half_sample");
+		
+	}
+	
+	
+	kinect_fusion_opencl_measurement_pipeline_block::kinect_fusion_opencl_measurement_pipeline_block (boost::compute::command_queue q, opencl_program_factory & opf, std::size_t window_size, float sigma_s, float sigma_r, std::size_t levels)
 		:	ve_(std::move(q)),
 			bilateral_kernel_(get_bilateral_kernel(opf)),
+			tileable_(false),
+			tiled_(true),
+			fusable_(false),
+			fused_(false),
 			v_kernel_(get_v_kernel(opf)),
 			n_kernel_(get_n_kernel(opf)),
-			v_(ve_.command_queue().get_context()),
-			kbuf_(ve_.command_queue().get_context(),sizeof(Eigen::Matrix3f),CL_MEM_READ_ONLY)
+			threshold_(3.0f*sigma_r)
 	{
 		
-		bilateral_kernel_.set_arg(2,1.0f/sigma_s*sigma_s);
-		bilateral_kernel_.set_arg(3,1.0f/sigma_r*sigma_r);
+		if (levels==0) throw std::logic_error("Must generate at least one level");
+		
+		//	By precedence these are 1 (up to rounding) rather
+		//	than sigma^-2 as the kernels document, this has
+		//	always been the case and the ground truth against
+		//	which the filter is tested depends on it
+		float spatial_scale=1.0f/sigma_s*sigma_s;
+		float range_scale=1.0f/sigma_r*sigma_r;
+		bilateral_kernel_.set_arg(2,spatial_scale);
+		bilateral_kernel_.set_arg(3,range_scale);
 		std::uint32_t ws(window_size);	//	TODO: Make sure this doesn't overflow?
 		bilateral_kernel_.set_arg(6,ws);
 		bilateral_kernel_.set_arg(7,ws);
 		
-		v_kernel_.set_arg(2,kbuf_);
+		auto ctx=ve_.command_queue().get_context();
+		
+		//	The tiled variant may be used whenever the device can
+		//	accommodate a tile and its apron in local memory and
+		//	the kernel may be launched with a work group per tile
+		//	(which may be fewer work items than the device allows
+		//	due to the local memory and registers the kernel uses)
+		auto dev=ve_.command_queue().get_device();
+		std::size_t tile_floats=(bilateral_tile_width+(2U*window_size))*(bilateral_tile_height+(2U*window_size));
+		std::size_t tile_size=bilateral_tile_width*bilateral_tile_height;
+		if (dev.local_memory_size()>=(tile_floats*sizeof(float))) {
+			
+			bilateral_tiled_kernel_=get_bilateral_tiled_kernel(opf);
+			tileable_=bilateral_tiled_kernel_.get_work_group_info<std::size_t>(dev,CL_KERNEL_WORK_GROUP_SIZE)>=tile_size;
+			
+		}
+		if (tileable_) {
+			
+			//	Spatial weights are precomputed for each offset
+			//	in [-window_size,window_size) in each dimension
+			std::vector<float> spatial;
+			auto spatial_width=2U*window_size;
+			for (std::size_t j=0;j<spatial_width;++j) for (std::size_t i=0;i<spatial_width;++i) {
+				
+				float dx=float(i)-float(window_size);
+				float dy=float(j)-float(window_size);
+				spatial.push_back(std::exp(-(((dx*dx)+(dy*dy))*spatial_scale)));
+				
+			}
+			spatial_=boost::compute::buffer(ctx,spatial.size()*sizeof(float),CL_MEM_READ_ONLY);
+			ve_.command_queue().enqueue_write_buffer(spatial_,0,spatial.size()*sizeof(float),spatial.data());
+			
+			bilateral_tiled_kernel_.set_arg(2,spatial_);
+			bilateral_tiled_kernel_.set_arg(3,range_scale);
+			bilateral_tiled_kernel_.set_arg(6,ws);
+			bilateral_tiled_kernel_.set_arg(7,boost::compute::local_buffer<float>(tile_floats));
+			
+			//	The fused kernel additionally requires the
+			//	filtered tile
+			if (dev.local_memory_size()>=((tile_floats+filtered_tile_floats)*sizeof(float))) {
+				
+				measurement_kernel_=get_measurement_kernel(opf);
+				fusable_=measurement_kernel_.get_work_group_info<std::size_t>(dev,CL_KERNEL_WORK_GROUP_SIZE)>=tile_size;
+				
+			}
+			if (fusable_) {
+				
+				measurement_kernel_.set_arg(3,spatial_);
+				measurement_kernel_.set_arg(4,range_scale);
+				measurement_kernel_.set_arg(7,ws);
+				measurement_kernel_.set_arg(9,boost::compute::local_buffer<float>(tile_floats));
+				measurement_kernel_.set_arg(10,boost::compute::local_buffer<float>(filtered_tile_floats));
+				
+			}
+			
+		}
+		for (std::size_t i=0;i<levels;++i) {
+			
+			v_.emplace_back(ctx);
+			kbuf_.emplace_back(ctx,sizeof(Eigen::Matrix3f),CL_MEM_READ_ONLY);
+			
+		}
+		if (levels>1) {
+			
+			half_sample_kernel_=get_half_sample_kernel(opf);
+			half_sample_kernel_.set_arg(3,threshold_);
+			
+		}
 		
 	}
 	
@@ -65,64 +188,187 @@ namespace kinfu {
 		kinect_fusion_opencl_measurement_pipeline_block::value_type v
 	) {
 		
-		//	Bilateral filtering
-		//
-		//	Kernel arguments are:
-		//
-		//	0:	Source
-		//	1:	Destination
-		//	2:	sigma_s^-2
-		//	3:	sigma_r^-2
-		//	4:	Width
-		//	5:	Height
-		auto && vec=ve_(frame);
+		boost::compute::wait_list events;
+		auto && vec=ve_(frame,events);
 		auto s=vec.size();
 		auto q=ve_.command_queue();
-		v_.resize(s,q);
-		bilateral_kernel_.set_arg(0,vec);
-		bilateral_kernel_.set_arg(1,v_);
-		bilateral_kernel_.set_arg(4,std::uint32_t(width));	//	TODO: Make sure this doesn't overflow?
-		bilateral_kernel_.set_arg(5,std::uint32_t(height));	//	TODO: Make sure this doesn't overflow?
-		std::size_t extent []={width,height};
-		q.enqueue_nd_range_kernel(bilateral_kernel_,2,nullptr,extent,nullptr);
-
-		using pv_type=opencl_vector_pipeline_value<map_type::value_type>;
+		v_[0].resize(s,q);
+		auto levels=v_.size();
+		
+		using pv_type=opencl_vector_pyramid_pipeline_value<map_type::value_type>;
 		if (!v) v=std::make_unique<pv_type>(q);
 		auto && pv=dynamic_cast<pv_type &>(*v);
-		auto && map=pv.vector();
-		map.resize(s,q);
+		pv.levels(levels);
 		
-		//	Vertex map
-		//
-		//	Kernel arguments are:
-		//
-		//	0:	Source (bilaterally filtered image)
-		//	1:	Destination (map)
-		//	2:	K^-1
 		if (k_!=k) {
 			
-			Eigen::Matrix3f k_inv=k.inverse();
-			k_inv.transposeInPlace();
-			q.enqueue_write_buffer(kbuf_,0,sizeof(k_inv),k_inv.data());
+			for (std::size_t i=0;i<levels;++i) {
+				
+				Eigen::Matrix3f k_inv=pyramid_k(k,i).inverse();
+				k_inv.transposeInPlace();
+				profile("write K^-1",q.enqueue_write_buffer(kbuf_[i],0,sizeof(k_inv),k_inv.data()));
+				
+			}
 			k_=std::move(k);
 			
 		}
 		
-		v_kernel_.set_arg(0,v_);
-		v_kernel_.set_arg(1,map);
-		q.enqueue_nd_range_kernel(v_kernel_,2,nullptr,extent,nullptr);
+		boost::compute::event e;
+		bool fused=fused_ && fusable_;
+		if (fused) {
+			
+			//	Fused measurement of the first level
+			//
+			//	Kernel arguments are:
+			//
+			//	0:	Source
+			//	1:	Destination (map)
+			//	2:	Destination (filtered depth)
+			//	3:	Spatial weights
+			//	4:	sigma_r^-2
+			//	5:	Width
+			//	6:	Height
+			//	7:	Window size
+			//	8:	K^-1
+			//	9:	Local memory for source
+			//	10:	Local memory for filtered depth
+			//	11:	Whether filtered depth should be written
+			//
+			//	The filtered depth is only required if further
+			//	levels must be half sampled from it
+			auto && map=pv.level(0);
+			map.resize(s,q);
+			measurement_kernel_.set_arg(0,vec);
+			measurement_kernel_.set_arg(1,map);
+			measurement_kernel_.set_arg(2,v_[0]);
+			measurement_kernel_.set_arg(5,std::uint32_t(width));
+			measurement_kernel_.set_arg(6,std::uint32_t(height));
+			measurement_kernel_.set_arg(8,kbuf_[0]);
+			measurement_kernel_.set_arg(11,std::uint32_t((levels>1) ? 1 : 0));
+			std::size_t extent []={round_up(width,bilateral_tile_width),round_up(height,bilateral_tile_height)};
+			std::size_t local []={bilateral_tile_width,bilateral_tile_height};
+			e=profile("measurement",q.enqueue_nd_range_kernel(measurement_kernel_,2,nullptr,extent,local,events));
+			
+		} else {
+			
+			//	Bilateral filtering
+			//
+			//	Kernel arguments are:
+			//
+			//	0:	Source
+			//	1:	Destination
+			//	2:	sigma_s^-2
+			//	3:	sigma_r^-2
+			//	4:	Width
+			//	5:	Height
+			if (tiled_ && tileable_) {
+				
+				//	The tiled kernel takes the same arguments save
+				//	that the spatial weights are taken from a table
+				//	(2) and its local memory (7) is allocated at
+				//	construction
+				bilateral_tiled_kernel_.set_arg(0,vec);
+				bilateral_tiled_kernel_.set_arg(1,v_[0]);
+				bilateral_tiled_kernel_.set_arg(4,std::uint32_t(width));
+				bilateral_tiled_kernel_.set_arg(5,std::uint32_t(height));
+				std::size_t extent []={round_up(width,bilateral_tile_width),round_up(height,bilateral_tile_height)};
+				std::size_t local []={bilateral_tile_width,bilateral_tile_height};
+				profile("bilateral_filter",q.enqueue_nd_range_kernel(bilateral_tiled_kernel_,2,nullptr,extent,local,events));
+				
+			} else {
+				
+				bilateral_kernel_.set_arg(0,vec);
+				bilateral_kernel_.set_arg(1,v_[0]);
+				bilateral_kernel_.set_arg(4,std::uint32_t(width));	//	TODO: Make sure this doesn't overflow?
+				bilateral_kernel_.set_arg(5,std::uint32_t(height));	//	TODO: Make sure this doesn't overflow?
+				std::size_t extent []={width,height};
+				profile("bilateral_filter",q.enqueue_nd_range_kernel(bilateral_kernel_,2,nullptr,extent,nullptr,events));
+				
+			}
+			
+		}
 		
-		//	Normal map
+		//	Half sampling
 		//
 		//	Kernel arguments are:
 		//
-		//	0:	Map
-		n_kernel_.set_arg(0,map);
-		q.enqueue_nd_range_kernel(n_kernel_,2,nullptr,extent,nullptr);
+		//	0:	Source (filtered depth of finer level)
+		//	1:	Destination
+		//	2:	Width of source
+		//	3:	Threshold
+		for (std::size_t i=1;i<levels;++i) {
+			
+			std::size_t level_extent []={width>>i,height>>i};
+			v_[i].resize(level_extent[0]*level_extent[1],q);
+			half_sample_kernel_.set_arg(0,v_[i-1]);
+			half_sample_kernel_.set_arg(1,v_[i]);
+			half_sample_kernel_.set_arg(2,std::uint32_t(width>>(i-1)));
+			profile("half_sample",q.enqueue_nd_range_kernel(half_sample_kernel_,2,nullptr,level_extent,nullptr));
+			
+		}
+		
+		//	Vertex and normal maps for those levels not measured
+		//	by the fused kernel
+		for (std::size_t i=fused ? 1 : 0;i<levels;++i) {
+			
+			std::size_t level_extent []={width>>i,height>>i};
+			auto && map=pv.level(i);
+			map.resize(level_extent[0]*level_extent[1],q);
+			
+			//	Vertex map
+			//
+			//	Kernel arguments are:
+			//
+			//	0:	Source (bilaterally filtered image)
+			//	1:	Destination (map)
+			//	2:	K^-1
+			v_kernel_.set_arg(0,v_[i]);
+			v_kernel_.set_arg(1,map);
+			v_kernel_.set_arg(2,kbuf_[i]);
+			profile("vertex_map",q.enqueue_nd_range_kernel(v_kernel_,2,nullptr,level_extent,nullptr));
+			
+			//	Normal map
+			//
+			//	Kernel arguments are:
+			//
+			//	0:	Map
+			n_kernel_.set_arg(0,map);
+			e=profile("normal_map",q.enqueue_nd_range_kernel(n_kernel_,2,nullptr,level_extent,nullptr));
+			
+		}
+		pv.event(std::move(e));
 		
 		return v;
 		
 	}
 	
+	
+	void kinect_fusion_opencl_measurement_pipeline_block::tiled (bool tiled) noexcept {
+		
+		tiled_=tiled;
+		
+	}
+	
+	
+	bool kinect_fusion_opencl_measurement_pipeline_block::tiled () const noexcept {
+		
+		return tiled_;
+		
+	}
+	
+	
+	void kinect_fusion_opencl_measurement_pipeline_block::fused (bool fused) noexcept {
+		
+		fused_=fused;
+		
+	}
+	
+	
+	bool kinect_fusion_opencl_measurement_pipeline_block::fused () const noexcept {
+		
+		return fused_;
+		
+	}
+	
 
 }
@@ -0,0 +1,316 @@
+#include <kinfu/boost_compute_detail_type_name_trait.hpp>
+#include <kinfu/camera.hpp>
+#include <kinfu/kinect_fusion_opencl_paged_update_reconstruction_pipeline_block.hpp>
+#include <kinfu/opencl_paged_voxel_pipeline_value.hpp>
+#include <kinfu/opencl_vector_pipeline_value.hpp>
+#include <kinfu/pose_estimation_pipeline_block.hpp>
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+namespace kinfu {
+
+
+	static boost::compute::kernel get_paged_integrate_kernel (opencl_program_factory & opf) {
+
+		auto p=opf("paging");
+		return boost::compute::kernel(p,"paged_integrate");
+
+	}
+
+
+	kinect_fusion_opencl_paged_update_reconstruction_pipeline_block::kinect_fusion_opencl_paged_update_reconstruction_pipeline_block (
+		boost::compute::command_queue q,
+		opencl_program_factory & opf,
+		float mu,
+		filesystem::path path,
+		std::size_t tsdf_width,
+		std::size_t tsdf_height,
+		std::size_t tsdf_depth,
+		float tsdf_extent_w,
+		float tsdf_extent_h,
+		float tsdf_extent_d,
+		std::size_t chunk_size,
+		std::size_t slots)
+		:	ve_(std::move(q)),
+			integrate_kernel_(get_paged_integrate_kernel(opf)),
+			proj_view_buf_(ve_.command_queue().get_context(),sizeof(Eigen::Matrix4f),CL_MEM_READ_ONLY),
+			k_buf_(ve_.command_queue().get_context(),sizeof(Eigen::Matrix3f),CL_MEM_READ_ONLY),
+			ik_buf_(ve_.command_queue().get_context(),sizeof(Eigen::Matrix3f),CL_MEM_READ_ONLY),
+			mu_(mu),
+			path_(std::move(path)),
+			width_(tsdf_width),
+			height_(tsdf_height),
+			depth_(tsdf_depth),
+			extent_(tsdf_extent_w,tsdf_extent_h,tsdf_extent_d),
+			chunk_size_(chunk_size),
+			slots_(slots),
+			max_depth_(4.0f),
+			reset_(true)
+	{
+
+		//	Kernel arguments are:
+		//
+		//	0:	Depth frame
+		//	1:	TSDF values of each slot
+		//	2:	Weights of each slot
+		//	3:	Chunk resident in each slot
+		//	4:	T_g_k^-1
+		//	5:	K
+		//	6:	K^-1
+		//	7:	mu
+		//	8:	Frame width
+		//	9:	Frame height
+		//	10:	TSDF width
+		//	11:	TSDF height
+		//	12:	TSDF depth
+		//	13:	TSDF extent (width)
+		//	14:	TSDF extent (height)
+		//	15:	TSDF extent (depth)
+		//	16:	Chunk size
+		//	17:	Number of chunks along the x axis
+		//	18:	Number of chunks along the y axis
+		//	19:	Maximum depth
+		integrate_kernel_.set_arg(4,proj_view_buf_);
+		integrate_kernel_.set_arg(5,k_buf_);
+		integrate_kernel_.set_arg(6,ik_buf_);
+		integrate_kernel_.set_arg(7,mu_);
+		integrate_kernel_.set_arg(10,std::uint32_t(width_));
+		integrate_kernel_.set_arg(11,std::uint32_t(height_));
+		integrate_kernel_.set_arg(12,std::uint32_t(depth_));
+		integrate_kernel_.set_arg(13,extent_(0));
+		integrate_kernel_.set_arg(14,extent_(1));
+		integrate_kernel_.set_arg(15,extent_(2));
+		integrate_kernel_.set_arg(16,std::uint32_t(chunk_size_));
+		integrate_kernel_.set_arg(19,max_depth_);
+
+	}
+
+
+	kinect_fusion_opencl_paged_update_reconstruction_pipeline_block::~kinect_fusion_opencl_paged_update_reconstruction_pipeline_block () noexcept {
+
+		//	Errors cannot be reported from a destructor
+		try {
+
+			writes_.wait();
+
+		} catch (...) {	}
+
+	}
+
+
+	namespace {
+
+
+		//	A plane in world space, points x such that
+		//	normal.dot(x)+offset>=0 are on the inside
+		class plane {
+
+			public:
+
+				Eigen::Vector3f normal;
+				float offset;
+
+				bool outside (const Eigen::Vector3f & lo, const Eigen::Vector3f & hi) const noexcept {
+
+					//	The corner of the box furthest along the normal
+					Eigen::Vector3f p;
+					for (std::size_t i = 0; i < 3U; ++i) p(i) = (normal(i) >= 0.0f) ? hi(i) : lo(i);
+
+					return (normal.dot(p) + offset) < 0.0f;
+
+				}
+
+		};
+
+
+	}
+
+
+	std::vector<std::size_t> kinect_fusion_opencl_paged_update_reconstruction_pipeline_block::select (
+		const Eigen::Matrix4f & t_g_k,
+		const Eigen::Matrix3f & k,
+		std::size_t frame_width,
+		std::size_t frame_height
+	) const {
+
+		//	The view frustum is bounded by the planes through the
+		//	camera and each pair of adjacent image corners (extended
+		//	by half a pixel since pixels are rounded) and by the
+		//	planes at a depth of zero and the maximum depth
+		Eigen::Vector3f t(t_g_k.block<3,1>(0,3));
+		Eigen::Matrix3f r(t_g_k.block<3,3>(0,0));
+		Eigen::Matrix3f k_inv(k.inverse());
+		Eigen::Vector3f axis(r.col(2));
+		Eigen::Vector3f rays [] = {
+			r * (k_inv * Eigen::Vector3f(-0.5f, -0.5f, 1.0f)),
+			r * (k_inv * Eigen::Vector3f(float(frame_width) - 0.5f, -0.5f, 1.0f)),
+			r * (k_inv * Eigen::Vector3f(float(frame_width) - 0.5f, float(frame_height) - 0.5f, 1.0f)),
+			r * (k_inv * Eigen::Vector3f(-0.5f, float(frame_height) - 0.5f, 1.0f))
+		};
+		std::vector<plane> planes;
+		for (std::size_t i = 0; i < 4U; ++i) {
+
+			Eigen::Vector3f n(rays[i].cross(rays[(i + 1U) % 4U]));
+			if (n.dot(axis) < 0.0f) n = -n;
+			planes.push_back(plane{n, -n.dot(t)});
+
+		}
+		planes.push_back(plane{axis, -axis.dot(t)});
+		planes.push_back(plane{-axis, max_depth_ + axis.dot(t)});
+
+		std::size_t sizes [] = {width_, height_, depth_};
+		std::size_t chunks [3];
+		std::size_t lo [3];
+		std::size_t hi [3];
+		Eigen::Vector3f voxel;
+		auto b = frustum_bounds(t_g_k, k, frame_width, frame_height, max_depth_);
+		for (std::size_t i = 0; i < 3U; ++i) {
+
+			chunks[i] = (sizes[i] + chunk_size_ - 1U) / chunk_size_;
+			voxel(i) = extent_(i) / float(sizes[i]);
+			float c = voxel(i) * float(chunk_size_);
+			float l = std::floor((b.first(i) - voxel(i)) / c);
+			float h = std::floor((b.second(i) + voxel(i)) / c);
+			if (!(l < float(chunks[i])) || !(h >= 0.0f)) return {};
+			lo[i] = std::size_t(std::max(l, 0.0f));
+			hi[i] = std::min(std::size_t(h), chunks[i] - 1U);
+
+		}
+
+		std::vector<std::pair<float,std::size_t>> selected;
+		for (std::size_t z = lo[2]; z <= hi[2]; ++z) for (std::size_t y = lo[1]; y <= hi[1]; ++y) for (std::size_t x = lo[0]; x <= hi[0]; ++x) {
+
+			std::size_t c [] = {x, y, z};
+			Eigen::Vector3f begin;
+			Eigen::Vector3f end;
+			for (std::size_t i = 0; i < 3U; ++i) {
+
+				//	A margin of one voxel absorbs rounding
+				begin(i) = (float(c[i] * chunk_size_) - 1.0f) * voxel(i);
+				end(i) = (float(std::min((c[i] + 1U) * chunk_size_, sizes[i])) + 1.0f) * voxel(i);
+
+			}
+			if (std::any_of(planes.begin(), planes.end(), [&] (const plane & p) noexcept {	return p.outside(begin, end);	})) continue;
+
+			selected.emplace_back((((begin + end) / 2.0f) - t).squaredNorm(), x + (chunks[0] * (y + (chunks[1] * z))));
+
+		}
+
+		//	When not all chunks may be resident those nearest the
+		//	camera take priority
+		std::sort(selected.begin(), selected.end());
+		if (selected.size() > slots_) selected.resize(slots_);
+		std::vector<std::size_t> retr;
+		for (auto && s : selected) retr.push_back(s.second);
+
+		return retr;
+
+	}
+
+
+	kinect_fusion_opencl_paged_update_reconstruction_pipeline_block::value_type kinect_fusion_opencl_paged_update_reconstruction_pipeline_block::operator () (
+		depth_device::value_type::element_type & frame,
+		std::size_t frame_width,
+		std::size_t frame_height,
+		Eigen::Matrix3f k,
+		pose_estimation_pipeline_block::value_type::element_type & T_g_k,
+		value_type v
+	) {
+
+		boost::compute::wait_list events;
+		auto && depth_frame = ve_(frame,events);
+		auto q = ve_.command_queue();
+		auto t_g_k = T_g_k.get();
+
+		writes_.wait();
+		writes_.clear();
+
+		if (t_g_k_ != t_g_k) {
+
+			t_g_k_ = t_g_k;
+			proj_view_ = t_g_k.inverse();
+			proj_view_.transposeInPlace();
+			writes_.insert(profile("write T_g_k^-1",q.enqueue_write_buffer_async(proj_view_buf_,0,sizeof(proj_view_),proj_view_.data())));
+
+		}
+
+		if (k_ != k) {
+
+			k_ = k;
+			ik_ = k.inverse();
+			ik_.transposeInPlace();
+			writes_.insert(profile("write K^-1",q.enqueue_write_buffer_async(ik_buf_,0,sizeof(ik_),ik_.data())));
+			k_t_ = k.transpose();
+			writes_.insert(profile("write K",q.enqueue_write_buffer_async(k_buf_,0,sizeof(k_t_),k_t_.data())));
+
+		}
+
+		using type = opencl_paged_voxel_pipeline_value;
+		if (!v.buffer) {
+
+			v.buffer = std::make_unique<type>(q,path_,width_,height_,depth_,chunk_size_,slots_);
+			reset_ = true;
+
+		}
+		auto && pv = dynamic_cast<type &>(*v.buffer);
+		if (reset_) {
+
+			pv.clear();
+			reset_ = false;
+
+		}
+
+		//	Chunks are paged in and out before the kernel is
+		//	enqueued, the in order queue ensures the kernel sees
+		//	them
+		pv.require(select(t_g_k, k, frame_width, frame_height));
+
+		integrate_kernel_.set_arg(0,depth_frame);
+		integrate_kernel_.set_arg(1,pv.tsdf());
+		integrate_kernel_.set_arg(2,pv.weights());
+		integrate_kernel_.set_arg(3,pv.slot_chunks().get_buffer());
+		integrate_kernel_.set_arg(8,std::uint32_t(frame_width));
+		integrate_kernel_.set_arg(9,std::uint32_t(frame_height));
+		integrate_kernel_.set_arg(17,std::uint32_t(pv.chunks_x()));
+		integrate_kernel_.set_arg(18,std::uint32_t(pv.chunks_y()));
+		pv.event(profile("paged_integrate",q.enqueue_1d_range_kernel(integrate_kernel_,0,slots_*chunk_size_*chunk_size_*chunk_size_,0,events)));
+
+		v.width = width_;
+		v.height = height_;
+		v.depth = depth_;
+
+		return v;
+
+	}
+
+
+	void kinect_fusion_opencl_paged_update_reconstruction_pipeline_block::max_depth (float depth) {
+
+		max_depth_ = depth;
+		integrate_kernel_.set_arg(19,max_depth_);
+
+	}
+
+
+	float kinect_fusion_opencl_paged_update_reconstruction_pipeline_block::max_depth () const noexcept {
+
+		return max_depth_;
+
+	}
+
+
+	void kinect_fusion_opencl_paged_update_reconstruction_pipeline_block::reset () noexcept {
+
+		reset_ = true;
+
+	}
+
+
+}
@@ -1,19 +1,26 @@
 #include <boost/compute.hpp>
 #include <kinfu/boost_compute_detail_type_name_trait.hpp>
+#include <kinfu/camera.hpp>
+#include <kinfu/correspondence_sampling.hpp>
 #include <kinfu/cpu_pipeline_value.hpp>
+#include <kinfu/motion_model.hpp>
 #include <kinfu/kinect_fusion_opencl_pose_estimation_pipeline_block.hpp>
 #include <kinfu/opencl_program_factory.hpp>
+#include <kinfu/opencl_vector_pyramid_pipeline_value.hpp>
 #include <kinfu/optional.hpp>
 #include <kinfu/scope.hpp>
 #include <Eigen/Dense>
 #include <Eigen/Cholesky>
+#include <algorithm>
 #include <cstddef>
 #include <cstring>
 #include <cstdint>
 #include <memory>
+#include <numeric>
 #include <sstream>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 
 
 namespace kinfu {
@@ -21,8 +28,27 @@ namespace kinfu {
 
 	constexpr std::size_t a_floats=21U;
 	constexpr std::size_t b_floats=6U;
-	constexpr std::size_t mats_floats=a_floats+b_floats;
+	constexpr std::size_t count_floats=1U;
+	constexpr std::size_t mats_floats=a_floats+b_floats+count_floats;
+	constexpr float min_correspondences=6.0f;
 	constexpr std::size_t sizeof_mats=sizeof(float)*mats_floats;
+	constexpr std::size_t groups_per_compute_unit=8U;
+
+
+	//	Layout of the status buffer shared with the
+	//	correspondences and solve kernels
+	using status_type=std::uint32_t [3];
+	constexpr std::size_t status_converged=0U;
+	constexpr std::size_t status_iterations=1U;
+	constexpr std::size_t status_failed=2U;
+
+
+	[[noreturn]]
+	static void tracking_lost () {
+
+		throw pose_estimation_pipeline_block::tracking_lost_error("Less than 6 correspondences were found");
+
+	}
 
 
 	kinect_fusion_opencl_pose_estimation_pipeline_block::kinect_fusion_opencl_pose_estimation_pipeline_block (
@@ -36,10 +62,37 @@ namespace kinfu {
 		std::size_t numit,
 		std::size_t group_size,
 		bool force_px_px
+	)	:	kinect_fusion_opencl_pose_estimation_pipeline_block(
+				std::move(q),
+				pf,
+				epsilon_d,
+				epsilon_theta,
+				frame_width,
+				frame_height,
+				std::move(t_gk_initial),
+				std::vector<std::size_t>{numit},
+				group_size,
+				force_px_px
+			)
+	{	}
+
+
+	kinect_fusion_opencl_pose_estimation_pipeline_block::kinect_fusion_opencl_pose_estimation_pipeline_block (
+		boost::compute::command_queue q,
+		opencl_program_factory & pf,
+		float epsilon_d,
+		float epsilon_theta,
+		std::size_t frame_width,
+		std::size_t frame_height,
+		Eigen::Matrix4f t_gk_initial,
+		std::vector<std::size_t> iterations,
+		std::size_t group_size,
+		bool force_px_px
 	)	:	q_(std::move(q)),
-			t_z_(q_.get_context(),sizeof(Eigen::Matrix4f),CL_MEM_READ_ONLY|CL_MEM_HOST_WRITE_ONLY),
-			t_frame_frame_(q_.get_context(),sizeof(Eigen::Matrix4f),CL_MEM_READ_ONLY|CL_MEM_HOST_WRITE_ONLY),
-			k_(q_.get_context(),sizeof(Eigen::Matrix3f),CL_MEM_READ_ONLY|CL_MEM_HOST_WRITE_ONLY),
+			t_z_(q_.get_context(),sizeof(Eigen::Matrix4f),CL_MEM_READ_WRITE),
+			t_frame_frame_(q_.get_context(),sizeof(Eigen::Matrix4f),CL_MEM_READ_WRITE),
+			t_gk_prev_inverse_(q_.get_context(),sizeof(Eigen::Matrix4f),CL_MEM_READ_ONLY|CL_MEM_HOST_WRITE_ONLY),
+			status_(q_.get_context(),sizeof(status_type),CL_MEM_READ_WRITE),
 			e_(q_),
 			p_e_(q_),
 			epsilon_d_(epsilon_d),
@@ -47,38 +100,77 @@ namespace kinfu {
 			frame_width_(frame_width),
 			frame_height_(frame_height),
 			t_gk_initial_(std::move(t_gk_initial)),
-			numit_(numit),
+			iterations_(std::move(iterations)),
 			group_size_(group_size),
-			force_px_px_(force_px_px)
+			force_px_px_(force_px_px),
+			epsilon_rotation_(0.0f),
+			epsilon_translation_(0.0f),
+			iterations_performed_(0),
+			device_solve_(false),
+			motion_model_(false),
+			histogram_(q_.get_context(),sizeof(std::uint32_t)*normal_space_buckets,CL_MEM_READ_WRITE),
+			sampling_(correspondence_sampling::all),
+			samples_(0),
+			samples_dirty_(false),
+			seed_(0)
 	{
 
-		if (numit_==0) throw std::logic_error("Must iterate at least once");
+		if (std::accumulate(iterations_.begin(),iterations_.end(),std::size_t(0))==0) throw std::logic_error("Must iterate at least once");
 
 		if (group_size_==0) throw std::logic_error("Size of OpenCL parallel sum work groups must be at least 1");
-		auto frame_size=frame_width_*frame_height_;
-		if (group_size_>frame_size) {
+		auto levels=iterations_.size();
+		for (std::size_t l=0;l<levels;++l) {
+
+			//	Levels at which no iterations are performed
+			//	impose no constraints
+			if (iterations_[levels-1U-l]==0) continue;
 
-			std::ostringstream ss;
-			ss << "Size of OpenCL parallel sum work groups " << group_size_ << " is greater than frame size " << frame_size << " (" << frame_width_ << "x" << frame_height_ << ")";
-			throw std::logic_error(ss.str());
+			auto width=frame_width_>>l;
+			auto height=frame_height_>>l;
+			auto frame_size=width*height;
+			if (group_size_>frame_size) {
+
+				std::ostringstream ss;
+				ss << "Size of OpenCL parallel sum work groups " << group_size_ << " is greater than frame size " << frame_size << " (" << width << "x" << height << ") at pyramid level " << l;
+				throw std::logic_error(ss.str());
+
+			}
 
 		}
-		if ((frame_size%group_size_)!=0) {
 
-			std::ostringstream ss;
-			ss << "Size of OpenCL parallel sum work groups " << group_size_ << " does not evenly divide frame size " << frame_size << " (" << frame_width_ << "x" << frame_height_ << ")";
-			throw std::logic_error(ss.str());
+		//	Each work item of the correspondences kernel loops
+		//	over the frame so only enough work groups to occupy
+		//	the device are launched, this bounds the number of
+		//	partial sums which must be combined afterwards
+		auto frame_size=frame_width_*frame_height_;
+		groups_=std::max<std::size_t>(q_.get_device().compute_units(),1U)*groups_per_compute_unit;
+		groups_=std::min(groups_,(frame_size+group_size_-1U)/group_size_);
+		mats_=boost::compute::buffer(q_.get_context(),groups_*sizeof_mats);
+
+		for (std::size_t l=0;l<levels;++l) k_.emplace_back(q_.get_context(),sizeof(Eigen::Matrix3f),CL_MEM_READ_ONLY|CL_MEM_HOST_WRITE_ONLY);
+		for (std::size_t l=0;l<levels;++l) {
+
+			sample_indices_.emplace_back(q_.get_context());
+			sample_counts_.emplace_back(q_.get_context(),sizeof(std::uint32_t),CL_MEM_READ_WRITE);
 
 		}
+		for (std::size_t l=1;l<levels;++l) {
 
-		auto frame_size_after=frame_size/group_size_;
-		mats_=boost::compute::buffer(q_.get_context(),frame_size_after*sizeof_mats);
-		if ((frame_size_after%group_size_)==0) mats_output_=boost::compute::buffer(q_.get_context(),(frame_size_after/group_size_)*sizeof_mats);
+			map_levels_.emplace_back(q_.get_context());
+			prev_map_levels_.emplace_back(q_.get_context());
+
+		}
 
 		auto p=pf("pose_estimation");
 		corr_=p.create_kernel("correspondences");
-		parallel_sum_=p.create_kernel("parallel_sum");
 		serial_sum_=p.create_kernel("serial_sum");
+		solve_=p.create_kernel("solve");
+		if (levels>1) half_sample_map_=pf("pyramid").create_kernel("half_sample_map");
+		auto sp=pf("sampling");
+		histogram_kernel_=sp.create_kernel("normal_space_histogram");
+		select_kernel_=sp.create_kernel("normal_space_select");
+		histogram_kernel_.set_arg(1,histogram_);
+		select_kernel_.set_arg(1,histogram_);
 
 		boost::compute::local_buffer<float> scratch(mats_floats*group_size_);
 
@@ -87,14 +179,152 @@ namespace kinfu {
 		corr_.set_arg(3,t_z_);
 		corr_.set_arg(4,epsilon_d_);
 		corr_.set_arg(5,epsilon_theta_);
-		corr_.set_arg(6,k_);
-		corr_.set_arg(7,std::uint32_t(frame_width));
-		corr_.set_arg(8,std::uint32_t(frame_height));
 		corr_.set_arg(9,mats_);
 		corr_.set_arg(10,scratch);
+		corr_.set_arg(11,status_);
+
+		//	Serial sum arguments
+		serial_sum_.set_arg(0,mats_);
 
-		//	Parallel sum arguments
-		parallel_sum_.set_arg(2,scratch);
+		//	Solve arguments
+		solve_.set_arg(0,mats_);
+		solve_.set_arg(1,t_z_);
+		solve_.set_arg(2,t_frame_frame_);
+		solve_.set_arg(3,t_gk_prev_inverse_);
+		solve_.set_arg(4,status_);
+		solve_.set_arg(7,std::uint32_t(force_px_px_ ? 1 : 0));
+
+	}
+
+
+	void kinect_fusion_opencl_pose_estimation_pipeline_block::termination_thresholds (float rotation, float translation) noexcept {
+
+		epsilon_rotation_=rotation;
+		epsilon_translation_=translation;
+
+	}
+
+
+	void kinect_fusion_opencl_pose_estimation_pipeline_block::device_solve (bool d) noexcept {
+
+		device_solve_=d;
+
+	}
+
+
+	bool kinect_fusion_opencl_pose_estimation_pipeline_block::device_solve () const noexcept {
+
+		return device_solve_;
+
+	}
+
+
+	void kinect_fusion_opencl_pose_estimation_pipeline_block::motion_model (bool m) noexcept {
+
+		motion_model_=m;
+
+	}
+
+
+	bool kinect_fusion_opencl_pose_estimation_pipeline_block::motion_model () const noexcept {
+
+		return motion_model_;
+
+	}
+
+
+	void kinect_fusion_opencl_pose_estimation_pipeline_block::sampling (correspondence_sampling s, std::size_t samples) {
+
+		if ((s!=correspondence_sampling::all) && (samples==0)) throw std::logic_error("Must sample at least one pixel");
+
+		sampling_=s;
+		samples_=samples;
+		samples_dirty_=true;
+
+	}
+
+
+	correspondence_sampling kinect_fusion_opencl_pose_estimation_pipeline_block::sampling () const noexcept {
+
+		return sampling_;
+
+	}
+
+
+	std::size_t kinect_fusion_opencl_pose_estimation_pipeline_block::samples () const noexcept {
+
+		return samples_;
+
+	}
+
+
+	std::size_t kinect_fusion_opencl_pose_estimation_pipeline_block::level_samples (std::size_t l) const noexcept {
+
+		//	Each level has a quarter of the pixels of the level
+		//	before it
+		return std::max<std::size_t>(samples_>>(2U*l),1U);
+
+	}
+
+
+	void kinect_fusion_opencl_pose_estimation_pipeline_block::prepare_samples (
+		const std::vector<boost::compute::vector<measurement_pipeline_block::value_type::element_type::type::value_type> *> & maps,
+		boost::compute::wait_list & events
+	) {
+
+		if (sampling_==correspondence_sampling::all) return;
+
+		//	Stride and random samples depend only on the size
+		//	of each level and are therefore only regenerated
+		//	when the configuration changes
+		if (sampling_!=correspondence_sampling::normal_space) {
+
+			if (!samples_dirty_) return;
+
+			for (std::size_t l=0;l<maps.size();++l) {
+
+				auto size=(frame_width_>>l)*(frame_height_>>l);
+				auto count=level_samples(l);
+				auto indices=(sampling_==correspondence_sampling::stride) ? stride_samples(size,count) : random_samples(size,count,std::uint32_t(l));
+				sample_indices_[l].resize(indices.size(),q_);
+				profile("write samples",q_.enqueue_write_buffer(sample_indices_[l].get_buffer(),0,indices.size()*sizeof(std::uint32_t),indices.data()));
+				std::uint32_t c(indices.size());
+				profile("write sample count",q_.enqueue_write_buffer(sample_counts_[l],0,sizeof(c),&c));
+
+			}
+			samples_dirty_=false;
+
+			return;
+
+		}
+
+		//	Normal space samples depend on the current frame and
+		//	are selected on the device
+		samples_dirty_=true;
+		std::uint32_t zero(0);
+		for (std::size_t l=0;l<maps.size();++l) {
+
+			std::size_t size=(frame_width_>>l)*(frame_height_>>l);
+			sample_indices_[l].resize(size,q_);
+			profile("clear histogram",q_.enqueue_fill_buffer(histogram_,&zero,sizeof(zero),0,sizeof(zero)*normal_space_buckets,events));
+			profile("clear sample count",q_.enqueue_fill_buffer(sample_counts_[l],&zero,sizeof(zero),0,sizeof(zero)));
+			histogram_kernel_.set_arg(0,*maps[l]);
+			profile("normal_space_histogram",q_.enqueue_nd_range_kernel(histogram_kernel_,1,nullptr,&size,nullptr));
+			select_kernel_.set_arg(0,*maps[l]);
+			select_kernel_.set_arg(2,sample_indices_[l]);
+			select_kernel_.set_arg(3,sample_counts_[l]);
+			select_kernel_.set_arg(4,std::uint32_t(level_samples(l)));
+			select_kernel_.set_arg(5,seed_++);
+			profile("normal_space_select",q_.enqueue_nd_range_kernel(select_kernel_,1,nullptr,&size,nullptr));
+
+		}
+
+	}
+
+
+	std::size_t kinect_fusion_opencl_pose_estimation_pipeline_block::iterations_performed () const noexcept {
+
+		return iterations_performed_;
 
 	}
 
@@ -107,9 +337,12 @@ namespace kinfu {
 	) {
 
 		using pv_type=cpu_pipeline_value<value_type::element_type::type>;
+
+		iterations_performed_=0;
 	
 		if (!(t_gk_minus_one && prev_map)) {
 
+			t_gk_minus_two_=nullopt;
 			t_gk_minus_one=std::make_unique<pv_type>();
 			static_cast<pv_type &>(*t_gk_minus_one).emplace(t_gk_initial_);
 
@@ -117,105 +350,261 @@ namespace kinfu {
 
 		}
 
-		//	Get input vectors and bind parameters
-		auto && map_b=e_(map);
-		corr_.set_arg(0,map_b);
-		auto && prev_map_b=p_e_(*prev_map);
-		corr_.set_arg(1,prev_map_b);
+		//	Get input vectors
+		boost::compute::wait_list events;
+		auto && map_b=e_(map,events);
+		auto && prev_map_b=p_e_(*prev_map,events);
+
+		//	Obtain coarser levels, the predicted vertex and
+		//	normal map is always half sampled here whereas the
+		//	vertex and normal map from the current frame is
+		//	taken from the measurement pipeline block when
+		//	available
+		using map_value_type=measurement_pipeline_block::value_type::element_type::type::value_type;
+		auto levels=iterations_.size();
+		auto pyramid=dynamic_cast<opencl_vector_pyramid_pipeline_value<map_value_type> *>(&map);
+		bool use_pyramid=pyramid && (pyramid->levels()>=levels) && (pyramid->context()==q_.get_context());
+		std::vector<boost::compute::vector<map_value_type> *> maps{&map_b};
+		std::vector<boost::compute::vector<map_value_type> *> prev_maps{&prev_map_b};
+		auto half_sample=[&] (boost::compute::vector<map_value_type> & src, boost::compute::vector<map_value_type> & dest, std::size_t l) {
+
+			std::size_t extent []={frame_width_>>l,frame_height_>>l};
+			dest.resize(extent[0]*extent[1],q_);
+			half_sample_map_.set_arg(0,src);
+			half_sample_map_.set_arg(1,dest);
+			half_sample_map_.set_arg(2,std::uint32_t(frame_width_>>(l-1U)));
+			profile("half_sample_map",q_.enqueue_nd_range_kernel(half_sample_map_,2,nullptr,extent,nullptr,events));
+
+		};
+		for (std::size_t l=1;l<levels;++l) {
+
+			half_sample(*prev_maps.back(),prev_map_levels_[l-1U],l);
+			prev_maps.push_back(&prev_map_levels_[l-1U]);
+
+			if (use_pyramid) {
+
+				maps.push_back(&pyramid->level(l));
+				continue;
+
+			}
+
+			half_sample(*maps.back(),map_levels_[l-1U],l);
+			maps.push_back(&map_levels_[l-1U]);
+
+		}
 
 		auto && pv=dynamic_cast<pv_type &>(*t_gk_minus_one);
 		auto t_gk_minus_one_m=pv.get();
 		Eigen::Matrix4f t_z(t_gk_minus_one_m);
 		Eigen::Matrix4f t_gk_prev_inverse(t_gk_minus_one_m.inverse());
 
-		k.transposeInPlace();
-		auto kw=q_.enqueue_write_buffer_async(k_,0,sizeof(k),&k);
-		auto kwg=make_scope_exit([&] () noexcept {	kw.wait();	});
+		//	The velocity is forgotten unless this invocation
+		//	succeeds
+		auto t_gk_minus_two=std::move(t_gk_minus_two_);
+		t_gk_minus_two_=nullopt;
+
+		//	Host copies of asynchronous writes, these must be
+		//	declared before the guard which waits for the writes
+		//	so that they outlive them should an exception be
+		//	thrown
+		std::vector<Eigen::Matrix3f> ks;
+		Eigen::Matrix4f t_z_t;
+		Eigen::Matrix4f t_frame_frame_t;
+		Eigen::Matrix4f t_gk_prev_inverse_t;
+		boost::compute::wait_list kws;
+		auto kwg=make_scope_exit([&] () noexcept {	kws.wait();	});
+		for (std::size_t l=0;l<levels;++l) ks.push_back(pyramid_k(k,l).transpose());
+		for (std::size_t l=0;l<levels;++l) kws.insert(profile("write K",q_.enqueue_write_buffer_async(k_[l],0,sizeof(ks[l]),ks[l].data())));
+
+		//	The correspondences kernel does nothing once the
+		//	status indicates convergence so this must be cleared
+		//	even when solving on the host
+		std::uint32_t zero(0);
+		profile("clear status",q_.enqueue_fill_buffer(status_,&zero,sizeof(zero),0,sizeof(status_type)));
+
+		prepare_samples(maps,events);
+
+		auto bind=[&] (std::size_t l) {
+
+			auto width=frame_width_>>l;
+			auto height=frame_height_>>l;
+			corr_.set_arg(0,*maps[l]);
+			corr_.set_arg(1,*prev_maps[l]);
+			corr_.set_arg(6,k_[l]);
+			corr_.set_arg(7,std::uint32_t(width));
+			corr_.set_arg(8,std::uint32_t(height));
+			auto size=width*height;
+			if (sampling_==correspondence_sampling::all) {
+
+				//	The sample buffers are not accessed but an
+				//	argument must nonetheless be provided
+				corr_.set_arg(12,sample_counts_[l]);
+				corr_.set_arg(13,std::uint32_t(0));
+
+			} else {
+
+				corr_.set_arg(12,sample_indices_[l]);
+				corr_.set_arg(13,std::uint32_t(1));
+				size=std::min(size,level_samples(l));
 
-		for (std::size_t i=0;i<numit_;++i) {
+			}
+			corr_.set_arg(14,sample_counts_[l]);
+			auto groups=std::min(groups_,(size+group_size_-1U)/group_size_);
+			serial_sum_.set_arg(1,std::uint32_t(groups));
+
+			return groups;
 
-			//	Upload current estimate to the GPU
-			Eigen::Matrix4f t_frame_frame(t_gk_prev_inverse*t_z);
+		};
+		auto correspondences=[&] (std::size_t groups) {
 
-			// If enabled, force pixel to pixel correspondences
-			if (force_px_px_) t_frame_frame = Eigen::Matrix4f::Identity();
+			std::size_t global_size=groups*group_size_;
+			profile("correspondences",q_.enqueue_nd_range_kernel(corr_,1,nullptr,&global_size,&group_size_,events));
+			//	Subsequent commands are ordered after the
+			//	first by the command queue
+			events.clear();
 
-			t_z.transposeInPlace();
-			auto tzw=q_.enqueue_write_buffer_async(t_z_,0,sizeof(t_z),&t_z);
-			auto tzwg=make_scope_exit([&] () noexcept {	tzw.wait();	});
-			t_frame_frame.transposeInPlace();
-			auto tffw=q_.enqueue_write_buffer_async(t_frame_frame_,0,sizeof(t_frame_frame),&t_frame_frame);
-			auto tffwg=make_scope_exit([&] () noexcept {	tffw.wait();	});
+			//	Combine the sums of each work group if necessary
+			if (groups>1) {
 
-			//	Enqueue correspondences kernel
-			auto input_size=frame_height_*frame_width_;
-			q_.enqueue_nd_range_kernel(corr_,1,nullptr,&input_size,&group_size_);
-			input_size/=group_size_;
+				std::size_t serial_size(mats_floats);
+				profile("serial_sum",q_.enqueue_nd_range_kernel(serial_sum_,1,nullptr,&serial_size,nullptr));
 
-			//	Perform parallel phase of sum
-			boost::compute::buffer in(mats_);
-			boost::compute::buffer out(mats_output_);
-			std::size_t output_size=input_size;	//	In case the branch on the next line isn't taken
-			if (group_size_!=1) while ((input_size%group_size_)==0) {
+			}
 
-				output_size=input_size/group_size_;
+		};
 
-				parallel_sum_.set_arg(0,in);
-				parallel_sum_.set_arg(1,out);
-				q_.enqueue_nd_range_kernel(parallel_sum_,1,nullptr,&input_size,&group_size_);
+		//	Choose between the previous pose and that predicted
+		//	by the motion model by the number of correspondences
+		//	each yields at the coarsest level
+		if (motion_model_ && t_gk_minus_two) {
 
-				input_size=output_size;
-				using std::swap;
-				swap(in,out);
+			Eigen::Matrix4f predicted(constant_velocity(*t_gk_minus_two,t_gk_minus_one_m));
+			auto groups=bind(levels-1U);
+			auto inliers=[&] (const Eigen::Matrix4f & t) {
 
-			}
+				Eigen::Matrix4f t_t(t.transpose());
+				Eigen::Matrix4f t_ff_t(force_px_px_ ? Eigen::Matrix4f::Identity() : Eigen::Matrix4f((t_gk_prev_inverse*t).transpose()));
+				profile("write T_z",q_.enqueue_write_buffer(t_z_,0,sizeof(t_t),t_t.data()));
+				profile("write T_frame_frame",q_.enqueue_write_buffer(t_frame_frame_,0,sizeof(t_ff_t),t_ff_t.data()));
+				correspondences(groups);
+				float count;
+				profile("read count",q_.enqueue_read_buffer(mats_,(a_floats+b_floats)*sizeof(float),sizeof(count),&count));
+
+				return count;
+
+			};
+			if (inliers(predicted)>=inliers(t_z)) t_z=predicted;
+
+		}
+
+		//	When solving on the device the initial estimate
+		//	is uploaded once and then updated by the solve
+		//	kernel
+		t_z_t=t_z.transpose();
+		t_frame_frame_t=force_px_px_ ? Eigen::Matrix4f::Identity() : Eigen::Matrix4f((t_gk_prev_inverse*t_z).transpose());
+		t_gk_prev_inverse_t=t_gk_prev_inverse.transpose();
+		if (device_solve_) {
 
-			//	Perform serial phase of sum if necessary
-			if (output_size>1) {
+			kws.insert(profile("write T_z",q_.enqueue_write_buffer_async(t_z_,0,sizeof(t_z_t),t_z_t.data())));
+			kws.insert(profile("write T_frame_frame",q_.enqueue_write_buffer_async(t_frame_frame_,0,sizeof(t_frame_frame_t),t_frame_frame_t.data())));
+			kws.insert(profile("write T_g,k-1^-1",q_.enqueue_write_buffer_async(t_gk_prev_inverse_,0,sizeof(t_gk_prev_inverse_t),t_gk_prev_inverse_t.data())));
+			solve_.set_arg(5,epsilon_rotation_);
+			solve_.set_arg(6,epsilon_translation_);
+
+		}
 
-				serial_sum_.set_arg(0,in);
-				serial_sum_.set_arg(1,std::uint32_t(input_size));
-				std::size_t serial_size(27);
-				q_.enqueue_nd_range_kernel(serial_sum_,1,nullptr,&serial_size,nullptr);
+		//	Iterate from the coarsest level to the finest
+		for (std::size_t n=0;n<levels;++n) {
+
+			auto groups=bind(levels-1U-n);
+
+			//	Convergence applies to each level separately
+			if (device_solve_) profile("clear converged",q_.enqueue_fill_buffer(status_,&zero,sizeof(zero),status_converged*sizeof(zero),sizeof(zero)));
+
+			for (std::size_t i=0;i<iterations_[n];++i) {
+
+				if (device_solve_) {
+
+					correspondences(groups);
+					std::size_t solve_size(1);
+					profile("solve",q_.enqueue_nd_range_kernel(solve_,1,nullptr,&solve_size,nullptr));
+
+					continue;
+
+				}
+
+				//	Upload current estimate to the GPU
+				Eigen::Matrix4f t_frame_frame(t_gk_prev_inverse*t_z);
+
+				// If enabled, force pixel to pixel correspondences
+				if (force_px_px_) t_frame_frame = Eigen::Matrix4f::Identity();
+
+				t_z.transposeInPlace();
+				auto tzw=profile("write T_z",q_.enqueue_write_buffer_async(t_z_,0,sizeof(t_z),&t_z));
+				auto tzwg=make_scope_exit([&] () noexcept {	tzw.wait();	});
+				t_frame_frame.transposeInPlace();
+				auto tffw=profile("write T_frame_frame",q_.enqueue_write_buffer_async(t_frame_frame_,0,sizeof(t_frame_frame),&t_frame_frame));
+				auto tffwg=make_scope_exit([&] () noexcept {	tffw.wait();	});
+
+				correspondences(groups);
+
+				//	Collect results
+				float buffer [mats_floats];
+				profile("read sums",q_.enqueue_read_buffer(mats_,0,sizeof(buffer),buffer));
+				if (buffer[a_floats+b_floats]<min_correspondences) tracking_lost();
+				using a_type=Eigen::Matrix<float,6,6>;
+				a_type a;
+				a <<	buffer[0],buffer[1],buffer[2],buffer[3],buffer[4],buffer[5],
+						buffer[1],buffer[6],buffer[7],buffer[8],buffer[9],buffer[10],
+						buffer[2],buffer[7],buffer[11],buffer[12],buffer[13],buffer[14],
+						buffer[3],buffer[8],buffer[12],buffer[15],buffer[16],buffer[17],
+						buffer[4],buffer[9],buffer[13],buffer[16],buffer[18],buffer[19],
+						buffer[5],buffer[10],buffer[14],buffer[17],buffer[19],buffer[20];
+				using b_type=Eigen::Matrix<float,6,1>;
+				b_type b;
+				std::memcpy(&b,buffer+a_floats,sizeof(b));
+
+				//	Solve system
+				auto solver=a.ldlt();
+				b_type x=solver.solve(b);
+
+				float alpha=x(0);
+				float beta=x(1);
+				float gamma=x(2);
+				float tx=x(3);
+				float ty=x(4);
+				float tz=x(5);
+
+				Eigen::Matrix4f t_inc;
+				t_inc <<  1.0f, -gamma, beta, tx,
+						 gamma, 1.0f, -alpha, ty,
+					 	 -beta, alpha, 1.0f, tz,
+						 0.0f, 0.0f, 0.0f, 1.0f;
+				t_z.transposeInPlace();
+				t_z=t_inc*t_z;
+				++iterations_performed_;
+
+				//	Stop iterating at this level once the increment
+				//	is negligible
+				if ((x.head<3>().norm()<epsilon_rotation_) && (x.tail<3>().norm()<epsilon_translation_)) break;
 
 			}
 
-			//	Collect results
-			float buffer [mats_floats];
-			q_.enqueue_read_buffer(in,0,sizeof(buffer),buffer);
-			using a_type=Eigen::Matrix<float,6,6>;
-			a_type a;
-			a <<	buffer[0],buffer[1],buffer[2],buffer[3],buffer[4],buffer[5],
-					buffer[1],buffer[6],buffer[7],buffer[8],buffer[9],buffer[10],
-					buffer[2],buffer[7],buffer[11],buffer[12],buffer[13],buffer[14],
-					buffer[3],buffer[8],buffer[12],buffer[15],buffer[16],buffer[17],
-					buffer[4],buffer[9],buffer[13],buffer[16],buffer[18],buffer[19],
-					buffer[5],buffer[10],buffer[14],buffer[17],buffer[19],buffer[20];
-			using b_type=Eigen::Matrix<float,6,1>;
-			b_type b;
-			std::memcpy(&b,buffer+a_floats,sizeof(b));
-
-			//	Solve system
-			auto solver=a.ldlt();
-			b_type x=solver.solve(b);
-
-			float alpha=x(0);
-			float beta=x(1);
-			float gamma=x(2);
-			float tx=x(3);
-			float ty=x(4);
-			float tz=x(5);
-
-			Eigen::Matrix4f t_inc;
-			t_inc <<  1.0f, -gamma, beta, tx,
-					 gamma, 1.0f, -alpha, ty,
-				 	 -beta, alpha, 1.0f, tz,
-					 0.0f, 0.0f, 0.0f, 1.0f;
-			t_z.transposeInPlace();
-			t_z=t_inc*t_z;
+		}
+
+		//	Read back the final estimate once
+		if (device_solve_) {
+
+			profile("read T_z",q_.enqueue_read_buffer(t_z_,0,sizeof(t_z_t),t_z_t.data()));
+			t_z=t_z_t.transpose();
+			status_type status;
+			profile("read status",q_.enqueue_read_buffer(status_,0,sizeof(status),status));
+			iterations_performed_=status[status_iterations];
+			if (status[status_failed]) tracking_lost();
 
 		}
 
+		t_gk_minus_two_=t_gk_minus_one_m;
 		pv.emplace(t_z);
 
 		return t_gk_minus_one;
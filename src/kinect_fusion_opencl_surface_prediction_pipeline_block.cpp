@@ -1,9 +1,12 @@
 #include <kinfu/boost_compute_detail_type_name_trait.hpp>
 #include <kinfu/kinect_fusion_opencl_surface_prediction_pipeline_block.hpp>
 #include <kinfu/opencl_vector_pipeline_value.hpp>
+#include <kinfu/opencl_voxel_pipeline_value.hpp>
 #include <kinfu/pixel.hpp>
+#include <kinfu/voxel_format.hpp>
 #include <Eigen/Dense>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <utility>
 
@@ -19,6 +22,14 @@ namespace kinfu {
 	}	
 	
 	
+	static boost::compute::kernel get_raycast_kernel (opencl_program_factory & opf, voxel_format format) {
+		
+		auto p=opf("raycast",voxel_format_options(format));
+		return boost::compute::kernel(p,"raycast");
+		
+	}
+	
+	
 	kinect_fusion_opencl_surface_prediction_pipeline_block::kinect_fusion_opencl_surface_prediction_pipeline_block (
 		boost::compute::command_queue q,
 		opencl_program_factory & opf,
@@ -26,23 +37,47 @@ namespace kinfu {
 		std::size_t tsdf_size,
 		float tsdf_extent,
 		std::size_t frame_width,
-		std::size_t frame_height)
+		std::size_t frame_height,
+		voxel_format format)
 		:	ve_(std::move(q)),
 			raycast_kernel_(get_raycast_kernel(opf)),
+			voxel_raycast_kernel_(get_raycast_kernel(opf,format)),
 			t_g_k_buf_(ve_.command_queue().get_context(),sizeof(Eigen::Matrix4f),CL_MEM_READ_ONLY),
 			ik_buf_(ve_.command_queue().get_context(),sizeof(Eigen::Matrix3f),CL_MEM_READ_ONLY),
+			no_ranges_(2U,ve_.command_queue().get_context()),
+			no_observed_(1U,ve_.command_queue().get_context()),
 			mu_(mu),
+			max_step_(0.8f*mu),
+			brick_skipping_(true),
 			tsdf_extent_(tsdf_extent),
 			tsdf_size_(tsdf_size),
 			frame_width_(frame_width),
-			frame_height_(frame_height)
+			frame_height_(frame_height),
+			format_(format)
 	{
 
-		raycast_kernel_.set_arg(6, std::uint32_t(tsdf_size_));
-		raycast_kernel_.set_arg(5, tsdf_extent_);
-		raycast_kernel_.set_arg(4, mu_);
-		raycast_kernel_.set_arg(3, ik_buf_);
-		raycast_kernel_.set_arg(2, t_g_k_buf_);
+		for (auto kernel : {&raycast_kernel_, &voxel_raycast_kernel_}) {
+
+			kernel->set_arg(13, max_step_);
+			kernel->set_arg(6, std::uint32_t(tsdf_size_));
+			kernel->set_arg(5, tsdf_extent_);
+			kernel->set_arg(4, mu_);
+			kernel->set_arg(3, ik_buf_);
+			kernel->set_arg(2, t_g_k_buf_);
+
+		}
+
+	}
+	
+	
+	kinect_fusion_opencl_surface_prediction_pipeline_block::~kinect_fusion_opencl_surface_prediction_pipeline_block () noexcept {
+
+		//	Errors cannot be reported from a destructor
+		try {
+
+			writes_.wait();
+
+		} catch (...) {	}
 
 	}
 	
@@ -61,12 +96,18 @@ namespace kinfu {
 		auto q = ve_.command_queue();
 
 
+		// The writes from the last invocation are ordered before
+		// its kernel so this should not block in practice, but the
+		// host copies may not be overwritten until they complete
+		writes_.wait();
+		writes_.clear();
+
 		auto t_g_k = t_g_k_pv.get();
 		if (t_g_k_ != t_g_k) {
 			
 			t_g_k_ = t_g_k;
-			t_g_k.transposeInPlace();
-			q.enqueue_write_buffer(t_g_k_buf_, 0, sizeof(t_g_k), t_g_k.data());
+			t_g_k_t_ = t_g_k.transpose();
+			writes_.insert(profile("write T_g_k",q.enqueue_write_buffer_async(t_g_k_buf_, 0, sizeof(t_g_k_t_), t_g_k_t_.data())));
 		
 		}
 
@@ -75,9 +116,9 @@ namespace kinfu {
 
 			k_ = k;
 
-			Eigen::Matrix3f k_inv = k.inverse();
-			k_inv.transposeInPlace();
-			q.enqueue_write_buffer(ik_buf_,0,sizeof(k_inv),k_inv.data());
+			ik_ = k.inverse();
+			ik_.transposeInPlace();
+			writes_.insert(profile("write K^-1",q.enqueue_write_buffer_async(ik_buf_,0,sizeof(ik_),ik_.data())));
 
 		}
 
@@ -87,18 +128,96 @@ namespace kinfu {
 		// allocate space if needed for the vmap and nmap
 		using type = opencl_vector_pipeline_value<pixel>;
 		if (!map) map = std::make_unique<type>(q);
-		auto && m = dynamic_cast<type &>(*map).vector();
+		auto && pv = dynamic_cast<type &>(*map);
+		auto && m = pv.vector();
 		m.resize(num_depth_px, q);
 
-		auto && tsdf_buf=ve_(tsdf);
+		boost::compute::wait_list events;
+		auto kernel = raycast_kernel_;
+		Eigen::Vector3i origin(Eigen::Vector3i::Zero());
+		Eigen::Vector3i wrap(Eigen::Vector3i::Zero());
+		// A TSDF stored in the format this object was created
+		// with may be raycast directly, anything else is
+		// converted to half precision values
+		using compatibility = opencl_voxel_pipeline_value::compatibility;
+		auto voxels = dynamic_cast<const opencl_voxel_pipeline_value *>(&tsdf);
+		auto c = voxels ? voxels->check(q) : compatibility::none;
+		if (voxels && (voxels->format() == format_) && ((c == compatibility::same_queue) || (c == compatibility::same_context))) {
+
+			if (c == compatibility::same_context) {
+
+				if (voxels->events().empty()) voxels->wait();
+				for (auto && e : voxels->events()) events.insert(e);
+
+			}
+			kernel = voxel_raycast_kernel_;
+			kernel.set_arg(0,voxels->vector().get_buffer());
+			kernel.set_arg(14,voxels->ranges().get_buffer());
+			kernel.set_arg(15,voxels->observed().get_buffer());
+			kernel.set_arg(16,std::uint32_t(brick_skipping_ ? 1U : 0U));
+			// The volume is addressed modulo its size
+			origin = voxels->origin();
+			for (std::size_t i = 0; i < 3U; ++i) {
+
+				wrap(i) = origin(i) % int(tsdf_size_);
+				if (wrap(i) < 0) wrap(i) += int(tsdf_size_);
+
+			}
+
+		} else {
+
+			// The half precision values are ordered starting
+			// from the origin (if any) but the TSDF remains
+			// where it is in world space
+			kernel.set_arg(0,ve_(tsdf,events));
+			kernel.set_arg(14,no_ranges_.get_buffer());
+			kernel.set_arg(15,no_observed_.get_buffer());
+			kernel.set_arg(16,std::uint32_t(0));
+			if (voxels) origin = voxels->origin();
 
-		raycast_kernel_.set_arg(0,tsdf_buf);
-		raycast_kernel_.set_arg(1,m);
+		}
+		kernel.set_arg(1,m);
+		kernel.set_arg(7,std::int32_t(origin(0)));
+		kernel.set_arg(8,std::int32_t(origin(1)));
+		kernel.set_arg(9,std::int32_t(origin(2)));
+		kernel.set_arg(10,std::int32_t(wrap(0)));
+		kernel.set_arg(11,std::int32_t(wrap(1)));
+		kernel.set_arg(12,std::int32_t(wrap(2)));
 
 		std::size_t extent []={frame_width_,frame_height_};
-		q.enqueue_nd_range_kernel(raycast_kernel_,2,nullptr,extent,nullptr);
+		pv.event(profile("raycast",q.enqueue_nd_range_kernel(kernel,2,nullptr,extent,nullptr,events)));
 
 		return map;
 	}
 	
+	
+	void kinect_fusion_opencl_surface_prediction_pipeline_block::max_step (float step) {
+
+		max_step_ = step;
+		raycast_kernel_.set_arg(13, max_step_);
+		voxel_raycast_kernel_.set_arg(13, max_step_);
+
+	}
+
+
+	float kinect_fusion_opencl_surface_prediction_pipeline_block::max_step () const noexcept {
+
+		return max_step_;
+
+	}
+
+
+	void kinect_fusion_opencl_surface_prediction_pipeline_block::brick_skipping (bool skip) noexcept {
+
+		brick_skipping_ = skip;
+
+	}
+
+
+	bool kinect_fusion_opencl_surface_prediction_pipeline_block::brick_skipping () const noexcept {
+
+		return brick_skipping_;
+
+	}
+	
 }
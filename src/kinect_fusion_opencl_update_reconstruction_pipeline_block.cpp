@@ -1,24 +1,55 @@
 #include <kinfu/boost_compute_detail_type_name_trait.hpp>
+#include <kinfu/camera.hpp>
 #include <kinfu/half.hpp>
 #include <kinfu/kinect_fusion_opencl_update_reconstruction_pipeline_block.hpp>
 #include <kinfu/opencl_vector_pipeline_value.hpp>
+#include <kinfu/opencl_voxel_pipeline_value.hpp>
 #include <kinfu/pose_estimation_pipeline_block.hpp>
+#include <kinfu/voxel_format.hpp>
 #include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <limits>
 #include <memory>
 #include <utility>
+#include <vector>
 
 namespace kinfu {
 	
 	
-	static boost::compute::kernel get_tsdf_kernel (opencl_program_factory & opf) {
+	static boost::compute::kernel get_tsdf_kernel (opencl_program_factory & opf, voxel_format format) {
 		
-		auto p=opf("tsdf");
+		auto p=opf("tsdf",voxel_format_options(format));
 		return boost::compute::kernel(p,"tsdf_kernel");
 		
 	}	
 	
 	
+	static boost::compute::kernel get_tsdf_sweep_kernel (opencl_program_factory & opf, voxel_format format) {
+		
+		auto p=opf("tsdf",voxel_format_options(format));
+		return boost::compute::kernel(p,"tsdf_sweep_kernel");
+		
+	}
+	
+	
+	static boost::compute::kernel get_evict_kernel (opencl_program_factory & opf, voxel_format format) {
+		
+		auto p=opf("tsdf",voxel_format_options(format));
+		return boost::compute::kernel(p,"evict_kernel");
+		
+	}
+	
+	
+	static boost::compute::kernel get_summarize_kernel (opencl_program_factory & opf, voxel_format format) {
+		
+		auto p=opf("tsdf",voxel_format_options(format));
+		return boost::compute::kernel(p,"summarize_kernel");
+		
+	}
+	
+	
 	kinect_fusion_opencl_update_reconstruction_pipeline_block::kinect_fusion_opencl_update_reconstruction_pipeline_block (
 		boost::compute::command_queue q,
 		opencl_program_factory & opf,
@@ -28,30 +59,281 @@ namespace kinfu {
 		std::size_t tsdf_depth,
 		float tsdf_extent_w,
 		float tsdf_extent_h,
-		float tsdf_extent_d)
+		float tsdf_extent_d,
+		voxel_format format)
 		:	ve_(std::move(q)),
-			tsdf_kernel_(get_tsdf_kernel(opf)),
+			tsdf_kernel_(get_tsdf_kernel(opf,format)),
+			tsdf_sweep_kernel_(get_tsdf_sweep_kernel(opf,format)),
+			evict_kernel_(get_evict_kernel(opf,format)),
+			summarize_kernel_(get_summarize_kernel(opf,format)),
 			t_g_k_vec_buf_(ve_.command_queue().get_context(),sizeof(Eigen::Vector3f),CL_MEM_READ_ONLY),
 			ik_buf_(ve_.command_queue().get_context(),sizeof(Eigen::Matrix3f),CL_MEM_READ_ONLY),
 			k_buf_(ve_.command_queue().get_context(),sizeof(Eigen::Matrix3f),CL_MEM_READ_ONLY),
 			proj_view_buf_(ve_.command_queue().get_context(),sizeof(Eigen::Matrix4f),CL_MEM_READ_ONLY),
-			weights_(tsdf_width*tsdf_height*tsdf_depth,ve_.command_queue().get_context()),
+			//	Formats which pack the weights with the TSDF values
+			//	never access this buffer but the kernel argument
+			//	must still be set
+			weights_(voxel_separate_weights(format) ? (tsdf_width*tsdf_height*tsdf_depth) : 1U,ve_.command_queue().get_context()),
 			mu_(mu),
 			tsdf_width_(tsdf_width),
 			tsdf_height_(tsdf_height),
 			tsdf_depth_(tsdf_depth),
-			invk_(0)
+			tsdf_extent_(tsdf_extent_w,tsdf_extent_h,tsdf_extent_d),
+			reset_(true),
+			culling_(true),
+			max_depth_(std::numeric_limits<float>::infinity()),
+			sweep_(false),
+			format_(format),
+			origin_(Eigen::Vector3i::Zero()),
+			rolling_(false),
+			shift_threshold_(std::min({tsdf_extent_w, tsdf_extent_h, tsdf_extent_d}) / 4.0f),
+			sink_(nullptr)
 	{
 
-		tsdf_kernel_.set_arg(5,proj_view_buf_);
-		tsdf_kernel_.set_arg(6,k_buf_);
-		tsdf_kernel_.set_arg(7,ik_buf_);
-		tsdf_kernel_.set_arg(8,t_g_k_vec_buf_);
-		tsdf_kernel_.set_arg(12, tsdf_extent_w);
-		tsdf_kernel_.set_arg(13, tsdf_extent_h);
-		tsdf_kernel_.set_arg(14, tsdf_extent_d);
-		tsdf_kernel_.set_arg(16, weights_);
+		// A shift evicts at most two boxes along each axis,
+		// reserving prevents the vectors from being copied
+		evicted_.reserve(6U);
+		for (std::size_t i = 0; i < 6U; ++i) evicted_.emplace_back(ve_.command_queue().get_context());
+
+		// Both kernels share arguments 0 through 19
+		for (auto kernel : {&tsdf_kernel_, &tsdf_sweep_kernel_}) {
+
+			kernel->set_arg(5,proj_view_buf_);
+			kernel->set_arg(6,k_buf_);
+			kernel->set_arg(7,ik_buf_);
+			kernel->set_arg(8,t_g_k_vec_buf_);
+			kernel->set_arg(12, tsdf_extent_w);
+			kernel->set_arg(13, tsdf_extent_h);
+			kernel->set_arg(14, tsdf_extent_d);
+			kernel->set_arg(15, weights_);
+			kernel->set_arg(16, max_depth_);
+
+		}
+
+		evict_kernel_.set_arg(1, weights_);
+		evict_kernel_.set_arg(3, std::uint32_t(tsdf_width_));
+		evict_kernel_.set_arg(4, std::uint32_t(tsdf_height_));
+		evict_kernel_.set_arg(5, std::uint32_t(tsdf_depth_));
+
+		summarize_kernel_.set_arg(1, weights_);
+		summarize_kernel_.set_arg(4, std::uint32_t(tsdf_width_));
+		summarize_kernel_.set_arg(5, std::uint32_t(tsdf_height_));
+		summarize_kernel_.set_arg(6, std::uint32_t(tsdf_depth_));
+
+
+	}
+	
+	
+	bool kinect_fusion_opencl_update_reconstruction_pipeline_block::bounds (
+		const Eigen::Matrix4f & t_g_k,
+		const Eigen::Matrix3f & k,
+		std::size_t frame_width,
+		std::size_t frame_height,
+		std::size_t (& offset) [3],
+		std::size_t (& extent) [3]
+	) const {
+
+		// Voxels cannot be further from the camera than
+		// the furthest corner of the volume
+		std::size_t sizes[] = {tsdf_width_, tsdf_height_, tsdf_depth_};
+		Eigen::Vector3f begin;
+		for (std::size_t i = 0; i < 3U; ++i) begin(i) = float(origin_(i)) * tsdf_extent_(i) / float(sizes[i]);
+		Eigen::Vector3f t(t_g_k.block<3,1>(0,3));
+		float furthest = 0.0f;
+		for (unsigned int i = 0; i < 8U; ++i) {
+
+			Eigen::Vector3f corner(
+				(i & 1U) ? tsdf_extent_(0) : 0.0f,
+				(i & 2U) ? tsdf_extent_(1) : 0.0f,
+				(i & 4U) ? tsdf_extent_(2) : 0.0f
+			);
+			furthest = std::max(furthest, (begin + corner - t).norm());
+
+		}
+		auto b = frustum_bounds(t_g_k, k, frame_width, frame_height, std::min(max_depth_, furthest));
+
+		// Voxel centers lie at (origin + i + 0.5) * extent / size,
+		// a margin of one voxel absorbs rounding
+		for (std::size_t i = 0; i < 3U; ++i) {
+
+			float voxel = tsdf_extent_(i) / float(sizes[i]);
+			float lo = std::floor((b.first(i) / voxel) - float(origin_(i)) - 0.5f) - 1.0f;
+			float hi = std::ceil((b.second(i) / voxel) - float(origin_(i)) - 0.5f) + 1.0f;
+			if (!(lo < float(sizes[i])) || !(hi >= 0.0f)) return false;
+			lo = std::max(lo, 0.0f);
+			hi = std::min(hi, float(sizes[i] - 1U));
+			offset[i] = std::size_t(lo);
+			extent[i] = std::size_t(hi) - offset[i] + 1U;
+
+		}
+
+		return true;
+
+	}
+	
+	
+	void kinect_fusion_opencl_update_reconstruction_pipeline_block::evict (
+		boost::compute::command_queue & q,
+		opencl_voxel_pipeline_value & tsdf,
+		const Eigen::Vector3i & begin,
+		const Eigen::Vector3i & end,
+		std::size_t slot,
+		boost::compute::wait_list & events
+	) {
+
+		Eigen::Vector3i size(end - begin);
+		if ((size.array() <= 0).any()) return;
+
+		std::size_t extent[] = {std::size_t(size(0)), std::size_t(size(1)), std::size_t(size(2))};
+		std::size_t n = extent[0] * extent[1] * extent[2];
+		auto bytes = n * voxel_size(format_);
+		auto && evicted = evicted_[slot];
+		if (evicted.size() < bytes) evicted.resize(bytes, q);
+
+		evict_kernel_.set_arg(0, tsdf.vector());
+		evict_kernel_.set_arg(2, evicted);
+		evict_kernel_.set_arg(6, std::int32_t(begin(0)));
+		evict_kernel_.set_arg(7, std::int32_t(begin(1)));
+		evict_kernel_.set_arg(8, std::int32_t(begin(2)));
+		auto e = profile("evict_kernel",q.enqueue_nd_range_kernel(evict_kernel_,3,nullptr,extent,nullptr));
+		events.insert(e);
+
+		if (!sink_) return;
+
+		// The download is not waited on here, the box is
+		// passed to the sink by the next invocation (the
+		// host buffer does not move when pending_ grows)
+		pending_slice p;
+		p.slice.origin = begin;
+		p.slice.width = extent[0];
+		p.slice.height = extent[1];
+		p.slice.depth = extent[2];
+		p.raw.resize(bytes);
+		p.event = profile("read evicted",q.enqueue_read_buffer_async(evicted.get_buffer(), 0, bytes, p.raw.data(), boost::compute::wait_list(e)));
+		pending_.push_back(std::move(p));
+
+	}
+	
+	
+	void kinect_fusion_opencl_update_reconstruction_pipeline_block::deliver () {
+
+		// Moved out so that slices are not passed to the
+		// sink twice should it throw
+		auto pending = std::move(pending_);
+		pending_.clear();
+		for (auto && p : pending) {
+
+			p.event.wait();
+			auto n = p.slice.width * p.slice.height * p.slice.depth;
+			p.slice.tsdf.resize(n);
+			decode_voxels(format_, p.raw.data(), n, p.slice.tsdf.data());
+			if (sink_) (*sink_)(std::move(p.slice));
+
+		}
+
+	}
+	
+	
+	void kinect_fusion_opencl_update_reconstruction_pipeline_block::shift (
+		boost::compute::command_queue & q,
+		opencl_voxel_pipeline_value & tsdf,
+		const Eigen::Vector3i & origin,
+		boost::compute::wait_list & events
+	) {
+
+		Eigen::Vector3i size(static_cast<int>(tsdf_width_), static_cast<int>(tsdf_height_), static_cast<int>(tsdf_depth_));
+		Eigen::Vector3i old_end(origin_ + size);
+		Eigen::Vector3i new_end(origin + size);
+
+		// The voxels which leave are partitioned into disjoint
+		// boxes: those outside the new volume along x, then
+		// those within it along x but outside it along y, and
+		// so on
+		Eigen::Vector3i begin(origin_);
+		Eigen::Vector3i end(old_end);
+		for (std::size_t i = 0; i < 3U; ++i) {
+
+			Eigen::Vector3i b(begin);
+			Eigen::Vector3i e(end);
+			e(i) = std::min(old_end(i), origin(i));
+			evict(q, tsdf, b, e, i * 2U, events);
+			b(i) = std::max(origin_(i), new_end(i));
+			e(i) = old_end(i);
+			evict(q, tsdf, b, e, (i * 2U) + 1U, events);
+
+			begin(i) = std::max(origin_(i), origin(i));
+			end(i) = std::min(old_end(i), new_end(i));
+			if (begin(i) >= end(i)) break;
+
+		}
+
+		origin_ = origin;
+
+	}
+	
+	
+	boost::compute::event kinect_fusion_opencl_update_reconstruction_pipeline_block::summarize (
+		boost::compute::command_queue & q,
+		opencl_voxel_pipeline_value & tsdf,
+		const std::size_t (& offset) [3],
+		const std::size_t (& extent) [3]
+	) {
 
+		// Bricks are indexed by where their voxels are stored
+		// so the region (relative to the origin) is mapped to
+		// the bricks which store it, a region which wraps
+		// around along an axis covers every brick along it
+		std::size_t sizes[] = {tsdf_width_, tsdf_height_, tsdf_depth_};
+		std::size_t begin[3];
+		std::size_t count[3];
+		for (std::size_t i = 0; i < 3U; ++i) {
+
+			std::size_t bricks = (sizes[i] + tsdf_brick_size - 1U) / tsdf_brick_size;
+			int o = origin_(i) % int(sizes[i]);
+			if (o < 0) o += int(sizes[i]);
+			std::size_t s = (std::size_t(o) + offset[i]) % sizes[i];
+			if ((s + extent[i]) > sizes[i]) {
+
+				begin[i] = 0;
+				count[i] = bricks;
+
+			} else {
+
+				begin[i] = s / tsdf_brick_size;
+				count[i] = ((s + extent[i] + tsdf_brick_size - 1U) / tsdf_brick_size) - begin[i];
+
+			}
+
+		}
+
+		summarize_kernel_.set_arg(0, tsdf.vector());
+		summarize_kernel_.set_arg(2, tsdf.ranges());
+		summarize_kernel_.set_arg(3, tsdf.observed());
+
+		return profile("summarize_kernel",q.enqueue_nd_range_kernel(summarize_kernel_,3,begin,count,nullptr));
+
+	}
+	
+	
+	kinect_fusion_opencl_update_reconstruction_pipeline_block::~kinect_fusion_opencl_update_reconstruction_pipeline_block () noexcept {
+
+		//	Errors cannot be reported from a destructor
+		try {
+
+			writes_.wait();
+
+		} catch (...) {	}
+		//	Downloads of evicted voxels write into host buffers
+		//	which are about to be freed
+		for (auto && p : pending_) {
+
+			try {
+
+				p.event.wait();
+
+			} catch (...) {	}
+
+		}
 
 	}
 	
@@ -65,24 +347,35 @@ namespace kinfu {
 		value_type v
 	) {
 		
-		auto && depth_frame = ve_(frame);
+		boost::compute::wait_list events;
+		auto && depth_frame = ve_(frame,events);
 		auto q = ve_.command_queue();
 		auto t_g_k=T_g_k.get();
 
+		// The writes from the last invocation are ordered before
+		// its kernel so this should not block in practice, but the
+		// host copies may not be overwritten until they complete
+		writes_.wait();
+		writes_.clear();
+
+		// Voxels evicted by the last invocation have almost
+		// certainly been downloaded by now
+		deliver();
+
 		if (t_g_k_ != t_g_k) {
 			
 			t_g_k_ = std::move(t_g_k);
 
 			// enqueue the proj_view matrix
-			Eigen::Matrix4f proj_view = t_g_k_->inverse();
-			proj_view.transposeInPlace();
+			proj_view_ = t_g_k_->inverse();
+			proj_view_.transposeInPlace();
 
-			q.enqueue_write_buffer(proj_view_buf_, 0, sizeof(proj_view), proj_view.data());
+			writes_.insert(profile("write T_g_k^-1",q.enqueue_write_buffer_async(proj_view_buf_, 0, sizeof(proj_view_), proj_view_.data())));
 			
 			// t_g_k is the transformation component of the sensor pose estimation
-			Eigen::Vector3f t_g_k_vec = t_g_k_->block<3,1>(0,3);
+			t_g_k_vec_ = t_g_k_->block<3,1>(0,3);
 
-			q.enqueue_write_buffer(t_g_k_vec_buf_,0,sizeof(t_g_k_vec),t_g_k_vec.data());
+			writes_.insert(profile("write t_g_k",q.enqueue_write_buffer_async(t_g_k_vec_buf_,0,sizeof(t_g_k_vec_),t_g_k_vec_.data())));
 		
 		}
 
@@ -91,38 +384,121 @@ namespace kinfu {
 
 			k_ = k;
 
-			Eigen::Matrix3f k_inv = k.inverse();
-			k_inv.transposeInPlace();
-			q.enqueue_write_buffer(ik_buf_,0,sizeof(k_inv),k_inv.data());
+			ik_ = k.inverse();
+			ik_.transposeInPlace();
+			writes_.insert(profile("write K^-1",q.enqueue_write_buffer_async(ik_buf_,0,sizeof(ik_),ik_.data())));
 
-			k.transposeInPlace();
-			q.enqueue_write_buffer(k_buf_,0,sizeof(k),k.data());
+			k_t_ = k.transpose();
+			writes_.insert(profile("write K",q.enqueue_write_buffer_async(k_buf_,0,sizeof(k_t_),k_t_.data())));
 
 		}
 
 
 		auto && tsdf_ptr = v.buffer;
-		using type = opencl_vector_pipeline_value<kinfu::half>;
-		if (!tsdf_ptr) tsdf_ptr = std::make_unique<type>(q);
-		auto && tsdf_buf = dynamic_cast<type &>(*tsdf_ptr).vector();
-		tsdf_buf.resize(tsdf_width_*tsdf_height_*tsdf_depth_, q);
+		using type = opencl_voxel_pipeline_value;
+		bool tsdf_allocated = bool(tsdf_ptr);
+		if (!tsdf_allocated) tsdf_ptr = std::make_unique<type>(q, format_);
+		auto && tsdf_pv = dynamic_cast<type &>(*tsdf_ptr);
+		tsdf_pv.resize(tsdf_width_, tsdf_height_, tsdf_depth_);
+		auto && tsdf_buf = tsdf_pv.vector();
+
+		// A newly allocated TSDF has unspecified contents
+		// and so must be cleared like one which was reset
+		//
+		// Clearing or moving the volume changes voxels outside
+		// the region integrated below so all bricks must then
+		// be summarized
+		boost::compute::wait_list fills;
+		if (reset_ || !tsdf_allocated) {
+
+			unsigned char empty[4];
+			empty_voxel(format_, empty);
+			fills.insert(profile("clear TSDF",q.enqueue_fill_buffer(tsdf_buf.get_buffer(), empty, voxel_size(format_), 0, tsdf_buf.size())));
+			if (voxel_separate_weights(format_)) {
+
+				std::uint8_t zero(0);
+				fills.insert(profile("clear weights",q.enqueue_fill_buffer(weights_.get_buffer(), &zero, sizeof(zero), 0, weights_.size())));
+
+			}
+			reset_ = false;
+
+		}
+
+		// Move the volume so that the camera is at its
+		// center if it has strayed too far along any axis
+		if (rolling_) {
+
+			std::size_t sizes[] = {tsdf_width_, tsdf_height_, tsdf_depth_};
+			Eigen::Vector3f t(t_g_k_->block<3,1>(0,3));
+			Eigen::Vector3i origin(origin_);
+			for (std::size_t i = 0; i < 3U; ++i) {
+
+				float voxel = tsdf_extent_(i) / float(sizes[i]);
+				float center = (float(origin_(i)) + (float(sizes[i]) * 0.5f)) * voxel;
+				if (std::abs(t(i) - center) > shift_threshold_) origin(i) = int(std::lround(t(i) / voxel)) - int(sizes[i] / 2U);
+
+			}
+			// Eviction is ordered after the fills since the
+			// command queue is in order
+			if (origin != origin_) shift(q, tsdf_pv, origin, fills);
+
+		}
+		tsdf_pv.origin(origin_);
 		
 		// Set kernel args
-		tsdf_kernel_.set_arg(0, depth_frame);
-		tsdf_kernel_.set_arg(1, tsdf_buf);
-		tsdf_kernel_.set_arg(2, std::uint32_t(tsdf_width_));
-		tsdf_kernel_.set_arg(3, std::uint32_t(tsdf_height_));
-		tsdf_kernel_.set_arg(4, std::uint32_t(tsdf_depth_));
+		auto && kernel = sweep_ ? tsdf_sweep_kernel_ : tsdf_kernel_;
+		kernel.set_arg(0, depth_frame);
+		kernel.set_arg(1, tsdf_buf);
+		kernel.set_arg(2, std::uint32_t(tsdf_width_));
+		kernel.set_arg(3, std::uint32_t(tsdf_height_));
+		kernel.set_arg(4, std::uint32_t(tsdf_depth_));
 		// 5,6,7 are bound in constructor
-		tsdf_kernel_.set_arg(9, mu_);
-		tsdf_kernel_.set_arg(10, std::uint32_t(frame_width));
-		tsdf_kernel_.set_arg(11, std::uint32_t(frame_height));
-		tsdf_kernel_.set_arg(15, std::uint32_t(invk_++));
+		kernel.set_arg(9, mu_);
+		kernel.set_arg(10, std::uint32_t(frame_width));
+		kernel.set_arg(11, std::uint32_t(frame_height));
+		kernel.set_arg(17, std::int32_t(origin_(0)));
+		kernel.set_arg(18, std::int32_t(origin_(1)));
+		kernel.set_arg(19, std::int32_t(origin_(2)));
 
 		
 		// Ready to run the kernel
+		std::size_t all_offset[] = {0, 0, 0};
+		std::size_t all_extent[] = {tsdf_width_, tsdf_height_, tsdf_depth_};
+		std::size_t tsdf_offset[] = {0, 0, 0};
 		std::size_t tsdf_extent[] = {tsdf_width_, tsdf_height_, tsdf_depth_};
-		q.enqueue_nd_range_kernel(tsdf_kernel_,3,nullptr,tsdf_extent,nullptr);
+		bool summarize_all = !fills.empty();
+		if (culling_ && !bounds(*t_g_k_, k, frame_width, frame_height, tsdf_offset, tsdf_extent)) {
+
+			// The volume is entirely outside the frustum
+			// so there is nothing to integrate
+			if (summarize_all) tsdf_pv.event(summarize(q, tsdf_pv, all_offset, all_extent));
+			v.width = tsdf_width_;
+			v.height = tsdf_height_;
+			v.depth = tsdf_depth_;
+
+			return v;
+
+		}
+		if (sweep_) {
+
+			// The sweep kernel is launched over x and y and
+			// sweeps the z range given by arguments 20 and 21
+			kernel.set_arg(20, std::uint32_t(tsdf_offset[2]));
+			kernel.set_arg(21, std::uint32_t(tsdf_offset[2] + tsdf_extent[2]));
+			profile("tsdf_kernel",q.enqueue_nd_range_kernel(kernel,2,tsdf_offset,tsdf_extent,nullptr,events));
+
+		} else {
+
+			profile("tsdf_kernel",q.enqueue_nd_range_kernel(kernel,3,tsdf_offset,tsdf_extent,nullptr,events));
+
+		}
+
+		// Only bricks within the region integrated can have
+		// changed (unless the volume was cleared or moved),
+		// this is ordered after the kernel since the command
+		// queue is in order
+		if (summarize_all) tsdf_pv.event(summarize(q, tsdf_pv, all_offset, all_extent));
+		else tsdf_pv.event(summarize(q, tsdf_pv, tsdf_offset, tsdf_extent));
 		
 		
 		v.width = tsdf_width_;
@@ -132,4 +508,111 @@ namespace kinfu {
 		return v;
 	}
 	
+	
+	void kinect_fusion_opencl_update_reconstruction_pipeline_block::frustum_culling (bool culling) noexcept {
+		
+		culling_ = culling;
+		
+	}
+	
+	
+	bool kinect_fusion_opencl_update_reconstruction_pipeline_block::frustum_culling () const noexcept {
+		
+		return culling_;
+		
+	}
+	
+	
+	void kinect_fusion_opencl_update_reconstruction_pipeline_block::max_depth (float depth) {
+		
+		max_depth_ = depth;
+		tsdf_kernel_.set_arg(16, max_depth_);
+		tsdf_sweep_kernel_.set_arg(16, max_depth_);
+		
+	}
+	
+	
+	float kinect_fusion_opencl_update_reconstruction_pipeline_block::max_depth () const noexcept {
+		
+		return max_depth_;
+		
+	}
+	
+	
+	void kinect_fusion_opencl_update_reconstruction_pipeline_block::sweep (bool sweep) noexcept {
+		
+		sweep_ = sweep;
+		
+	}
+	
+	
+	bool kinect_fusion_opencl_update_reconstruction_pipeline_block::sweep () const noexcept {
+		
+		return sweep_;
+		
+	}
+	
+	
+	void kinect_fusion_opencl_update_reconstruction_pipeline_block::rolling (bool rolling) noexcept {
+		
+		rolling_ = rolling;
+		
+	}
+	
+	
+	bool kinect_fusion_opencl_update_reconstruction_pipeline_block::rolling () const noexcept {
+		
+		return rolling_;
+		
+	}
+	
+	
+	void kinect_fusion_opencl_update_reconstruction_pipeline_block::shift_threshold (float threshold) noexcept {
+		
+		shift_threshold_ = threshold;
+		
+	}
+	
+	
+	float kinect_fusion_opencl_update_reconstruction_pipeline_block::shift_threshold () const noexcept {
+		
+		return shift_threshold_;
+		
+	}
+	
+	
+	void kinect_fusion_opencl_update_reconstruction_pipeline_block::slice_sink (tsdf_slice_sink & sink) noexcept {
+		
+		sink_ = &sink;
+		
+	}
+	
+	
+	void kinect_fusion_opencl_update_reconstruction_pipeline_block::flush_slices () {
+		
+		deliver();
+		
+	}
+	
+	
+	const Eigen::Vector3i & kinect_fusion_opencl_update_reconstruction_pipeline_block::origin () const noexcept {
+		
+		return origin_;
+		
+	}
+	
+	
+	void kinect_fusion_opencl_update_reconstruction_pipeline_block::reset () noexcept {
+		
+		reset_ = true;
+		
+	}
+	
+	
+	voxel_format kinect_fusion_opencl_update_reconstruction_pipeline_block::format () const noexcept {
+		
+		return format_;
+		
+	}
+	
 }
@@ -6,18 +6,26 @@
 #include <kinfu/file_system_depth_device.hpp>
 #include <kinfu/file_system_opencl_program_factory.hpp>
 #include <kinfu/filesystem.hpp>
+#include <kinfu/half.hpp>
 #include <kinfu/kinect_fusion.hpp>
+#include <kinfu/kinect_fusion_opencl_hashed_surface_prediction_pipeline_block.hpp>
+#include <kinfu/kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block.hpp>
 #include <kinfu/kinect_fusion_opencl_surface_prediction_pipeline_block.hpp>
 #include <kinfu/kinect_fusion_opencl_measurement_pipeline_block.hpp>
+#include <kinfu/kinect_fusion_opencl_paged_surface_prediction_pipeline_block.hpp>
+#include <kinfu/kinect_fusion_opencl_paged_update_reconstruction_pipeline_block.hpp>
 #include <kinfu/kinect_fusion_opencl_pose_estimation_pipeline_block.hpp>
 #include <kinfu/kinect_fusion_opencl_update_reconstruction_pipeline_block.hpp>
 #include <kinfu/libigl.hpp>
 #include <kinfu/msrc_file_system_depth_device.hpp>
 #include <kinfu/opencl_depth_device.hpp>
+#include <kinfu/opencl_profiler.hpp>
+#include <kinfu/opencl_voxel_pipeline_value.hpp>
 #include <kinfu/opencv_depth_device.hpp>
 #include <kinfu/optional.hpp>
 #include <kinfu/path.hpp>
 #include <kinfu/timer.hpp>
+#include <kinfu/voxel_format.hpp>
 #include <chrono>
 #include <cmath>
 #include <cstddef>
@@ -26,6 +34,7 @@
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 
 namespace {
@@ -41,6 +50,12 @@ namespace {
 			kinfu::optional<std::size_t> max_frames;
 			kinfu::optional<kinfu::filesystem::path> save_off;
 			kinfu::optional<kinfu::filesystem::path> read_off;
+			bool profile=false;
+			kinfu::optional<std::size_t> samples;
+			kinfu::voxel_format format=kinfu::voxel_format::half;
+			bool hashing=false;
+			bool rolling=false;
+			kinfu::optional<kinfu::filesystem::path> paged;
 
 
 	};
@@ -56,6 +71,12 @@ static kinfu::optional<program_options> get_program_options (int argc, char ** a
 		("max-frames",boost::program_options::value<std::size_t>(),"Max frames to process")
 		("save-off",boost::program_options::value<std::string>(),"Save the generated mesh to this .off file")
 		("read-off",boost::program_options::value<std::string>(),"Read the generated mesh to this .off file and exit")
+		("profile","Report the time taken on the device by each OpenCL command")
+		("samples",boost::program_options::value<std::size_t>(),"Number of pixels to sample (by normal space bucketing) for pose estimation")
+		("voxel-format",boost::program_options::value<std::string>(),"Format in which voxels are stored (half, fixed16, half16, or fixed8)")
+		("voxel-hashing","Store the TSDF sparsely as bricks located by a hash table")
+		("rolling","Move the volume with the camera (voxels which leave the volume are discarded, they are not streamed to the host and are not exported)")
+		("paged",boost::program_options::value<std::string>(),"Store the TSDF in this file keeping only the chunks in view on the device")
 		("help,?","Display usage information");
 
 	boost::program_options::variables_map vm;
@@ -75,6 +96,34 @@ static kinfu::optional<program_options> get_program_options (int argc, char ** a
 	if (vm.count("max-frames")) retr.max_frames.emplace(vm["max-frames"].as<std::size_t>());
 	if (vm.count("save-off")) retr.save_off.emplace(vm["save-off"].as<std::string>());
 	if (vm.count("read-off")) retr.read_off.emplace(vm["read-off"].as<std::string>());
+	if (vm.count("profile")) retr.profile=true;
+	if (vm.count("samples")) retr.samples.emplace(vm["samples"].as<std::size_t>());
+	if (vm.count("voxel-format")) {
+
+		auto && format=vm["voxel-format"].as<std::string>();
+		if (format=="half") retr.format=kinfu::voxel_format::half;
+		else if (format=="fixed16") retr.format=kinfu::voxel_format::fixed16_weight8;
+		else if (format=="half16") retr.format=kinfu::voxel_format::half_weight16;
+		else if (format=="fixed8") retr.format=kinfu::voxel_format::fixed8_weight8;
+		else throw std::invalid_argument("Unrecognized voxel format " + format);
+
+	}
+	if (vm.count("voxel-hashing")) retr.hashing=true;
+	if (vm.count("rolling")) retr.rolling=true;
+	if (vm.count("paged")) retr.paged.emplace(vm["paged"].as<std::string>());
+	if (retr.hashing) {
+
+		if (retr.paged) throw std::invalid_argument("--voxel-hashing cannot be combined with --paged");
+		if (retr.rolling) throw std::invalid_argument("--rolling cannot be combined with --voxel-hashing");
+		if (vm.count("voxel-format")) throw std::invalid_argument("--voxel-format cannot be combined with --voxel-hashing");
+
+	}
+	if (retr.paged) {
+
+		if (retr.rolling) throw std::invalid_argument("--rolling cannot be combined with --paged");
+		if (vm.count("voxel-format")) throw std::invalid_argument("--voxel-format cannot be combined with --paged");
+
+	}
 
 	return retr;
 
@@ -107,7 +156,13 @@ static void main_impl (int argc, char ** argv) {
 
 	auto d=boost::compute::system::default_device();
 	boost::compute::context ctx(d);
-	boost::compute::command_queue q(ctx,d);
+	cl_command_queue_properties props=options.profile ? boost::compute::command_queue::enable_profiling : 0;
+	boost::compute::command_queue q(ctx,d,props);
+	//	Frames are uploaded and measured on their own queue
+	//	so that measurement of the next frame may overlap with
+	//	integration and surface prediction of the current frame
+	boost::compute::command_queue mq(ctx,d,props);
+	kinfu::opencl_profiler prof;
 
 	kinfu::optional<kinfu::msrc_file_system_depth_device_frame_factory> ff;
 	kinfu::optional<kinfu::msrc_file_system_depth_device_filter> f;
@@ -129,32 +184,83 @@ static void main_impl (int argc, char ** argv) {
 
 	}
 
-	kinfu::opencl_depth_device ocldd(*ddp,q);
-	kinfu::buffered_depth_device dd(ocldd,10);
-
 	kinfu::filesystem::path pp(kinfu::current_executable_parent_path());
+	kinfu::file_system_opencl_program_factory opf(pp/".."/"cl",ctx);
+
+	kinfu::opencl_depth_device ocldd(*ddp,mq,opf);
+	kinfu::buffered_depth_device dd(ocldd,10);
 
 	float tsdf_extent = 3.0;
 	std::size_t tsdf_size(256);
 	float mu = 0.03f;
 
-	kinfu::file_system_opencl_program_factory opf(pp/".."/"cl",ctx);
-	kinfu::kinect_fusion_opencl_measurement_pipeline_block mpb(q,opf,13,4.5f,0.03f);
+	kinfu::kinect_fusion_opencl_measurement_pipeline_block mpb(mq,opf,13,4.5f,0.03f,3);
+	mpb.fused(true);
 	Eigen::Matrix4f t_g_k(Eigen::Matrix4f::Identity());
 	t_g_k(0,3)=1.5f;
 	t_g_k(1,3)=1.5f;
 	t_g_k(2,3)=1.5f;
-	kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block pepb(q,opf,0.1f,std::sin(20.0f*3.14159254f/180.0f),dd.width(),dd.height(),t_g_k,15,64);
-	kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block urpb(q,opf,mu,tsdf_size,tsdf_size,tsdf_size);
-	kinfu::kinect_fusion_opencl_surface_prediction_pipeline_block sppb(q,opf,mu,tsdf_size, tsdf_extent, dd.width(), dd.height());
+	kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block pepb(q,opf,0.1f,std::sin(20.0f*3.14159254f/180.0f),dd.width(),dd.height(),t_g_k,std::vector<std::size_t>{4,5,10},64);
+	pepb.termination_thresholds(0.0005f,0.0005f);
+	pepb.device_solve(true);
+	pepb.motion_model(true);
+	if (options.samples) pepb.sampling(kinfu::correspondence_sampling::normal_space,*options.samples);
+	//	Only the blocks of the selected TSDF are created
+	kinfu::optional<kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block> urpb;
+	kinfu::optional<kinfu::kinect_fusion_opencl_surface_prediction_pipeline_block> sppb;
+	kinfu::optional<kinfu::kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block> hurpb;
+	kinfu::optional<kinfu::kinect_fusion_opencl_hashed_surface_prediction_pipeline_block> hsppb;
+	kinfu::optional<kinfu::kinect_fusion_opencl_paged_update_reconstruction_pipeline_block> purpb;
+	kinfu::optional<kinfu::kinect_fusion_opencl_paged_surface_prediction_pipeline_block> psppb;
 
 
 	kinfu::kinect_fusion kf;
 	kf.depth_device(dd);
 	kf.measurement_pipeline_block(mpb);
 	kf.pose_estimation_pipeline_block(pepb);
-	kf.update_reconstruction_pipeline_block(urpb);
-	kf.surface_prediction_pipeline_block(sppb);
+
+	if (options.hashing) {
+
+		hurpb.emplace(q,opf,mu,tsdf_extent/float(tsdf_size),tsdf_size,tsdf_size,tsdf_size);
+		hsppb.emplace(q,opf,dd.width(),dd.height());
+		kf.update_reconstruction_pipeline_block(*hurpb);
+		kf.surface_prediction_pipeline_block(*hsppb);
+
+	} else if (options.paged) {
+
+		//	The file is only created once the first frame is integrated
+		purpb.emplace(q,opf,mu,*options.paged,tsdf_size,tsdf_size,tsdf_size,tsdf_extent,tsdf_extent,tsdf_extent,32,256);
+		psppb.emplace(q,opf,tsdf_extent,dd.width(),dd.height());
+		kf.update_reconstruction_pipeline_block(*purpb);
+		kf.surface_prediction_pipeline_block(*psppb);
+
+	} else {
+
+		urpb.emplace(q,opf,mu,tsdf_size,tsdf_size,tsdf_size,tsdf_extent,tsdf_extent,tsdf_extent,options.format);
+		urpb->sweep(true);
+		//	No slice sink is installed so voxels which leave the
+		//	volume are lost and only the final volume is exported
+		urpb->rolling(options.rolling);
+		sppb.emplace(q,opf,mu,tsdf_size, tsdf_extent, dd.width(), dd.height(), options.format);
+		kf.update_reconstruction_pipeline_block(*urpb);
+		kf.surface_prediction_pipeline_block(*sppb);
+
+	}
+	kf.pipelined(true);
+	if (options.profile) {
+
+		ocldd.profiler(prof);
+		mpb.profiler(prof);
+		pepb.profiler(prof);
+		if (urpb) urpb->profiler(prof);
+		if (sppb) sppb->profiler(prof);
+		if (hurpb) hurpb->profiler(prof);
+		if (hsppb) hsppb->profiler(prof);
+		if (purpb) purpb->profiler(prof);
+		if (psppb) psppb->profiler(prof);
+		kf.profiler(prof);
+
+	}
 
 	std::size_t total(0);
 	std::size_t frames(0);
@@ -164,20 +270,15 @@ static void main_impl (int argc, char ** argv) {
 
 			kinfu::timer t;
 			kf();
-			//	We do this because we're not actually consuming
-			//	the generated values, in the future this shouldn't
-			//	be necessary as the pipeline_value objects we consume
-			//	will do this or equivalent internally as they'll have
-			//	to wait for their offered values to become available
-			//	on the GPU before they download them
-			q.finish();
 			auto e=t.elapsed_ms();
 			std::cout << "Depth frame took " << std::chrono::duration_cast<std::chrono::milliseconds>(kf.depth_device_elapsed()).count() << "ms" << std::endl;
 			std::cout << "Measurement took " << std::chrono::duration_cast<std::chrono::milliseconds>(kf.measurement_pipeline_block_elapsed()).count() << "ms" << std::endl;
 			std::cout << "Pose estimation took " << std::chrono::duration_cast<std::chrono::milliseconds>(kf.pose_estimation_pipeline_block_elapsed()).count() << "ms" << std::endl;
+			std::cout << "Pose estimation iterations: " << pepb.iterations_performed() << std::endl;
 			std::cout << "Updating reconstruction took " << std::chrono::duration_cast<std::chrono::milliseconds>(kf.update_reconstruction_pipeline_block_elapsed()).count() << "ms" << std::endl;
 			std::cout << "Surface prediction took " << std::chrono::duration_cast<std::chrono::milliseconds>(kf.surface_prediction_pipeline_block_elapsed()).count() << "ms" << std::endl;
 			std::cout << "Frame took " << e.count() << "ms" << std::endl;
+			for (auto && r : kf.profile()) std::cout << "\t" << r.name << " took " << std::chrono::duration_cast<std::chrono::microseconds>(r.end-r.start).count() << "us on the device" << std::endl;
 			total+=e.count();
 
 			if (options.max_frames) {
@@ -195,8 +296,27 @@ static void main_impl (int argc, char ** argv) {
 	std::size_t avg=(frames==0) ? 0 : (total/frames);
 	std::cout << "Average time per frame: " << avg << "ms" << std::endl;
 	
-	auto && tsdf = kf.truncated_signed_distance_function().get();
-
+	//	The dense TSDF is mapped rather than copied to the
+	//	host and its voxels are converted to half precision
+	//	from whatever format they are stored in as they are
+	//	read, the hashed and paged TSDFs assemble a host copy
+	//	from their bricks and chunks respectively
+	//
+	//	The hashed TSDF only presents the region of the dense
+	//	TSDF which it replaces, bricks allocated outside it
+	//	are not exported
+	if (options.hashing) std::cout << "WARNING: Only voxels within the initial " << tsdf_extent << "m volume are exported" << std::endl;
+	auto && tsdf_pv = kf.truncated_signed_distance_function();
+	auto voxels = dynamic_cast<kinfu::opencl_voxel_pipeline_value *>(&tsdf_pv);
+	kinfu::optional<kinfu::opencl_voxel_pipeline_value::view> mapped;
+	const std::vector<kinfu::half> * copied(nullptr);
+	if (voxels) mapped.emplace(voxels->map());
+	else copied = &tsdf_pv.get();
+
+	//	The exported volume is wherever it has moved to, only
+	//	the dense TSDF moves
+	Eigen::Vector3i origin(urpb ? urpb->origin() : Eigen::Vector3i::Zero());
+	Eigen::Vector3f offset(origin.cast<float>()*(tsdf_extent/tsdf_size));
 	float px,py,pz;
     Eigen::MatrixXi SF;
     Eigen::MatrixXd SV;
@@ -209,21 +329,21 @@ static void main_impl (int argc, char ** argv) {
 
     for(std::size_t zi(0); zi < tsdf_size; ++zi) {
 
-        pz = (float(zi)+0.5f) * tsdf_extent/tsdf_size;
+        pz = offset(2) + (float(zi)+0.5f) * tsdf_extent/tsdf_size;
 
         for(std::size_t yi(0); yi < tsdf_size; ++yi) {
 
-            py = (float(yi)+0.5f) * tsdf_extent/tsdf_size;
+            py = offset(1) + (float(yi)+0.5f) * tsdf_extent/tsdf_size;
 
             for(std::size_t xi(0); xi < tsdf_size; ++xi) {
 
-                px = (float(xi)+0.5f) * tsdf_extent/tsdf_size;
+                px = offset(0) + (float(xi)+0.5f) * tsdf_extent/tsdf_size;
                
                 std::size_t vox_idx(xi + tsdf_size * (yi + tsdf_size * zi));
 
                 GV.row(vox_idx) = Eigen::RowVector3d(px,py,pz);
 
- 				S_(abs_idx) = tsdf[vox_idx];
+ 				S_(abs_idx) = mapped ? (*mapped)[vox_idx] : (*copied)[vox_idx];
 
                 abs_idx++;
 
@@ -235,6 +355,9 @@ static void main_impl (int argc, char ** argv) {
 
     }
 
+	//	The storage is unmapped before meshing
+	mapped = kinfu::nullopt;
+
     std::cout << "Running Marching Cubes..." << std::endl;
 
     kinfu::libigl::marching_cubes(S_,GV,tsdf_size,tsdf_size,tsdf_size,SV,SF);
@@ -0,0 +1,29 @@
+#include <kinfu/memory_tsdf_slice_sink.hpp>
+#include <utility>
+
+
+namespace kinfu {
+
+
+	void memory_tsdf_slice_sink::operator () (slice s) {
+
+		slices_.push_back(std::move(s));
+
+	}
+
+
+	const memory_tsdf_slice_sink::slices_type & memory_tsdf_slice_sink::slices () const noexcept {
+
+		return slices_;
+
+	}
+
+
+	void memory_tsdf_slice_sink::clear () noexcept {
+
+		slices_.clear();
+
+	}
+
+
+}
@@ -0,0 +1,15 @@
+#include <kinfu/motion_model.hpp>
+
+
+namespace kinfu {
+
+
+	Eigen::Matrix4f constant_velocity (const Eigen::Matrix4f & t_gk_minus_two, const Eigen::Matrix4f & t_gk_minus_one) noexcept {
+
+		Eigen::Matrix4f velocity(t_gk_minus_two.inverse()*t_gk_minus_one);
+		return t_gk_minus_one*velocity;
+
+	}
+
+
+}
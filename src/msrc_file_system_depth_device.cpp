@@ -1,9 +1,9 @@
 #include <opencv2/opencv.hpp>
-#include <kinfu/cpu_pipeline_value.hpp>
 #include <kinfu/filesystem.hpp>
 #include <kinfu/msrc_file_system_depth_device.hpp>
+#include <kinfu/raw_depth_pipeline_value.hpp>
+#include <algorithm>
 #include <cstdint>
-#include <limits>
 #include <memory>
 #include <regex>
 #include <stdexcept>
@@ -29,12 +29,10 @@ namespace kinfu {
 	
 	msrc_file_system_depth_device_frame_factory::value_type msrc_file_system_depth_device_frame_factory::operator () (const filesystem::path & path, value_type v) {
 		
-		using type=cpu_pipeline_value<buffer_type>;
-		if (!v) v=std::make_unique<type>();
-		auto && vec=dynamic_cast<type &>(*v.get()).get_or_emplace();
-		vec.clear();
-		// reserve the size of our image
-		vec.reserve(640*480);
+		// In the MSRC dataset 65535 represents an invalid depth value
+		using type=raw_depth_pipeline_value;
+		if (!v) v=std::make_unique<type>(65535U);
+		auto && vec=dynamic_cast<type &>(*v.get()).raw();
 
 		// Load a grayscale depth image. Anydepth is necessary as these are 16 bit ints 
 		auto img = cv::imread(path.string(), CV_LOAD_IMAGE_GRAYSCALE | CV_LOAD_IMAGE_ANYDEPTH);
@@ -43,13 +41,12 @@ namespace kinfu {
 
 		if (img.rows != 480 || img.cols != 640) throw std::runtime_error("Image is not of the expected size (640x480)");
 
-		// Convert mm to m, cast uint16 to float and push into the vector		
-		for (int i=0; i < img.rows; ++i) for (int j = 0; j < img.cols; ++j) {
-			auto v=img.at<std::uint16_t>(i,j);
-			// In the MSRC dataset 65535 represents an invalid depth value
-			// which we represent in floating point using qNaN
-			static_assert(std::numeric_limits<float>::has_quiet_NaN,"qNaN not supported on this platform");
-			vec.push_back((v==65535U) ? std::numeric_limits<float>::quiet_NaN() : (v/1000.0f));
+		// Depth values are kept in millimeters, conversion to meters
+		// (and of invalid depth values to qNaN) is deferred to the consumer
+		vec.resize(640*480);
+		for (int i=0; i < img.rows; ++i) {
+			auto row=img.ptr<std::uint16_t>(i);
+			std::copy(row, row + img.cols, vec.begin() + (i * img.cols));
 		}
 		
 		return v;
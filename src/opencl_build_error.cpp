@@ -106,13 +106,13 @@ namespace kinfu {
 	}
 	
 	
-	boost::compute::program opencl_file_build_error::build (const filesystem::path & path, const boost::compute::context & ctx) {
+	boost::compute::program opencl_file_build_error::build (const filesystem::path & path, const boost::compute::context & ctx, const std::string & options) {
 		
 		auto retr=boost::compute::program::create_with_source_file(path.string(),ctx);
 		
 		try {
 			
-			retr.build();
+			retr.build(options);
 			
 		} catch (const boost::compute::opencl_error & err) {
 			
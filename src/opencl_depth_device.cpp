@@ -1,19 +1,91 @@
-#include <boost/compute/algorithm/copy.hpp>
+#include <boost/compute/buffer.hpp>
 #include <boost/compute/container/vector.hpp>
-#include <boost/compute/async/future.hpp>
+#include <boost/compute/event.hpp>
+#include <boost/compute/utility/wait_list.hpp>
 #include <kinfu/opencl_depth_device.hpp>
 #include <kinfu/opencl_vector_pipeline_value.hpp>
+#include <kinfu/optional.hpp>
+#include <kinfu/raw_depth_pipeline_value.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <memory>
+#include <stdexcept>
 #include <utility>
 
 
 namespace kinfu {
 	
 	
-	opencl_depth_device::opencl_depth_device (depth_device & dev, boost::compute::command_queue q)
+	opencl_depth_device::opencl_depth_device (depth_device & dev, boost::compute::command_queue q, std::size_t staging)
 		:	depth_device_decorator(dev),
-			q_(std::move(q))
-	{	}
+			q_(std::move(q)),
+			staging_(staging),
+			next_(0)
+	{
+		
+		if (staging==0) throw std::logic_error("Must have at least one staging buffer");
+		
+	}
+	
+	
+	opencl_depth_device::opencl_depth_device (depth_device & dev, boost::compute::command_queue q, opencl_program_factory & opf, std::size_t staging)
+		:	opencl_depth_device(dev,std::move(q),staging)
+	{
+		
+		auto p=opf("depth");
+		kernel_.emplace(p,"depth_to_meters");
+		
+	}
+	
+	
+	opencl_depth_device::~opencl_depth_device () noexcept {
+		
+		//	Uploads may still be reading from the staging
+		//	buffers
+		//
+		//	Errors cannot be reported from a destructor and
+		//	should not prevent the remaining buffers from
+		//	being unmapped
+		for (auto && s : staging_) if (s.ptr) {
+			
+			try {
+				
+				if (s.event.get()) s.event.wait();
+				q_.enqueue_unmap_buffer(s.buffer,s.ptr).wait();
+				
+			} catch (...) {	}
+			
+		}
+		
+	}
+	
+	
+	boost::compute::event opencl_depth_device::upload (const void * src, std::size_t size, const boost::compute::buffer & dest) {
+		
+		auto && s=staging_[next_];
+		next_=(next_+1)%staging_.size();
+		
+		//	The upload from this staging buffer issued
+		//	staging_.size() frames ago must complete before
+		//	it may be overwritten
+		if (s.event.get()) s.event.wait();
+		if (s.size<size) {
+			
+			if (s.ptr) q_.enqueue_unmap_buffer(s.buffer,s.ptr).wait();
+			s.ptr=nullptr;
+			s.buffer=boost::compute::buffer(q_.get_context(),size,CL_MEM_READ_ONLY|CL_MEM_ALLOC_HOST_PTR);
+			s.ptr=q_.enqueue_map_buffer(s.buffer,CL_MAP_WRITE,0,size);
+			s.size=size;
+			
+		}
+		
+		std::memcpy(s.ptr,src,size);
+		s.event=q_.enqueue_write_buffer_async(dest,0,size,s.ptr);
+		
+		return s.event;
+		
+	}
 	
 	
 	opencl_depth_device::value_type opencl_depth_device::operator () (value_type v) {
@@ -26,22 +98,12 @@ namespace kinfu {
 			
 			
 				value_type inner;
-				boost::compute::future<boost::compute::vector<buffer_type::value_type>::iterator> future;
+				optional<boost::compute::vector<std::uint16_t>> raw;
 				
 				
 				using base_type::base_type;
 				
 				
-				~pipeline_value () noexcept {
-					
-					//	Because OpenCL may be still using
-					//	things until the asynchronous task
-					//	completes
-					if (future.valid()) future.wait();
-					
-				}
-				
-				
 				virtual const buffer_type & get () override {
 					
 					return inner->get();
@@ -56,17 +118,53 @@ namespace kinfu {
 		auto && pv=static_cast<pipeline_value &>(*v.get());
 		//	We don't want undefined behaviour/race
 		//	conditions
-		if (was) pv.future.wait();
+		if (was) pv.wait();
 		
 		value_type pvi;
 		using std::swap;
 		swap(pvi,pv.inner);
 		pv.inner=dev_(std::move(pvi));
-		auto && vi=pv.inner->get();
-		
 		auto && vec=pv.vector();
+		
+		//	Frames are copied into a pinned staging buffer and
+		//	then uploaded asynchronously so that the next frame
+		//	may be obtained while this frame is uploaded
+		//
+		//	Frames in the native 16 bit representation are
+		//	uploaded as such and converted to meters on the
+		//	device
+		auto raw=dynamic_cast<const raw_depth_pipeline_value *>(pv.inner.get());
+		if (kernel_ && raw && !raw->raw().empty()) {
+			
+			auto && vi=raw->raw();
+			if (!pv.raw) pv.raw.emplace(q_.get_context());
+			pv.raw->resize(vi.size(),q_);
+			vec.resize(vi.size(),q_);
+			boost::compute::wait_list events(profile("write raw depth frame",upload(vi.data(),vi.size()*sizeof(std::uint16_t),pv.raw->get_buffer())));
+			
+			//	Kernel arguments are:
+			//
+			//	0:	Source (raw)
+			//	1:	Destination
+			//	2:	Invalid value
+			kernel_->set_arg(0,*pv.raw);
+			kernel_->set_arg(1,vec);
+			kernel_->set_arg(2,raw->invalid());
+			pv.event(profile("depth_to_meters",q_.enqueue_1d_range_kernel(*kernel_,0,vi.size(),0,events)));
+			
+			return v;
+			
+		}
+		
+		auto && vi=pv.inner->get();
 		vec.resize(vi.size(),q_);
-		pv.future=boost::compute::copy_async(vi.begin(),vi.end(),vec.begin(),q_);
+		if (vi.empty()) {
+			
+			pv.events(boost::compute::wait_list{});
+			return v;
+			
+		}
+		pv.event(profile("write depth frame",upload(vi.data(),vi.size()*sizeof(buffer_type::value_type),vec.get_buffer())));
 		
 		return v;
 		
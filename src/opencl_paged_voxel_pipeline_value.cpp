@@ -0,0 +1,349 @@
+#include <boost/compute/command_queue.hpp>
+#include <boost/compute/container/vector.hpp>
+#include <boost/compute/utility/wait_list.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <kinfu/boost_compute_detail_type_name_trait.hpp>
+#include <kinfu/filesystem.hpp>
+#include <kinfu/half.hpp>
+#include <kinfu/opencl_paged_voxel_pipeline_value.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace kinfu {
+
+
+	static std::size_t chunks_along (std::size_t size, std::size_t chunk_size) noexcept {
+
+		return (size+chunk_size-1)/chunk_size;
+
+	}
+
+
+	//	Each chunk occupies chunk_size^3 TSDF values followed by
+	//	chunk_size^3 weights in the file
+	static std::size_t chunk_bytes (std::size_t chunk_size) noexcept {
+
+		return chunk_size*chunk_size*chunk_size*(sizeof(half)+sizeof(std::uint8_t));
+
+	}
+
+
+	static std::string create_file (const filesystem::path & path, std::size_t size) {
+
+		std::ofstream stream(path.string(),std::ios::binary|std::ios::trunc);
+		stream.close();
+		filesystem::resize_file(path,size);
+
+		return path.string();
+
+	}
+
+
+	opencl_paged_voxel_pipeline_value::opencl_paged_voxel_pipeline_value (
+		boost::compute::command_queue q,
+		const filesystem::path & path,
+		std::size_t width,
+		std::size_t height,
+		std::size_t depth,
+		std::size_t chunk_size,
+		std::size_t slots
+	)	:	base(q),
+			width_(width),
+			height_(height),
+			depth_(depth),
+			chunk_size_(chunk_size),
+			chunks_x_(chunks_along(width,chunk_size)),
+			chunks_y_(chunks_along(height,chunk_size)),
+			chunks_z_(chunks_along(depth,chunk_size)),
+			file_(create_file(path,chunks_x_*chunks_y_*chunks_z_*chunk_bytes(chunk_size)).c_str(),boost::interprocess::read_write),
+			region_(file_,boost::interprocess::read_write),
+			stored_(chunks_x_*chunks_y_*chunks_z_,false),
+			table_(stored_.size(),-1),
+			slot_chunks_(slots,-1),
+			tsdf_(slots*chunk_size*chunk_size*chunk_size,q.get_context()),
+			weights_(tsdf_.size(),q.get_context()),
+			table_gpu_(table_.size(),q.get_context()),
+			slot_chunks_gpu_(slots,q.get_context()),
+			dirty_(true)
+	{	}
+
+
+	opencl_paged_voxel_pipeline_value::~opencl_paged_voxel_pipeline_value () noexcept {
+
+		//	Transfers to and from the file must complete before
+		//	it is unmapped
+		//
+		//	Errors cannot be reported from a destructor
+		try {
+
+			writes_.wait();
+
+		} catch (...) {	}
+
+	}
+
+
+	unsigned char * opencl_paged_voxel_pipeline_value::chunk_data (std::size_t chunk) noexcept {
+
+		return static_cast<unsigned char *>(region_.get_address())+(chunk*chunk_bytes(chunk_size_));
+
+	}
+
+
+	void opencl_paged_voxel_pipeline_value::page_out (boost::compute::command_queue & q, std::size_t slot) {
+
+		auto chunk=std::size_t(slot_chunks_[slot]);
+		auto n=chunk_size_*chunk_size_*chunk_size_;
+		auto ptr=chunk_data(chunk);
+		writes_.insert(q.enqueue_read_buffer_async(tsdf_.get_buffer(),slot*n*sizeof(half),n*sizeof(half),ptr));
+		writes_.insert(q.enqueue_read_buffer_async(weights_.get_buffer(),slot*n,n,ptr+(n*sizeof(half))));
+		stored_[chunk]=true;
+
+	}
+
+
+	void opencl_paged_voxel_pipeline_value::page_in (boost::compute::command_queue & q, std::size_t chunk, std::size_t slot) {
+
+		auto n=chunk_size_*chunk_size_*chunk_size_;
+		if (stored_[chunk]) {
+
+			auto ptr=chunk_data(chunk);
+			writes_.insert(q.enqueue_write_buffer_async(tsdf_.get_buffer(),slot*n*sizeof(half),n*sizeof(half),ptr));
+			writes_.insert(q.enqueue_write_buffer_async(weights_.get_buffer(),slot*n,n,ptr+(n*sizeof(half))));
+			return;
+
+		}
+
+		half empty(1.0f);
+		std::uint8_t zero_weight(0);
+		q.enqueue_fill_buffer(tsdf_.get_buffer(),&empty,sizeof(empty),slot*n*sizeof(half),n*sizeof(half));
+		q.enqueue_fill_buffer(weights_.get_buffer(),&zero_weight,sizeof(zero_weight),slot*n,n);
+
+	}
+
+
+	void opencl_paged_voxel_pipeline_value::upload (boost::compute::command_queue & q) {
+
+		writes_.insert(q.enqueue_write_buffer_async(table_gpu_.get_buffer(),0,table_.size()*sizeof(std::int32_t),table_.data()));
+		writes_.insert(q.enqueue_write_buffer_async(slot_chunks_gpu_.get_buffer(),0,slot_chunks_.size()*sizeof(std::int32_t),slot_chunks_.data()));
+
+	}
+
+
+	void opencl_paged_voxel_pipeline_value::clear () {
+
+		//	Must be a mutable lvalue
+		auto q=base::command_queue();
+		dirty_=true;
+		writes_.wait();
+		writes_.clear();
+
+		std::fill(stored_.begin(),stored_.end(),false);
+		std::fill(table_.begin(),table_.end(),-1);
+		std::fill(slot_chunks_.begin(),slot_chunks_.end(),-1);
+		upload(q);
+		base::events(writes_);
+
+	}
+
+
+	void opencl_paged_voxel_pipeline_value::require (const std::vector<std::size_t> & chunks) {
+
+		//	Must be a mutable lvalue
+		auto q=base::command_queue();
+		dirty_=true;
+		writes_.wait();
+		writes_.clear();
+
+		std::vector<bool> wanted(table_.size(),false);
+		for (auto chunk : chunks) wanted[chunk]=true;
+		std::vector<std::size_t> free;
+		for (std::size_t slot=0;slot<slot_chunks_.size();++slot) {
+
+			auto chunk=slot_chunks_[slot];
+			if ((chunk<0) || !wanted[std::size_t(chunk)]) free.push_back(slot);
+
+		}
+
+		auto next=free.begin();
+		bool changed=false;
+		for (auto chunk : chunks) {
+
+			if (table_[chunk]>=0) continue;
+			if (next==free.end()) break;
+			auto slot=*(next++);
+			if (slot_chunks_[slot]>=0) {
+
+				page_out(q,slot);
+				table_[std::size_t(slot_chunks_[slot])]=-1;
+
+			}
+			page_in(q,chunk,slot);
+			table_[chunk]=std::int32_t(slot);
+			slot_chunks_[slot]=std::int32_t(chunk);
+			changed=true;
+
+		}
+
+		if (changed) upload(q);
+
+	}
+
+
+	void opencl_paged_voxel_pipeline_value::flush () {
+
+		//	Must be a mutable lvalue
+		auto q=base::command_queue();
+		for (std::size_t slot=0;slot<slot_chunks_.size();++slot) if (slot_chunks_[slot]>=0) page_out(q,slot);
+		writes_.wait();
+		writes_.clear();
+
+	}
+
+
+	std::size_t opencl_paged_voxel_pipeline_value::width () const noexcept {
+
+		return width_;
+
+	}
+
+
+	std::size_t opencl_paged_voxel_pipeline_value::height () const noexcept {
+
+		return height_;
+
+	}
+
+
+	std::size_t opencl_paged_voxel_pipeline_value::depth () const noexcept {
+
+		return depth_;
+
+	}
+
+
+	std::size_t opencl_paged_voxel_pipeline_value::chunk_size () const noexcept {
+
+		return chunk_size_;
+
+	}
+
+
+	std::size_t opencl_paged_voxel_pipeline_value::chunks_x () const noexcept {
+
+		return chunks_x_;
+
+	}
+
+
+	std::size_t opencl_paged_voxel_pipeline_value::chunks_y () const noexcept {
+
+		return chunks_y_;
+
+	}
+
+
+	std::size_t opencl_paged_voxel_pipeline_value::chunks_z () const noexcept {
+
+		return chunks_z_;
+
+	}
+
+
+	std::size_t opencl_paged_voxel_pipeline_value::slots () const noexcept {
+
+		return slot_chunks_.size();
+
+	}
+
+
+	std::size_t opencl_paged_voxel_pipeline_value::resident () const noexcept {
+
+		return std::size_t(std::count_if(slot_chunks_.begin(),slot_chunks_.end(),[] (auto chunk) noexcept {	return chunk>=0;	}));
+
+	}
+
+
+	boost::compute::vector<half> & opencl_paged_voxel_pipeline_value::tsdf () noexcept {
+
+		dirty_=true;
+		return tsdf_;
+
+	}
+
+
+	const boost::compute::vector<half> & opencl_paged_voxel_pipeline_value::tsdf () const noexcept {
+
+		return tsdf_;
+
+	}
+
+
+	boost::compute::vector<std::uint8_t> & opencl_paged_voxel_pipeline_value::weights () noexcept {
+
+		dirty_=true;
+		return weights_;
+
+	}
+
+
+	const boost::compute::vector<std::int32_t> & opencl_paged_voxel_pipeline_value::table () const noexcept {
+
+		return table_gpu_;
+
+	}
+
+
+	const boost::compute::vector<std::int32_t> & opencl_paged_voxel_pipeline_value::slot_chunks () const noexcept {
+
+		return slot_chunks_gpu_;
+
+	}
+
+
+	const std::vector<half> & opencl_paged_voxel_pipeline_value::get () {
+
+		if (!dirty_) return cpu_;
+
+		wait();
+		flush();
+
+		cpu_.assign(width_*height_*depth_,half(1.0f));
+		auto c=chunk_size_;
+		for (std::size_t chunk=0;chunk<stored_.size();++chunk) {
+
+			if (!stored_[chunk]) continue;
+
+			auto bx=(chunk%chunks_x_)*c;
+			auto by=((chunk/chunks_x_)%chunks_y_)*c;
+			auto bz=(chunk/(chunks_x_*chunks_y_))*c;
+			auto row=std::min(c,width_-bx);
+			auto ptr=chunk_data(chunk);
+			for (std::size_t z=0;(z<c) && ((bz+z)<depth_);++z) for (std::size_t y=0;(y<c) && ((by+y)<height_);++y) {
+
+				std::memcpy(
+					cpu_.data()+(bx+(width_*((by+y)+(height_*(bz+z))))),
+					ptr+((c*(y+(c*z)))*sizeof(half)),
+					row*sizeof(half)
+				);
+
+			}
+
+		}
+
+		dirty_=false;
+
+		return cpu_;
+
+	}
+
+
+}
@@ -0,0 +1,81 @@
+#include <boost/compute/cl.hpp>
+#include <boost/compute/event.hpp>
+#include <kinfu/opencl_profiler.hpp>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <utility>
+
+
+namespace kinfu {
+
+
+	static std::chrono::nanoseconds get_time (const boost::compute::event & e, cl_profiling_info info) {
+
+		return std::chrono::nanoseconds(e.get_profiling_info<cl_ulong>(info));
+
+	}
+
+
+	boost::compute::event opencl_profiler::operator () (std::string name, boost::compute::event event) {
+
+		std::lock_guard<std::mutex> l(m_);
+		pending_.emplace_back(std::move(name),event);
+
+		return event;
+
+	}
+
+
+	void opencl_profiler::clear () {
+
+		std::lock_guard<std::mutex> l(m_);
+		pending_.clear();
+		records_.clear();
+
+	}
+
+
+	const opencl_profiler::records_type & opencl_profiler::records () {
+
+		std::lock_guard<std::mutex> l(m_);
+		for (auto && p : pending_) {
+
+			auto && e=p.second;
+			e.wait();
+			records_.push_back(record{
+				std::move(p.first),
+				get_time(e,CL_PROFILING_COMMAND_QUEUED),
+				get_time(e,CL_PROFILING_COMMAND_SUBMIT),
+				get_time(e,CL_PROFILING_COMMAND_START),
+				get_time(e,CL_PROFILING_COMMAND_END)
+			});
+
+		}
+		pending_.clear();
+
+		return records_;
+
+	}
+
+
+	opencl_profiled::opencl_profiled () noexcept : p_(nullptr) {	}
+
+
+	boost::compute::event opencl_profiled::profile (const char * name, boost::compute::event event) {
+
+		if (!p_) return event;
+
+		return (*p_)(name,std::move(event));
+
+	}
+
+
+	void opencl_profiled::profiler (opencl_profiler & p) noexcept {
+
+		p_=&p;
+
+	}
+
+
+}
@@ -0,0 +1,219 @@
+#include <boost/compute/algorithm/copy.hpp>
+#include <boost/compute/command_queue.hpp>
+#include <boost/compute/container/vector.hpp>
+#include <boost/compute/utility/wait_list.hpp>
+#include <kinfu/boost_compute_detail_type_name_trait.hpp>
+#include <kinfu/half.hpp>
+#include <kinfu/opencl_voxel_hash_pipeline_value.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace kinfu {
+
+
+	constexpr std::size_t brick_voxels=voxel_hash_brick_size*voxel_hash_brick_size*voxel_hash_brick_size;
+
+
+	opencl_voxel_hash_pipeline_value::opencl_voxel_hash_pipeline_value (
+		boost::compute::command_queue q,
+		std::size_t buckets,
+		std::size_t bricks,
+		float voxel_size,
+		std::size_t width,
+		std::size_t height,
+		std::size_t depth
+	)	:	base(q),
+			voxel_size_(voxel_size),
+			width_(width),
+			height_(height),
+			depth_(depth),
+			keys_(buckets,q.get_context()),
+			ptrs_(buckets,q.get_context()),
+			brick_keys_(bricks,q.get_context()),
+			tsdf_(bricks*brick_voxels,q.get_context()),
+			weights_(bricks*brick_voxels,q.get_context()),
+			count_(1U,q.get_context()),
+			dirty_(true)
+	{	}
+
+
+	void opencl_voxel_hash_pipeline_value::clear () {
+
+		//	Must be a mutable lvalue
+		auto q=base::command_queue();
+		dirty_=true;
+
+		std::uint32_t empty_key(0xFFFFFFFFU);
+		std::int32_t no_brick(-1);
+		half empty(1.0f);
+		std::uint8_t zero_weight(0);
+		std::uint32_t zero_count(0);
+		boost::compute::wait_list events;
+		events.insert(q.enqueue_fill_buffer(keys_.get_buffer(),&empty_key,sizeof(empty_key),0,keys_.size()*sizeof(empty_key)));
+		events.insert(q.enqueue_fill_buffer(ptrs_.get_buffer(),&no_brick,sizeof(no_brick),0,ptrs_.size()*sizeof(no_brick)));
+		events.insert(q.enqueue_fill_buffer(tsdf_.get_buffer(),&empty,sizeof(empty),0,tsdf_.size()*sizeof(empty)));
+		events.insert(q.enqueue_fill_buffer(weights_.get_buffer(),&zero_weight,sizeof(zero_weight),0,weights_.size()));
+		events.insert(q.enqueue_fill_buffer(count_.get_buffer(),&zero_count,sizeof(zero_count),0,sizeof(zero_count)));
+		base::events(std::move(events));
+
+	}
+
+
+	std::size_t opencl_voxel_hash_pipeline_value::allocated () const {
+
+		auto q=base::command_queue();
+		std::uint32_t retr;
+		q.enqueue_read_buffer(count_.get_buffer(),0,sizeof(retr),&retr,base::events());
+
+		return retr;
+
+	}
+
+
+	std::size_t opencl_voxel_hash_pipeline_value::buckets () const noexcept {
+
+		return keys_.size();
+
+	}
+
+
+	std::size_t opencl_voxel_hash_pipeline_value::bricks () const noexcept {
+
+		return brick_keys_.size();
+
+	}
+
+
+	float opencl_voxel_hash_pipeline_value::voxel_size () const noexcept {
+
+		return voxel_size_;
+
+	}
+
+
+	boost::compute::vector<std::uint32_t> & opencl_voxel_hash_pipeline_value::keys () noexcept {
+
+		dirty_=true;
+		return keys_;
+
+	}
+
+
+	const boost::compute::vector<std::uint32_t> & opencl_voxel_hash_pipeline_value::keys () const noexcept {
+
+		return keys_;
+
+	}
+
+
+	boost::compute::vector<std::int32_t> & opencl_voxel_hash_pipeline_value::pointers () noexcept {
+
+		dirty_=true;
+		return ptrs_;
+
+	}
+
+
+	const boost::compute::vector<std::int32_t> & opencl_voxel_hash_pipeline_value::pointers () const noexcept {
+
+		return ptrs_;
+
+	}
+
+
+	boost::compute::vector<std::uint32_t> & opencl_voxel_hash_pipeline_value::brick_keys () noexcept {
+
+		dirty_=true;
+		return brick_keys_;
+
+	}
+
+
+	boost::compute::vector<half> & opencl_voxel_hash_pipeline_value::tsdf () noexcept {
+
+		dirty_=true;
+		return tsdf_;
+
+	}
+
+
+	const boost::compute::vector<half> & opencl_voxel_hash_pipeline_value::tsdf () const noexcept {
+
+		return tsdf_;
+
+	}
+
+
+	boost::compute::vector<std::uint8_t> & opencl_voxel_hash_pipeline_value::weights () noexcept {
+
+		dirty_=true;
+		return weights_;
+
+	}
+
+
+	boost::compute::vector<std::uint32_t> & opencl_voxel_hash_pipeline_value::count () noexcept {
+
+		dirty_=true;
+		return count_;
+
+	}
+
+
+	//	Must agree with key_brick in cl/hashing.cl
+	static std::ptrdiff_t unpack_component (std::uint32_t bits) noexcept {
+
+		std::ptrdiff_t retr(bits&1023U);
+		return (retr>=512) ? (retr-1024) : retr;
+
+	}
+
+
+	const std::vector<half> & opencl_voxel_hash_pipeline_value::get () {
+
+		if (!dirty_) return cpu_;
+
+		wait();
+		auto q=base::command_queue();
+		std::vector<std::uint32_t> keys(keys_.size());
+		boost::compute::copy(keys_.begin(),keys_.end(),keys.begin(),q);
+		std::vector<std::int32_t> ptrs(ptrs_.size());
+		boost::compute::copy(ptrs_.begin(),ptrs_.end(),ptrs.begin(),q);
+		//	Only the allocated part of the pool need be downloaded
+		auto n=std::min(allocated(),bricks());
+		std::vector<half> tsdf(n*brick_voxels);
+		boost::compute::copy(tsdf_.begin(),tsdf_.begin()+tsdf.size(),tsdf.begin(),q);
+
+		cpu_.assign(width_*height_*depth_,half(1.0f));
+		auto b=std::ptrdiff_t(voxel_hash_brick_size);
+		for (std::size_t slot=0;slot<keys.size();++slot) {
+
+			if ((keys[slot]==0xFFFFFFFFU) || (ptrs[slot]<0)) continue;
+
+			std::ptrdiff_t bx=unpack_component(keys[slot]>>20)*b;
+			std::ptrdiff_t by=unpack_component(keys[slot]>>10)*b;
+			std::ptrdiff_t bz=unpack_component(keys[slot])*b;
+			auto brick=tsdf.begin()+(std::size_t(ptrs[slot])*brick_voxels);
+			for (std::ptrdiff_t z=0;z<b;++z) for (std::ptrdiff_t y=0;y<b;++y) for (std::ptrdiff_t x=0;x<b;++x) {
+
+				auto gx=bx+x;
+				auto gy=by+y;
+				auto gz=bz+z;
+				if ((gx<0) || (gy<0) || (gz<0) || (gx>=std::ptrdiff_t(width_)) || (gy>=std::ptrdiff_t(height_)) || (gz>=std::ptrdiff_t(depth_))) continue;
+				cpu_[std::size_t(gx)+(width_*(std::size_t(gy)+(height_*std::size_t(gz))))]=brick[x+(b*(y+(b*z)))];
+
+			}
+
+		}
+
+		dirty_=false;
+
+		return cpu_;
+
+	}
+
+
+}
@@ -0,0 +1,331 @@
+#include <boost/compute/buffer.hpp>
+#include <boost/compute/command_queue.hpp>
+#include <boost/compute/container/vector.hpp>
+#include <boost/compute/utility/wait_list.hpp>
+#include <kinfu/half.hpp>
+#include <kinfu/opencl_voxel_pipeline_value.hpp>
+#include <kinfu/voxel_format.hpp>
+#include <Eigen/Dense>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+
+namespace kinfu {
+
+
+	opencl_voxel_pipeline_value::view::view (
+		boost::compute::command_queue q,
+		const boost::compute::buffer & buffer,
+		voxel_format format,
+		std::size_t width,
+		std::size_t height,
+		std::size_t depth,
+		const std::size_t (& offset) [3],
+		const boost::compute::wait_list & events
+	)	:	q_(std::move(q)),
+			buffer_(buffer),
+			ptr_(nullptr),
+			format_(format),
+			width_(width),
+			height_(height),
+			depth_(depth),
+			offset_{offset[0],offset[1],offset[2]}
+	{
+
+		if (size()==0) return;
+		ptr_=static_cast<const unsigned char *>(q_.enqueue_map_buffer(buffer_,CL_MAP_READ,0,size()*voxel_size(format_),events));
+
+	}
+
+
+	opencl_voxel_pipeline_value::view::view (view && other) noexcept
+		:	q_(std::move(other.q_)),
+			buffer_(std::move(other.buffer_)),
+			ptr_(other.ptr_),
+			format_(other.format_),
+			width_(other.width_),
+			height_(other.height_),
+			depth_(other.depth_),
+			offset_{other.offset_[0],other.offset_[1],other.offset_[2]}
+	{
+
+		other.ptr_=nullptr;
+		other.width_=0;
+
+	}
+
+
+	opencl_voxel_pipeline_value::view & opencl_voxel_pipeline_value::view::operator = (view && other) noexcept {
+
+		unmap();
+		q_=std::move(other.q_);
+		buffer_=std::move(other.buffer_);
+		ptr_=other.ptr_;
+		format_=other.format_;
+		width_=other.width_;
+		height_=other.height_;
+		depth_=other.depth_;
+		for (std::size_t i=0;i<3U;++i) offset_[i]=other.offset_[i];
+		other.ptr_=nullptr;
+		other.width_=0;
+
+		return *this;
+
+	}
+
+
+	opencl_voxel_pipeline_value::view::~view () noexcept {
+
+		unmap();
+
+	}
+
+
+	void opencl_voxel_pipeline_value::view::unmap () noexcept {
+
+		if (!ptr_) return;
+		//	Errors cannot be reported from a destructor
+		try {
+
+			q_.enqueue_unmap_buffer(buffer_,const_cast<unsigned char *>(ptr_)).wait();
+
+		} catch (...) {	}
+		ptr_=nullptr;
+
+	}
+
+
+	std::size_t opencl_voxel_pipeline_value::view::size () const noexcept {
+
+		return width_*height_*depth_;
+
+	}
+
+
+	bool opencl_voxel_pipeline_value::view::empty () const noexcept {
+
+		return size()==0;
+
+	}
+
+
+	half opencl_voxel_pipeline_value::view::operator [] (std::size_t i) const noexcept {
+
+		//	Voxels are presented starting from the voxel at
+		//	the origin but are stored modulo the volume
+		if ((offset_[0]!=0) || (offset_[1]!=0) || (offset_[2]!=0)) {
+
+			auto x=(i%width_)+offset_[0];
+			auto y=((i/width_)%height_)+offset_[1];
+			auto z=(i/(width_*height_))+offset_[2];
+			i=(x%width_)+(width_*((y%height_)+(height_*(z%depth_))));
+
+		}
+		if (format_==voxel_format::half) return reinterpret_cast<const half *>(ptr_)[i];
+
+		half retr;
+		decode_voxels(format_,ptr_+(i*voxel_size(format_)),1U,&retr);
+
+		return retr;
+
+	}
+
+
+	opencl_voxel_pipeline_value::opencl_voxel_pipeline_value (boost::compute::command_queue q, voxel_format format)
+		:	base(q),
+			format_(format),
+			width_(0),
+			height_(1),
+			depth_(1),
+			origin_(Eigen::Vector3i::Zero()),
+			gpu_(q.get_context()),
+			ranges_(q.get_context()),
+			observed_(q.get_context()),
+			dirty_(false)
+	{	}
+
+
+	voxel_format opencl_voxel_pipeline_value::format () const noexcept {
+
+		return format_;
+
+	}
+
+
+	std::size_t opencl_voxel_pipeline_value::size () const noexcept {
+
+		return gpu_.size()/voxel_size(format_);
+
+	}
+
+
+	void opencl_voxel_pipeline_value::resize (std::size_t size) {
+
+		resize(size,1U,1U);
+
+	}
+
+
+	void opencl_voxel_pipeline_value::resize (std::size_t width, std::size_t height, std::size_t depth) {
+
+		dirty_=true;
+		width_=width;
+		height_=height;
+		depth_=depth;
+		//	Must be a mutable lvalue
+		auto q=base::command_queue();
+		gpu_.resize(width*height*depth*voxel_size(format_),q);
+		auto b=bricks();
+		std::size_t n(b(0)*b(1)*b(2));
+		ranges_.resize(n*2U,q);
+		observed_.resize(n,q);
+
+	}
+
+
+	void opencl_voxel_pipeline_value::origin (const Eigen::Vector3i & origin) noexcept {
+
+		dirty_=true;
+		origin_=origin;
+
+	}
+
+
+	const Eigen::Vector3i & opencl_voxel_pipeline_value::origin () const noexcept {
+
+		return origin_;
+
+	}
+
+
+	static std::size_t wrap (int origin, std::size_t size) noexcept {
+
+		auto retr=origin%int(size);
+
+		return std::size_t((retr<0) ? (retr+int(size)) : retr);
+
+	}
+
+
+	boost::compute::vector<std::uint8_t> & opencl_voxel_pipeline_value::vector () noexcept {
+
+		dirty_=true;
+		return gpu_;
+
+	}
+
+
+	const boost::compute::vector<std::uint8_t> & opencl_voxel_pipeline_value::vector () const noexcept {
+
+		return gpu_;
+
+	}
+
+
+	static int bricks_along (std::size_t size) noexcept {
+
+		return int((size+tsdf_brick_size-1U)/tsdf_brick_size);
+
+	}
+
+
+	Eigen::Vector3i opencl_voxel_pipeline_value::bricks () const noexcept {
+
+		return Eigen::Vector3i(bricks_along(width_),bricks_along(height_),bricks_along(depth_));
+
+	}
+
+
+	boost::compute::vector<float> & opencl_voxel_pipeline_value::ranges () noexcept {
+
+		return ranges_;
+
+	}
+
+
+	const boost::compute::vector<float> & opencl_voxel_pipeline_value::ranges () const noexcept {
+
+		return ranges_;
+
+	}
+
+
+	boost::compute::vector<std::uint8_t> & opencl_voxel_pipeline_value::observed () noexcept {
+
+		return observed_;
+
+	}
+
+
+	const boost::compute::vector<std::uint8_t> & opencl_voxel_pipeline_value::observed () const noexcept {
+
+		return observed_;
+
+	}
+
+
+	opencl_voxel_pipeline_value::view opencl_voxel_pipeline_value::map () const {
+
+		std::size_t offset[]={0,0,0};
+		if (size()!=0) {
+
+			offset[0]=wrap(origin_(0),width_);
+			offset[1]=wrap(origin_(1),height_);
+			offset[2]=wrap(origin_(2),depth_);
+
+		}
+
+		return view(base::command_queue(),gpu_.get_buffer(),format_,width_,height_,depth_,offset,base::events());
+
+	}
+
+
+	const std::vector<half> & opencl_voxel_pipeline_value::get () {
+
+		if (!dirty_) return cpu_;
+
+		auto n=size();
+		cpu_.resize(n);
+		if (n!=0) {
+
+			auto q=base::command_queue();
+			auto ptr=q.enqueue_map_buffer(gpu_.get_buffer(),CL_MAP_READ,0,gpu_.size(),base::events());
+			std::size_t ox(wrap(origin_(0),width_));
+			std::size_t oy(wrap(origin_(1),height_));
+			std::size_t oz(wrap(origin_(2),depth_));
+			if ((ox==0) && (oy==0) && (oz==0)) {
+
+				decode_voxels(format_,ptr,n,cpu_.data());
+
+			} else {
+
+				//	Each row is stored as two contiguous runs
+				//	which are rotated into place
+				auto stride=voxel_size(format_);
+				auto begin=static_cast<const unsigned char *>(ptr);
+				for (std::size_t z=0;z<depth_;++z) for (std::size_t y=0;y<height_;++y) {
+
+					auto sy=(y+oy)%height_;
+					auto sz=(z+oz)%depth_;
+					auto row=begin+((width_*(sy+(height_*sz)))*stride);
+					auto out=cpu_.data()+(width_*(y+(height_*z)));
+					decode_voxels(format_,row+(ox*stride),width_-ox,out);
+					decode_voxels(format_,row,ox,out+(width_-ox));
+
+				}
+
+			}
+			q.enqueue_unmap_buffer(gpu_.get_buffer(),ptr).wait();
+
+		}
+
+		dirty_=false;
+
+		return cpu_;
+
+	}
+
+
+}
@@ -1,9 +1,9 @@
-#include <kinfu/cpu_pipeline_value.hpp>
 #include <kinfu/opencv_depth_device.hpp>
+#include <kinfu/raw_depth_pipeline_value.hpp>
 #include <opencv2/core/core.hpp>
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
-#include <limits>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
@@ -57,25 +57,20 @@ namespace kinfu {
 		}
 		
 		//	Initialize the pipeline_value if necessary
-		using pipeline_value_type=cpu_pipeline_value<buffer_type>;
-		if (!v) v=std::make_unique<pipeline_value_type>();
+		using pipeline_value_type=raw_depth_pipeline_value;
+		if (!v) v=std::make_unique<pipeline_value_type>(0U);
 		auto && pv=dynamic_cast<pipeline_value_type &>(*v);
-		auto && vec=pv.get_or_emplace();
-		vec.reserve(height_*width_);
-		vec.clear();
-
-		//	Copy frame over
-		for (std::size_t i=0;i<width_;++i) for (std::size_t j=0;j<height_;++j) {
+		auto && vec=pv.raw();
+		vec.resize(height_*width_);
+
+		//	Copy frame over (row major), OpenCV returns the depth
+		//	in millimeters with 0 representing an invalid depth
+		//	value and conversion to meters (and of invalid depth
+		//	values to qNaN) is deferred to the consumer
+		for (std::size_t j=0;j<height_;++j) {
 			
-			cv::Point p(i,j);
-			auto curr=depth.at<std::uint16_t>(p);
-			vec.push_back(
-				(curr==0)
-					?	std::numeric_limits<buffer_type::value_type>::quiet_NaN()
-						//	OpenCV returns the depth in millimeters, we're returning
-						//	meters
-					:	(buffer_type::value_type(curr)/1000.0f)
-			);
+			auto row=depth.ptr<std::uint16_t>(j);
+			std::copy(row,row+width_,vec.begin()+(j*width_));
 
 		}
 
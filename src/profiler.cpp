@@ -0,0 +1,10 @@
+#include <kinfu/profiler.hpp>
+
+
+namespace kinfu {
+
+
+	profiler::~profiler () noexcept {	}
+
+
+}
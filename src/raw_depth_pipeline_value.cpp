@@ -0,0 +1,103 @@
+#include <kinfu/raw_depth_pipeline_value.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+namespace kinfu {
+	
+	
+	raw_depth_pipeline_value::raw_depth_pipeline_value (std::uint16_t invalid) noexcept : invalid_(invalid), dirty_(false) {	}
+	
+	
+	float raw_depth_pipeline_value::to_meters (std::uint16_t depth, std::uint16_t invalid) noexcept {
+		
+		static_assert(std::numeric_limits<float>::has_quiet_NaN,"qNaN not supported on this platform");
+		if (depth==invalid) return std::numeric_limits<float>::quiet_NaN();
+		
+		return depth/1000.0f;
+		
+	}
+	
+	
+	void raw_depth_pipeline_value::to_meters (const std::uint16_t * begin, const std::uint16_t * end, float * out, std::uint16_t invalid) noexcept {
+		
+		//	Division (rather than multiplication by the
+		//	reciprocal) keeps the vectorized paths identical
+		//	to the scalar path
+#if defined(__AVX2__)
+		auto nan=_mm256_set1_ps(std::numeric_limits<float>::quiet_NaN());
+		auto thousand=_mm256_set1_ps(1000.0f);
+		auto inv=_mm256_set1_epi32(invalid);
+		for (;(end-begin)>=8;begin+=8,out+=8) {
+			
+			auto d=_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(begin)));
+			auto m=_mm256_div_ps(_mm256_cvtepi32_ps(d),thousand);
+			auto mask=_mm256_castsi256_ps(_mm256_cmpeq_epi32(d,inv));
+			_mm256_storeu_ps(out,_mm256_blendv_ps(m,nan,mask));
+			
+		}
+#elif defined(__SSE2__)
+		auto nan=_mm_set1_ps(std::numeric_limits<float>::quiet_NaN());
+		auto thousand=_mm_set1_ps(1000.0f);
+		auto inv=_mm_set1_epi16(std::int16_t(invalid));
+		auto zero=_mm_setzero_si128();
+		for (;(end-begin)>=8;begin+=8,out+=8) {
+			
+			auto d=_mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+			auto mask=_mm_cmpeq_epi16(d,inv);
+			auto lo_mask=_mm_castsi128_ps(_mm_unpacklo_epi16(mask,mask));
+			auto hi_mask=_mm_castsi128_ps(_mm_unpackhi_epi16(mask,mask));
+			auto lo=_mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(d,zero)),thousand);
+			auto hi=_mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(d,zero)),thousand);
+			_mm_storeu_ps(out,_mm_or_ps(_mm_and_ps(lo_mask,nan),_mm_andnot_ps(lo_mask,lo)));
+			_mm_storeu_ps(out+4,_mm_or_ps(_mm_and_ps(hi_mask,nan),_mm_andnot_ps(hi_mask,hi)));
+			
+		}
+#endif
+		for (;begin!=end;++begin,++out) *out=to_meters(*begin,invalid);
+		
+	}
+	
+	
+	std::uint16_t raw_depth_pipeline_value::invalid () const noexcept {
+		
+		return invalid_;
+		
+	}
+	
+	
+	raw_depth_pipeline_value::raw_buffer_type & raw_depth_pipeline_value::raw () noexcept {
+		
+		dirty_=true;
+		return raw_;
+		
+	}
+	
+	
+	const raw_depth_pipeline_value::raw_buffer_type & raw_depth_pipeline_value::raw () const noexcept {
+		
+		return raw_;
+		
+	}
+	
+	
+	const depth_device::buffer_type & raw_depth_pipeline_value::get () {
+		
+		if (!dirty_) return converted_;
+		
+		converted_.resize(raw_.size());
+		to_meters(raw_.data(),raw_.data()+raw_.size(),converted_.data(),invalid_);
+		dirty_=false;
+		
+		return converted_;
+		
+	}
+	
+	
+}
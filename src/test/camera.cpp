@@ -55,3 +55,98 @@ SCENARIO("kinfu::to_pixel translates from camera to pixel coordinates and kinfu:
 	}
 
 }
+
+
+SCENARIO("kinfu::pyramid_k obtains the camera calibration matrix for coarser levels of an image pyramid","[kinfu][pyramid_k]") {
+
+	GIVEN("A camera calibration matrix") {
+
+		Eigen::Matrix3f k;
+		k <<	585.0f, 0.0f, 320.0f,
+				0.0f, -585.0f, 240.0f,
+				0.0f, 0.0f, 1.0f;
+
+		THEN("Level zero is unchanged") {
+
+			CHECK(kinfu::pyramid_k(k,0)==k);
+
+		}
+
+		WHEN("kinfu::pyramid_k is invoked to obtain level two") {
+
+			auto k2=kinfu::pyramid_k(k,2);
+
+			THEN("The focal lengths are quartered") {
+
+				CHECK(k2(0,0)==Approx(146.25f));
+				CHECK(k2(1,1)==Approx(-146.25f));
+
+			}
+
+			THEN("The principal point is mapped to the corresponding coarse pixel coordinate") {
+
+				CHECK(k2(0,2)==Approx(79.625f));
+				CHECK(k2(1,2)==Approx(59.625f));
+
+			}
+
+			THEN("A point observed at the center of a 4x4 block at level zero is observed at the corresponding pixel at level two") {
+
+				auto cam=kinfu::to_camera(Eigen::Vector2i(0,0),1.0f,k2);
+				Eigen::Vector3f p(k*cam);
+				CHECK((p(0)/p(2))==Approx(1.5f));
+				CHECK((p(1)/p(2))==Approx(1.5f));
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO("kinfu::frustum_bounds obtains the axis aligned bounding box of the view frustum of a camera","[kinfu][frustum_bounds]") {
+
+	GIVEN("A camera calibration matrix for a 2x2 image with unit focal length") {
+
+		Eigen::Matrix3f k;
+		k << 1.0f, 0.0f, 0.5f,
+			 0.0f, 1.0f, 0.5f,
+			 0.0f, 0.0f, 1.0f;
+
+		WHEN("The bounds of the frustum of a camera at the origin are obtained to a depth of 2") {
+
+			auto b=kinfu::frustum_bounds(Eigen::Matrix4f::Identity(),k,2,2,2.0f);
+
+			THEN("They extend from the camera to the corners of the image at that depth") {
+
+				CHECK(b.first.isApprox(Eigen::Vector3f(-2.0f,-2.0f,0.0f)));
+				CHECK(b.second.isApprox(Eigen::Vector3f(2.0f,2.0f,2.0f)));
+
+			}
+
+		}
+
+		WHEN("The bounds of the frustum of a camera which is translated and rotated a half turn about the y axis are obtained to a depth of 1") {
+
+			Eigen::Matrix4f t_g_k(Eigen::Matrix4f::Identity());
+			t_g_k(0,0)=-1.0f;
+			t_g_k(2,2)=-1.0f;
+			t_g_k(0,3)=1.0f;
+			t_g_k(1,3)=2.0f;
+			t_g_k(2,3)=3.0f;
+			auto b=kinfu::frustum_bounds(t_g_k,k,2,2,1.0f);
+
+			THEN("They are transformed accordingly") {
+
+				CHECK(b.first.isApprox(Eigen::Vector3f(0.0f,1.0f,2.0f)));
+				CHECK(b.second.isApprox(Eigen::Vector3f(2.0f,3.0f,3.0f)));
+
+			}
+
+		}
+
+	}
+
+}
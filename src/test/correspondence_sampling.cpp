@@ -0,0 +1,116 @@
+#include <kinfu/correspondence_sampling.hpp>
+
+
+#include <kinfu/pixel.hpp>
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <set>
+#include <vector>
+#include <catch.hpp>
+
+
+SCENARIO("kinfu::stride_samples selects pixels at regular intervals","[kinfu][correspondence_sampling][stride_samples]") {
+
+	GIVEN("A number of pixels") {
+
+		std::size_t size(100);
+
+		WHEN("kinfu::stride_samples is used to select a quarter of them") {
+
+			auto samples=kinfu::stride_samples(size,25);
+
+			THEN("Every fourth pixel is selected") {
+
+				REQUIRE(samples.size()==25U);
+				for (std::size_t i=0;i<samples.size();++i) CHECK(samples[i]==(i*4U));
+
+			}
+
+		}
+
+		WHEN("kinfu::stride_samples is used to select more pixels than there are") {
+
+			auto samples=kinfu::stride_samples(size,200);
+
+			THEN("Every pixel is selected") {
+
+				REQUIRE(samples.size()==size);
+				for (std::size_t i=0;i<samples.size();++i) CHECK(samples[i]==i);
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO("kinfu::random_samples selects one pixel from each stratum","[kinfu][correspondence_sampling][random_samples]") {
+
+	GIVEN("A number of pixels") {
+
+		std::size_t size(1000);
+
+		WHEN("kinfu::random_samples is used to select a tenth of them") {
+
+			auto samples=kinfu::random_samples(size,100,0);
+
+			THEN("One pixel is selected from each stratum") {
+
+				REQUIRE(samples.size()==100U);
+				for (std::size_t i=0;i<samples.size();++i) {
+
+					CHECK(samples[i]>=(i*10U));
+					CHECK(samples[i]<((i+1U)*10U));
+
+				}
+
+			}
+
+			THEN("The same seed yields the same selection") {
+
+				CHECK(kinfu::random_samples(size,100,0)==samples);
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO("kinfu::normal_space_samples distributes samples between normal directions","[kinfu][correspondence_sampling][normal_space_samples]") {
+
+	GIVEN("A map wherein most normals face one direction, a few face another, and some pixels are invalid") {
+
+		std::vector<kinfu::pixel> map;
+		for (std::size_t i=0;i<90;++i) map.push_back(kinfu::pixel{Eigen::Vector3f(0.0f,0.0f,1.0f),Eigen::Vector3f(0.0f,0.0f,-1.0f)});
+		for (std::size_t i=0;i<10;++i) map.push_back(kinfu::pixel{Eigen::Vector3f(0.0f,0.0f,1.0f),Eigen::Vector3f(1.0f,0.0f,0.0f)});
+		auto nan=std::numeric_limits<float>::quiet_NaN();
+		for (std::size_t i=0;i<10;++i) map.push_back(kinfu::pixel{Eigen::Vector3f(nan,nan,nan),Eigen::Vector3f(nan,nan,nan)});
+
+		WHEN("kinfu::normal_space_samples is used to select 20 pixels") {
+
+			auto samples=kinfu::normal_space_samples(map,20,0);
+
+			THEN("Both directions are equally represented and no invalid pixels are selected") {
+
+				REQUIRE(samples.size()==20U);
+				CHECK(std::is_sorted(samples.begin(),samples.end()));
+				CHECK(std::set<std::uint32_t>(samples.begin(),samples.end()).size()==20U);
+				auto minority=std::count_if(samples.begin(),samples.end(),[] (auto i) noexcept {	return (i>=90U) && (i<100U);	});
+				CHECK(minority==10);
+				CHECK(std::none_of(samples.begin(),samples.end(),[] (auto i) noexcept {	return i>=100U;	}));
+
+			}
+
+		}
+
+	}
+
+}
@@ -92,3 +92,44 @@ SCENARIO_METHOD(fixture,"kinfu::file_system_opencl_program_factory instances ret
 	}
 	
 }
+
+
+SCENARIO_METHOD(fixture,"kinfu::file_system_opencl_program_factory instances pass options to the OpenCL compiler","[kinfu][opencl_program_factory][file_system_opencl_program_factory]") {
+	
+	GIVEN("A kinfu::file_system_opencl_program_factory") {
+		
+		kinfu::file_system_opencl_program_factory f(std::move(p),std::move(ctx));
+		
+		THEN("Attempting to retrieve a program which only compiles when a certain macro is defined fails without options") {
+			
+			CHECK_THROWS(f("options"));
+			
+		}
+		
+		THEN("Attempting to retrieve a program which only compiles when a certain macro is defined succeeds when that macro is defined by the options") {
+			
+			CHECK_NOTHROW(f("options","-DREQUIRED=1"));
+			
+		}
+		
+	}
+	
+}
+
+
+SCENARIO_METHOD(fixture,"kinfu::file_system_opencl_program_factory instances allow programs to include files from the same directory","[kinfu][opencl_program_factory][file_system_opencl_program_factory]") {
+	
+	GIVEN("A kinfu::file_system_opencl_program_factory") {
+		
+		kinfu::file_system_opencl_program_factory f(std::move(p),std::move(ctx));
+		
+		THEN("Attempting to retrieve a program which includes a file from the same directory succeeds both with and without options") {
+			
+			CHECK_NOTHROW(f("include"));
+			CHECK_NOTHROW(f("include","-DUNUSED=1"));
+			
+		}
+		
+	}
+	
+}
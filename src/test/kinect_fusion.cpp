@@ -1,7 +1,23 @@
 #include <kinfu/kinect_fusion.hpp>
 
 
+#include <boost/compute.hpp>
+#include <kinfu/file_system_depth_device.hpp>
+#include <kinfu/file_system_opencl_program_factory.hpp>
+#include <kinfu/filesystem.hpp>
+#include <kinfu/kinect_fusion_opencl_measurement_pipeline_block.hpp>
+#include <kinfu/kinect_fusion_opencl_pose_estimation_pipeline_block.hpp>
+#include <kinfu/kinect_fusion_opencl_surface_prediction_pipeline_block.hpp>
+#include <kinfu/kinect_fusion_opencl_update_reconstruction_pipeline_block.hpp>
+#include <kinfu/msrc_file_system_depth_device.hpp>
+#include <kinfu/opencl_depth_device.hpp>
+#include <kinfu/path.hpp>
+#include <kinfu/pixel.hpp>
+#include <Eigen/Dense>
+#include <cmath>
+#include <cstddef>
 #include <stdexcept>
+#include <vector>
 #include <catch.hpp>
 
 
@@ -20,3 +36,201 @@ SCENARIO("kinfu::kinect_fusion objects reject attempts to invoke them when the p
 	}
 
 }
+
+
+namespace {
+
+
+	class fixture {
+
+
+		private:
+
+
+			static kinfu::filesystem::path curr_dir () {
+
+				return kinfu::filesystem::path(kinfu::current_executable_parent_path());
+
+			}
+
+
+			static kinfu::filesystem::path cl_path () {
+
+				auto retr=curr_dir();
+				retr/="..";
+				retr/="cl";
+
+				return retr;
+
+			}
+
+
+			static kinfu::filesystem::path frames_path () {
+
+				auto retr=curr_dir();
+				retr/="..";
+				retr/="data/test/kinect_fusion_eigen_pose_estimation_pipeline_block";
+
+				return retr;
+
+			}
+
+
+		public:
+
+
+			class pipeline {
+
+
+				public:
+
+
+					kinfu::file_system_depth_device ddi;
+					kinfu::opencl_depth_device dd;
+					kinfu::kinect_fusion_opencl_measurement_pipeline_block mpb;
+					kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block pepb;
+					kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block urpb;
+					kinfu::kinect_fusion_opencl_surface_prediction_pipeline_block sppb;
+					kinfu::kinect_fusion kf;
+
+
+					pipeline (fixture & f, boost::compute::command_queue mq)
+						:	ddi(frames_path(),f.ff,&f.f),
+							dd(ddi,mq),
+							mpb(mq,f.pf,16,2.0f,1.0f),
+							pepb(f.q,f.pf,0.1f,std::sin(20.0f*3.14159f/180.0f),f.width,f.height,f.t_gk_initial,15,f.group_size),
+							urpb(f.q,f.pf,f.mu,f.tsdf_size,f.tsdf_size,f.tsdf_size),
+							sppb(f.q,f.pf,f.mu,f.tsdf_size,3.0f,f.width,f.height)
+					{
+
+						kf.depth_device(dd);
+						kf.measurement_pipeline_block(mpb);
+						kf.pose_estimation_pipeline_block(pepb);
+						kf.update_reconstruction_pipeline_block(urpb);
+						kf.surface_prediction_pipeline_block(sppb);
+
+					}
+
+
+			};
+
+
+			boost::compute::device dev;
+			boost::compute::context ctx;
+			boost::compute::command_queue q;
+			boost::compute::command_queue mq;
+			std::size_t width;
+			std::size_t height;
+			Eigen::Matrix4f t_gk_initial;
+			std::size_t group_size;
+			float mu;
+			std::size_t tsdf_size;
+			kinfu::file_system_opencl_program_factory pf;
+			kinfu::msrc_file_system_depth_device_frame_factory ff;
+			kinfu::msrc_file_system_depth_device_filter f;
+
+
+			fixture ()
+				:	dev(boost::compute::system::default_device()),
+					ctx(dev),
+					q(ctx,dev),
+					mq(ctx,dev),
+					width(640),
+					height(480),
+					t_gk_initial(Eigen::Matrix4f::Identity()),
+					group_size(dev.get_info<std::size_t>(CL_DEVICE_MAX_WORK_GROUP_SIZE)),
+					mu(0.03f),
+					tsdf_size(64),
+					pf(cl_path(),ctx)
+			{
+
+				t_gk_initial(0,3)=1.5f;
+				t_gk_initial(1,3)=1.5f;
+				t_gk_initial(2,3)=1.5f;
+
+				if (group_size>16) group_size=16;
+
+			}
+
+
+	};
+
+
+}
+
+
+SCENARIO_METHOD(fixture,"kinfu::kinect_fusion objects produce the same results whether or not pipelined execution is enabled","[kinfu][kinect_fusion]") {
+
+	GIVEN("A kinfu::kinect_fusion with pipelined execution disabled and a kinfu::kinect_fusion with pipelined execution enabled whose measurement pipeline block uses a separate command queue") {
+
+		pipeline serial(*this,q);
+		pipeline pipelined(*this,mq);
+		pipelined.kf.pipelined(true);
+		REQUIRE(pipelined.kf.pipelined());
+		REQUIRE_FALSE(serial.kf.pipelined());
+
+		WHEN("Both are invoked for each frame in the same sequence") {
+
+			std::vector<Eigen::Matrix4f> serial_poses;
+			std::vector<Eigen::Matrix4f> pipelined_poses;
+			for (std::size_t i=0;i<3;++i) {
+
+				serial.kf();
+				serial_poses.push_back(serial.kf.pose_estimation().get());
+				pipelined.kf();
+				pipelined_poses.push_back(pipelined.kf.pose_estimation().get());
+
+			}
+
+			THEN("The pose estimations are the same") {
+
+				for (std::size_t i=0;i<3;++i) CHECK(serial_poses[i].isApprox(pipelined_poses[i],1e-5f));
+
+			}
+
+			THEN("The truncated signed distance functions are the same") {
+
+				auto && a=serial.kf.truncated_signed_distance_function().get();
+				auto && b=pipelined.kf.truncated_signed_distance_function().get();
+				REQUIRE(a.size()==b.size());
+				std::size_t mismatched=0;
+				for (std::size_t i=0;i<a.size();++i) {
+
+					float x(a[i]);
+					float y(b[i]);
+					if (std::isnan(x) && std::isnan(y)) continue;
+					if (std::abs(x-y)>1e-3f) ++mismatched;
+
+				}
+				CHECK(mismatched==0);
+
+			}
+
+			THEN("The vertex and normal maps correspond to the same frame") {
+
+				auto && a=serial.kf.vertex_and_normal_map().get();
+				auto && b=pipelined.kf.vertex_and_normal_map().get();
+				REQUIRE(a.size()==b.size());
+				std::size_t mismatched=0;
+				for (std::size_t i=0;i<a.size();++i) {
+
+					if (std::isnan(a[i].v(2)) && std::isnan(b[i].v(2))) continue;
+					if (!a[i].v.isApprox(b[i].v,1e-5f)) ++mismatched;
+
+				}
+				CHECK(mismatched==0);
+
+			}
+
+			THEN("An exception encountered while obtaining the next frame is deferred to the next invocation") {
+
+				CHECK_THROWS_AS(serial.kf(),kinfu::file_system_depth_device::end);
+				CHECK_THROWS_AS(pipelined.kf(),kinfu::file_system_depth_device::end);
+
+			}
+
+		}
+
+	}
+
+}
@@ -0,0 +1,150 @@
+#include <kinfu/kinect_fusion_opencl_hashed_surface_prediction_pipeline_block.hpp>
+
+
+#include <boost/compute.hpp>
+#include <kinfu/cpu_pipeline_value.hpp>
+#include <kinfu/kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block.hpp>
+#include <kinfu/kinect_fusion_opencl_surface_prediction_pipeline_block.hpp>
+#include <kinfu/kinect_fusion_opencl_update_reconstruction_pipeline_block.hpp>
+#include <kinfu/msrc_file_system_depth_device.hpp>
+#include <kinfu/file_system_depth_device.hpp>
+#include <kinfu/file_system_opencl_program_factory.hpp>
+#include <kinfu/opencl_depth_device.hpp>
+#include <kinfu/filesystem.hpp>
+#include <kinfu/path.hpp>
+#include <kinfu/pixel.hpp>
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cstddef>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include <catch.hpp>
+
+
+namespace {
+
+
+	class fixture {
+
+		private:
+
+			static kinfu::filesystem::path cl_path () {
+
+				kinfu::filesystem::path retr(kinfu::current_executable_parent_path());
+				retr/="..";
+				retr/="cl";
+
+				return retr;
+
+			}
+
+		protected:
+
+			boost::compute::device dev;
+			boost::compute::context ctx;
+			boost::compute::command_queue q;
+			std::size_t width;
+			std::size_t height;
+			Eigen::Matrix3f k;
+			Eigen::Matrix4f t_g_k;
+			kinfu::file_system_opencl_program_factory fsopf;
+			std::size_t tsdf_size;
+
+		public:
+
+		fixture () : dev(boost::compute::system::default_device()), ctx(dev), q(ctx,dev), width(640), height(480), fsopf(cl_path(),ctx), tsdf_size(128) {
+
+				k << 585.0f, 0.0f, 320.0f,
+					 0.0f, 585.0f, 240.0f,
+					 0.0f, 0.0f, 1.0f;
+
+				t_g_k = Eigen::Matrix4f::Identity();
+				t_g_k(0,3) = 1.5f;
+				t_g_k(1,3) = 1.5f;
+				t_g_k(2,3) = 1.5f;
+
+			}
+
+	};
+
+
+}
+
+
+static bool is_nan (const Eigen::Vector3f & v) noexcept {
+
+	return std::isnan(v(0)) && std::isnan(v(1)) && std::isnan(v(2));
+
+}
+
+
+SCENARIO_METHOD(fixture, "kinfu::kinect_fusion_opencl_hashed_surface_prediction_pipeline_block objects predict essentially the same surface from a hashed TSDF as kinfu::kinect_fusion_opencl_surface_prediction_pipeline_block objects predict from a dense TSDF","[kinfu][surface_prediction_pipeline_block][kinect_fusion_opencl_hashed_surface_prediction_pipeline_block]") {
+
+	GIVEN("A hashed TSDF and a dense TSDF with the same voxel size into which the same frame has been integrated") {
+
+		float mu = 0.1f;
+		float extent = 3.0f;
+		float voxel_size = extent / float(tsdf_size);
+
+		kinfu::kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block hashed_urpb(q, fsopf, mu, voxel_size, tsdf_size, tsdf_size, tsdf_size);
+		kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block dense_urpb(q, fsopf, mu, tsdf_size, tsdf_size, tsdf_size);
+
+		kinfu::filesystem::path pp(kinfu::current_executable_parent_path());
+		kinfu::msrc_file_system_depth_device_frame_factory ff;
+		kinfu::msrc_file_system_depth_device_filter f;
+		kinfu::file_system_depth_device ddi(pp/".."/"data/test/tsdf_viewer/",ff,&f);
+		kinfu::opencl_depth_device dd(ddi,q);
+		auto frame = dd();
+
+		kinfu::cpu_pipeline_value<Eigen::Matrix4f> t_g_k_pv;
+		t_g_k_pv.emplace(t_g_k);
+		auto hashed_tsdf = hashed_urpb(*frame, width, height, k, t_g_k_pv);
+		auto dense_tsdf = dense_urpb(*frame, width, height, k, t_g_k_pv);
+
+		WHEN("Each is raycast from the pose from which the frame was captured") {
+
+			kinfu::kinect_fusion_opencl_hashed_surface_prediction_pipeline_block hashed_sppb(q, fsopf, width, height);
+			kinfu::kinect_fusion_opencl_surface_prediction_pipeline_block dense_sppb(q, fsopf, mu, tsdf_size, extent, width, height);
+			kinfu::cpu_pipeline_value<std::vector<kinfu::pixel>> prev;
+			prev.emplace();
+			auto hashed_ptr = hashed_sppb(*hashed_tsdf.buffer, hashed_tsdf.width, hashed_tsdf.height, hashed_tsdf.depth, t_g_k_pv, k, prev, {});
+			auto dense_ptr = dense_sppb(*dense_tsdf.buffer, dense_tsdf.width, dense_tsdf.height, dense_tsdf.depth, t_g_k_pv, k, prev, {});
+
+			THEN("The hashed map is remotely sane and the vertices found by both are within two voxels of each other") {
+
+				auto && hashed_map = hashed_ptr->get();
+				auto && dense_map = dense_ptr->get();
+				REQUIRE(hashed_map.size() == (width * height));
+				REQUIRE(dense_map.size() == hashed_map.size());
+
+				Eigen::Vector3f nullv(0,0,0);
+				auto nulls=std::count_if(hashed_map.begin(),hashed_map.end(),[&] (const auto & p) noexcept {	return !is_nan(p.n) && (p.n==nullv);	});
+				CHECK(nulls==0);
+
+				std::size_t hashed_valid(0);
+				std::size_t dense_valid(0);
+				std::size_t both(0);
+				std::size_t close(0);
+				for (std::size_t i = 0; i < hashed_map.size(); ++i) {
+
+					bool h = !is_nan(hashed_map[i].v);
+					bool d = !is_nan(dense_map[i].v);
+					if (h) ++hashed_valid;
+					if (d) ++dense_valid;
+					if (!(h && d)) continue;
+					++both;
+					if ((hashed_map[i].v - dense_map[i].v).norm() <= (2.0f * voxel_size)) ++close;
+
+				}
+				CHECK(hashed_valid > 0U);
+				CHECK(both >= ((dense_valid * 9U) / 10U));
+				CHECK(close >= ((both * 95U) / 100U));
+
+			}
+
+		}
+
+	}
+
+}
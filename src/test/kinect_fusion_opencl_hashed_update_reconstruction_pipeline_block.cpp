@@ -0,0 +1,169 @@
+#include <kinfu/kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block.hpp>
+#include <kinfu/kinect_fusion_opencl_update_reconstruction_pipeline_block.hpp>
+#include <kinfu/msrc_file_system_depth_device.hpp>
+#include <kinfu/file_system_depth_device.hpp>
+#include <kinfu/file_system_opencl_program_factory.hpp>
+#include <kinfu/opencl_voxel_hash_pipeline_value.hpp>
+#include <boost/compute.hpp>
+#include <kinfu/cpu_pipeline_value.hpp>
+#include <kinfu/filesystem.hpp>
+#include <kinfu/path.hpp>
+#include <Eigen/Dense>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+#include <catch.hpp>
+
+
+namespace {
+
+
+	class fixture {
+
+		private:
+
+			static kinfu::filesystem::path cl_path () {
+
+				kinfu::filesystem::path retr(kinfu::current_executable_parent_path());
+				retr/="..";
+				retr/="cl";
+
+				return retr;
+
+			}
+
+		protected:
+
+			boost::compute::device dev;
+			boost::compute::context ctx;
+			boost::compute::command_queue q;
+			std::size_t width;
+			std::size_t height;
+			Eigen::Matrix3f k;
+			kinfu::cpu_pipeline_value<Eigen::Matrix4f> t_g_k;
+			kinfu::file_system_opencl_program_factory fsopf;
+			kinfu::cpu_pipeline_value<std::vector<float>> pv;
+
+		public:
+
+		fixture () : dev(boost::compute::system::default_device()), ctx(dev), q(ctx,dev), width(640), height(480), fsopf(cl_path(),ctx) {
+
+				k << 585.0f, 0.0f, 320.0f,
+					 0.0f, 585.0f, 240.0f,
+					 0.0f, 0.0f, 1.0f;
+
+				Eigen::Matrix4f t_g_k(Eigen::Matrix4f::Identity());
+				t_g_k(0,3) = 1.5f;
+				t_g_k(1,3) = 1.5f;
+				t_g_k(2,3) = 1.5f;
+				this->t_g_k.emplace(std::move(t_g_k));
+
+				kinfu::filesystem::path pp(kinfu::current_executable_parent_path());
+				kinfu::msrc_file_system_depth_device_frame_factory ff;
+				kinfu::msrc_file_system_depth_device_filter f;
+				kinfu::file_system_depth_device ddi(pp/".."/"data/test/msrc_file_system_depth_device",ff,&f);
+				pv.emplace(ddi()->get());
+
+			}
+
+	};
+
+
+}
+
+
+SCENARIO_METHOD(fixture, "kinfu::kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block objects allocate bricks only near observed surfaces","[kinfu][update_reconstruction_pipeline_block][kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block]") {
+
+	GIVEN("A kinfu::kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block") {
+
+		kinfu::kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block kfohurpb(q, fsopf, 0.03f, 3.0f / 64.0f, 64, 64, 64, 4096, 16384);
+
+		WHEN("It integrates a frame") {
+
+			auto v = kfohurpb(pv, width, height, k, t_g_k);
+
+			THEN("A kinfu::opencl_voxel_hash_pipeline_value is produced in which some but not all of the bricks which would cover a dense TSDF are allocated") {
+
+				REQUIRE(v.buffer);
+				auto && hash = dynamic_cast<kinfu::opencl_voxel_hash_pipeline_value &>(*v.buffer);
+				CHECK(v.width == 64U);
+				CHECK(v.height == 64U);
+				CHECK(v.depth == 64U);
+				CHECK(hash.allocated() > 0U);
+				//	A dense 64^3 TSDF would consist of 8^3 bricks
+				CHECK(hash.allocated() < 512U);
+
+			}
+
+		}
+
+		WHEN("It integrates a frame twice, is reset, and integrates the frame once more") {
+
+			auto v = kfohurpb(pv, width, height, k, t_g_k);
+			std::vector<float> once;
+			for (auto && t : v.buffer->get()) once.push_back(t);
+			v = kfohurpb(pv, width, height, k, t_g_k, std::move(v));
+			auto ptr = v.buffer.get();
+			kfohurpb.reset();
+			v = kfohurpb(pv, width, height, k, t_g_k, std::move(v));
+
+			THEN("The same TSDF is produced as when the frame was integrated once without reallocating it") {
+
+				CHECK(v.buffer.get() == ptr);
+				auto && tsdf = v.buffer->get();
+				REQUIRE(tsdf.size() == once.size());
+				std::size_t mismatches(0);
+				for (std::size_t i = 0; i < tsdf.size(); ++i) if (float(tsdf[i]) != once[i]) ++mismatches;
+				CHECK(mismatches == 0U);
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO_METHOD(fixture, "kinfu::kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block objects produce essentially the same TSDF near surfaces as kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block objects","[kinfu][update_reconstruction_pipeline_block][kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block]") {
+
+	GIVEN("A kinfu::kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block and a kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block with the same voxel size") {
+
+		kinfu::kinect_fusion_opencl_hashed_update_reconstruction_pipeline_block hashed(q, fsopf, 0.03f, 3.0f / 64.0f, 64, 64, 64, 4096, 16384);
+		kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block dense(q, fsopf, 0.03f, 64, 64, 64);
+
+		WHEN("Both integrate the same frame twice") {
+
+			auto a = hashed(pv, width, height, k, t_g_k);
+			a = hashed(pv, width, height, k, t_g_k, std::move(a));
+			auto b = dense(pv, width, height, k, t_g_k);
+			b = dense(pv, width, height, k, t_g_k, std::move(b));
+
+			THEN("Every voxel within the truncation region of the dense TSDF matches within 0.01 (voxels beyond the truncation region may be unallocated in the hashed TSDF)") {
+
+				auto && a_tsdf = a.buffer->get();
+				auto && b_tsdf = b.buffer->get();
+				REQUIRE(a_tsdf.size() == b_tsdf.size());
+				std::size_t near(0);
+				std::size_t mismatches(0);
+				for (std::size_t i = 0; i < b_tsdf.size(); ++i) {
+
+					float expected(b_tsdf[i]);
+					if (std::isnan(expected) || !(expected < 1.0f)) continue;
+					++near;
+					if (!(std::abs(float(a_tsdf[i]) - expected) <= 0.01f)) ++mismatches;
+
+				}
+				CHECK(near > 0U);
+				CHECK(mismatches <= (near / 100U));
+
+			}
+
+		}
+
+	}
+
+}
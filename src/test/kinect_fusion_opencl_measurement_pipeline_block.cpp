@@ -8,6 +8,7 @@
 #include <kinfu/file_system_opencl_program_factory.hpp>
 #include <kinfu/filesystem.hpp>
 #include <kinfu/msrc_file_system_depth_device.hpp>
+#include <kinfu/opencl_vector_pyramid_pipeline_value.hpp>
 #include <kinfu/path.hpp>
 #include <kinfu/pixel.hpp>
 #include <Eigen/Dense>
@@ -240,3 +241,112 @@ SCENARIO_METHOD(fixture,"The vertices returned by a kinfu::kinect_fusion_opencl_
 	}
 
 }
+
+
+SCENARIO_METHOD(fixture,"kinfu::kinect_fusion_opencl_measurement_pipeline_block objects produce the same results whether or not the tiled bilateral filter is used","[kinfu][measurement_pipeline_block][kinect_fusion_opencl_measurement_pipeline_block]") {
+
+	GIVEN("A kinfu::kinect_fusion_opencl_measurement_pipeline_block which uses the tiled bilateral filter and one which does not") {
+
+		kinfu::kinect_fusion_opencl_measurement_pipeline_block a(q, fsopf, 16, 2.0f, 1.0f);
+		kinfu::kinect_fusion_opencl_measurement_pipeline_block b(q, fsopf, 16, 2.0f, 1.0f);
+		a.tiled(false);
+		CHECK_FALSE(a.tiled());
+		CHECK(b.tiled());
+
+		WHEN("They are run on the same depth frame") {
+
+			auto frame_ptr=dd();
+			auto k=dd.k();
+			auto h=dd.height();
+			auto w=dd.width();
+			auto a_ptr=a(*frame_ptr,w,h,k);
+			auto b_ptr=b(*frame_ptr,w,h,k);
+
+			THEN("The vertex and normal maps match within 0.001") {
+
+				auto && a_map=a_ptr->get();
+				auto && b_map=b_ptr->get();
+				REQUIRE(a_map.size()==b_map.size());
+				auto close=[] (const Eigen::Vector3f & a, const Eigen::Vector3f & b) noexcept {
+
+					if (std::isnan(a(0))) return bool(std::isnan(b(0)));
+
+					return (a-b).isZero(0.001f);
+
+				};
+				std::size_t mismatches(0);
+				for (std::size_t i=0;i<a_map.size();++i) if (!(close(a_map[i].v,b_map[i].v) && close(a_map[i].n,b_map[i].n))) ++mismatches;
+				CHECK(mismatches==0U);
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO_METHOD(fixture,"kinfu::kinect_fusion_opencl_measurement_pipeline_block objects produce the same results whether or not the fused kernel is used","[kinfu][measurement_pipeline_block][kinect_fusion_opencl_measurement_pipeline_block]") {
+
+	GIVEN("A kinfu::kinect_fusion_opencl_measurement_pipeline_block which uses the fused kernel and one which does not") {
+
+		kinfu::kinect_fusion_opencl_measurement_pipeline_block a(q, fsopf, 16, 2.0f, 1.0f, 3);
+		kinfu::kinect_fusion_opencl_measurement_pipeline_block b(q, fsopf, 16, 2.0f, 1.0f, 3);
+		b.fused(true);
+		CHECK(b.fused());
+
+		WHEN("They are run on the same depth frame") {
+
+			auto frame_ptr=dd();
+			auto k=dd.k();
+			auto h=dd.height();
+			auto w=dd.width();
+			auto a_ptr=a(*frame_ptr,w,h,k);
+			auto b_ptr=b(*frame_ptr,w,h,k);
+
+			THEN("The vertex and normal maps match within 0.001") {
+
+				auto && a_map=a_ptr->get();
+				auto && b_map=b_ptr->get();
+				REQUIRE(a_map.size()==b_map.size());
+				auto close=[] (const Eigen::Vector3f & a, const Eigen::Vector3f & b) noexcept {
+
+					if (std::isnan(a(0))) return bool(std::isnan(b(0)));
+
+					return (a-b).isZero(0.001f);
+
+				};
+				std::size_t mismatches(0);
+				for (std::size_t i=0;i<a_map.size();++i) if (!(close(a_map[i].v,b_map[i].v) && close(a_map[i].n,b_map[i].n))) ++mismatches;
+				CHECK(mismatches==0U);
+
+			}
+
+			THEN("The coarsest vertex maps, which are generated from the filtered depth, match within 0.001") {
+
+				using pv_type=kinfu::opencl_vector_pyramid_pipeline_value<kinfu::pixel>;
+				auto && a_level=dynamic_cast<pv_type &>(*a_ptr).level(2);
+				auto && b_level=dynamic_cast<pv_type &>(*b_ptr).level(2);
+				REQUIRE(a_level.size()==b_level.size());
+				std::vector<kinfu::pixel> a_map(a_level.size());
+				std::vector<kinfu::pixel> b_map(b_level.size());
+				q.enqueue_read_buffer(a_level.get_buffer(),0,a_map.size()*sizeof(kinfu::pixel),a_map.data());
+				q.enqueue_read_buffer(b_level.get_buffer(),0,b_map.size()*sizeof(kinfu::pixel),b_map.data());
+				std::size_t mismatches(0);
+				for (std::size_t i=0;i<a_map.size();++i) {
+
+					auto && av=a_map[i].v;
+					auto && bv=b_map[i].v;
+					if (std::isnan(av(0)) ? !std::isnan(bv(0)) : !(av-bv).isZero(0.001f)) ++mismatches;
+
+				}
+				CHECK(mismatches==0U);
+
+			}
+
+		}
+
+	}
+
+}
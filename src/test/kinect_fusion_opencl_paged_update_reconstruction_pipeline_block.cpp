@@ -0,0 +1,153 @@
+#include <kinfu/kinect_fusion_opencl_paged_update_reconstruction_pipeline_block.hpp>
+#include <kinfu/kinect_fusion_opencl_update_reconstruction_pipeline_block.hpp>
+#include <kinfu/msrc_file_system_depth_device.hpp>
+#include <kinfu/file_system_depth_device.hpp>
+#include <kinfu/file_system_opencl_program_factory.hpp>
+#include <kinfu/opencl_paged_voxel_pipeline_value.hpp>
+#include <boost/compute.hpp>
+#include <kinfu/cpu_pipeline_value.hpp>
+#include <kinfu/filesystem.hpp>
+#include <kinfu/path.hpp>
+#include <Eigen/Dense>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+#include <catch.hpp>
+
+
+namespace {
+
+
+	class fixture {
+
+		private:
+
+			static kinfu::filesystem::path cl_path () {
+
+				kinfu::filesystem::path retr(kinfu::current_executable_parent_path());
+				retr/="..";
+				retr/="cl";
+
+				return retr;
+
+			}
+
+		protected:
+
+			boost::compute::device dev;
+			boost::compute::context ctx;
+			boost::compute::command_queue q;
+			std::size_t width;
+			std::size_t height;
+			Eigen::Matrix3f k;
+			kinfu::cpu_pipeline_value<Eigen::Matrix4f> a;
+			kinfu::cpu_pipeline_value<Eigen::Matrix4f> b;
+			kinfu::file_system_opencl_program_factory fsopf;
+			kinfu::cpu_pipeline_value<std::vector<float>> pv;
+			kinfu::filesystem::path path;
+
+		public:
+
+		fixture () : dev(boost::compute::system::default_device()), ctx(dev), q(ctx,dev), width(640), height(480), fsopf(cl_path(),ctx), path(kinfu::filesystem::temp_directory_path()/"kinfu_paged_update_reconstruction_test.tsdf") {
+
+				k << 585.0f, 0.0f, 320.0f,
+					 0.0f, 585.0f, 240.0f,
+					 0.0f, 0.0f, 1.0f;
+
+				Eigen::Matrix4f t_g_k(Eigen::Matrix4f::Identity());
+				t_g_k(0,3) = 1.5f;
+				t_g_k(1,3) = 1.5f;
+				t_g_k(2,3) = 1.6f;
+				a.emplace(t_g_k);
+				//	With a maximum depth of 1m the view frustum from
+				//	the first pose intersects 8 chunks and the view
+				//	frustum from this pose intersects 4 other chunks
+				t_g_k(0,3) = 0.2f;
+				t_g_k(1,3) = 0.2f;
+				t_g_k(2,3) = 0.2f;
+				b.emplace(t_g_k);
+
+				kinfu::filesystem::path pp(kinfu::current_executable_parent_path());
+				kinfu::msrc_file_system_depth_device_frame_factory ff;
+				kinfu::msrc_file_system_depth_device_filter f;
+				kinfu::file_system_depth_device ddi(pp/".."/"data/test/msrc_file_system_depth_device",ff,&f);
+				pv.emplace(ddi()->get());
+
+			}
+
+			~fixture () noexcept {
+
+				kinfu::filesystem::remove(path);
+
+			}
+
+	};
+
+
+}
+
+
+SCENARIO_METHOD(fixture, "kinfu::kinect_fusion_opencl_paged_update_reconstruction_pipeline_block objects produce the same TSDF as kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block objects while paging chunks in and out","[kinfu][update_reconstruction_pipeline_block][kinect_fusion_opencl_paged_update_reconstruction_pipeline_block]") {
+
+	GIVEN("A kinfu::kinect_fusion_opencl_paged_update_reconstruction_pipeline_block whose chunks do not all fit on the GPU and a kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block with the same maximum depth") {
+
+		kinfu::kinect_fusion_opencl_paged_update_reconstruction_pipeline_block paged(q, fsopf, 0.03f, path, 64, 64, 64, 3.0f, 3.0f, 3.0f, 16, 8);
+		paged.max_depth(1.0f);
+		kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block dense(q, fsopf, 0.03f, 64, 64, 64);
+		dense.max_depth(1.0f);
+		dense.sweep(false);
+
+		WHEN("Both integrate the same frame from one pose, then another pose, then the first pose again") {
+
+			auto x = paged(pv, width, height, k, a);
+			x = paged(pv, width, height, k, b, std::move(x));
+			x = paged(pv, width, height, k, a, std::move(x));
+			auto y = dense(pv, width, height, k, a);
+			y = dense(pv, width, height, k, b, std::move(y));
+			y = dense(pv, width, height, k, a, std::move(y));
+
+			THEN("A kinfu::opencl_paged_voxel_pipeline_value backed by a file large enough for every chunk is produced") {
+
+				REQUIRE(x.buffer);
+				auto && paged_pv = dynamic_cast<kinfu::opencl_paged_voxel_pipeline_value &>(*x.buffer);
+				CHECK(x.width == 64U);
+				CHECK(x.height == 64U);
+				CHECK(x.depth == 64U);
+				CHECK(paged_pv.chunks_x() == 4U);
+				CHECK(paged_pv.chunks_y() == 4U);
+				CHECK(paged_pv.chunks_z() == 4U);
+				CHECK(paged_pv.resident() > 0U);
+				CHECK(paged_pv.resident() == 8U);
+				CHECK(kinfu::filesystem::file_size(path) == (64U * 16U * 16U * 16U * 3U));
+
+			}
+
+			THEN("Every voxel matches within 0.01 (allowing for rare differences in rounding to the nearest pixel)") {
+
+				auto && x_tsdf = x.buffer->get();
+				auto && y_tsdf = y.buffer->get();
+				REQUIRE(x_tsdf.size() == y_tsdf.size());
+				std::size_t updated(0);
+				std::size_t mismatches(0);
+				for (std::size_t i = 0; i < y_tsdf.size(); ++i) {
+
+					float expected(y_tsdf[i]);
+					float actual(x_tsdf[i]);
+					if (expected != 1.0f) ++updated;
+					if (std::isnan(expected) && std::isnan(actual)) continue;
+					if (!(std::abs(actual - expected) <= 0.01f)) ++mismatches;
+
+				}
+				CHECK(updated > 0U);
+				CHECK(mismatches <= (updated / 1000U));
+
+			}
+
+		}
+
+	}
+
+}
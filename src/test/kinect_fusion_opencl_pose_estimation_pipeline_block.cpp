@@ -187,11 +187,6 @@ SCENARIO_METHOD(fixture,"The constructor of kinfu::kinect_fusion_opencl_pose_est
 
 	}
 
-	WHEN("kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block is constructed with a group size which does not evenly divide the frame size an exception is thrown") {
-
-		CHECK_THROWS_AS(kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block(q,pf,0.10f,std::sin(20.0f*3.14159f/180.0f),width,height,t_gk_initial,iterations,19),std::logic_error);
-
-	}
 
 	WHEN("kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block is constructed with a group size which is greater than the frame size an exception is thrown") {
 
@@ -210,6 +205,18 @@ SCENARIO_METHOD(fixture,"The constructor of kinfu::kinect_fusion_opencl_pose_est
 
 	}
 
+	WHEN("kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block is constructed with no pyramid levels") {
+
+		CHECK_THROWS_AS(kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block(q,pf,0.10f,std::sin(20.0f*3.14159f/180.0f),width,height,t_gk_initial,std::vector<std::size_t>{},group_size),std::logic_error);
+
+	}
+
+	WHEN("kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block is constructed with zero iterations at each pyramid level") {
+
+		CHECK_THROWS_AS(kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block(q,pf,0.10f,std::sin(20.0f*3.14159f/180.0f),width,height,t_gk_initial,std::vector<std::size_t>{0,0,0},group_size),std::logic_error);
+
+	}
+
 }
 
 
@@ -268,6 +275,247 @@ SCENARIO_METHOD(fixture,"kinfu::kinect_fusion_opencl_pose_estimation_pipeline_bl
 
 }
 
+SCENARIO_METHOD(fixture,"kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block objects accept group sizes which do not evenly divide the frame size","[kinfu][pose_estimation_pipeline_block][kinect_fusion_opencl_pose_estimation_pipeline_block]") {
+
+	GIVEN("A kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block object with a group size which does not evenly divide the frame size") {
+
+		kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block pepb(q,pf,0.10f,std::sin(20.0f*3.14159f/180.0f),width,height,t_gk_initial,iterations,std::min<std::size_t>(group_size,7));
+
+		WHEN("It is invoked on two identical sets of vertices and normals") {
+
+			auto frame_ptr=dd();
+			auto m_ptr=mpb(*frame_ptr,width,height,k);
+			auto ptr=pepb(*m_ptr,nullptr,k,{});
+			kinfu::cpu_pipeline_value<std::vector<kinfu::pixel>> pv;
+			pv.emplace(to_global(m_ptr->get()));
+			ptr=pepb(*m_ptr,&pv,k,std::move(ptr));
+
+			THEN("The resulting T_gk matrix is an identity matrix with the translation components from the initial T_gk matrix") {
+
+				auto t_gk=ptr->get();
+				auto diff=t_gk-t_gk_initial;
+				CHECK(diff.isZero());
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO_METHOD(fixture,"kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block objects stop iterating once the incremental transformation converges","[kinfu][pose_estimation_pipeline_block][kinect_fusion_opencl_pose_estimation_pipeline_block]") {
+
+	GIVEN("A kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block object") {
+
+		kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block pepb(q,pf,0.10f,std::sin(20.0f*3.14159f/180.0f),width,height,t_gk_initial,iterations,group_size);
+
+		THEN("It reports that it has performed no iterations") {
+
+			CHECK(pepb.iterations_performed()==0U);
+
+		}
+
+		WHEN("It is invoked on two identical sets of vertices and normals") {
+
+			auto frame_ptr=dd();
+			auto m_ptr=mpb(*frame_ptr,width,height,k);
+			auto ptr=pepb(*m_ptr,nullptr,k,{});
+			kinfu::cpu_pipeline_value<std::vector<kinfu::pixel>> pv;
+			pv.emplace(to_global(m_ptr->get()));
+			ptr=pepb(*m_ptr,&pv,k,std::move(ptr));
+
+			THEN("It reports that it has performed all iterations") {
+
+				CHECK(pepb.iterations_performed()==iterations);
+
+			}
+
+			AND_WHEN("Termination thresholds are set and it is invoked again") {
+
+				pepb.termination_thresholds(0.0001f,0.0001f);
+				ptr=pepb(*m_ptr,&pv,k,std::move(ptr));
+
+				THEN("It performs fewer iterations") {
+
+					CHECK(pepb.iterations_performed()<iterations);
+					CHECK(pepb.iterations_performed()>0U);
+
+				}
+
+				THEN("The resulting T_gk matrix is an identity matrix with the translation components from the initial T_gk matrix") {
+
+					auto t_gk=ptr->get();
+					auto diff=t_gk-t_gk_initial;
+					CHECK(diff.isZero());
+
+				}
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO_METHOD(fixture,"kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block objects which solve on the device derive the same transformation matrix as those which solve on the host","[kinfu][pose_estimation_pipeline_block][kinect_fusion_opencl_pose_estimation_pipeline_block]") {
+
+	GIVEN("Two kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block objects, one of which solves on the device") {
+
+		kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block host(q,pf,0.10f,std::sin(20.0f*3.14159f/180.0f),width,height,t_gk_initial,iterations,group_size);
+		kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block device(q,pf,0.10f,std::sin(20.0f*3.14159f/180.0f),width,height,t_gk_initial,iterations,group_size);
+		device.device_solve(true);
+		CHECK(device.device_solve());
+		CHECK_FALSE(host.device_solve());
+
+		WHEN("They are invoked on a set of vertices and normals, and a set of perturbed vertices and normals") {
+
+			auto frame_ptr=dd();
+			auto m_ptr=mpb(*frame_ptr,width,height,k);
+			auto host_ptr=host(*m_ptr,nullptr,k,{});
+			auto device_ptr=device(*m_ptr,nullptr,k,{});
+			kinfu::cpu_pipeline_value<std::vector<kinfu::pixel>> pv;
+			pv.emplace(perturb(to_global(m_ptr->get()),rand_perturbation()));
+			host_ptr=host(*m_ptr,&pv,k,std::move(host_ptr));
+			device_ptr=device(*m_ptr,&pv,k,std::move(device_ptr));
+
+			THEN("The resulting T_gk matrices are approximately equal") {
+
+				CHECK(device_ptr->get().isApprox(host_ptr->get(),1e-3f));
+
+			}
+
+			THEN("They report having performed the same number of iterations") {
+
+				CHECK(device.iterations_performed()==host.iterations_performed());
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO_METHOD(fixture,"kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block objects with the constant velocity motion model enabled track a stationary sensor","[kinfu][pose_estimation_pipeline_block][kinect_fusion_opencl_pose_estimation_pipeline_block]") {
+
+	GIVEN("A kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block object with the motion model enabled") {
+
+		kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block pepb(q,pf,0.10f,std::sin(20.0f*3.14159f/180.0f),width,height,t_gk_initial,iterations,group_size);
+		CHECK_FALSE(pepb.motion_model());
+		pepb.motion_model(true);
+		CHECK(pepb.motion_model());
+
+		WHEN("It is invoked repeatedly on two identical sets of vertices and normals") {
+
+			auto frame_ptr=dd();
+			auto m_ptr=mpb(*frame_ptr,width,height,k);
+			auto ptr=pepb(*m_ptr,nullptr,k,{});
+			kinfu::cpu_pipeline_value<std::vector<kinfu::pixel>> pv;
+			pv.emplace(to_global(m_ptr->get()));
+			ptr=pepb(*m_ptr,&pv,k,std::move(ptr));
+			ptr=pepb(*m_ptr,&pv,k,std::move(ptr));
+			ptr=pepb(*m_ptr,&pv,k,std::move(ptr));
+
+			THEN("The resulting T_gk matrix is an identity matrix with the translation components from the initial T_gk matrix") {
+
+				auto t_gk=ptr->get();
+				auto diff=t_gk-t_gk_initial;
+				CHECK(diff.isZero());
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO_METHOD(fixture,"kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block objects which sample pixels derive a transformation matrix between two identical frames that is the identity matrix with some set, constant, initial translation","[kinfu][pose_estimation_pipeline_block][kinect_fusion_opencl_pose_estimation_pipeline_block]") {
+
+	GIVEN("A kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block object") {
+
+		kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block pepb(q,pf,0.10f,std::sin(20.0f*3.14159f/180.0f),width,height,t_gk_initial,iterations,group_size);
+		CHECK(pepb.sampling()==kinfu::correspondence_sampling::all);
+
+		THEN("Requesting zero samples results in an exception") {
+
+			CHECK_THROWS_AS(pepb.sampling(kinfu::correspondence_sampling::stride,0),std::logic_error);
+
+		}
+
+		WHEN("It samples an eighth of the pixels using each strategy and is invoked on two identical sets of vertices and normals") {
+
+			auto frame_ptr=dd();
+			auto m_ptr=mpb(*frame_ptr,width,height,k);
+			kinfu::cpu_pipeline_value<std::vector<kinfu::pixel>> pv;
+			pv.emplace(to_global(m_ptr->get()));
+
+			THEN("The resulting T_gk matrix is an identity matrix with the translation components from the initial T_gk matrix") {
+
+				kinfu::correspondence_sampling strategies []={
+					kinfu::correspondence_sampling::stride,
+					kinfu::correspondence_sampling::random,
+					kinfu::correspondence_sampling::normal_space
+				};
+				for (auto strategy : strategies) {
+
+					pepb.sampling(strategy,(width*height)/8U);
+					CHECK(pepb.sampling()==strategy);
+					CHECK(pepb.samples()==((width*height)/8U));
+					auto ptr=pepb(*m_ptr,nullptr,k,{});
+					ptr=pepb(*m_ptr,&pv,k,std::move(ptr));
+					auto t_gk=ptr->get();
+					auto diff=t_gk-t_gk_initial;
+					CHECK(diff.isZero());
+
+				}
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO_METHOD(fixture,"kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block objects which iterate over a depth pyramid derive a transformation matrix between two identical frames that is the identity matrix with some set, constant, initial translation","[kinfu][pose_estimation_pipeline_block][kinect_fusion_opencl_pose_estimation_pipeline_block]") {
+
+	GIVEN("A kinfu::kinect_fusion_opencl_measurement_pipeline_block object which generates a depth pyramid and a kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block object which iterates coarse to fine") {
+
+		kinfu::kinect_fusion_opencl_measurement_pipeline_block pmpb(q,pf,16,2.0f,1.0f,3);
+		kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block pepb(q,pf,0.10f,std::sin(20.0f*3.14159f/180.0f),width,height,t_gk_initial,std::vector<std::size_t>{4,5,10},group_size);
+
+		WHEN("It is invoked on two identical sets of vertices and normals") {
+
+			auto frame_ptr=dd();
+			auto m_ptr=pmpb(*frame_ptr,width,height,k);
+			auto ptr=pepb(*m_ptr,nullptr,k,{});
+			kinfu::cpu_pipeline_value<std::vector<kinfu::pixel>> pv;
+			pv.emplace(to_global(m_ptr->get()));
+			ptr=pepb(*m_ptr,&pv,k,std::move(ptr));
+
+			THEN("The resulting T_gk matrix is an identity matrix with the translation components from the initial T_gk matrix") {
+
+				auto t_gk=ptr->get();
+				auto diff=t_gk-t_gk_initial;
+				CHECK(diff.isZero());
+
+			}
+
+		}
+
+	}
+
+}
+
+
 SCENARIO_METHOD(fixture,"kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block objects derive a transformation matrix between consecutive MSRC frames that matches the expected value, when forcing pixel to pixel correspondences","[!hide][kinfu][pose_estimation_pipeline_block][kinect_fusion_opencl_pose_estimation_pipeline_block][!mayfail]") {
 
 	GIVEN("A kinfu::kinect_fusion_opencl_pose_estimation_pipeline_block object with force pixel to pixel correspondences enabled") {
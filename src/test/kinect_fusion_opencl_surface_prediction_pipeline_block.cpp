@@ -127,3 +127,240 @@ SCENARIO_METHOD(fixture, "A kinfu::kinect_fusion_opencl_surface_prediction_pipel
 	}
 
 }
+
+
+SCENARIO_METHOD(fixture, "kinfu::kinect_fusion_opencl_surface_prediction_pipeline_block objects raycast a TSDF whose volume has moved","[kinfu][surface_prediction_pipeline_block][kinect_fusion_opencl_surface_prediction_pipeline_block]") {
+
+	GIVEN("A TSDF whose volume has moved with the camera and one whose volume has not into which the same frames have been integrated") {
+
+		float mu = 0.1f;
+
+		kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block rolling(q, fsopf, mu, 128, 128, 128);
+		rolling.rolling(true);
+		rolling.shift_threshold(0.25f);
+		kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block fixed(q, fsopf, mu, 128, 128, 128);
+
+		kinfu::filesystem::path pp(kinfu::current_executable_parent_path());
+		kinfu::msrc_file_system_depth_device_frame_factory ff;
+		kinfu::msrc_file_system_depth_device_filter f;
+		kinfu::file_system_depth_device ddi(pp/".."/"data/test/tsdf_viewer/",ff,&f);
+		kinfu::opencl_depth_device dd(ddi,q);
+		auto frame = dd();
+
+		kinfu::cpu_pipeline_value<Eigen::Matrix4f> first;
+		first.emplace(t_g_k);
+		Eigen::Matrix4f t(t_g_k);
+		t(0,3) = 1.8f;
+		kinfu::cpu_pipeline_value<Eigen::Matrix4f> second;
+		second.emplace(t);
+
+		auto r = rolling(*frame, width, height, k, first);
+		r = rolling(*frame, width, height, k, second, std::move(r));
+		REQUIRE(rolling.origin() != Eigen::Vector3i::Zero());
+		auto a = fixed(*frame, width, height, k, first);
+		a = fixed(*frame, width, height, k, second, std::move(a));
+
+		WHEN("Each is raycast from the pose from which the second frame was integrated") {
+
+			kinfu::kinect_fusion_opencl_surface_prediction_pipeline_block kfosppb(q, fsopf, mu, 128);
+			kinfu::cpu_pipeline_value<std::vector<kinfu::pixel>> prev;
+			prev.emplace();
+			auto r_ptr = kfosppb(*r.buffer, r.width, r.height, r.depth, second, k, prev, {});
+			auto && r_map = r_ptr->get();
+			std::vector<kinfu::pixel> r_copy(r_map.begin(), r_map.end());
+			auto a_ptr = kfosppb(*a.buffer, a.width, a.height, a.depth, second, k, prev, {});
+			auto && a_map = a_ptr->get();
+
+			THEN("Vertices are found in the moved volume and wherever both find a vertex it is the same vertex") {
+
+				REQUIRE(r_copy.size() == a_map.size());
+				std::size_t valid(0);
+				std::size_t both(0);
+				std::size_t mismatches(0);
+				for (std::size_t i = 0; i < r_copy.size(); ++i) {
+
+					if (is_nan(r_copy[i].v)) continue;
+					++valid;
+					if (is_nan(a_map[i].v)) continue;
+					++both;
+					if (!((r_copy[i].v - a_map[i].v).norm() <= 0.0001f)) ++mismatches;
+
+				}
+				CHECK(valid > 0U);
+				CHECK(both > 0U);
+				CHECK(mismatches == 0U);
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO_METHOD(fixture, "kinfu::kinect_fusion_opencl_surface_prediction_pipeline_block objects skip through free space without changing the predicted surface","[kinfu][surface_prediction_pipeline_block][kinect_fusion_opencl_surface_prediction_pipeline_block]") {
+
+	GIVEN("A TSDF into which a frame has been integrated") {
+
+		float mu = 0.1f;
+
+		kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block kfourpb(q, fsopf, mu, tsdf_width, tsdf_height, tsdf_depth);
+
+		kinfu::filesystem::path pp(kinfu::current_executable_parent_path());
+		kinfu::msrc_file_system_depth_device_frame_factory ff;
+		kinfu::msrc_file_system_depth_device_filter f;
+		kinfu::file_system_depth_device ddi(pp/".."/"data/test/tsdf_viewer/",ff,&f);
+		kinfu::opencl_depth_device dd(ddi,q);
+
+		kinfu::cpu_pipeline_value<Eigen::Matrix4f> t_g_k_pv;
+		t_g_k_pv.emplace(t_g_k);
+		auto tsdf = kfourpb(*dd(), width, height, k, t_g_k_pv);
+
+		WHEN("It is raycast with the default maximum step and with a maximum step of 0.5mm (i.e. a fixed step march)") {
+
+			kinfu::kinect_fusion_opencl_surface_prediction_pipeline_block skipping(q, fsopf, mu, tsdf_width);
+			kinfu::kinect_fusion_opencl_surface_prediction_pipeline_block fixed(q, fsopf, mu, tsdf_width);
+			fixed.max_step(0.0005f);
+			kinfu::cpu_pipeline_value<std::vector<kinfu::pixel>> prev;
+			prev.emplace();
+			auto skipping_ptr = skipping(*tsdf.buffer, tsdf.width, tsdf.height, tsdf.depth, t_g_k_pv, k, prev, {});
+			auto fixed_ptr = fixed(*tsdf.buffer, tsdf.width, tsdf.height, tsdf.depth, t_g_k_pv, k, prev, {});
+
+			THEN("Essentially the same vertices are found") {
+
+				CHECK(skipping.max_step() == Approx(0.08f));
+				auto && skipping_map = skipping_ptr->get();
+				auto && fixed_map = fixed_ptr->get();
+				REQUIRE(skipping_map.size() == fixed_map.size());
+
+				std::size_t fixed_valid(0);
+				std::size_t same(0);
+				for (std::size_t i = 0; i < fixed_map.size(); ++i) {
+
+					if (is_nan(fixed_map[i].v)) continue;
+					++fixed_valid;
+					if (!is_nan(skipping_map[i].v) && ((skipping_map[i].v - fixed_map[i].v).norm() <= 0.001f)) ++same;
+
+				}
+				CHECK(fixed_valid > 0U);
+				CHECK(same >= ((fixed_valid * 99U) / 100U));
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO_METHOD(fixture, "kinfu::kinect_fusion_opencl_surface_prediction_pipeline_block objects skip bricks which cannot contain a surface without changing the predicted surface","[kinfu][surface_prediction_pipeline_block][kinect_fusion_opencl_surface_prediction_pipeline_block]") {
+
+	GIVEN("A TSDF into which a frame has been integrated") {
+
+		float mu = 0.1f;
+
+		kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block kfourpb(q, fsopf, mu, tsdf_width, tsdf_height, tsdf_depth);
+
+		kinfu::filesystem::path pp(kinfu::current_executable_parent_path());
+		kinfu::msrc_file_system_depth_device_frame_factory ff;
+		kinfu::msrc_file_system_depth_device_filter f;
+		kinfu::file_system_depth_device ddi(pp/".."/"data/test/tsdf_viewer/",ff,&f);
+		kinfu::opencl_depth_device dd(ddi,q);
+
+		kinfu::cpu_pipeline_value<Eigen::Matrix4f> t_g_k_pv;
+		t_g_k_pv.emplace(t_g_k);
+		auto tsdf = kfourpb(*dd(), width, height, k, t_g_k_pv);
+
+		WHEN("It is raycast with a fixed step march both with and without skipping bricks") {
+
+			kinfu::kinect_fusion_opencl_surface_prediction_pipeline_block skipping(q, fsopf, mu, tsdf_width);
+			skipping.max_step(0.0005f);
+			kinfu::kinect_fusion_opencl_surface_prediction_pipeline_block marching(q, fsopf, mu, tsdf_width);
+			marching.max_step(0.0005f);
+			marching.brick_skipping(false);
+			kinfu::cpu_pipeline_value<std::vector<kinfu::pixel>> prev;
+			prev.emplace();
+			auto skipping_ptr = skipping(*tsdf.buffer, tsdf.width, tsdf.height, tsdf.depth, t_g_k_pv, k, prev, {});
+			auto marching_ptr = marching(*tsdf.buffer, tsdf.width, tsdf.height, tsdf.depth, t_g_k_pv, k, prev, {});
+
+			THEN("Essentially the same vertices are found") {
+
+				CHECK(skipping.brick_skipping());
+				CHECK_FALSE(marching.brick_skipping());
+				auto && skipping_map = skipping_ptr->get();
+				auto && marching_map = marching_ptr->get();
+				REQUIRE(skipping_map.size() == marching_map.size());
+
+				std::size_t marching_valid(0);
+				std::size_t same(0);
+				for (std::size_t i = 0; i < marching_map.size(); ++i) {
+
+					if (is_nan(marching_map[i].v)) continue;
+					++marching_valid;
+					if (!is_nan(skipping_map[i].v) && ((skipping_map[i].v - marching_map[i].v).norm() <= 0.001f)) ++same;
+
+				}
+				CHECK(marching_valid > 0U);
+				CHECK(same >= ((marching_valid * 99U) / 100U));
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO_METHOD(fixture, "kinfu::kinect_fusion_opencl_surface_prediction_pipeline_block objects raycast a TSDF from a camera outside the volume","[kinfu][surface_prediction_pipeline_block][kinect_fusion_opencl_surface_prediction_pipeline_block]") {
+
+	GIVEN("A TSDF into which a frame has been integrated from a pose outside the volume") {
+
+		float mu = 0.1f;
+		float extent = 3.0f;
+
+		//	The near plane of this pose lies outside the volume
+		t_g_k(2,3) = -0.5f;
+		kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block kfourpb(q, fsopf, mu, tsdf_width, tsdf_height, tsdf_depth);
+
+		kinfu::filesystem::path pp(kinfu::current_executable_parent_path());
+		kinfu::msrc_file_system_depth_device_frame_factory ff;
+		kinfu::msrc_file_system_depth_device_filter f;
+		kinfu::file_system_depth_device ddi(pp/".."/"data/test/tsdf_viewer/",ff,&f);
+		kinfu::opencl_depth_device dd(ddi,q);
+
+		kinfu::cpu_pipeline_value<Eigen::Matrix4f> t_g_k_pv;
+		t_g_k_pv.emplace(t_g_k);
+		auto tsdf = kfourpb(*dd(), width, height, k, t_g_k_pv);
+
+		WHEN("It is raycast from that pose") {
+
+			kinfu::kinect_fusion_opencl_surface_prediction_pipeline_block kfosppb(q, fsopf, mu, tsdf_width, extent);
+			kinfu::cpu_pipeline_value<std::vector<kinfu::pixel>> prev;
+			prev.emplace();
+			auto ptr = kfosppb(*tsdf.buffer, tsdf.width, tsdf.height, tsdf.depth, t_g_k_pv, k, prev, {});
+
+			THEN("Vertices are found and all of them lie within the volume") {
+
+				auto && map = ptr->get();
+				std::size_t valid(0);
+				std::size_t outside(0);
+				for (auto && p : map) {
+
+					if (is_nan(p.v)) continue;
+					++valid;
+					if ((p.v.minCoeff() < 0.0f) || (p.v.maxCoeff() > extent)) ++outside;
+
+				}
+				CHECK(valid > 0U);
+				CHECK(outside == 0U);
+
+			}
+
+		}
+
+	}
+
+}
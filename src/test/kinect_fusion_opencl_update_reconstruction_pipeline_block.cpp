@@ -6,10 +6,15 @@
 #include <boost/compute.hpp>
 #include <kinfu/cpu_pipeline_value.hpp>
 #include <kinfu/filesystem.hpp>
+#include <kinfu/memory_tsdf_slice_sink.hpp>
 #include <kinfu/path.hpp>
+#include <kinfu/timer.hpp>
+#include <kinfu/voxel_format.hpp>
 #include <kinfu/file_system_opencl_program_factory.hpp>
 #include <Eigen/Dense>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstddef>
 #include <iostream>
 #include <tuple>
@@ -149,3 +154,299 @@ SCENARIO_METHOD(fixture, "A kinfu::kinect_fusion_opencl_update_reconstruction_pi
 	}
 
 }
+
+
+SCENARIO_METHOD(fixture, "kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block objects produce the same TSDF whether or not the launch is culled to the view frustum","[kinfu][update_reconstruction_pipeline_block][kinect_fusion_opencl_update_reconstruction_pipeline_block]") {
+
+	GIVEN("A kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block which culls and one which does not") {
+
+		kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block culled(q, fsopf, 0.03f, 64, 64, 64);
+		kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block full(q, fsopf, 0.03f, 64, 64, 64);
+		full.frustum_culling(false);
+		CHECK(culled.frustum_culling());
+		CHECK_FALSE(full.frustum_culling());
+
+		kinfu::filesystem::path pp(kinfu::current_executable_parent_path());
+		kinfu::msrc_file_system_depth_device_frame_factory ff;
+		kinfu::msrc_file_system_depth_device_filter f;
+		kinfu::file_system_depth_device ddi(pp/".."/"data/test/msrc_file_system_depth_device",ff,&f);
+		kinfu::cpu_pipeline_value<std::vector<float>> pv;
+		pv.emplace(ddi()->get());
+
+		WHEN("Both integrate the same frame from two poses, the second of which sees only part of the volume") {
+
+			kinfu::cpu_pipeline_value<Eigen::Matrix4f> second;
+			Eigen::Matrix4f t(t_g_k.get());
+			t(0,3) = 0.5f;
+			t(2,3) = 2.8f;
+			second.emplace(t);
+
+			auto a = culled(pv, width, height, k, t_g_k);
+			a = culled(pv, width, height, k, second, std::move(a));
+			auto b = full(pv, width, height, k, t_g_k);
+			b = full(pv, width, height, k, second, std::move(b));
+
+			THEN("The TSDFs are identical") {
+
+				auto && a_tsdf = a.buffer->get();
+				auto && b_tsdf = b.buffer->get();
+				REQUIRE(a_tsdf.size() == b_tsdf.size());
+				std::size_t mismatches(0);
+				for (std::size_t i = 0; i < a_tsdf.size(); ++i) if (float(a_tsdf[i]) != float(b_tsdf[i])) ++mismatches;
+				CHECK(mismatches == 0U);
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO_METHOD(fixture, "kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block objects produce essentially the same TSDF whether each column is swept or each voxel is updated independently","[kinfu][update_reconstruction_pipeline_block][kinect_fusion_opencl_update_reconstruction_pipeline_block]") {
+
+	GIVEN("A kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block which sweeps and one which does not") {
+
+		kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block swept(q, fsopf, 0.03f, 64, 64, 64);
+		kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block voxels(q, fsopf, 0.03f, 64, 64, 64);
+		swept.sweep(true);
+		CHECK(swept.sweep());
+		CHECK_FALSE(voxels.sweep());
+
+		kinfu::filesystem::path pp(kinfu::current_executable_parent_path());
+		kinfu::msrc_file_system_depth_device_frame_factory ff;
+		kinfu::msrc_file_system_depth_device_filter f;
+		kinfu::file_system_depth_device ddi(pp/".."/"data/test/msrc_file_system_depth_device",ff,&f);
+		kinfu::cpu_pipeline_value<std::vector<float>> pv;
+		pv.emplace(ddi()->get());
+
+		WHEN("Both integrate the same frame twice") {
+
+			auto a = swept(pv, width, height, k, t_g_k);
+			a = swept(pv, width, height, k, t_g_k, std::move(a));
+			auto b = voxels(pv, width, height, k, t_g_k);
+			b = voxels(pv, width, height, k, t_g_k, std::move(b));
+
+			THEN("Almost all voxels match within 0.01 (voxels which project onto the boundary between pixels may differ due to rounding)") {
+
+				auto && a_tsdf = a.buffer->get();
+				auto && b_tsdf = b.buffer->get();
+				REQUIRE(a_tsdf.size() == b_tsdf.size());
+				std::size_t mismatches(0);
+				for (std::size_t i = 0; i < a_tsdf.size(); ++i) if (!(std::abs(float(a_tsdf[i]) - float(b_tsdf[i])) <= 0.01f)) ++mismatches;
+				CHECK(mismatches <= (a_tsdf.size() / 1000U));
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO_METHOD(fixture, "kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block objects may be reset to clear the TSDF without reallocating it","[kinfu][update_reconstruction_pipeline_block][kinect_fusion_opencl_update_reconstruction_pipeline_block]") {
+
+	GIVEN("A kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block and a depth frame") {
+
+		kinfu::filesystem::path pp(kinfu::current_executable_parent_path());
+		kinfu::msrc_file_system_depth_device_frame_factory ff;
+		kinfu::msrc_file_system_depth_device_filter f;
+		kinfu::file_system_depth_device ddi(pp/".."/"data/test/msrc_file_system_depth_device",ff,&f);
+		kinfu::cpu_pipeline_value<std::vector<float>> pv;
+		pv.emplace(ddi()->get());
+
+		THEN("Integrating the frame twice, resetting, and integrating the frame once more in each of two voxel formats produces the same TSDF as integrating the frame once without reallocating it") {
+
+			for (auto format : {kinfu::voxel_format::half, kinfu::voxel_format::fixed8_weight8}) {
+
+				kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block kfourpb(q, fsopf, 0.03f, 64, 64, 64, 3.0f, 3.0f, 3.0f, format);
+				auto v = kfourpb(pv, width, height, k, t_g_k);
+				std::vector<float> once;
+				for (auto && t : v.buffer->get()) once.push_back(t);
+				v = kfourpb(pv, width, height, k, t_g_k, std::move(v));
+				auto ptr = v.buffer.get();
+				kfourpb.reset();
+				v = kfourpb(pv, width, height, k, t_g_k, std::move(v));
+
+				CHECK(v.buffer.get() == ptr);
+				auto && tsdf = v.buffer->get();
+				REQUIRE(tsdf.size() == once.size());
+				std::size_t mismatches(0);
+				for (std::size_t i = 0; i < tsdf.size(); ++i) if (float(tsdf[i]) != once[i]) ++mismatches;
+				CHECK(mismatches == 0U);
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO_METHOD(fixture, "kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block objects produce essentially the same TSDF in each voxel format","[kinfu][update_reconstruction_pipeline_block][kinect_fusion_opencl_update_reconstruction_pipeline_block]") {
+
+	GIVEN("A depth frame") {
+
+		kinfu::filesystem::path pp(kinfu::current_executable_parent_path());
+		kinfu::msrc_file_system_depth_device_frame_factory ff;
+		kinfu::msrc_file_system_depth_device_filter f;
+		kinfu::file_system_depth_device ddi(pp/".."/"data/test/msrc_file_system_depth_device",ff,&f);
+		kinfu::cpu_pipeline_value<std::vector<float>> pv;
+		pv.emplace(ddi()->get());
+
+		kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block reference(q, fsopf, 0.03f, 64, 64, 64);
+		CHECK(reference.format() == kinfu::voxel_format::half);
+		auto r = reference(pv, width, height, k, t_g_k);
+		r = reference(pv, width, height, k, t_g_k, std::move(r));
+		auto && r_tsdf = r.buffer->get();
+
+		THEN("Integrating it twice in each other format produces a TSDF within the precision of that format of the TSDF produced in half precision") {
+
+			using format_type = std::tuple<kinfu::voxel_format, float>;
+			for (auto && t : {format_type(kinfu::voxel_format::fixed16_weight8, 0.002f), format_type(kinfu::voxel_format::half_weight16, 0.0f), format_type(kinfu::voxel_format::fixed8_weight8, 0.02f)}) {
+
+				auto format = std::get<0>(t);
+				kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block kfourpb(q, fsopf, 0.03f, 64, 64, 64, 3.0f, 3.0f, 3.0f, format);
+				CHECK(kfourpb.format() == format);
+				auto v = kfourpb(pv, width, height, k, t_g_k);
+				v = kfourpb(pv, width, height, k, t_g_k, std::move(v));
+				auto && tsdf = v.buffer->get();
+				REQUIRE(tsdf.size() == r_tsdf.size());
+				std::size_t mismatches(0);
+				for (std::size_t i = 0; i < tsdf.size(); ++i) if (!(std::abs(float(tsdf[i]) - float(r_tsdf[i])) <= std::get<1>(t))) ++mismatches;
+				CHECK(mismatches == 0U);
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO_METHOD(fixture, "kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block objects may move the volume with the camera","[kinfu][update_reconstruction_pipeline_block][kinect_fusion_opencl_update_reconstruction_pipeline_block]") {
+
+	GIVEN("A kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block whose volume moves, one whose volume does not, and a depth frame") {
+
+		kinfu::memory_tsdf_slice_sink sink;
+		kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block rolling(q, fsopf, 0.03f, 64, 64, 64);
+		rolling.rolling(true);
+		rolling.shift_threshold(0.75f);
+		rolling.slice_sink(sink);
+		CHECK(rolling.rolling());
+		CHECK(rolling.shift_threshold() == 0.75f);
+		kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block fixed(q, fsopf, 0.03f, 64, 64, 64);
+		CHECK_FALSE(fixed.rolling());
+
+		kinfu::filesystem::path pp(kinfu::current_executable_parent_path());
+		kinfu::msrc_file_system_depth_device_frame_factory ff;
+		kinfu::msrc_file_system_depth_device_filter f;
+		kinfu::file_system_depth_device ddi(pp/".."/"data/test/msrc_file_system_depth_device",ff,&f);
+		kinfu::cpu_pipeline_value<std::vector<float>> pv;
+		pv.emplace(ddi()->get());
+
+		WHEN("Both integrate the frame from the center of the volume and then from a pose 1m along the x axis") {
+
+			kinfu::cpu_pipeline_value<Eigen::Matrix4f> second;
+			Eigen::Matrix4f t(t_g_k.get());
+			t(0,3) = 2.5f;
+			second.emplace(t);
+
+			auto a = fixed(pv, width, height, k, t_g_k);
+			std::vector<float> first;
+			for (auto && v : a.buffer->get()) first.push_back(v);
+			a = fixed(pv, width, height, k, second, std::move(a));
+			auto && a_tsdf = a.buffer->get();
+
+			auto r = rolling(pv, width, height, k, t_g_k);
+			CHECK(rolling.origin() == Eigen::Vector3i::Zero());
+			CHECK(sink.slices().empty());
+			r = rolling(pv, width, height, k, second, std::move(r));
+			auto && r_tsdf = r.buffer->get();
+			// Evicted voxels are downloaded asynchronously
+			// and only passed to the sink when flushed or
+			// by the next invocation
+			CHECK(sink.slices().empty());
+			rolling.flush_slices();
+
+			THEN("The volume moves so that the camera is at its center, the voxels which leave it are passed to the sink as they were, and the voxels which remain are unchanged") {
+
+				// The camera is 53.33 voxels along the x axis
+				CHECK(rolling.origin() == Eigen::Vector3i(21, 0, 0));
+				REQUIRE(r_tsdf.size() == a_tsdf.size());
+				REQUIRE(first.size() == a_tsdf.size());
+
+				std::size_t evicted(0);
+				std::size_t mismatches(0);
+				for (auto && slice : sink.slices()) {
+
+					evicted += slice.tsdf.size();
+					REQUIRE(slice.tsdf.size() == (slice.width * slice.height * slice.depth));
+					for (std::size_t z = 0; z < slice.depth; ++z) for (std::size_t y = 0; y < slice.height; ++y) for (std::size_t x = 0; x < slice.width; ++x) {
+
+						auto gx = std::size_t(slice.origin(0)) + x;
+						auto gy = std::size_t(slice.origin(1)) + y;
+						auto gz = std::size_t(slice.origin(2)) + z;
+						if (float(slice.tsdf[x + slice.width * (y + slice.height * z)]) != first[gx + 64U * (gy + 64U * gz)]) ++mismatches;
+
+					}
+
+				}
+				CHECK(evicted == (21U * 64U * 64U));
+				CHECK(mismatches == 0U);
+
+				mismatches = 0;
+				for (std::size_t z = 0; z < 64U; ++z) for (std::size_t y = 0; y < 64U; ++y) for (std::size_t x = 0; x < (64U - 21U); ++x) {
+
+					if (float(r_tsdf[x + 64U * (y + 64U * z)]) != float(a_tsdf[(x + 21U) + 64U * (y + 64U * z)])) ++mismatches;
+
+				}
+				CHECK(mismatches == 0U);
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO_METHOD(fixture, "kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block objects integrate frames quickly whether or not each column is swept","[.][benchmark][kinfu][update_reconstruction_pipeline_block][kinect_fusion_opencl_update_reconstruction_pipeline_block]") {
+
+	GIVEN("A depth frame") {
+
+		kinfu::filesystem::path pp(kinfu::current_executable_parent_path());
+		kinfu::msrc_file_system_depth_device_frame_factory ff;
+		kinfu::msrc_file_system_depth_device_filter f;
+		kinfu::file_system_depth_device ddi(pp/".."/"data/test/msrc_file_system_depth_device",ff,&f);
+		kinfu::cpu_pipeline_value<std::vector<float>> pv;
+		pv.emplace(ddi()->get());
+
+		THEN("The time taken to integrate it is reported for each kernel and size") {
+
+			for (std::size_t size : {std::size_t(256U), std::size_t(512U)}) for (bool sweep : {false, true}) {
+
+				kinfu::kinect_fusion_opencl_update_reconstruction_pipeline_block kfourpb(q, fsopf, 0.03f, size, size, size);
+				kfourpb.sweep(sweep);
+				// The first invocation initializes the TSDF
+				auto v = kfourpb(pv, width, height, k, t_g_k);
+				q.finish();
+				std::size_t iterations(10);
+				kinfu::timer t;
+				for (std::size_t i = 0; i < iterations; ++i) v = kfourpb(pv, width, height, k, t_g_k, std::move(v));
+				q.finish();
+				auto e = t.elapsed();
+				std::cout << size << "^3 " << (sweep ? "sweep" : "per voxel") << ": " << std::chrono::duration_cast<std::chrono::microseconds>(e).count() / iterations << "us per frame" << std::endl;
+
+			}
+
+		}
+
+	}
+
+}
@@ -0,0 +1,59 @@
+#include <kinfu/memory_tsdf_slice_sink.hpp>
+
+
+#include <kinfu/half.hpp>
+#include <Eigen/Dense>
+#include <utility>
+
+
+#include <catch.hpp>
+
+
+SCENARIO("kinfu::memory_tsdf_slice_sink objects keep the slices they receive","[kinfu][tsdf_slice_sink][memory_tsdf_slice_sink]") {
+	
+	GIVEN("A kinfu::memory_tsdf_slice_sink") {
+		
+		kinfu::memory_tsdf_slice_sink sink;
+		
+		WHEN("Two slices are passed to it") {
+			
+			kinfu::tsdf_slice_sink::slice a;
+			a.origin = Eigen::Vector3i(-2, 0, 5);
+			a.width = 2;
+			a.height = 1;
+			a.depth = 1;
+			a.tsdf = {kinfu::half(0.5f), kinfu::half(-0.25f)};
+			kinfu::tsdf_slice_sink::slice b;
+			b.origin = Eigen::Vector3i(0, 0, 0);
+			b.width = 1;
+			b.height = 1;
+			b.depth = 1;
+			b.tsdf = {kinfu::half(1.0f)};
+			kinfu::tsdf_slice_sink & base = sink;
+			base(std::move(a));
+			base(std::move(b));
+			
+			THEN("Both are retained in the order they were received") {
+				
+				auto && slices = sink.slices();
+				REQUIRE(slices.size() == 2U);
+				CHECK(slices[0].origin == Eigen::Vector3i(-2, 0, 5));
+				CHECK(slices[0].width == 2U);
+				REQUIRE(slices[0].tsdf.size() == 2U);
+				CHECK(float(slices[0].tsdf[1]) == -0.25f);
+				CHECK(slices[1].origin == Eigen::Vector3i::Zero());
+				
+			}
+			
+			THEN("They may be discarded") {
+				
+				sink.clear();
+				CHECK(sink.slices().empty());
+				
+			}
+			
+		}
+		
+	}
+	
+}
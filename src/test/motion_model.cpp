@@ -0,0 +1,48 @@
+#include <kinfu/motion_model.hpp>
+
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+#include <catch.hpp>
+
+
+SCENARIO("kinfu::constant_velocity extrapolates sensor poses","[kinfu][motion_model][constant_velocity]") {
+
+	GIVEN("Two identical poses") {
+
+		Eigen::Matrix4f t(Eigen::Matrix4f::Identity());
+		t(0,3)=1.5f;
+		t(1,3)=1.5f;
+		t(2,3)=1.5f;
+
+		THEN("The extrapolated pose is the same") {
+
+			CHECK(kinfu::constant_velocity(t,t).isApprox(t));
+
+		}
+
+	}
+
+	GIVEN("Two poses which differ by a rotation and translation") {
+
+		Eigen::Affine3f a(Eigen::Translation3f(1.5f,1.5f,1.5f));
+		Eigen::Affine3f step(Eigen::Translation3f(0.01f,-0.02f,0.005f)*Eigen::AngleAxisf(0.03f,Eigen::Vector3f(0.0f,1.0f,0.0f)));
+		Eigen::Matrix4f t_gk_minus_two(a.matrix());
+		Eigen::Matrix4f t_gk_minus_one((a*step).matrix());
+
+		WHEN("kinfu::constant_velocity is invoked thereupon") {
+
+			auto t_gk=kinfu::constant_velocity(t_gk_minus_two,t_gk_minus_one);
+
+			THEN("The same motion is applied once more") {
+
+				Eigen::Matrix4f expected((a*step*step).matrix());
+				CHECK(t_gk.isApprox(expected));
+
+			}
+
+		}
+
+	}
+
+}
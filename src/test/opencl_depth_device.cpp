@@ -3,13 +3,72 @@
 
 #include <boost/compute.hpp>
 #include <Eigen/Dense>
+#include <kinfu/depth_device.hpp>
+#include <kinfu/file_system_opencl_program_factory.hpp>
+#include <kinfu/filesystem.hpp>
 #include <kinfu/mock_depth_device.hpp>
 #include <kinfu/opencl_vector_pipeline_value.hpp>
+#include <kinfu/path.hpp>
+#include <kinfu/raw_depth_pipeline_value.hpp>
 #include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <catch.hpp>
 
 
+namespace {
+	
+	
+	class raw_depth_device final : public kinfu::depth_device {
+		
+		
+		public:
+		
+		
+			std::vector<std::uint16_t> frame;
+			
+			
+			virtual value_type operator () (value_type v=value_type{}) override {
+				
+				using type=kinfu::raw_depth_pipeline_value;
+				if (!v) v=std::make_unique<type>(65535U);
+				dynamic_cast<type &>(*v).raw()=frame;
+				
+				return v;
+				
+			}
+			
+			
+			virtual std::size_t width () const noexcept override {
+				
+				return frame.size();
+				
+			}
+			
+			
+			virtual std::size_t height () const noexcept override {
+				
+				return 1;
+				
+			}
+			
+			
+			virtual Eigen::Matrix3f k () const noexcept override {
+				
+				return Eigen::Matrix3f::Zero();
+				
+			}
+		
+		
+	};
+	
+	
+}
+
+
 SCENARIO("kinfu::opencl_depth_device objects wrap a kinfu::depth_device and upload its depth frames to the GPU","[kinfu][depth_device][opencl_depth_device]") {
 	
 	GIVEN("A kinfu::opencl_depth_device which wraps a kinfu::depth_device which does not upload its depth frames to the GPU") {
@@ -53,3 +112,93 @@ SCENARIO("kinfu::opencl_depth_device objects wrap a kinfu::depth_device and uplo
 	}
 	
 }
+
+
+SCENARIO("kinfu::opencl_depth_device objects upload depth frames in their native 16 bit representation and convert them on the GPU","[kinfu][depth_device][opencl_depth_device]") {
+	
+	GIVEN("A kinfu::opencl_depth_device which wraps a kinfu::depth_device which generates kinfu::raw_depth_pipeline_value objects") {
+		
+		raw_depth_device rdd;
+		rdd.frame={0U,500U,1000U,1234U,65535U,4000U};
+		auto dev=boost::compute::system::default_device();
+		boost::compute::context ctx(dev);
+		boost::compute::command_queue q(ctx,dev);
+		kinfu::filesystem::path cl_path(kinfu::current_executable_parent_path());
+		cl_path/="..";
+		cl_path/="cl";
+		kinfu::file_system_opencl_program_factory fsopf(cl_path,ctx);
+		kinfu::opencl_depth_device gpudd(rdd,q,fsopf);
+		
+		WHEN("It is invoked") {
+			
+			auto pv=gpudd();
+			
+			THEN("The frame available on the GPU is the same as that obtained by converting the frame on the CPU") {
+				
+				auto ptr=dynamic_cast<kinfu::opencl_vector_pipeline_value<float> *>(pv.get());
+				REQUIRE(ptr);
+				std::vector<float> gpu(ptr->vector().size());
+				q.finish();	//	In case any operation is still pending
+				boost::compute::copy(ptr->vector().begin(),ptr->vector().end(),gpu.begin(),q);
+				kinfu::raw_depth_pipeline_value cpu_pv(65535U);
+				cpu_pv.raw()=rdd.frame;
+				auto && cpu=cpu_pv.get();
+				REQUIRE(gpu.size()==cpu.size());
+				for (std::size_t i=0;i<cpu.size();++i) {
+					
+					if (std::isnan(cpu[i])) CHECK(std::isnan(gpu[i]));
+					else CHECK(gpu[i]==Approx(cpu[i]));
+					
+				}
+				
+			}
+			
+		}
+		
+	}
+	
+}
+
+
+SCENARIO("kinfu::opencl_depth_device objects reuse their staging buffers without corrupting frames which are still in flight","[kinfu][depth_device][opencl_depth_device]") {
+	
+	GIVEN("A kinfu::opencl_depth_device with two staging buffers which wraps a kinfu::depth_device which generates more frames than that") {
+		
+		kinfu::mock_depth_device mdd(Eigen::Matrix3f::Zero(),2,2);
+		std::vector<std::vector<float>> frames;
+		for (std::size_t i=0;i<5;++i) {
+			
+			float f(i);
+			frames.push_back(std::vector<float>{f,f+0.25f,f+0.5f,f+0.75f});
+			mdd.add(frames.back());
+			
+		}
+		auto dev=boost::compute::system::default_device();
+		boost::compute::context ctx(dev);
+		boost::compute::command_queue q(ctx,dev);
+		kinfu::opencl_depth_device gpudd(mdd,q,2);
+		
+		WHEN("It is invoked for each frame without waiting on any of them") {
+			
+			std::vector<kinfu::depth_device::value_type> pvs;
+			for (std::size_t i=0;i<frames.size();++i) pvs.push_back(gpudd());
+			
+			THEN("Each frame is available on the GPU") {
+				
+				q.finish();
+				for (std::size_t i=0;i<frames.size();++i) {
+					
+					auto ptr=dynamic_cast<kinfu::opencl_vector_pipeline_value<float> *>(pvs[i].get());
+					REQUIRE(ptr);
+					auto && ve=ptr->vector();
+					CHECK(std::equal(frames[i].begin(),frames[i].end(),ve.begin(),ve.end()));
+					
+				}
+				
+			}
+			
+		}
+		
+	}
+	
+}
@@ -0,0 +1,149 @@
+#include <kinfu/opencl_profiler.hpp>
+
+
+#include <boost/compute.hpp>
+#include <kinfu/cpu_pipeline_value.hpp>
+#include <kinfu/file_system_opencl_program_factory.hpp>
+#include <kinfu/filesystem.hpp>
+#include <kinfu/kinect_fusion_opencl_measurement_pipeline_block.hpp>
+#include <kinfu/path.hpp>
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+
+
+namespace {
+
+
+	class fixture {
+
+
+		private:
+
+
+			static kinfu::filesystem::path cl_path () {
+
+				kinfu::filesystem::path retr(kinfu::current_executable_parent_path());
+				retr/="..";
+				retr/="cl";
+
+				return retr;
+
+			}
+
+
+		protected:
+
+
+			boost::compute::device dev;
+			boost::compute::context ctx;
+			boost::compute::command_queue q;
+			kinfu::file_system_opencl_program_factory fsopf;
+
+
+		public:
+
+
+			fixture ()
+				:	dev(boost::compute::system::default_device()),
+					ctx(dev),
+					q(ctx,dev,boost::compute::command_queue::enable_profiling),
+					fsopf(cl_path(),ctx)
+			{	}
+
+
+	};
+
+
+}
+
+
+static bool is_sane (const kinfu::profiler::record & r) noexcept {
+
+	return (r.queued<=r.submit) && (r.submit<=r.start) && (r.start<=r.end);
+
+}
+
+
+SCENARIO_METHOD(fixture,"kinfu::opencl_profiler objects record device timings for OpenCL commands","[kinfu][profiler][opencl_profiler]") {
+
+	GIVEN("A kinfu::opencl_profiler") {
+
+		kinfu::opencl_profiler p;
+
+		THEN("It has no records") {
+
+			CHECK(p.records().empty());
+
+		}
+
+		WHEN("A command is recorded") {
+
+			int arr []={1,2,3,4};
+			boost::compute::vector<int> v(4,ctx);
+			p("write",q.enqueue_write_buffer_async(v.get_buffer(),0,sizeof(arr),arr));
+
+			THEN("Its timings are available") {
+
+				auto && rs=p.records();
+				REQUIRE(rs.size()==1U);
+				CHECK(rs[0].name=="write");
+				CHECK(is_sane(rs[0]));
+
+				AND_WHEN("It is cleared") {
+
+					p.clear();
+
+					THEN("It has no records") {
+
+						CHECK(p.records().empty());
+
+					}
+
+				}
+
+			}
+
+		}
+
+		GIVEN("A kinfu::kinect_fusion_opencl_measurement_pipeline_block which reports to it") {
+
+			kinfu::kinect_fusion_opencl_measurement_pipeline_block mpb(q,fsopf,16,2.0f,1.0f);
+			mpb.profiler(p);
+			Eigen::Matrix3f k;
+			k <<	585.0f, 0.0f, 2.0f,
+					0.0f, -585.0f, 2.0f,
+					0.0f, 0.0f, 1.0f;
+			kinfu::cpu_pipeline_value<std::vector<float>> frame;
+			frame.emplace(16,1.0f);
+
+			WHEN("It is invoked") {
+
+				mpb(frame,4,4,k);
+
+				THEN("Each of its kernels is recorded") {
+
+					auto && rs=p.records();
+					std::vector<std::string> names;
+					for (auto && r : rs) {
+
+						CHECK(is_sane(r));
+						names.push_back(r.name);
+
+					}
+					CHECK(std::count(names.begin(),names.end(),"bilateral_filter")==1);
+					CHECK(std::count(names.begin(),names.end(),"vertex_map")==1);
+					CHECK(std::count(names.begin(),names.end(),"normal_map")==1);
+
+				}
+
+			}
+
+		}
+
+	}
+
+}
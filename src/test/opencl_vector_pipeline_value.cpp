@@ -68,6 +68,55 @@ SCENARIO_METHOD(fixture,"kinfu::opencl_vector_pipeline_value objects keep the CP
 }
 
 
+SCENARIO_METHOD(fixture,"kinfu::opencl_vector_pipeline_value objects may map their GPU copy into host memory rather than downloading it","[kinfu][pipeline_value][opencl_pipeline_value][opencl_vector_pipeline_value]") {
+	
+	GIVEN("A kinfu::opencl_vector_pipeline_value") {
+		
+		kinfu::opencl_vector_pipeline_value<int> pv(q);
+		
+		THEN("Mapping it when it is empty yields an empty view") {
+			
+			auto view=pv.map();
+			CHECK(view.empty());
+			CHECK(view.size()==0U);
+			
+		}
+		
+		WHEN("Data is transferred to the underlying boost::compute::vector and it is mapped") {
+			
+			auto && gpu=pv.vector();
+			std::vector<int> cpu{1,2,3,4};
+			boost::compute::copy(cpu.begin(),cpu.end(),std::back_inserter(gpu),q);
+			auto view=pv.map();
+			
+			THEN("The view contains the data") {
+				
+				REQUIRE(view.size()==cpu.size());
+				CHECK(std::equal(view.begin(),view.end(),cpu.begin(),cpu.end()));
+				CHECK(view[2]==3);
+				
+			}
+			
+			AND_WHEN("The view is moved") {
+				
+				auto moved=std::move(view);
+				
+				THEN("The moved to view contains the data and the moved from view is empty") {
+					
+					CHECK(std::equal(moved.begin(),moved.end(),cpu.begin(),cpu.end()));
+					CHECK(view.empty());
+					
+				}
+				
+			}
+			
+		}
+		
+	}
+	
+}
+
+
 SCENARIO_METHOD(fixture,"kinfu::opencl_vector_pipeline_value_extractor objects allow pipeline_value objects to be transparently used on the GPU","[kinfu][pipeline_value][opencl_vector_pipeline_value_extractor]") {
 	
 	GIVEN("A kinfu::opencl_vector_pipeline_value_extractor") {
@@ -92,6 +141,47 @@ SCENARIO_METHOD(fixture,"kinfu::opencl_vector_pipeline_value_extractor objects a
 			
 		}
 		
+		GIVEN("A kinfu::opencl_vector_pipeline_value associated with a different boost::compute::command_queue in the same boost::compute::context whose producer recorded an event") {
+			
+			boost::compute::command_queue n_q(ctx,dev);
+			REQUIRE(n_q!=q);
+			kinfu::opencl_vector_pipeline_value<int> pv(n_q);
+			int arr []={1,2,3};
+			auto && gpu=pv.vector();
+			gpu.resize(std::size(arr),n_q);
+			pv.event(n_q.enqueue_write_buffer_async(gpu.get_buffer(),0,sizeof(arr),arr));
+			
+			WHEN("The kinfu::opencl_vector_pipeline_value_extractor is invoked and given the kinfu::opencl_vector_pipeline_value and a wait list") {
+				
+				boost::compute::wait_list events;
+				auto && v=e(pv,events);
+				
+				THEN("The boost::compute::vector wrapped by the kinfu::opencl_vector_pipeline_value is returned") {
+					
+					CHECK(&v==&pv.vector());
+					
+				}
+				
+				THEN("The event recorded by the producer is added to the wait list") {
+					
+					REQUIRE(events.size()==1U);
+					CHECK(events[0]==pv.events()[0]);
+					
+					AND_THEN("Once the wait list completes the returned boost::compute::vector contains the data written by the producer") {
+						
+						events.wait();
+						std::vector<int> cpu(v.size());
+						boost::compute::copy(v.begin(),v.end(),cpu.begin(),q);
+						CHECK(std::equal(std::begin(arr),std::end(arr),cpu.begin(),cpu.end()));
+						
+					}
+					
+				}
+				
+			}
+			
+		}
+		
 		GIVEN("A kinfu::opencl_vector_pipeline_value associated with a different boost::compute::context") {
 			
 			boost::compute::context n_ctx(dev);
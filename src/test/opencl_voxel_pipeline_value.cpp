@@ -0,0 +1,97 @@
+#include <kinfu/opencl_voxel_pipeline_value.hpp>
+
+
+#include <boost/compute.hpp>
+#include <kinfu/half.hpp>
+#include <kinfu/voxel_format.hpp>
+#include <Eigen/Dense>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <catch.hpp>
+
+
+namespace {
+
+
+	class fixture {
+
+
+		protected:
+
+
+			boost::compute::device dev;
+			boost::compute::context ctx;
+			boost::compute::command_queue q;
+
+
+		public:
+
+
+			fixture () : dev(boost::compute::system::default_device()), ctx(dev), q(ctx,dev) {	}
+
+
+	};
+
+
+}
+
+
+SCENARIO_METHOD(fixture,"kinfu::opencl_voxel_pipeline_value objects may map their GPU storage into host memory rather than converting it","[kinfu][pipeline_value][opencl_pipeline_value][opencl_voxel_pipeline_value]") {
+
+	GIVEN("An empty kinfu::opencl_voxel_pipeline_value") {
+
+		kinfu::opencl_voxel_pipeline_value pv(q,kinfu::voxel_format::half);
+
+		THEN("Mapping it yields an empty view") {
+
+			auto view=pv.map();
+			CHECK(view.empty());
+			CHECK(view.size()==0U);
+
+		}
+
+	}
+
+	GIVEN("Voxels stored in a volume whose origin has moved") {
+
+		//	Any bit pattern is a voxel in every format
+		std::vector<std::uint8_t> bytes(4U*3U*2U*4U);
+		for (std::size_t i=0;i<bytes.size();++i) bytes[i]=std::uint8_t((i*37U)+11U);
+
+		THEN("Mapping a kinfu::opencl_voxel_pipeline_value in each format yields a view which presents the same values in the same order as the CPU copy, and which may be moved") {
+
+			for (auto format : {kinfu::voxel_format::half,kinfu::voxel_format::fixed16_weight8,kinfu::voxel_format::half_weight16,kinfu::voxel_format::fixed8_weight8}) {
+
+				kinfu::opencl_voxel_pipeline_value pv(q,format);
+				pv.resize(4,3,2);
+				auto n=pv.size()*kinfu::voxel_size(format);
+				boost::compute::copy(bytes.begin(),bytes.begin()+n,pv.vector().begin(),q);
+				pv.origin(Eigen::Vector3i(1,-1,3));
+
+				auto && cpu=pv.get();
+				auto view=pv.map();
+				REQUIRE(view.size()==cpu.size());
+				std::size_t mismatches(0);
+				//	Compared bitwise since some patterns are NaN
+				for (std::size_t i=0;i<cpu.size();++i) {
+
+					kinfu::half v(view[i]);
+					if (std::memcmp(&v,&cpu[i],sizeof(v))!=0) ++mismatches;
+
+				}
+				CHECK(mismatches==0U);
+
+				auto moved=std::move(view);
+				CHECK(moved.size()==cpu.size());
+				CHECK(view.empty());
+
+			}
+
+		}
+
+	}
+
+}
@@ -0,0 +1,146 @@
+#include <kinfu/raw_depth_pipeline_value.hpp>
+
+
+#include <kinfu/timer.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include <catch.hpp>
+
+
+SCENARIO("kinfu::raw_depth_pipeline_value objects represent depth frames in millimeters and convert them to meters when retrieved","[kinfu][raw_depth_pipeline_value]") {
+	
+	GIVEN("A kinfu::raw_depth_pipeline_value for which 65535 represents an invalid depth value") {
+		
+		kinfu::raw_depth_pipeline_value pv(65535U);
+		pv.raw()={0U,1000U,1500U,65535U};
+		
+		WHEN("Its value is retrieved") {
+			
+			auto && v=pv.get();
+			
+			THEN("The depth values are converted to meters and invalid depth values are converted to qNaN") {
+				
+				REQUIRE(v.size()==4U);
+				CHECK(v[0]==0.0f);
+				CHECK(v[1]==Approx(1.0f));
+				CHECK(v[2]==Approx(1.5f));
+				CHECK(std::isnan(v[3]));
+				
+			}
+			
+			AND_WHEN("The raw frame is replaced and its value is retrieved once again") {
+				
+				pv.raw()={2000U};
+				auto && v=pv.get();
+				
+				THEN("The new depth values are converted") {
+					
+					REQUIRE(v.size()==1U);
+					CHECK(v[0]==Approx(2.0f));
+					
+				}
+				
+			}
+			
+		}
+		
+	}
+	
+	GIVEN("A kinfu::raw_depth_pipeline_value for which 0 represents an invalid depth value") {
+		
+		kinfu::raw_depth_pipeline_value pv(0U);
+		pv.raw()={0U,65535U};
+		
+		WHEN("Its value is retrieved") {
+			
+			auto && v=pv.get();
+			
+			THEN("Only 0 is converted to qNaN") {
+				
+				REQUIRE(v.size()==2U);
+				CHECK(std::isnan(v[0]));
+				CHECK(v[1]==Approx(65.535f));
+				
+			}
+			
+		}
+		
+	}
+	
+}
+
+
+SCENARIO("kinfu::raw_depth_pipeline_value::to_meters converts ranges of raw depth values exactly as it converts individual raw depth values","[kinfu][raw_depth_pipeline_value]") {
+	
+	GIVEN("Every possible raw depth value") {
+		
+		//	One more than a multiple of the vector width so that
+		//	the scalar remainder is exercised
+		std::vector<std::uint16_t> raw;
+		for (std::size_t i=0;i<=65535U;++i) raw.push_back(std::uint16_t(i));
+		raw.push_back(65535U);
+		
+		WHEN("They are converted as a range") {
+			
+			std::vector<float> out(raw.size());
+			
+			THEN("The result is the same as converting each value individually whichever value is invalid") {
+				
+				for (std::uint16_t invalid : {std::uint16_t(0U),std::uint16_t(65535U)}) {
+					
+					kinfu::raw_depth_pipeline_value::to_meters(raw.data(),raw.data()+raw.size(),out.data(),invalid);
+					std::size_t mismatches(0);
+					for (std::size_t i=0;i<raw.size();++i) {
+						
+						auto expected=kinfu::raw_depth_pipeline_value::to_meters(raw[i],invalid);
+						if (std::isnan(expected) ? !std::isnan(out[i]) : (out[i]!=expected)) ++mismatches;
+						
+					}
+					CHECK(mismatches==0U);
+					
+				}
+				
+			}
+			
+		}
+		
+	}
+	
+}
+
+
+SCENARIO("kinfu::raw_depth_pipeline_value::to_meters converts 640x480 frames quickly","[.][benchmark][kinfu][raw_depth_pipeline_value]") {
+	
+	GIVEN("A 640x480 raw depth frame") {
+		
+		std::vector<std::uint16_t> raw;
+		for (std::size_t i=0;i<(640U*480U);++i) raw.push_back(std::uint16_t((i%7U==0U) ? 0U : (500U+(i%4000U))));
+		std::vector<float> out(raw.size());
+		
+		WHEN("It is converted many times") {
+			
+			std::size_t iterations(1000);
+			kinfu::timer t;
+			for (std::size_t i=0;i<iterations;++i) kinfu::raw_depth_pipeline_value::to_meters(raw.data(),raw.data()+raw.size(),out.data(),0U);
+			auto e=t.elapsed();
+			kinfu::timer scalar_t;
+			for (std::size_t i=0;i<iterations;++i) for (std::size_t j=0;j<raw.size();++j) out[j]=kinfu::raw_depth_pipeline_value::to_meters(raw[j],0U);
+			auto scalar_e=scalar_t.elapsed();
+			
+			THEN("The time taken is reported") {
+				
+				std::cout << "Range conversion: " << std::chrono::duration_cast<std::chrono::microseconds>(e).count()/iterations << "us per frame" << std::endl;
+				std::cout << "Scalar conversion: " << std::chrono::duration_cast<std::chrono::microseconds>(scalar_e).count()/iterations << "us per frame" << std::endl;
+				CHECK(std::isnan(out[0]));
+				
+			}
+			
+		}
+		
+	}
+	
+}
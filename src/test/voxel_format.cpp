@@ -0,0 +1,136 @@
+#include <kinfu/voxel_format.hpp>
+
+
+#include <kinfu/half.hpp>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <catch.hpp>
+
+
+SCENARIO("kinfu::voxel_format values determine the size of each voxel and whether weights are stored separately","[kinfu][voxel_format]") {
+
+	GIVEN("Each kinfu::voxel_format") {
+
+		THEN("The size of each voxel is correct") {
+
+			CHECK(kinfu::voxel_size(kinfu::voxel_format::half)==2U);
+			CHECK(kinfu::voxel_size(kinfu::voxel_format::fixed16_weight8)==4U);
+			CHECK(kinfu::voxel_size(kinfu::voxel_format::half_weight16)==4U);
+			CHECK(kinfu::voxel_size(kinfu::voxel_format::fixed8_weight8)==2U);
+
+		}
+
+		THEN("Only kinfu::voxel_format::half stores weights separately") {
+
+			CHECK(kinfu::voxel_separate_weights(kinfu::voxel_format::half));
+			CHECK_FALSE(kinfu::voxel_separate_weights(kinfu::voxel_format::fixed16_weight8));
+			CHECK_FALSE(kinfu::voxel_separate_weights(kinfu::voxel_format::half_weight16));
+			CHECK_FALSE(kinfu::voxel_separate_weights(kinfu::voxel_format::fixed8_weight8));
+
+		}
+
+		THEN("Each format is built with different options") {
+
+			CHECK(kinfu::voxel_format_options(kinfu::voxel_format::half)=="-DVOXEL_FORMAT=0");
+			CHECK(kinfu::voxel_format_options(kinfu::voxel_format::fixed8_weight8)=="-DVOXEL_FORMAT=3");
+
+		}
+
+	}
+
+}
+
+
+SCENARIO("kinfu::empty_voxel produces voxels which decode to a TSDF value of 1","[kinfu][voxel_format]") {
+
+	GIVEN("Each kinfu::voxel_format") {
+
+		for (auto format : {kinfu::voxel_format::half,kinfu::voxel_format::fixed16_weight8,kinfu::voxel_format::half_weight16,kinfu::voxel_format::fixed8_weight8}) {
+
+			unsigned char voxel [4];
+			kinfu::empty_voxel(format,voxel);
+			kinfu::half out;
+			kinfu::decode_voxels(format,voxel,1U,&out);
+			CHECK(float(out)==1.0f);
+			//	Weights occupy the third byte when packed
+			if (kinfu::voxel_size(format)==4U) CHECK(voxel[2]==0U);
+
+		}
+
+	}
+
+}
+
+
+SCENARIO("kinfu::decode_voxels converts voxels to half precision TSDF values","[kinfu][voxel_format]") {
+
+	GIVEN("Voxels stored in kinfu::voxel_format::fixed16_weight8") {
+
+		std::vector<std::uint32_t> voxels={32767U|(5U<<16),std::uint16_t(-32767)|(255U<<16),16384U};
+
+		WHEN("They are decoded") {
+
+			std::vector<kinfu::half> out(voxels.size());
+			kinfu::decode_voxels(kinfu::voxel_format::fixed16_weight8,voxels.data(),voxels.size(),out.data());
+
+			THEN("The weights are ignored and the fixed point values are converted") {
+
+				CHECK(float(out[0])==1.0f);
+				CHECK(float(out[1])==-1.0f);
+				CHECK(float(out[2])==Approx(0.5f).epsilon(0.001));
+
+			}
+
+		}
+
+	}
+
+	GIVEN("Voxels stored in kinfu::voxel_format::half_weight16") {
+
+		std::vector<std::uint16_t> voxels(4U);
+		kinfu::half a(0.25f);
+		kinfu::half b(-0.75f);
+		std::memcpy(&voxels[0],&a,sizeof(a));
+		voxels[1]=65535U;
+		std::memcpy(&voxels[2],&b,sizeof(b));
+		voxels[3]=1U;
+
+		WHEN("They are decoded") {
+
+			std::vector<kinfu::half> out(2U);
+			kinfu::decode_voxels(kinfu::voxel_format::half_weight16,voxels.data(),out.size(),out.data());
+
+			THEN("The weights are ignored and the half precision values are retrieved exactly") {
+
+				CHECK(float(out[0])==0.25f);
+				CHECK(float(out[1])==-0.75f);
+
+			}
+
+		}
+
+	}
+
+	GIVEN("Voxels stored in kinfu::voxel_format::fixed8_weight8") {
+
+		std::vector<std::int8_t> voxels={127,1,-127,-1,0,std::int8_t(-1)};
+
+		WHEN("They are decoded") {
+
+			std::vector<kinfu::half> out(3U);
+			kinfu::decode_voxels(kinfu::voxel_format::fixed8_weight8,voxels.data(),out.size(),out.data());
+
+			THEN("The weights are ignored and the fixed point values are converted") {
+
+				CHECK(float(out[0])==1.0f);
+				CHECK(float(out[1])==-1.0f);
+				CHECK(float(out[2])==0.0f);
+
+			}
+
+		}
+
+	}
+
+}
@@ -0,0 +1,10 @@
+#include <kinfu/tsdf_slice_sink.hpp>
+
+
+namespace kinfu {
+
+
+	tsdf_slice_sink::~tsdf_slice_sink () noexcept {	}
+
+
+}
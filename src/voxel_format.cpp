@@ -0,0 +1,109 @@
+#include <kinfu/half.hpp>
+#include <kinfu/voxel_format.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+
+namespace kinfu {
+
+
+	std::size_t voxel_size (voxel_format format) noexcept {
+
+		switch (format) {
+
+			case voxel_format::fixed16_weight8:
+			case voxel_format::half_weight16:
+				return 4U;
+			default:
+				break;
+
+		}
+
+		return 2U;
+
+	}
+
+
+	bool voxel_separate_weights (voxel_format format) noexcept {
+
+		return format==voxel_format::half;
+
+	}
+
+
+	std::string voxel_format_options (voxel_format format) {
+
+		//	Must agree with the VOXEL_FORMAT values understood
+		//	by tsdf.cl and raycast.cl
+		std::string retr("-DVOXEL_FORMAT=");
+		retr+=std::to_string(int(format));
+
+		return retr;
+
+	}
+
+
+	template <typename T>
+	static T load (const unsigned char * ptr) noexcept {
+
+		T retr;
+		std::memcpy(&retr,ptr,sizeof(retr));
+
+		return retr;
+
+	}
+
+
+	void empty_voxel (voxel_format format, void * out) noexcept {
+
+		auto ptr=static_cast<unsigned char *>(out);
+		std::memset(ptr,0,voxel_size(format));
+		switch (format) {
+
+			case voxel_format::half:
+			case voxel_format::half_weight16:{
+				half one(1.0f);
+				std::memcpy(ptr,&one,sizeof(one));
+				break;
+			}
+			case voxel_format::fixed16_weight8:{
+				std::uint32_t v(32767U);
+				std::memcpy(ptr,&v,sizeof(v));
+				break;
+			}
+			case voxel_format::fixed8_weight8:
+				ptr[0]=127U;
+				break;
+
+		}
+
+	}
+
+
+	void decode_voxels (voxel_format format, const void * begin, std::size_t size, half * out) noexcept {
+
+		auto ptr=static_cast<const unsigned char *>(begin);
+		auto stride=voxel_size(format);
+		for (std::size_t i=0;i<size;++i,ptr+=stride) switch (format) {
+
+			case voxel_format::half:
+			case voxel_format::half_weight16:
+				//	The TSDF value is the leading half in both
+				//	formats
+				out[i]=load<half>(ptr);
+				break;
+			case voxel_format::fixed16_weight8:
+				out[i]=half(float(std::int16_t(load<std::uint32_t>(ptr)&0xFFFFU))/32767.0f);
+				break;
+			case voxel_format::fixed8_weight8:
+				out[i]=half(float(load<std::int8_t>(ptr))/127.0f);
+				break;
+
+		}
+
+	}
+
+
+}